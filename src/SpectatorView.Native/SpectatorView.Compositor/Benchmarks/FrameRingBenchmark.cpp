@@ -0,0 +1,240 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+// Benchmark and check for the ring of captured frames in SharedHeaders: FrameRing and the RingDepthController that sizes
+// it. The checks publish frames, resize the ring the way the capture providers do, and read the frames back, to make sure
+// the newest frames survive every resize. They also feed the controller a jittery lag and count how often it resizes.
+// The timings write and read frames as fast as one thread can, at a fixed depth and while the depth keeps changing.
+//
+// Usage: FrameRingBenchmark [--verify-only] [--frames N]
+// Returns a non-zero exit code if any check fails.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include "FrameRing.h"
+#include "RingDepth.h"
+
+namespace
+{
+    const int capacity = 20;
+
+    struct TestFrame
+    {
+        int sequence;
+        int64_t timestamp;
+    };
+
+    typedef FrameRing<TestFrame, capacity> TestRing;
+
+    int failures = 0;
+
+    void Expect(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            printf("FAIL  %s\n", what);
+            failures++;
+        }
+    }
+
+    void Write(TestRing& ring, int sequence)
+    {
+        TestFrame& frame = ring.BeginWrite(sequence);
+        frame.sequence = sequence;
+        frame.timestamp = sequence * 10;
+        ring.Publish(sequence);
+    }
+
+    bool CanRead(const TestRing& ring, int sequence)
+    {
+        int read = 0;
+        return ring.Read(sequence, [&](const TestFrame& frame) { read = frame.sequence; }) && read == sequence;
+    }
+
+    // Number of the count newest published frames that can be read back.
+    int ReadableNewest(const TestRing& ring, int count)
+    {
+        int readable = 0;
+        int latest = ring.GetPublishedSequence();
+        for (int sequence = latest; sequence > latest - count && sequence > 0; sequence--)
+        {
+            readable += CanRead(ring, sequence) ? 1 : 0;
+        }
+
+        return readable;
+    }
+
+    void CheckResize()
+    {
+        TestRing ring;
+        for (int sequence = 1; sequence <= 110; sequence++)
+        {
+            Write(ring, sequence);
+        }
+
+        Expect(ReadableNewest(ring, capacity) == capacity, "Every slot holds one of the newest frames");
+
+        ring.SetDepth(12);
+        Expect(ReadableNewest(ring, 12) == 12, "Shrinking keeps the newest frames readable");
+        Expect(!CanRead(ring, 110 - 12), "Shrinking drops the frames that no longer fit");
+
+        for (int sequence = 111; sequence <= 115; sequence++)
+        {
+            Write(ring, sequence);
+            Expect(ReadableNewest(ring, 12) == 12, "Frames written after a shrink overwrite the oldest ones");
+        }
+
+        ring.SetDepth(7);
+        Expect(ReadableNewest(ring, 7) == 7, "Shrinking again keeps the newest frames readable");
+
+        ring.SetDepth(capacity);
+        Expect(ReadableNewest(ring, 7) == 7, "Growing keeps every frame");
+        for (int sequence = 116; sequence <= 150; sequence++)
+        {
+            Write(ring, sequence);
+            Expect(ReadableNewest(ring, (std::min)(capacity, sequence - 115 + 7)) == (std::min)(capacity, sequence - 115 + 7),
+                "Frames written after a grow fill the new slots before they overwrite any");
+        }
+
+        ring.SetDepth(5);
+        FrameBracket<int64_t> bracket = ring.FindBracket<int64_t>(1475, [](const TestFrame& frame) { return frame.timestamp; });
+        Expect(bracket.earlier == 147 && bracket.later == 148, "Frames are found by timestamp after a resize");
+
+        // A frame still being written is neither readable nor moved, and the next write skips no frame it still needs.
+        TestFrame& claimed = ring.BeginWrite(151);
+        claimed.sequence = 151;
+        Expect(ring.IsWriting(151) && !CanRead(ring, 151), "A claimed frame is not readable");
+        Expect(ReadableNewest(ring, 5) == 4, "Claiming a slot only drops the oldest frame");
+        ring.Publish(151);
+        Expect(CanRead(ring, 151) && !ring.IsWriting(151), "A published frame is readable");
+    }
+
+    void CheckTornRead()
+    {
+        TestRing ring;
+        for (int sequence = 1; sequence <= 30; sequence++)
+        {
+            Write(ring, sequence);
+        }
+
+        // Write over the frame being read, like the capture thread does when the ring is too shallow.
+        bool read = ring.Read(30 - ring.GetDepth() + 1, [&](const TestFrame&) { Write(ring, 31); });
+        Expect(!read, "A frame overwritten during the read is reported as torn");
+
+        // Shrink under a read of the newest frame, which was written past the slots the resize keeps, so it has to move.
+        Expect(&ring.Slot(31) >= &ring.SlotAt(4), "The newest frame is in a slot that shrinking to 4 drops");
+        read = ring.Read(31, [&](const TestFrame&) { ring.SetDepth(4); });
+        Expect(!read && CanRead(ring, 31), "A frame moved during the read is reported as torn, and readable where it moved");
+    }
+
+    // Feed the controller a render thread that trails capture by lag frames, and count how often the depth changes.
+    template <typename Lag>
+    int CountResizes(RingDepthController& controller, int frames, const Lag& lag, int* finalDepth)
+    {
+        int resizes = 0;
+        int depth = capacity;
+        for (int frame = 1; frame <= frames; frame++)
+        {
+            controller.ObserveLag(frame, frame - lag(frame));
+            int newDepth = controller.Update();
+            resizes += (newDepth != depth) ? 1 : 0;
+            depth = newDepth;
+        }
+
+        *finalDepth = depth;
+        return resizes;
+    }
+
+    void CheckDepthController()
+    {
+        int depth = 0;
+
+        // Mostly 8 frames behind, sometimes 10, and a stall every 200 frames.
+        RingDepthController jittery(capacity);
+        int resizes = CountResizes(jittery, 18000, [](int frame) { return (frame % 200 == 0) ? 15 : ((frame % 7 == 0) ? 10 : 8); }, &depth);
+        Expect(resizes <= 1 && depth >= 15 + RingDepthController::Headroom, "Jittery lag does not make the ring resize over and over");
+
+        // Once the stalls stop for good, the ring shrinks back to what the latency preference asks for.
+        RingDepthController settling(capacity);
+        CountResizes(settling, 18000, [](int frame) { return (frame < 1000) ? 15 : 4; }, &depth);
+        Expect(depth == RingDepthController::DefaultLag + RingDepthController::Headroom, "Steady lag shrinks the ring to the preferred depth");
+
+        // A stall grows the ring right away.
+        RingDepthController stalled(capacity);
+        stalled.SetLatencyPreference(0.0f);
+        CountResizes(stalled, 2000, [](int frame) { return (frame < 1999) ? 2 : 12; }, &depth);
+        Expect(depth == 12 + RingDepthController::Headroom, "A stall grows the ring right away");
+    }
+
+    // Nanoseconds to write, publish and read back a frame, resizing the ring every resizeInterval frames if not 0.
+    double TimeRing(int frameCount, int resizeInterval)
+    {
+        TestRing ring;
+        int64_t checksum = 0;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int sequence = 1; sequence <= frameCount; sequence++)
+        {
+            if (resizeInterval != 0 && sequence % resizeInterval == 0)
+            {
+                ring.SetDepth((ring.GetDepth() == capacity) ? capacity / 2 : capacity);
+            }
+
+            Write(ring, sequence);
+            ring.Read(sequence - 2, [&](const TestFrame& frame) { checksum += frame.timestamp; });
+        }
+
+        double nanoseconds = std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count();
+        if (checksum == 0 && frameCount > 3)
+        {
+            printf("No frame was read back.\n");
+        }
+
+        return nanoseconds / frameCount;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool verifyOnly = false;
+    int frameCount = 1000000;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--verify-only") == 0)
+        {
+            verifyOnly = true;
+        }
+        else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+        {
+            frameCount = (std::max)(1, atoi(argv[++i]));
+        }
+        else
+        {
+            printf("Usage: %s [--verify-only] [--frames N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    CheckResize();
+    CheckTornRead();
+    CheckDepthController();
+
+    if (!verifyOnly)
+    {
+        printf("%-24s %12s\n", "ring", "ns/frame");
+        printf("%-24s %12.1f\n", "fixed depth", TimeRing(frameCount, 0));
+        printf("%-24s %12.1f\n", "resize every 100", TimeRing(frameCount, 100));
+    }
+
+    if (failures > 0)
+    {
+        printf("\n%d check(s) failed.\n", failures);
+        return 1;
+    }
+
+    printf("\nFrames survive every resize, and the depth settles.\n");
+    return 0;
+}
@@ -0,0 +1,686 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+// Benchmark and golden-output check for the CPU pixel kernels in SharedHeaders.
+// Every conversion, blend, flip, resample and deinterlace runs on synthetic frames at 720p, 1080p and 4K, once for each
+// instruction set this machine supports, and once through the threaded PixelConversion registry the compositor uses.
+// The YUV conversions are checked with every color matrix. SIMD and threaded output must match the single threaded
+// _Scalar reference byte for byte, and the reference itself is pinned to a handful of known values.
+//
+// Usage: PixelBenchmark [--verify-only] [--iterations N]
+// Returns a non-zero exit code if any output is wrong.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <vector>
+#include "AlphaBlending.h"
+#include "Deinterlacing.h"
+#include "PixelConversion.h"
+#include "Resampling.h"
+#include "V210Conversion.h"
+#include "YUVConversion.h"
+
+namespace
+{
+    struct Resolution
+    {
+        const char* name;
+        int width;
+        int height;
+        // The tail size is only there to cover the leftover pixels of every kernel, it is not timed.
+        bool timed;
+    };
+
+    const Resolution resolutions[] =
+    {
+        { "tails", 1286, 10, false },
+        { "720p", 1280, 720, true },
+        { "1080p", 1920, 1080, true },
+        { "4K", 3840, 2160, true },
+    };
+
+    // Synthetic input in every format the kernels read.
+    struct Frames
+    {
+        int width = 0;
+        int height = 0;
+        std::vector<uint8_t> bgra;
+        std::vector<uint8_t> overlay;
+        std::vector<uint8_t> uyvy;
+        std::vector<uint8_t> alpha;
+        std::vector<uint8_t> rgb;
+        std::vector<uint8_t> v210;
+
+        Frames(int width, int height) : width(width), height(height)
+        {
+            uint32_t seed = 0x9E3779B9u ^ (uint32_t)(width * 31 + height);
+            Fill(bgra, (size_t)width * height * 4, seed);
+            Fill(overlay, (size_t)width * height * 4, seed);
+            Fill(uyvy, (size_t)width * height * 2, seed);
+            Fill(alpha, (size_t)width * height, seed);
+            Fill(rgb, (size_t)width * height * 3, seed);
+
+            // v210 words only use the low 30 bits.
+            Fill(v210, (size_t)V210Conversion::RowBytes(width) * height, seed);
+            for (size_t i = 3; i < v210.size(); i += 4)
+            {
+                v210[i] &= 0x3F;
+            }
+        }
+
+        int V210Pitch() const
+        {
+            return V210Conversion::RowBytes(width);
+        }
+
+    private:
+        static void Fill(std::vector<uint8_t>& bytes, size_t size, uint32_t& seed)
+        {
+            bytes.resize(size);
+            for (size_t i = 0; i < size; i++)
+            {
+                seed ^= seed << 13;
+                seed ^= seed >> 17;
+                seed ^= seed << 5;
+                bytes[i] = (uint8_t)(seed >> 24);
+            }
+        }
+    };
+
+    enum class Dispatch
+    {
+        // One run per supported SimdLevel.
+        PerLevel,
+        // Only a scalar implementation exists.
+        ScalarOnly,
+        // Through PixelConversion, which picks the best level and splits the frame across the ConversionThreadPool.
+        ThreadPool
+    };
+
+    typedef std::function<void(SimdLevel level, const Frames& frames, std::vector<uint8_t>& output)> RunFunction;
+
+    struct Kernel
+    {
+        const char* name;
+        Dispatch dispatch;
+        // Bytes read and written per pixel, for throughput.
+        double inputBytesPerPixel;
+        double outputBytesPerPixel;
+        // Called before a run whose output is checked, for kernels that update their output in place.
+        std::function<void(const Frames& frames, std::vector<uint8_t>& output)> prepare;
+        RunFunction run;
+        // Expected output. Kernels without one are checked against their own Scalar run.
+        RunFunction reference;
+        // True if the kernel reads matrix, so it is checked with every ColorMatrix.
+        bool perMatrix = false;
+
+        size_t OutputSize(const Frames& frames) const
+        {
+            return (size_t)(frames.width * (double)frames.height * outputBytesPerPixel);
+        }
+    };
+
+    std::vector<SimdLevel> SupportedLevels()
+    {
+        std::vector<SimdLevel> levels;
+        levels.push_back(SimdLevel::Scalar);
+
+        SimdLevel best = CpuFeatures::GetSimdLevel();
+#if defined(SV_SIMD_X86)
+        if (best >= SimdLevel::SSE41)
+        {
+            levels.push_back(SimdLevel::SSE41);
+        }
+
+        if (best >= SimdLevel::AVX2)
+        {
+            levels.push_back(SimdLevel::AVX2);
+        }
+#elif defined(SV_SIMD_NEON)
+        levels.push_back(SimdLevel::NEON);
+#endif
+        (void)best;
+        return levels;
+    }
+
+    // Pointer to the Scalar, SSE41, AVX2 or NEON variant of a kernel, or of one instantiation of a kernel template.
+#if defined(SV_SIMD_X86)
+#define SELECT_KERNEL(level, function) \
+    ((level) == SimdLevel::AVX2 ? &function##_AVX2 : (level) == SimdLevel::SSE41 ? &function##_SSE41 : &function##_Scalar)
+#define SELECT_KERNEL_INSTANCE(level, function, ...) \
+    ((level) == SimdLevel::AVX2 ? &function##_AVX2<__VA_ARGS__> : (level) == SimdLevel::SSE41 ? &function##_SSE41<__VA_ARGS__> : &function##_Scalar<__VA_ARGS__>)
+#elif defined(SV_SIMD_NEON)
+#define SELECT_KERNEL(level, function) \
+    ((level) == SimdLevel::NEON ? &function##_NEON : &function##_Scalar)
+#define SELECT_KERNEL_INSTANCE(level, function, ...) \
+    ((level) == SimdLevel::NEON ? &function##_NEON<__VA_ARGS__> : &function##_Scalar<__VA_ARGS__>)
+#else
+#define SELECT_KERNEL(level, function) (&function##_Scalar)
+#define SELECT_KERNEL_INSTANCE(level, function, ...) (&function##_Scalar<__VA_ARGS__>)
+#endif
+
+    // The matrix the YUV kernels convert with. Kernels marked PerMatrix are checked with each one, and timed with BT.709 limited.
+    const bool PerMatrix = true;
+    const ColorMatrix TimedMatrix = ColorMatrix::BT709Limited;
+    ColorMatrix matrix = TimedMatrix;
+
+    const char* GetColorMatrixName(ColorMatrix colorMatrix)
+    {
+        switch (colorMatrix)
+        {
+        case ColorMatrix::BT601Limited: return "BT.601 limited";
+        case ColorMatrix::BT709Limited: return "BT.709 limited";
+        case ColorMatrix::BT601Full: return "BT.601 full";
+        case ColorMatrix::BT709Full: return "BT.709 full";
+        default: return "unknown";
+        }
+    }
+
+    template <bool Rgba, bool UseAlpha>
+    void UYVYtoBGRA(SimdLevel level, const Frames& frames, uint8_t* output)
+    {
+        auto convert = SELECT_KERNEL_INSTANCE(level, YUVConversion::ConvertUYVYtoBGRA, Rgba, UseAlpha);
+        const YUVCoefficients& coefficients = YUVConversion::GetCoefficients(matrix);
+        int width = frames.width;
+        for (int y = 0; y < frames.height; y++)
+        {
+            const uint8_t* alpha = UseAlpha ? frames.alpha.data() + (size_t)y * width : nullptr;
+            convert(frames.uyvy.data() + (size_t)y * width * 2, alpha, output + (size_t)y * width * 4, width, coefficients);
+        }
+    }
+
+    void V210toUYVY(SimdLevel level, const Frames& frames, uint8_t* output)
+    {
+        auto convert = SELECT_KERNEL(level, V210Conversion::ConvertV210toUYVY);
+        for (int y = 0; y < frames.height; y++)
+        {
+            convert(frames.v210.data() + (size_t)y * frames.V210Pitch(), output + (size_t)y * frames.width * 2, frames.width);
+        }
+    }
+
+    // Unpacked and decoded a row at a time, like PixelConversion does in chunks.
+    template <bool Rgba>
+    void V210toBGRA(SimdLevel level, const Frames& frames, uint8_t* output)
+    {
+#if defined(SV_SIMD_X86)
+        // The SSE4.1 unpack also serves AVX2.
+        auto unpack = (level == SimdLevel::Scalar) ? &V210Conversion::UnpackV210_Scalar : &V210Conversion::UnpackV210_SSE41;
+#else
+        auto unpack = SELECT_KERNEL(level, V210Conversion::UnpackV210);
+#endif
+        auto convert = SELECT_KERNEL_INSTANCE(level, V210Conversion::ConvertUYVY10toBGRA, Rgba);
+        const YUVCoefficients& coefficients = YUVConversion::GetCoefficients(matrix);
+        std::vector<uint16_t> components((size_t)frames.width * 2);
+        for (int y = 0; y < frames.height; y++)
+        {
+            unpack(frames.v210.data() + (size_t)y * frames.V210Pitch(), components.data(), frames.width);
+            convert(components.data(), output + (size_t)y * frames.width * 4, frames.width, coefficients);
+        }
+    }
+
+    template <bool Rgba>
+    void BGRAtoNV12(SimdLevel level, const Frames& frames, uint8_t* output)
+    {
+        auto convert = SELECT_KERNEL_INSTANCE(level, YUVConversion::ConvertBGRAtoNV12Rows, Rgba);
+        const YUVCoefficients& coefficients = YUVConversion::GetCoefficients(matrix);
+        int width = frames.width;
+        uint8_t* chroma = output + (size_t)width * frames.height;
+        for (int y = 0; y + 1 < frames.height; y += 2)
+        {
+            const uint8_t* row0 = frames.bgra.data() + (size_t)y * width * 4;
+            convert(row0, row0 + width * 4, output + (size_t)y * width, output + (size_t)(y + 1) * width, chroma + (size_t)(y / 2) * width, width, coefficients);
+        }
+    }
+
+    void Blend(SimdLevel level, const Frames& frames, std::vector<uint8_t>& output, BlendMode mode)
+    {
+        auto blend = SELECT_KERNEL(level, AlphaBlending::BlendRow);
+        int width = frames.width;
+        for (int y = 0; y < frames.height; y++)
+        {
+            blend(output.data() + (size_t)y * width * 4, frames.overlay.data() + (size_t)y * width * 4, width, 192, mode);
+        }
+    }
+
+    void CopyBGRA(const Frames& frames, std::vector<uint8_t>& output)
+    {
+        memcpy(output.data(), frames.bgra.data(), frames.bgra.size());
+    }
+
+    // Per pixel reference for the swizzles and flips, which have no _Scalar kernel of their own.
+    void SwizzleReference(const Frames& frames, std::vector<uint8_t>& output, bool swapRedBlue, bool flip)
+    {
+        int width = frames.width;
+        for (int y = 0; y < frames.height; y++)
+        {
+            const uint8_t* source = frames.bgra.data() + (size_t)y * width * 4;
+            uint8_t* destination = output.data() + (size_t)(flip ? frames.height - 1 - y : y) * width * 4;
+            for (int x = 0; x < width * 4; x += 4)
+            {
+                destination[x + 0] = source[x + (swapRedBlue ? 2 : 0)];
+                destination[x + 1] = source[x + 1];
+                destination[x + 2] = source[x + (swapRedBlue ? 0 : 2)];
+                destination[x + 3] = source[x + 3];
+            }
+        }
+    }
+
+    // Rows of the other field are interpolated from the UYVY frame, rows of field are copied.
+    void BobUYVY(SimdLevel level, const Frames& frames, uint8_t* output, int field)
+    {
+        auto interpolate = SELECT_KERNEL(level, Deinterlacing::InterpolateRow);
+        int rowBytes = frames.width * 2;
+        for (int y = 0; y < frames.height; y++)
+        {
+            const uint8_t* source = frames.uyvy.data();
+            if ((y & 1) == field)
+            {
+                memcpy(output + (size_t)y * rowBytes, source + (size_t)y * rowBytes, rowBytes);
+                continue;
+            }
+
+            int above = (y > 0) ? y - 1 : y + 1;
+            int below = (y + 1 < frames.height) ? y + 1 : y - 1;
+            interpolate(source + (size_t)above * rowBytes, source + (size_t)below * rowBytes, output + (size_t)y * rowBytes, rowBytes);
+        }
+    }
+
+    // The UYVY frame is the previous frame. The current one matches it in the top half and moved in the bottom half,
+    // so both the woven and the interpolated path are covered.
+    void PrepareMotion(const Frames& frames, std::vector<uint8_t>& output)
+    {
+        memcpy(output.data(), frames.uyvy.data(), frames.uyvy.size());
+        for (size_t i = frames.uyvy.size() / 2; i < frames.uyvy.size(); i++)
+        {
+            output[i] ^= 0x40;
+        }
+    }
+
+    void MotionAdaptiveUYVY(SimdLevel level, const Frames& frames, uint8_t* output)
+    {
+        auto deinterlace = SELECT_KERNEL(level, Deinterlacing::MotionAdaptiveRow);
+        int rowBytes = frames.width * 2;
+        const uint8_t* previous = frames.uyvy.data();
+        for (int y = 0; y < frames.height; y += 2)
+        {
+            int above = (y > 0) ? y - 1 : y + 1;
+            int below = (y + 1 < frames.height) ? y + 1 : y - 1;
+            deinterlace(output + (size_t)above * rowBytes, output + (size_t)below * rowBytes, previous + (size_t)above * rowBytes, previous + (size_t)below * rowBytes,
+                output + (size_t)y * rowBytes, rowBytes, Deinterlacing::DefaultMotionThreshold);
+        }
+    }
+
+    ImageView View(const std::vector<uint8_t>& bytes, const Frames& frames, ImageFormat format)
+    {
+        return ImageView(bytes.data(), frames.width, frames.height, format);
+    }
+
+    // Resample to half size, rounded down to even dimensions for NV12.
+    void ResampleHalf(SimdLevel level, const std::vector<uint8_t>& input, const Frames& frames, std::vector<uint8_t>& output, ImageFormat format, ResampleFilter filter)
+    {
+        ImageView destination(output.data(), (frames.width / 2) & ~1, (frames.height / 2) & ~1, format);
+        Resampling::Resample(View(input, frames, format), destination, filter, level);
+    }
+
+    std::vector<Kernel> Kernels()
+    {
+        std::vector<Kernel> kernels;
+
+        kernels.push_back({ "UYVY to BGRA", Dispatch::PerLevel, 2, 4, nullptr,
+            [](SimdLevel level, const Frames& frames, std::vector<uint8_t>& output) { UYVYtoBGRA<false, false>(level, frames, output.data()); }, nullptr, PerMatrix });
+
+        kernels.push_back({ "UYVY + alpha to RGBA", Dispatch::PerLevel, 3, 4, nullptr,
+            [](SimdLevel level, const Frames& frames, std::vector<uint8_t>& output) { UYVYtoBGRA<true, true>(level, frames, output.data()); }, nullptr, PerMatrix });
+
+        kernels.push_back({ "BGRA to UYVY", Dispatch::PerLevel, 4, 2, nullptr,
+            [](SimdLevel level, const Frames& frames, std::vector<uint8_t>& output)
+            {
+                auto convert = SELECT_KERNEL_INSTANCE(level, YUVConversion::ConvertBGRAtoUYVY, false, false);
+                const YUVCoefficients& coefficients = YUVConversion::GetCoefficients(matrix);
+                for (int y = 0; y < frames.height; y++)
+                {
+                    convert(frames.bgra.data() + (size_t)y * frames.width * 4, output.data() + (size_t)y * frames.width * 2, nullptr, frames.width, coefficients);
+                }
+            }, nullptr, PerMatrix });
+
+        kernels.push_back({ "RGBA to UYVY + alpha", Dispatch::PerLevel, 4, 3, nullptr,
+            [](SimdLevel level, const Frames& frames, std::vector<uint8_t>& output)
+            {
+                auto convert = SELECT_KERNEL_INSTANCE(level, YUVConversion::ConvertBGRAtoUYVY, true, true);
+                const YUVCoefficients& coefficients = YUVConversion::GetCoefficients(matrix);
+                uint8_t* alpha = output.data() + (size_t)frames.width * frames.height * 2;
+                for (int y = 0; y < frames.height; y++)
+                {
+                    convert(frames.bgra.data() + (size_t)y * frames.width * 4, output.data() + (size_t)y * frames.width * 2, alpha + (size_t)y * frames.width, frames.width, coefficients);
+                }
+            }, nullptr, PerMatrix });
+
+        kernels.push_back({ "BGRA to NV12", Dispatch::PerLevel, 4, 1.5, nullptr,
+            [](SimdLevel level, const Frames& frames, std::vector<uint8_t>& output) { BGRAtoNV12<false>(level, frames, output.data()); }, nullptr, PerMatrix });
+
+        kernels.push_back({ "v210 to UYVY", Dispatch::PerLevel, 8.0 / 3.0, 2, nullptr,
+            [](SimdLevel level, const Frames& frames, std::vector<uint8_t>& output) { V210toUYVY(level, frames, output.data()); }, nullptr });
+
+        kernels.push_back({ "v210 to BGRA", Dispatch::PerLevel, 8.0 / 3.0, 4, nullptr,
+            [](SimdLevel level, const Frames& frames, std::vector<uint8_t>& output) { V210toBGRA<false>(level, frames, output.data()); }, nullptr, PerMatrix });
+
+        kernels.push_back({ "Blend premultiplied", Dispatch::PerLevel, 8, 4, CopyBGRA,
+            [](SimdLevel level, const Frames& frames, std::vector<uint8_t>& output) { Blend(level, frames, output, BlendMode::Premultiplied); }, nullptr });
+
+        kernels.push_back({ "Blend straight", Dispatch::PerLevel, 8, 4, CopyBGRA,
+            [](SimdLevel level, const Frames& frames, std::vector<uint8_t>& output) { Blend(level, frames, output, BlendMode::Straight); }, nullptr });
+
+        kernels.push_back({ "Bob UYVY", Dispatch::PerLevel, 2, 2, nullptr,
+            [](SimdLevel level, const Frames& frames, std::vector<uint8_t>& output) { BobUYVY(level, frames, output.data(), 1); }, nullptr });
+
+        kernels.push_back({ "Motion adaptive UYVY", Dispatch::PerLevel, 4, 2, PrepareMotion,
+            [](SimdLevel level, const Frames& frames, std::vector<uint8_t>& output) { MotionAdaptiveUYVY(level, frames, output.data()); }, nullptr });
+
+        // Resampling runs threaded at every level.
+        kernels.push_back({ "Resample RGBA 1/2 area", Dispatch::PerLevel, 4, 1, nullptr,
+            [](SimdLevel level, const Frames& frames, std::vector<uint8_t>& output) { ResampleHalf(level, frames.bgra, frames, output, ImageFormat::RGBA, ResampleFilter::Area); }, nullptr });
+
+        kernels.push_back({ "Resample RGBA 1/2 lanczos", Dispatch::PerLevel, 4, 1, nullptr,
+            [](SimdLevel level, const Frames& frames, std::vector<uint8_t>& output) { ResampleHalf(level, frames.bgra, frames, output, ImageFormat::RGBA, ResampleFilter::Lanczos3); }, nullptr });
+
+        kernels.push_back({ "Resample UYVY 1/2 bilinear", Dispatch::PerLevel, 2, 0.5, nullptr,
+            [](SimdLevel level, const Frames& frames, std::vector<uint8_t>& output) { ResampleHalf(level, frames.uyvy, frames, output, ImageFormat::UYVY, ResampleFilter::Bilinear); }, nullptr });
+
+        kernels.push_back({ "Resample alpha 1/2 area", Dispatch::PerLevel, 1, 0.25, nullptr,
+            [](SimdLevel level, const Frames& frames, std::vector<uint8_t>& output) { ResampleHalf(level, frames.alpha, frames, output, ImageFormat::Alpha8, ResampleFilter::Area); }, nullptr });
+
+        // The paths the compositor takes, threaded and dispatched.
+        kernels.push_back({ "Pool UYVY to RGBA", Dispatch::ThreadPool, 2, 4, nullptr,
+            [](SimdLevel, const Frames& frames, std::vector<uint8_t>& output)
+            {
+                PixelConversion::Convert(View(frames.uyvy, frames, ImageFormat::UYVY), View(output, frames, ImageFormat::RGBA), matrix);
+            },
+            [](SimdLevel, const Frames& frames, std::vector<uint8_t>& output) { UYVYtoBGRA<true, false>(SimdLevel::Scalar, frames, output.data()); }, PerMatrix });
+
+        kernels.push_back({ "Pool BGRA to NV12", Dispatch::ThreadPool, 4, 1.5, nullptr,
+            [](SimdLevel, const Frames& frames, std::vector<uint8_t>& output)
+            {
+                PixelConversion::Convert(View(frames.bgra, frames, ImageFormat::BGRA), View(output, frames, ImageFormat::NV12), matrix);
+            },
+            [](SimdLevel, const Frames& frames, std::vector<uint8_t>& output) { BGRAtoNV12<false>(SimdLevel::Scalar, frames, output.data()); }, PerMatrix });
+
+        kernels.push_back({ "Pool v210 to RGBA", Dispatch::ThreadPool, 8.0 / 3.0, 4, nullptr,
+            [](SimdLevel, const Frames& frames, std::vector<uint8_t>& output)
+            {
+                ImageView source(frames.v210.data(), frames.width, frames.height, ImageFormat::V210);
+                PixelConversion::Convert(source, View(output, frames, ImageFormat::RGBA), matrix);
+            },
+            [](SimdLevel, const Frames& frames, std::vector<uint8_t>& output) { V210toBGRA<true>(SimdLevel::Scalar, frames, output.data()); }, PerMatrix });
+
+        kernels.push_back({ "Pool BGRA to RGBA", Dispatch::ThreadPool, 4, 4, nullptr,
+            [](SimdLevel, const Frames& frames, std::vector<uint8_t>& output)
+            {
+                PixelConversion::Convert(View(frames.bgra, frames, ImageFormat::BGRA), View(output, frames, ImageFormat::RGBA), matrix, AlphaPolicy::Preserve);
+            },
+            [](SimdLevel, const Frames& frames, std::vector<uint8_t>& output) { SwizzleReference(frames, output, true, false); } });
+
+        kernels.push_back({ "Pool RGB to BGRA", Dispatch::ThreadPool, 3, 4, nullptr,
+            [](SimdLevel, const Frames& frames, std::vector<uint8_t>& output)
+            {
+                PixelConversion::Convert(View(frames.rgb, frames, ImageFormat::RGB), View(output, frames, ImageFormat::BGRA), matrix);
+            },
+            [](SimdLevel, const Frames& frames, std::vector<uint8_t>& output)
+            {
+                for (size_t i = 0, j = 0; i < frames.rgb.size(); i += 3, j += 4)
+                {
+                    output[j + 0] = frames.rgb[i + 2];
+                    output[j + 1] = frames.rgb[i + 1];
+                    output[j + 2] = frames.rgb[i + 0];
+                    output[j + 3] = 255;
+                }
+            } });
+
+        kernels.push_back({ "Pool bob UYVY", Dispatch::ThreadPool, 2, 2, nullptr,
+            [](SimdLevel, const Frames& frames, std::vector<uint8_t>& output)
+            {
+                Deinterlacing::Bob(View(frames.uyvy, frames, ImageFormat::UYVY), View(output, frames, ImageFormat::UYVY), 1);
+            },
+            [](SimdLevel, const Frames& frames, std::vector<uint8_t>& output) { BobUYVY(SimdLevel::Scalar, frames, output.data(), 1); } });
+
+        kernels.push_back({ "Pool adaptive UYVY", Dispatch::ThreadPool, 4, 2, PrepareMotion,
+            [](SimdLevel, const Frames& frames, std::vector<uint8_t>& output)
+            {
+                Deinterlacing::MotionAdaptive(View(output, frames, ImageFormat::UYVY), View(frames.uyvy, frames, ImageFormat::UYVY), 1);
+            },
+            [](SimdLevel, const Frames& frames, std::vector<uint8_t>& output) { MotionAdaptiveUYVY(SimdLevel::Scalar, frames, output.data()); } });
+
+        kernels.push_back({ "Pool flip BGRA", Dispatch::ThreadPool, 4, 4, nullptr,
+            [](SimdLevel, const Frames& frames, std::vector<uint8_t>& output)
+            {
+                PixelConversion::Convert(View(frames.bgra, frames, ImageFormat::BGRA), View(output, frames, ImageFormat::BGRA).FlippedVertically(), matrix, AlphaPolicy::Preserve);
+            },
+            [](SimdLevel, const Frames& frames, std::vector<uint8_t>& output) { SwizzleReference(frames, output, false, true); } });
+
+        kernels.push_back({ "Pool flip BGRA to RGBA", Dispatch::ThreadPool, 4, 4, nullptr,
+            [](SimdLevel, const Frames& frames, std::vector<uint8_t>& output)
+            {
+                PixelConversion::Convert(View(frames.bgra, frames, ImageFormat::BGRA), View(output, frames, ImageFormat::RGBA).FlippedVertically(), matrix, AlphaPolicy::Preserve);
+            },
+            [](SimdLevel, const Frames& frames, std::vector<uint8_t>& output) { SwizzleReference(frames, output, true, true); } });
+
+        return kernels;
+    }
+
+    int failures = 0;
+
+    void Expect(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            printf("FAIL  %s\n", what);
+            failures++;
+        }
+    }
+
+    // Known values that tie the scalar references to the published matrices, so a change to a reference
+    // cannot silently move every SIMD kernel along with it.
+    void CheckKnownValues()
+    {
+        const YUVCoefficients& bt601 = YUVConversion::GetCoefficients(ColorMatrix::BT601Limited);
+
+        uint8_t uyvy[4] = { 128, 235, 128, 16 };
+        uint8_t bgra[8];
+        YUVConversion::ConvertUYVYtoBGRA_Scalar<false, false>(uyvy, nullptr, bgra, 2, bt601);
+        const uint8_t expectedBGRA[8] = { 255, 255, 255, 255, 0, 0, 0, 255 };
+        Expect(memcmp(bgra, expectedBGRA, 8) == 0, "BT.601 limited white and black decode");
+
+        uint8_t white[8] = { 255, 255, 255, 255, 255, 255, 255, 255 };
+        YUVConversion::ConvertBGRAtoUYVY_Scalar<false, false>(white, uyvy, nullptr, 2, bt601);
+        const uint8_t expectedUYVY[4] = { 128, 235, 128, 235 };
+        Expect(memcmp(uyvy, expectedUYVY, 4) == 0, "BT.601 limited white encode");
+
+        uint8_t back[4] = { 10, 20, 30, 0 };
+        const uint8_t front[4] = { 200, 100, 50, 255 };
+        AlphaBlending::BlendRow_Scalar(back, front, 1, 255, BlendMode::Premultiplied);
+        const uint8_t expectedBlend[4] = { 200, 100, 50, 255 };
+        Expect(memcmp(back, expectedBlend, 4) == 0, "Opaque front replaces back");
+
+        // Cb = 1023, Y = 512, Cr = 64, then Y = 4.
+        const uint8_t v210[8] = { 0xFF, 0x03, 0x08, 0x04, 0x04, 0x00, 0x00, 0x00 };
+        uint8_t unpacked[4];
+        V210Conversion::ConvertV210toUYVY_Scalar(v210, unpacked, 2);
+        const uint8_t expectedUnpacked[4] = { 255, 128, 16, 1 };
+        Expect(memcmp(unpacked, expectedUnpacked, 4) == 0, "v210 unpack drops the two low bits");
+
+        uint16_t components[4];
+        V210Conversion::UnpackV210_Scalar(v210, components, 2);
+        const uint16_t expectedComponents[4] = { 1023, 512, 64, 4 };
+        Expect(memcmp(components, expectedComponents, sizeof(components)) == 0, "v210 unpack keeps all 10 bits");
+
+        // Components that are 8 bit values shifted up decode like the 8 bit kernel. Y = 66, just above black, is lost
+        // when it is cut to 8 bits but rounds up to 1 from 10 bits.
+        const uint16_t uyvy10[8] = { 512, 940, 512, 64, 512, 66, 512, 64 };
+        uint8_t decoded[16];
+        V210Conversion::ConvertUYVY10toBGRA_Scalar<false>(uyvy10, decoded, 4, bt601);
+        const uint8_t expectedDecoded[16] = { 255, 255, 255, 255, 0, 0, 0, 255, 1, 1, 1, 255, 0, 0, 0, 255 };
+        Expect(memcmp(decoded, expectedDecoded, 16) == 0, "10 bit decode matches 8 bit and rounds from all 10 bits");
+
+        // Static bytes are woven, moved bytes are the rounded up average of the rows above and below.
+        const uint8_t above[2] = { 10, 10 };
+        const uint8_t below[2] = { 21, 21 };
+        const uint8_t previousAbove[2] = { 10, 60 };
+        uint8_t current[2] = { 99, 99 };
+        Deinterlacing::MotionAdaptiveRow_Scalar(above, below, previousAbove, below, current, 2, Deinterlacing::DefaultMotionThreshold);
+        const uint8_t expectedDeinterlaced[2] = { 99, 16 };
+        Expect(memcmp(current, expectedDeinterlaced, 2) == 0, "Motion adaptive weaves static and interpolates moving bytes");
+    }
+
+    bool Matches(const std::vector<uint8_t>& actual, const std::vector<uint8_t>& expected, size_t& mismatch)
+    {
+        for (mismatch = 0; mismatch < expected.size(); mismatch++)
+        {
+            if (actual[mismatch] != expected[mismatch])
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Median of the per frame times, in milliseconds.
+    double TimeKernel(const Kernel& kernel, SimdLevel level, const Frames& frames, std::vector<uint8_t>& output, int iterations)
+    {
+        kernel.run(level, frames, output);
+
+        std::vector<double> times;
+        for (int i = 0; i < iterations; i++)
+        {
+            auto start = std::chrono::high_resolution_clock::now();
+            kernel.run(level, frames, output);
+            times.push_back(std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+        }
+
+        std::sort(times.begin(), times.end());
+        return times[times.size() / 2];
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool verifyOnly = false;
+    int iterations = 20;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--verify-only") == 0)
+        {
+            verifyOnly = true;
+        }
+        else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+        {
+            iterations = std::max(1, atoi(argv[++i]));
+        }
+        else
+        {
+            printf("Usage: %s [--verify-only] [--iterations N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    // The pool cases have to split frames into bands to check the band edges, even on a machine with one processor.
+    if (verifyOnly && ConversionThreadPool::Instance().GetWorkerCount() < 2)
+    {
+        ConversionThreadPool::Instance().SetWorkerCount(2);
+    }
+
+    std::vector<SimdLevel> levels = SupportedLevels();
+    printf("Best instruction set: %s, conversion workers: %d\n\n",
+        CpuFeatures::GetSimdLevelName(CpuFeatures::GetSimdLevel()), ConversionThreadPool::Instance().GetWorkerCount());
+
+    CheckKnownValues();
+
+    if (!verifyOnly)
+    {
+        printf("%-24s %-6s %-14s %10s %8s\n", "kernel", "size", "isa", "ms/frame", "GB/s");
+    }
+
+    std::vector<Kernel> kernels = Kernels();
+    for (const Resolution& resolution : resolutions)
+    {
+        Frames frames(resolution.width, resolution.height);
+
+        for (const Kernel& kernel : kernels)
+        {
+            std::vector<SimdLevel> kernelLevels;
+            if (kernel.dispatch == Dispatch::PerLevel)
+            {
+                kernelLevels = levels;
+            }
+            else
+            {
+                kernelLevels.push_back(kernel.dispatch == Dispatch::ThreadPool ? CpuFeatures::GetSimdLevel() : SimdLevel::Scalar);
+            }
+
+            int matrixCount = kernel.perMatrix ? (int)ColorMatrix::Count : 1;
+            for (int matrixIndex = 0; matrixIndex < matrixCount; matrixIndex++)
+            {
+                matrix = kernel.perMatrix ? (ColorMatrix)matrixIndex : TimedMatrix;
+
+                size_t outputSize = kernel.OutputSize(frames);
+                std::vector<uint8_t> expected(outputSize, 0xCD);
+                if (kernel.prepare)
+                {
+                    kernel.prepare(frames, expected);
+                }
+
+                if (kernel.reference)
+                {
+                    kernel.reference(SimdLevel::Scalar, frames, expected);
+                }
+                else
+                {
+                    kernel.run(SimdLevel::Scalar, frames, expected);
+                }
+
+                for (SimdLevel level : kernelLevels)
+                {
+                    std::vector<uint8_t> output(outputSize, 0xCD);
+                    if (kernel.prepare)
+                    {
+                        kernel.prepare(frames, output);
+                    }
+
+                    kernel.run(level, frames, output);
+
+                    size_t mismatch;
+                    if (!Matches(output, expected, mismatch))
+                    {
+                        printf("FAIL  %s at %s, %s, %s: byte %zu is %d, expected %d\n", kernel.name, resolution.name, CpuFeatures::GetSimdLevelName(level),
+                            GetColorMatrixName(matrix), mismatch, output[mismatch], expected[mismatch]);
+                        failures++;
+                    }
+
+                    if (verifyOnly || !resolution.timed || matrix != TimedMatrix)
+                    {
+                        continue;
+                    }
+
+                    double milliseconds = TimeKernel(kernel, level, frames, output, iterations);
+                    double bytes = (double)frames.width * frames.height * (kernel.inputBytesPerPixel + kernel.outputBytesPerPixel);
+                    char isa[32];
+                    snprintf(isa, sizeof(isa), "%s%s", CpuFeatures::GetSimdLevelName(level), kernel.dispatch == Dispatch::ThreadPool ? " pool" : "");
+                    printf("%-24s %-6s %-14s %10.3f %8.2f\n", kernel.name, resolution.name, isa, milliseconds, bytes / (milliseconds * 1.0e6));
+                }
+            }
+        }
+    }
+
+    if (failures > 0)
+    {
+        printf("\n%d check(s) failed.\n", failures);
+        return 1;
+    }
+
+    printf("\nAll outputs match the scalar references.\n");
+    return 0;
+}
@@ -0,0 +1,439 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+// Benchmark and check for the recording pipeline in SharedHeaders: MediaRecorder feeding synthetic video frames and
+// audio through its encoder thread into a sink. The checks record with RawFileMediaSink and read the files back,
+// to make sure every frame and audio buffer lands in order, and that gaps are filled. The timings run 1080p and 4K
+// recordings as fast as the producer can queue them, once into a sink that discards every sample, which measures the
+// copy and the queue, and once into the Y4M and WAV files, which adds the color conversion and the disk.
+//
+// Usage: RecordingBenchmark [--verify-only] [--frames N]
+// Returns a non-zero exit code if any check fails. Files are written to the working directory and removed again.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include "MediaRecorder.h"
+#include "RawFileMediaSink.h"
+#include "YUVConversion.h"
+
+namespace
+{
+    const int fps = 30;
+    const int64_t frameDuration = MEDIA_TICKS_PER_SECOND / fps;
+    const int audioSampleRate = 48000;
+    const int audioChannels = 2;
+    // Samples in each audio buffer, about what Unity delivers per callback.
+    const int audioSamplesPerBuffer = 1024;
+    const int audioBufferSize = audioSamplesPerBuffer * audioChannels * 2;
+
+    const wchar_t* recordingPath = L"RecordingBenchmark.mp4";
+    const char* videoFileName = "RecordingBenchmark.y4m";
+    const char* audioFileName = "RecordingBenchmark.wav";
+
+    struct Resolution
+    {
+        const char* name;
+        int width;
+        int height;
+    };
+
+    const Resolution resolutions[] =
+    {
+        { "1080p", 1920, 1080 },
+        { "4K", 3840, 2160 },
+    };
+
+    // Records nothing, so the time is spent in copying and queueing.
+    class DiscardMediaSink : public IMediaSink
+    {
+    public:
+        virtual bool Open(const std::wstring& /*path*/, const MediaSinkFormat& recordingFormat) override
+        {
+            format = recordingFormat;
+            return true;
+        }
+
+        virtual void Close() override {}
+
+        virtual bool AcquireVideoBuffer(MediaSinkBuffer* buffer) override
+        {
+            return AcquireBuffer(format.VideoBufferSize(), buffer);
+        }
+
+        virtual bool AcquireAudioBuffer(int size, MediaSinkBuffer* buffer) override
+        {
+            return AcquireBuffer(size, buffer);
+        }
+
+        virtual void ReleaseBuffer(MediaSinkBuffer* buffer) override
+        {
+            FrameBufferPool::Instance().Release(buffer->data);
+            buffer->data = nullptr;
+        }
+
+        virtual bool WriteVideo(MediaSinkBuffer* buffer, int64_t /*sampleTime*/, int64_t /*duration*/) override
+        {
+            ReleaseBuffer(buffer);
+            return true;
+        }
+
+        virtual bool WriteAudio(MediaSinkBuffer* buffer, int64_t /*sampleTime*/, int64_t /*duration*/) override
+        {
+            ReleaseBuffer(buffer);
+            return true;
+        }
+
+    private:
+        static bool AcquireBuffer(int size, MediaSinkBuffer* buffer)
+        {
+            buffer->data = FrameBufferPool::Instance().Acquire(size);
+            buffer->size = size;
+            buffer->sinkData = nullptr;
+            return buffer->data != nullptr;
+        }
+
+        MediaSinkFormat format = {};
+    };
+
+    MediaSinkFormat Format(int width, int height, ImageFormat videoFormat)
+    {
+        MediaSinkFormat format = {};
+        format.width = width;
+        format.height = height;
+        format.stride = (videoFormat == ImageFormat::NV12) ? width : width * 4;
+        format.videoFormat = videoFormat;
+        format.fps = fps;
+        format.encodeAudio = true;
+        format.audioSampleRate = audioSampleRate;
+        format.audioChannels = audioChannels;
+        format.audioBPS = 24000;
+        return format;
+    }
+
+    // A few synthetic frames to cycle through. The first byte of each NV12 frame is its index, so the order can be
+    // read back from the file.
+    std::vector<std::vector<uint8_t>> SyntheticFrames(const MediaSinkFormat& format, int count)
+    {
+        std::vector<std::vector<uint8_t>> frames(count);
+        uint32_t seed = 0x9E3779B9u ^ (uint32_t)(format.width * 31 + format.height);
+        for (int i = 0; i < count; i++)
+        {
+            frames[i].resize(format.VideoBufferSize());
+            for (uint8_t& byte : frames[i])
+            {
+                seed ^= seed << 13;
+                seed ^= seed >> 17;
+                seed ^= seed << 5;
+                byte = (uint8_t)(seed >> 24);
+            }
+
+            frames[i][0] = (uint8_t)i;
+        }
+
+        return frames;
+    }
+
+    std::vector<uint8_t> AudioBuffer(int index)
+    {
+        std::vector<uint8_t> audio(audioBufferSize);
+        for (int i = 0; i < audioBufferSize; i++)
+        {
+            audio[i] = (uint8_t)(index * 7 + i);
+        }
+
+        return audio;
+    }
+
+    // Queue frameCount frames with the audio that plays between them, like the compositor does each frame.
+    // Frames listed in skippedFrames are left out, as if the compositor missed them.
+    void Record(MediaRecorder& recorder, const std::vector<std::vector<uint8_t>>& frames, int frameCount,
+        const std::vector<int>& skippedFrames, const std::vector<std::vector<uint8_t>>& audioBuffers)
+    {
+        const int64_t audioBufferDuration = (int64_t)audioSamplesPerBuffer * MEDIA_TICKS_PER_SECOND / audioSampleRate;
+        const int64_t startTime = 1000 * MEDIA_TICKS_PER_SECOND;
+        int64_t audioTime = startTime;
+        int audioIndex = 0;
+
+        for (int frame = 0; frame < frameCount; frame++)
+        {
+            int64_t frameTime = startTime + frame * frameDuration;
+            if (std::find(skippedFrames.begin(), skippedFrames.end(), frame) == skippedFrames.end())
+            {
+                recorder.QueueVideoFrame(frames[frame % frames.size()].data(), frameTime, frameDuration);
+            }
+
+            while (audioTime < frameTime + frameDuration)
+            {
+                recorder.QueueAudioFrame(audioBuffers[audioIndex % audioBuffers.size()].data(), audioBufferSize, audioTime);
+                audioTime += audioBufferDuration;
+                audioIndex++;
+            }
+        }
+    }
+
+    std::vector<uint8_t> ReadFile(const char* name)
+    {
+        std::vector<uint8_t> bytes;
+        FILE* file = fopen(name, "rb");
+        if (file == nullptr)
+        {
+            return bytes;
+        }
+
+        fseek(file, 0, SEEK_END);
+        bytes.resize(ftell(file));
+        fseek(file, 0, SEEK_SET);
+        bytes.resize(fread(bytes.data(), 1, bytes.size(), file));
+        fclose(file);
+        return bytes;
+    }
+
+    int failures = 0;
+
+    void Expect(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            printf("FAIL  %s\n", what);
+            failures++;
+        }
+    }
+
+    // The Y, U and V planes a frame should be stored as.
+    std::vector<uint8_t> ExpectedPlanes(const MediaSinkFormat& format, const std::vector<uint8_t>& frame)
+    {
+        std::vector<uint8_t> nv12;
+        if (format.videoFormat == ImageFormat::BGRA)
+        {
+            nv12.resize((size_t)format.width * format.height * 3 / 2);
+            YUVConversion::ConvertBGRAtoNV12(frame.data(), nv12.data(), format.width, format.height);
+        }
+        else
+        {
+            nv12 = frame;
+        }
+
+        size_t lumaSize = (size_t)format.width * format.height;
+        size_t chromaSize = lumaSize / 4;
+        std::vector<uint8_t> planes(nv12.begin(), nv12.begin() + lumaSize);
+        planes.resize(lumaSize + 2 * chromaSize);
+        for (size_t i = 0; i < chromaSize; i++)
+        {
+            planes[lumaSize + i] = nv12[lumaSize + 2 * i];
+            planes[lumaSize + chromaSize + i] = nv12[lumaSize + 2 * i + 1];
+        }
+
+        return planes;
+    }
+
+    // Record a short clip with a missing frame, and check the files frame by frame and byte by byte.
+    void CheckRecording(ImageFormat videoFormat, const char* formatName)
+    {
+        char what[128];
+        const int frameCount = 12;
+        const int skippedFrame = 5;
+
+        MediaSinkFormat format = Format(320, 180, videoFormat);
+        std::vector<std::vector<uint8_t>> frames = SyntheticFrames(format, frameCount);
+        std::vector<std::vector<uint8_t>> audioBuffers;
+        for (int i = 0; i < 8; i++)
+        {
+            audioBuffers.push_back(AudioBuffer(i));
+        }
+
+        RawFileMediaSink sink;
+        MediaRecorder recorder(&sink);
+        snprintf(what, sizeof(what), "%s recording starts", formatName);
+        Expect(recorder.Start(recordingPath, format), what);
+
+        Record(recorder, frames, frameCount, { skippedFrame }, audioBuffers);
+        BoundedQueueStats stats = recorder.GetQueueStats();
+        recorder.Stop();
+
+        snprintf(what, sizeof(what), "%s recording drops nothing with the Block policy", formatName);
+        Expect(stats.dropped == 0 && !recorder.IsRecording(), what);
+
+        // The skipped frame is filled with the one after it, so the file still has a frame for every slot.
+        std::vector<uint8_t> video = ReadFile(videoFileName);
+        char header[128];
+        int headerLength = snprintf(header, sizeof(header), "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg XCOLORRANGE=LIMITED\n", format.width, format.height, fps);
+        size_t frameBytes = 6 + (size_t)format.width * format.height * 3 / 2;
+
+        snprintf(what, sizeof(what), "%s video has a header and %d frames", formatName, frameCount);
+        Expect(video.size() == headerLength + frameCount * frameBytes && memcmp(video.data(), header, headerLength) == 0
+            && sink.GetFramesWritten() == frameCount, what);
+
+        for (int frame = 0; frame < frameCount && video.size() == headerLength + frameCount * frameBytes; frame++)
+        {
+            int source = (frame == skippedFrame) ? frame + 1 : frame;
+            std::vector<uint8_t> expected = ExpectedPlanes(format, frames[source]);
+            const uint8_t* stored = video.data() + headerLength + frame * frameBytes;
+
+            snprintf(what, sizeof(what), "%s frame %d holds frame %d", formatName, frame, source);
+            Expect(memcmp(stored, "FRAME\n", 6) == 0 && memcmp(stored + 6, expected.data(), expected.size()) == 0, what);
+        }
+
+        // Audio is written in the order it was queued, after a header with the final sizes.
+        std::vector<uint8_t> audio = ReadFile(audioFileName);
+        int64_t audioBytes = sink.GetAudioBytesWritten();
+        snprintf(what, sizeof(what), "%s audio has a header and every buffer", formatName);
+        Expect(audioBytes > 0 && audioBytes % audioBufferSize == 0 && (int64_t)audio.size() == 44 + audioBytes
+            && memcmp(audio.data(), "RIFF", 4) == 0 && memcmp(audio.data() + 36, "data", 4) == 0
+            && (uint32_t)(audio[40] | audio[41] << 8 | audio[42] << 16 | audio[43] << 24) == (uint32_t)audioBytes, what);
+
+        for (int64_t buffer = 0; buffer < audioBytes / audioBufferSize && (int64_t)audio.size() == 44 + audioBytes; buffer++)
+        {
+            const std::vector<uint8_t>& expected = audioBuffers[buffer % audioBuffers.size()];
+            if (memcmp(audio.data() + 44 + buffer * audioBufferSize, expected.data(), audioBufferSize) != 0)
+            {
+                snprintf(what, sizeof(what), "%s audio buffer %d in order", formatName, (int)buffer);
+                Expect(false, what);
+                break;
+            }
+        }
+
+        remove(videoFileName);
+        remove(audioFileName);
+    }
+
+    // Frames queued faster than a slow sink takes them are dropped oldest first with DropOldest, and the producer
+    // waits with Block.
+    class SlowMediaSink : public DiscardMediaSink
+    {
+    public:
+        std::vector<uint8_t> writtenFrames;
+
+        virtual bool WriteVideo(MediaSinkBuffer* buffer, int64_t sampleTime, int64_t duration) override
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            writtenFrames.push_back(buffer->data[0]);
+            return DiscardMediaSink::WriteVideo(buffer, sampleTime, duration);
+        }
+    };
+
+    void CheckQueuePolicies()
+    {
+        MediaSinkFormat format = Format(64, 64, ImageFormat::NV12);
+        format.encodeAudio = false;
+        std::vector<std::vector<uint8_t>> frames = SyntheticFrames(format, 200);
+
+        for (QueueFullPolicy policy : { QueueFullPolicy::Block, QueueFullPolicy::DropOldest })
+        {
+            bool block = policy == QueueFullPolicy::Block;
+            SlowMediaSink sink;
+            MediaRecorder recorder(&sink);
+            recorder.SetQueuePolicy(policy, 4);
+            recorder.Start(recordingPath, format);
+            Record(recorder, frames, 200, {}, { AudioBuffer(0) });
+            recorder.Stop();
+
+            BoundedQueueStats stats = recorder.GetQueueStats();
+            bool ordered = std::is_sorted(sink.writtenFrames.begin(), sink.writtenFrames.end());
+            if (block)
+            {
+                Expect(sink.writtenFrames.size() == 200 && ordered && stats.dropped == 0 && stats.stalls > 0 && stats.peakDepth <= 4,
+                    "Block writes every frame in order, and stalls the producer");
+            }
+            else
+            {
+                Expect(sink.writtenFrames.size() + stats.dropped == 200 && stats.dropped > 0 && ordered && sink.writtenFrames.back() == 199,
+                    "DropOldest drops old frames, keeps the order and the newest frame");
+            }
+        }
+    }
+
+    struct Timing
+    {
+        double millisecondsPerFrame;
+        BoundedQueueStats stats;
+    };
+
+    Timing TimeRecording(IMediaSink& sink, const MediaSinkFormat& format, int frameCount)
+    {
+        std::vector<std::vector<uint8_t>> frames = SyntheticFrames(format, 4);
+        std::vector<std::vector<uint8_t>> audioBuffers = { AudioBuffer(0) };
+
+        MediaRecorder recorder(&sink);
+        recorder.Start(recordingPath, format);
+
+        // Until Stop returns, so frames still queued are timed too.
+        auto start = std::chrono::high_resolution_clock::now();
+        Record(recorder, frames, frameCount, {}, audioBuffers);
+        BoundedQueueStats stats = recorder.GetQueueStats();
+        recorder.Stop();
+        double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+        remove(videoFileName);
+        remove(audioFileName);
+        return { milliseconds / frameCount, stats };
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool verifyOnly = false;
+    int frameCount = 60;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--verify-only") == 0)
+        {
+            verifyOnly = true;
+        }
+        else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+        {
+            frameCount = std::max(1, atoi(argv[++i]));
+        }
+        else
+        {
+            printf("Usage: %s [--verify-only] [--frames N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    CheckRecording(ImageFormat::NV12, "NV12");
+    CheckRecording(ImageFormat::BGRA, "BGRA");
+    CheckQueuePolicies();
+
+    if (!verifyOnly)
+    {
+        printf("%-8s %-6s %-8s %10s %8s %6s %8s %10s\n", "sink", "size", "format", "ms/frame", "fps", "peak", "stalls", "stall ms");
+
+        for (const Resolution& resolution : resolutions)
+        {
+            for (ImageFormat videoFormat : { ImageFormat::NV12, ImageFormat::BGRA })
+            {
+                MediaSinkFormat format = Format(resolution.width, resolution.height, videoFormat);
+                const char* formatName = (videoFormat == ImageFormat::NV12) ? "NV12" : "BGRA";
+
+                DiscardMediaSink discardSink;
+                RawFileMediaSink fileSink;
+                IMediaSink* sinks[] = { &discardSink, &fileSink };
+                const char* sinkNames[] = { "discard", "y4m+wav" };
+
+                for (int i = 0; i < 2; i++)
+                {
+                    Timing timing = TimeRecording(*sinks[i], format, frameCount);
+                    printf("%-8s %-6s %-8s %10.3f %8.1f %6d %8llu %10.1f\n", sinkNames[i], resolution.name, formatName,
+                        timing.millisecondsPerFrame, 1000.0 / timing.millisecondsPerFrame, timing.stats.peakDepth,
+                        (unsigned long long)timing.stats.stalls, timing.stats.stallMilliseconds);
+                }
+            }
+        }
+    }
+
+    if (failures > 0)
+    {
+        printf("\n%d check(s) failed.\n", failures);
+        return 1;
+    }
+
+    printf("\nRecordings match the queued frames and audio.\n");
+    return 0;
+}
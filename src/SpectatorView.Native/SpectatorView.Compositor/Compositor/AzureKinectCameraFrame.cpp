@@ -6,124 +6,48 @@
 #if defined(INCLUDE_AZUREKINECT)
 #include "AzureKinectCameraFrame.h"
 
-AzureKinectCameraFrame::AzureKinectCameraFrame(bool captureDepth, bool captureBodyMask)
-    : _captureDepth(captureDepth)
-    , _captureBodyMask(captureBodyMask)
-    , _status(FrameStatus::Unused)
+AzureKinectCameraFrame::AzureKinectCameraFrame()
 {
-    _imageSizes[(int)AzureKinectImageType::Color] = FRAME_BUFSIZE_RGBA;
-    _imageSizes[(int)AzureKinectImageType::Depth] = FRAME_BUFSIZE_DEPTH16;
-    _imageSizes[(int)AzureKinectImageType::BodyMask] = FRAME_BUFSIZE_DEPTH16;
-
-    for (int i = 0; i < AZURE_KINECT_IMAGE_TYPE_COUNT; i++)
-    {
-        _images[i] = new uint8_t[_imageSizes[i]];
-    }
 }
 
 AzureKinectCameraFrame::~AzureKinectCameraFrame()
 {
     for (int i = 0; i < AZURE_KINECT_IMAGE_TYPE_COUNT; i++)
     {
-        delete[] _images[i];
-    }
-}
-
-void AzureKinectCameraFrame::StageImage(AzureKinectImageType imageType, k4a_image_t image)
-{
-    std::lock_guard<std::mutex> guard(_statusGuard);
-
-    if (_status == FrameStatus::WritingColorAndDepth || _status == FrameStatus::WritingBodyMask)
-    {
-        auto stride = k4a_image_get_stride_bytes(image);
-        auto buffer = k4a_image_get_buffer(image);
-        rsize_t height = k4a_image_get_height_pixels(image);
-
-        _imageStrides[(int)imageType] = stride;
-        memcpy_s(_images[(int)imageType], _imageSizes[(int)imageType], buffer, height * stride);
-    }
-}
-
-void AzureKinectCameraFrame::UpdateSRV(AzureKinectImageType imageType, ID3D11Device* device, ID3D11ShaderResourceView* targetView)
-{
-    std::lock_guard<std::mutex> guard(_statusGuard);
-
-    if (_status == FrameStatus::Reading)
-    {
-        if (targetView != nullptr)
+        if (_images[i] != nullptr)
         {
-            DirectXHelper::UpdateSRV(device, targetView, _images[(int)imageType], _imageStrides[(int)imageType]);
+            k4a_image_release(_images[i]);
         }
     }
 }
 
-bool AzureKinectCameraFrame::TryBeginWritingColorAndDepth()
-{
-    std::lock_guard<std::mutex> guard(_statusGuard);
-    if (_status == FrameStatus::WritingColorAndDepth)
-    {
-        return true;
-    }
-    else if (_status == FrameStatus::Unused || _status == FrameStatus::Staged)
-    {
-        _status = FrameStatus::WritingColorAndDepth;
-        return true;
-    }
-    else
-    {
-        return false;
-    }
-}
-
-void AzureKinectCameraFrame::EndWritingColorAndDepth()
+k4a_image_t AzureKinectCameraFrame::StageImage(AzureKinectImageType imageType, k4a_image_t image)
 {
-    std::lock_guard<std::mutex> guard(_statusGuard);
-    if (_status == FrameStatus::WritingColorAndDepth)
-    {
-        _status = FrameStatus::Staged;
-    }
-}
+    k4a_image_reference(image);
 
-void AzureKinectCameraFrame::BeginWritingBodyMask()
-{
-    std::lock_guard<std::mutex> guard(_statusGuard);
-    if (_status == FrameStatus::WritingColorAndDepth)
-    {
-        _status = FrameStatus::WritingBodyMask;
-    }
+    k4a_image_t previousImage = _images[(int)imageType];
+    _images[(int)imageType] = image;
+    return previousImage;
 }
 
-void AzureKinectCameraFrame::EndWritingBodyMask()
+k4a_image_t AzureKinectCameraFrame::TakeImage(AzureKinectImageType imageType)
 {
-    std::lock_guard<std::mutex> guard(_statusGuard);
-    if (_status == FrameStatus::WritingBodyMask)
-    {
-        _status = FrameStatus::Staged;
-    }
+    k4a_image_t image = _images[(int)imageType];
+    _images[(int)imageType] = nullptr;
+    return image;
 }
 
-bool AzureKinectCameraFrame::TryBeginReading()
+k4a_image_t AzureKinectCameraFrame::GetImage(AzureKinectImageType imageType) const
 {
-    std::lock_guard<std::mutex> guard(_statusGuard);
-
-    if (_status == FrameStatus::Staged)
-    {
-        _status = FrameStatus::Reading;
-        return true;
-    }
-    else
-    {
-        return false;
-    }
+    return _images[(int)imageType];
 }
 
-void AzureKinectCameraFrame::EndReading()
+void AzureKinectCameraFrame::UpdateSRV(AzureKinectImageType imageType, ID3D11Device* device, ID3D11ShaderResourceView* targetView) const
 {
-    std::lock_guard<std::mutex> guard(_statusGuard);
-
-    if (_status == FrameStatus::Reading)
+    k4a_image_t image = _images[(int)imageType];
+    if (targetView != nullptr && image != nullptr)
     {
-        _status = FrameStatus::Unused;
+        DirectXHelper::UpdateSRV(device, targetView, k4a_image_get_buffer(image), k4a_image_get_stride_bytes(image));
     }
 }
-#endif
\ No newline at end of file
+#endif
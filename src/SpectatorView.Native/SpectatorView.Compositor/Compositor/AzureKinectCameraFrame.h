@@ -18,57 +18,36 @@ enum class AzureKinectImageType
 // Represents a single frame from the AzureKinect camera,
 // bundling together the color image, the depth image, and
 // the body mask image for that frame.
+// Frames live in a FrameRing, which decides who may write and read them.
+// Images are held by reference rather than copied: the color image is the
+// one the camera captured, the depth and body mask images are created for
+// the frame and the depth to color transformation writes straight into them.
 class AzureKinectCameraFrame
 {
 public:
-    AzureKinectCameraFrame(bool captureDepth, bool captureBodyMask);
+    AzureKinectCameraFrame();
     ~AzureKinectCameraFrame();
 
-    void StageImage(AzureKinectImageType imageType, k4a_image_t image);
-    void UpdateSRV(AzureKinectImageType imageType, ID3D11Device* device, ID3D11ShaderResourceView* targetView);
+    // Hold a reference to image and return the image held before, which the
+    // caller now owns and must release.
+    k4a_image_t StageImage(AzureKinectImageType imageType, k4a_image_t image);
+    // Stop holding the image and return it, the caller now owns it and must release it.
+    k4a_image_t TakeImage(AzureKinectImageType imageType);
+    k4a_image_t GetImage(AzureKinectImageType imageType) const;
+    void UpdateSRV(AzureKinectImageType imageType, ID3D11Device* device, ID3D11ShaderResourceView* targetView) const;
 
-    bool TryBeginWritingColorAndDepth();
-    void EndWritingColorAndDepth();
-    void BeginWritingBodyMask();
-    void EndWritingBodyMask();
-    bool TryBeginReading();
-    void EndReading();
+    // The frame index the images belong to, so images replaced later can be kept while it is read.
+    int GetFrameIndex() const { return _frameIndex; }
+    void SetFrameIndex(int frameIndex) { _frameIndex = frameIndex; }
 
-private:
-    enum class FrameStatus
-    {
-        // Marks a frame that is currently unusued, and is ready to be written
-        // to by the camera.
-        Unused,
-
-        // Marks a frame that is currently in the process of having its color
-        // and depth images captured and staged.
-        WritingColorAndDepth,
-
-        // Marks a frame that is currently in the process of having its body
-        // mask captured and staged.
-        WritingBodyMask,
-
-        // Marks a frame that is fully-staged and ready to be read from.
-        // Staged frames can be overwritten when the reading thread is not
-        // consuming frames (e.g. if the Unity player is paused but the
-        // camera input is still pulling frames).
-        Staged,
+    // When the frame was captured, in QueryPerformanceCounter ticks.
+    LONGLONG GetTimestamp() const { return _timestamp; }
+    void SetTimestamp(LONGLONG timestamp) { _timestamp = timestamp; }
 
-        // Marks a frame that is currently being read from and will soon
-        // be released to the unused state.
-        Reading
-    };
-
-    uint8_t* _images[AZURE_KINECT_IMAGE_TYPE_COUNT] = { nullptr };
-    int _imageSizes[AZURE_KINECT_IMAGE_TYPE_COUNT] = { 0 };
-    int _imageStrides[AZURE_KINECT_IMAGE_TYPE_COUNT] = { 0 };
-
-    bool _captureDepth;
-    bool _captureBodyMask;
-
-    std::mutex _statusGuard;
-    FrameStatus _status;
+private:
+    k4a_image_t _images[AZURE_KINECT_IMAGE_TYPE_COUNT] = { nullptr };
+    int _frameIndex = 0;
+    LONGLONG _timestamp = 0;
 };
 
-#endif
\ No newline at end of file
+#endif
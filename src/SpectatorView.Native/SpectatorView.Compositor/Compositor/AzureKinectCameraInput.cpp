@@ -11,36 +11,40 @@
 #include <k4abt.h>
 #endif
 
-AzureKinectCameraInput::AzureKinectCameraInput(k4a_depth_mode_t depthMode, bool captureDepth, bool captureBodyMask)
+AzureKinectCameraInput::AzureKinectCameraInput(k4a_depth_mode_t depthMode, bool captureDepth, bool captureBodyMask, uint32_t deviceIndex)
     : _captureDepth(captureDepth)
     , _captureBodyMask(captureBodyMask)
     , _depthCameraMode(depthMode)
     , _calibration()
     , _k4aDevice(nullptr)
     , _transformation(nullptr)
-    , _transformedDepthImage(nullptr)
-    , _transformedBodyMaskImage(nullptr)
     , _bodyMaskImage(nullptr)
     , _stopRequested(false)
     , _currentFrameIndex(0)
+    , _lastUpdatedFrameIndex(0)
+    , _readingFrameIndex(0)
     , _detectMarkers(false)
     , _markerSize(0.0f)
     , _markerDictionaryName(cv::aruco::DICT_6X6_250)
     , _markerDetector(new ArUcoMarkerDetector())
     , _colorImageStride(0)
-    , _depthImageStride(0)
-    , _bodyMaskImageStride(0)
 #if defined(INCLUDE_AZUREKINECT_BODYTRACKING)
     , _currentBodyMaskFrameIndex(0)
+    , _pendingBodyMaskFrames(0)
     , _k4abtTracker(nullptr)
 #endif
 {
     for (int i = 0; i < MAX_NUM_CACHED_BUFFERS; i++)
     {
-        _cameraFrames[i] = new AzureKinectCameraFrame(captureDepth, captureBodyMask);
+        _cameraFrames.SlotAt(i) = new AzureKinectCameraFrame();
     }
 
-    if (K4A_RESULT_SUCCEEDED != k4a_device_open(K4A_DEVICE_DEFAULT, &_k4aDevice))
+    // Device timestamps are in microseconds.
+    LARGE_INTEGER qpcFrequency;
+    QueryPerformanceFrequency(&qpcFrequency);
+    _timestampClock.SetClockRates(1000000, qpcFrequency.QuadPart);
+
+    if (K4A_RESULT_SUCCEEDED != k4a_device_open(deviceIndex, &_k4aDevice))
     {
         OutputDebugString(L"Failed to open AzureKinect device");
         goto FailedExit;
@@ -66,8 +70,6 @@ AzureKinectCameraInput::AzureKinectCameraInput(k4a_depth_mode_t depthMode, bool
     if (captureDepth)
     {
         _transformation = k4a_transformation_create(&_calibration);
-        k4a_image_create(K4A_IMAGE_FORMAT_DEPTH16, _calibration.color_camera_calibration.resolution_width, _calibration.color_camera_calibration.resolution_height, 2 * _calibration.color_camera_calibration.resolution_width, &_transformedDepthImage);
-        _depthImageStride = k4a_image_get_stride_bytes(_transformedDepthImage);
 
 #if defined(INCLUDE_AZUREKINECT_BODYTRACKING)
         if (captureBodyMask)
@@ -81,8 +83,6 @@ AzureKinectCameraInput::AzureKinectCameraInput(k4a_depth_mode_t depthMode, bool
 
             // Create new depth texture for body depth only
             k4a_image_create(K4A_IMAGE_FORMAT_DEPTH16, _calibration.depth_camera_calibration.resolution_width, _calibration.depth_camera_calibration.resolution_height, 2 * _calibration.depth_camera_calibration.resolution_width, &_bodyMaskImage);
-            k4a_image_create(K4A_IMAGE_FORMAT_DEPTH16, _calibration.color_camera_calibration.resolution_width, _calibration.color_camera_calibration.resolution_height, 2 * _calibration.color_camera_calibration.resolution_width, &_transformedBodyMaskImage);
-            _bodyMaskImageStride = k4a_image_get_stride_bytes(_transformedBodyMaskImage);
         }
 #endif
 
@@ -109,6 +109,12 @@ FailedExit:
 AzureKinectCameraInput::~AzureKinectCameraInput()
 {
     _stopRequested = true;
+#if defined(INCLUDE_AZUREKINECT_BODYTRACKING)
+    {
+        std::lock_guard<std::mutex> lock(_bodyMaskLock);
+    }
+    _bodyMaskPublished.notify_all();
+#endif
 
     if (_thread != nullptr)
     {
@@ -128,17 +134,7 @@ AzureKinectCameraInput::~AzureKinectCameraInput()
         _bodyMaskImage = nullptr;
     }
 
-    if (_transformedBodyMaskImage != nullptr)
-    {
-        k4a_image_release(_transformedBodyMaskImage);
-        _transformedBodyMaskImage = nullptr;
-    }
-
-    if (_transformedDepthImage != nullptr)
-    {
-        k4a_image_release(_transformedDepthImage);
-        _transformedDepthImage = nullptr;
-    }
+    ReleaseRetiredImages(true);
 
     if (_k4aDevice != nullptr)
     {
@@ -157,23 +153,37 @@ AzureKinectCameraInput::~AzureKinectCameraInput()
 
     for (int i = 0; i < MAX_NUM_CACHED_BUFFERS; i++)
     {
-        delete _cameraFrames[i];
+        delete _cameraFrames.SlotAt(i);
     }
 }
 
 void AzureKinectCameraInput::RunCaptureLoop()
 {
+    ThreadRoleScope threadRole(ThreadRole::Capture);
+
     while (!_stopRequested)
     {
-        int frameIndex = _currentFrameIndex % MAX_NUM_CACHED_BUFFERS;
-        if (!_cameraFrames[frameIndex]->TryBeginWritingColorAndDepth())
+        ThreadRoles::Instance().Apply(ThreadRole::Capture);
+
+        int frameIndex = _currentFrameIndex + 1;
+#if defined(INCLUDE_AZUREKINECT_BODYTRACKING)
+        if (_cameraFrames.IsNextSlotWriting())
         {
-            // If the next frame in the buffer is still pending write or is being read from, then we've
-            // exceeded the capacity of the buffer and either the reader is blocking too long, or
-            // the body index processing thread has fallen behind.
+            // If the next frame in the buffer is still waiting for its body mask, then we've
+            // exceeded the capacity of the buffer and the body index processing thread has fallen behind.
+            // Sleep until it publishes a frame: spinning at this thread's priority would starve it.
             OutputDebugString(L"Warning: frame buffer is completely full, and we can't begin writing to the next frame");
+            std::unique_lock<std::mutex> lock(_bodyMaskLock);
+            _bodyMaskPublished.wait_for(lock, std::chrono::milliseconds(BODY_INDEX_WAIT_TIME_MILLISECONDS), [this]()
+            {
+                return _stopRequested || !_cameraFrames.IsNextSlotWriting();
+            });
             continue;
         }
+#endif
+
+        // The ring is only resized while no frame waits for its body mask, so frameIndex stays free.
+        ResizeCameraFrames();
 
         k4a_capture_t capture = nullptr;
 
@@ -187,72 +197,201 @@ void AzureKinectCameraInput::RunCaptureLoop()
             return;
         }
 
+        LARGE_INTEGER captureTime;
+        QueryPerformanceCounter(&captureTime);
+
         auto colorImage = k4a_capture_get_color_image(capture);
         if (colorImage != nullptr)
         {
+            // Readers of the frame this slot held before fail from here on, rather than reading a torn frame.
+            AzureKinectCameraFrame* cameraFrame = _cameraFrames.BeginWrite(frameIndex);
+            bool waitForBodyMask = false;
+
+            // The frame takes its own reference to the color image. The image it replaces belongs
+            // to the frame this slot held before, which may still be read by the output thread.
+            int replacedFrameIndex = cameraFrame->GetFrameIndex();
+            cameraFrame->SetFrameIndex(frameIndex);
+            // The device timestamp is taken when the camera exposes the image, so it has none of the jitter of
+            // k4a_device_get_capture returning.
+            cameraFrame->SetTimestamp(_timestampClock.AddSample((LONGLONG)k4a_image_get_device_timestamp_usec(colorImage), captureTime.QuadPart));
+
             _colorImageStride = k4a_image_get_stride_bytes(colorImage);
-            _cameraFrames[frameIndex]->StageImage(AzureKinectImageType::Color, colorImage);
+            RetireImage(replacedFrameIndex, cameraFrame->StageImage(AzureKinectImageType::Color, colorImage));
+            // The depth and body mask images are retired too, the output thread may still be copying them.
+            // CreateFrameImage gives the frame new ones to transform into.
+            RetireImage(replacedFrameIndex, cameraFrame->TakeImage(AzureKinectImageType::Depth));
+            RetireImage(replacedFrameIndex, cameraFrame->TakeImage(AzureKinectImageType::BodyMask));
             UpdateArUcoMarkers(colorImage);
 
             if (_captureDepth)
             {
                 auto depthImage = k4a_capture_get_depth_image(capture);
-                if (depthImage != nullptr)
+                if (depthImage != nullptr && CreateFrameImage(cameraFrame, AzureKinectImageType::Depth))
                 {
-                    k4a_transformation_depth_image_to_color_camera(_transformation, depthImage, _transformedDepthImage);
-                    _cameraFrames[frameIndex]->StageImage(AzureKinectImageType::Depth, _transformedDepthImage);
+                    k4a_transformation_depth_image_to_color_camera(_transformation, depthImage, cameraFrame->GetImage(AzureKinectImageType::Depth));
 
 #if defined(INCLUDE_AZUREKINECT_BODYTRACKING)
-                    if (_captureBodyMask)
+                    if (_captureBodyMask && CreateFrameImage(cameraFrame, AzureKinectImageType::BodyMask))
                     {
-                        // Move to the state of writing the body mask before enqueuing the capture.
-                        // This will put the frame in a state where it's waiting for the body mask
-                        // before entering the Staged state.
-                        _cameraFrames[frameIndex]->BeginWritingBodyMask();
+                        // The body index thread publishes the frame once the body mask is staged.
+                        _pendingBodyMaskFrames++;
                         k4a_wait_result_t queue_capture_result = k4abt_tracker_enqueue_capture(_k4abtTracker, capture, K4A_WAIT_INFINITE);
 
                         if (queue_capture_result == K4A_WAIT_RESULT_FAILED)
                         {
                             printf("Error: Adding capture to tracker process queue failed!\n");
-                            _cameraFrames[frameIndex]->EndWritingBodyMask();
+                            _pendingBodyMaskFrames--;
+                        }
+                        else
+                        {
+                            waitForBodyMask = true;
                         }
                     }
 #endif
+                }
 
+                if (depthImage != nullptr)
+                {
                     k4a_image_release(depthImage);
                 }
             }
             k4a_image_release(colorImage);
+
+            if (!waitForBodyMask)
+            {
+                _cameraFrames.Publish(frameIndex);
+            }
+
+            _currentFrameIndex = frameIndex;
         }
         k4a_capture_release(capture);
-
-        // End the writing state. If the state machine already transitioned
-        // to WritingBodyMask, this will have no effect. If the state machine
-        // is still in the WritingColorAndDepth state, it will move to the 
-        // Staged state to mark the frame as ready for reading.
-        _cameraFrames[frameIndex]->EndWritingColorAndDepth();
-        _currentFrameIndex++;
     }
 }
 
 bool AzureKinectCameraInput::UpdateSRVs(int frameIndex, ID3D11Device* device, ID3D11ShaderResourceView* colorSRV, ID3D11ShaderResourceView* depthSRV, ID3D11ShaderResourceView* bodySRV)
 {
-    int cameraFrameIndex = frameIndex % MAX_NUM_CACHED_BUFFERS;
-    if (!_cameraFrames[cameraFrameIndex]->TryBeginReading())
+    _ringDepth.ObserveLag(_cameraFrames.GetPublishedSequence(), frameIndex);
+
+    if (frameIndex == _lastUpdatedFrameIndex)
     {
-        // If the target frame is not ready to be read from yet because it's
-        // still being written to, or because we've already consumed that frame,
-        // then there's no need to update the target shader resource views again.
+        // There's no need to update the target shader resource views again.
         return false;
     }
 
-    _cameraFrames[cameraFrameIndex]->UpdateSRV(AzureKinectImageType::Color, device, colorSRV);
-    _cameraFrames[cameraFrameIndex]->UpdateSRV(AzureKinectImageType::Depth, device, depthSRV);
-    _cameraFrames[cameraFrameIndex]->UpdateSRV(AzureKinectImageType::BodyMask, device, bodySRV);
-    _cameraFrames[cameraFrameIndex]->EndReading();
+    // Announce the frame before reading it, so the capture thread keeps its retired images alive.
+    _readingFrameIndex = frameIndex;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    bool updated = _cameraFrames.Read(frameIndex, [&](AzureKinectCameraFrame* const& cameraFrame)
+    {
+        cameraFrame->UpdateSRV(AzureKinectImageType::Color, device, colorSRV);
+        cameraFrame->UpdateSRV(AzureKinectImageType::Depth, device, depthSRV);
+        cameraFrame->UpdateSRV(AzureKinectImageType::BodyMask, device, bodySRV);
+    });
+
+    _readingFrameIndex.store(0, std::memory_order_release);
+
+    // If the target frame is not published yet because it's still being written to,
+    // or it was overwritten while it was read, try again on the next update.
+    if (updated)
+    {
+        _lastUpdatedFrameIndex = frameIndex;
+    }
+
+    return updated;
+}
+
+void AzureKinectCameraInput::ResizeCameraFrames()
+{
+    int depth = _ringDepth.Update();
+    if (depth == _cameraFrames.GetDepth())
+    {
+        return;
+    }
+
+#if defined(INCLUDE_AZUREKINECT_BODYTRACKING)
+    if (_pendingBodyMaskFrames > 0)
+    {
+        // The body index thread still has to find its frames where they were written.
+        return;
+    }
+
+    // Frames the resize drops no longer read as published, so the body index thread must not skip over them.
+    _currentBodyMaskFrameIndex = _currentFrameIndex.load();
+#endif
+
+    _cameraFrames.SetDepth(depth);
+
+    // Images of dropped frames are retired like replaced ones, so one the output thread still reads stays alive.
+    for (int i = _cameraFrames.GetDepth(); i < MAX_NUM_CACHED_BUFFERS; i++)
+    {
+        AzureKinectCameraFrame* cameraFrame = _cameraFrames.SlotAt(i);
+        for (int imageType = 0; imageType < AZURE_KINECT_IMAGE_TYPE_COUNT; imageType++)
+        {
+            RetireImage(cameraFrame->GetFrameIndex(), cameraFrame->TakeImage((AzureKinectImageType)imageType));
+        }
+    }
+}
+
+bool AzureKinectCameraInput::CreateFrameImage(AzureKinectCameraFrame* cameraFrame, AzureKinectImageType imageType)
+{
+    // Depth and body index images are transformed into a color resolution image the frame owns.
+    // Its buffer comes from the frame buffer pool, and goes back to it when the image is released.
+    int width = _calibration.color_camera_calibration.resolution_width;
+    int height = _calibration.color_camera_calibration.resolution_height;
+    size_t size = 2 * width * height;
+    uint8_t* buffer = FrameBufferPool::Instance().Acquire(size);
+    if (buffer == nullptr)
+    {
+        return false;
+    }
+
+    k4a_image_t image = nullptr;
+    auto releaseBuffer = [](void* releasedBuffer, void* context) { FrameBufferPool::Instance().Release(releasedBuffer); };
+    if (K4A_RESULT_SUCCEEDED != k4a_image_create_from_buffer(K4A_IMAGE_FORMAT_DEPTH16, width, height, 2 * width, buffer, size, releaseBuffer, nullptr, &image))
+    {
+        FrameBufferPool::Instance().Release(buffer);
+        return false;
+    }
+
+    // The frame holds its own reference, so drop ours.
+    cameraFrame->StageImage(imageType, image);
+    k4a_image_release(image);
     return true;
 }
 
+void AzureKinectCameraInput::RetireImage(int frameIndex, k4a_image_t image)
+{
+    if (image != nullptr)
+    {
+        _retiredImages.push_back({ frameIndex, image });
+    }
+
+    ReleaseRetiredImages(false);
+}
+
+void AzureKinectCameraInput::ReleaseRetiredImages(bool releaseAll)
+{
+    // Pairs with the fence in UpdateSRVs: either the output thread sees its frame being
+    // written and skips it, or this sees the frame it announced and keeps its images.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int readingFrameIndex = _readingFrameIndex;
+
+    auto retiredImage = _retiredImages.begin();
+    while (retiredImage != _retiredImages.end())
+    {
+        if (releaseAll || retiredImage->frameIndex != readingFrameIndex)
+        {
+            k4a_image_release(retiredImage->image);
+            retiredImage = _retiredImages.erase(retiredImage);
+        }
+        else
+        {
+            retiredImage++;
+        }
+    }
+}
+
 void AzureKinectCameraInput::UpdateArUcoMarkers(k4a_image_t image)
 {
     std::lock_guard<std::mutex> lockGuard(_markerDetectorLock);
@@ -321,8 +460,12 @@ void AzureKinectCameraInput::GetCameraCalibrationInformation(CameraIntrinsics* c
 #if defined(INCLUDE_AZUREKINECT_BODYTRACKING)
 void AzureKinectCameraInput::RunBodyIndexLoop()
 {
+    ThreadRoleScope threadRole(ThreadRole::Detect);
+
     while (!_stopRequested)
     {
+        ThreadRoles::Instance().Apply(ThreadRole::Detect);
+
         k4abt_frame_t bodyFrame;
         k4a_wait_result_t pop_frame_result = k4abt_tracker_pop_result(_k4abtTracker, &bodyFrame, BODY_INDEX_WAIT_TIME_MILLISECONDS);
         if (pop_frame_result == K4A_WAIT_RESULT_SUCCEEDED)
@@ -341,20 +484,26 @@ void AzureKinectCameraInput::RunBodyIndexLoop()
             }
             ReleaseBodyIndexMap(bodyFrame, bodyIndexMap);
 
-            k4a_result_t result = k4a_transformation_depth_image_to_color_camera(_transformation, _bodyMaskImage, _transformedBodyMaskImage);
-
-            height = k4a_image_get_height_pixels(_transformedBodyMaskImage);
-            width = k4a_image_get_width_pixels(_transformedBodyMaskImage);
+            // Results arrive in the order captures were enqueued. Frames the tracker rejected were
+            // already published by the capture thread without a body mask, so skip over them.
+            int frameIndex = _currentBodyMaskFrameIndex + 1;
+            while (_cameraFrames.IsPublished(frameIndex))
+            {
+                frameIndex++;
+            }
 
-            bodyMaskBuffer = reinterpret_cast<uint16_t*>(k4a_image_get_buffer(_transformedBodyMaskImage));
+            // Transform the body mask straight into the frame's image, and then publish the frame for the output thread.
+            k4a_transformation_depth_image_to_color_camera(_transformation, _bodyMaskImage, _cameraFrames.Slot(frameIndex)->GetImage(AzureKinectImageType::BodyMask));
+            _cameraFrames.Publish(frameIndex);
 
-            // Stage the body mask image, and then end the WritingBodyMask state.
-            // This will transition the frame to the Staged state.
-            int frameIndex = _currentBodyMaskFrameIndex % MAX_NUM_CACHED_BUFFERS;
-            _cameraFrames[frameIndex]->StageImage(AzureKinectImageType::BodyMask, _transformedBodyMaskImage);
-            _cameraFrames[frameIndex]->EndWritingBodyMask();
+            _currentBodyMaskFrameIndex = frameIndex;
+            _pendingBodyMaskFrames--;
 
-            _currentBodyMaskFrameIndex++;
+            // Wake the capture thread if it waits for this slot. Taking the lock orders the notification after its check.
+            {
+                std::lock_guard<std::mutex> lock(_bodyMaskLock);
+            }
+            _bodyMaskPublished.notify_one();
         }
     }
 }
@@ -8,7 +8,16 @@
 
 #include "ArUcoMarkerDetector.h"
 #include "AzureKinectCameraFrame.h"
+#include "ClockDomain.h"
+#include "FrameBufferPool.h"
+#include "FrameRing.h"
+#include "RingDepth.h"
+#include "ThreadRoles.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
 #include <thread>
+#include <vector>
 #include <opencv2\aruco.hpp>
 #include <k4a/k4a.h>
 #if defined(INCLUDE_AZUREKINECT_BODYTRACKING)
@@ -17,27 +26,36 @@
 #define MAX_NUM_CACHED_BUFFERS 20
 #define BODY_INDEX_WAIT_TIME_MILLISECONDS 500
 // Reads and buffers input from the Azure Kinect camera into a circular buffer.
-// The input threads stage AzureKinectCameraFrames, which contain buffered copies
-// of the color, depth, and body index images for that frame.
-// The output thread calls UpdateSRVs to read staged frames and write the results
+// The input threads stage AzureKinectCameraFrames, which hold references to the
+// color, depth, and body index images for that frame.
+// The capture thread publishes frames without a body mask, the body index thread
+// publishes the others once their mask is staged.
+// The output thread calls UpdateSRVs to read published frames and write the results
 // into the SRVs used by the compositor.
 class AzureKinectCameraInput
 {
 public:
-    AzureKinectCameraInput(k4a_depth_mode_t depthMode, bool captureDepth, bool captureBodyMask);
+    // deviceIndex picks the camera when several are connected, in the order k4a_device_open counts them.
+    AzureKinectCameraInput(k4a_depth_mode_t depthMode, bool captureDepth, bool captureBodyMask, uint32_t deviceIndex = K4A_DEVICE_DEFAULT);
     ~AzureKinectCameraInput();
 
     int GetCaptureFrameIndex()
     {
-#if defined(INCLUDE_AZUREKINECT_BODYTRACKING)
-        if (_captureBodyMask)
-        {
-            return _currentBodyMaskFrameIndex;
-        }
-#endif
-        return _currentFrameIndex;
+        return _cameraFrames.GetPublishedSequence();
+    }
+    LONGLONG GetTimestamp(int frameIndex)
+    {
+        LONGLONG timestamp = 0;
+        _cameraFrames.Read(frameIndex, [&](const AzureKinectCameraFrame* cameraFrame) { timestamp = cameraFrame->GetTimestamp(); });
+        return timestamp;
     }
+    FrameBracket<LONGLONG> FindFramesAtTimestamp(LONGLONG timestamp)
+    {
+        return _cameraFrames.FindBracket(timestamp, [](const AzureKinectCameraFrame* cameraFrame) { return cameraFrame->GetTimestamp(); });
+    }
+    ClockDomainFit GetTimestampClockFit() { return _timestampClock.GetFit(); }
     void GetCameraCalibrationInformation(CameraIntrinsics* calibration);
+    void SetLatencyPreference(float latencyPreference) { _ringDepth.SetLatencyPreference(latencyPreference); }
     void StartArUcoMarkerDetector(cv::aruco::PREDEFINED_DICTIONARY_NAME markerDictionaryName, float markerSize);
     void StopArUcoMarkerDetector();
     int GetLatestArUcoMarkerCount() { return _markerDetector->GetDetectedMarkersCount(); }
@@ -48,6 +66,10 @@ public:
 private:
     void RunCaptureLoop();
     void UpdateArUcoMarkers(k4a_image_t image);
+    void RetireImage(int frameIndex, k4a_image_t image);
+    void ReleaseRetiredImages(bool releaseAll);
+    void ResizeCameraFrames();
+    bool CreateFrameImage(AzureKinectCameraFrame* cameraFrame, AzureKinectImageType imageType);
 
     std::atomic_bool _captureDepth;
     std::atomic_bool _captureBodyMask;
@@ -55,16 +77,32 @@ private:
     k4a_device_configuration_t _config = K4A_DEVICE_CONFIG_INIT_DISABLE_ALL;
     k4a_calibration_t _calibration;
     k4a_transformation_t _transformation;
-    k4a_image_t _transformedDepthImage;
-    k4a_image_t _transformedBodyMaskImage;
     k4a_image_t _bodyMaskImage;
     k4a_depth_mode_t _depthCameraMode = K4A_DEPTH_MODE_OFF;
 
-    AzureKinectCameraFrame* _cameraFrames[MAX_NUM_CACHED_BUFFERS];
+    FrameRing<AzureKinectCameraFrame*, MAX_NUM_CACHED_BUFFERS> _cameraFrames;
+    // Sizes _cameraFrames from the latency preference and how far the compositor trails capture.
+    // Frames get new depth and body mask images each time they are written, and release them once dropped.
+    RingDepthController _ringDepth { MAX_NUM_CACHED_BUFFERS };
+    // Only touched by the output thread.
+    int _lastUpdatedFrameIndex;
+
+    // Images replaced in a frame are retired rather than released, so the output thread
+    // never reads an image released under it. The output thread announces the frame it reads
+    // in _readingFrameIndex, 0 when it reads none, and retired images of that frame are kept
+    // until a later pass. _retiredImages is only touched by the capture thread.
+    struct RetiredImage
+    {
+        int frameIndex;
+        k4a_image_t image;
+    };
+    std::vector<RetiredImage> _retiredImages;
+    std::atomic_int32_t _readingFrameIndex;
 
     std::atomic_int _colorImageStride;
-    int _depthImageStride;
-    int _bodyMaskImageStride;
+
+    // Maps the device timestamps of color images to QueryPerformanceCounter, only fed by the capture thread.
+    ClockDomainMapper _timestampClock;
 
     std::shared_ptr<std::thread> _thread;
     std::atomic_bool _stopRequested;
@@ -87,6 +125,12 @@ private:
     k4abt_tracker_configuration_t _tracker_config = K4ABT_TRACKER_CONFIG_DEFAULT;
     std::shared_ptr<std::thread> _bodyIndexThread;
     std::atomic_int32_t _currentBodyMaskFrameIndex;
+    // Frames enqueued to the tracker that the body index thread has not published yet.
+    // The ring is only resized while this is 0, so both threads agree on where frames live.
+    std::atomic_int32_t _pendingBodyMaskFrames;
+    // Signaled by the body index thread each time it publishes a frame, for a capture thread that found the ring full.
+    std::mutex _bodyMaskLock;
+    std::condition_variable _bodyMaskPublished;
 #endif
 };
 #endif
\ No newline at end of file
@@ -10,11 +10,12 @@
 #include <k4abt.h>
 #endif
 
-AzureKinectFrameProvider::AzureKinectFrameProvider(ProviderType providerType)
+AzureKinectFrameProvider::AzureKinectFrameProvider(ProviderType providerType, int deviceIndex)
     : _colorSRV(nullptr)
     , _depthSRV(nullptr)
     , _bodySRV(nullptr)
     , _providerType(providerType)
+    , _deviceIndex(deviceIndex)
     , d3d11Device(nullptr)
     , cameraInput(nullptr)
 {
@@ -44,14 +45,30 @@ HRESULT AzureKinectFrameProvider::Initialize(ID3D11ShaderResourceView* colorSRV,
         break;
     }
 
-    cameraInput = std::make_shared<AzureKinectCameraInput>(depthCameraMode, _depthSRV != nullptr && depthCameraMode != K4A_DEPTH_MODE_OFF, _bodySRV != nullptr && depthCameraMode != K4A_DEPTH_MODE_OFF);
+    cameraInput = std::make_shared<AzureKinectCameraInput>(depthCameraMode, _depthSRV != nullptr && depthCameraMode != K4A_DEPTH_MODE_OFF, _bodySRV != nullptr && depthCameraMode != K4A_DEPTH_MODE_OFF, (uint32_t)_deviceIndex);
 
     return S_OK;
 }
 
 LONGLONG AzureKinectFrameProvider::GetTimestamp(int frame)
 {
-    return LONGLONG();
+    return cameraInput == nullptr ? 0 : cameraInput->GetTimestamp(frame);
+}
+
+FrameBracket<LONGLONG> AzureKinectFrameProvider::FindFramesAtTimestamp(LONGLONG timestamp)
+{
+    return cameraInput == nullptr ? FrameBracket<LONGLONG>() : cameraInput->FindFramesAtTimestamp(timestamp);
+}
+
+bool AzureKinectFrameProvider::GetTimestampClockFit(ClockDomainFit* fit)
+{
+    if (cameraInput == nullptr)
+    {
+        return false;
+    }
+
+    *fit = cameraInput->GetTimestampClockFit();
+    return true;
 }
 
 LONGLONG AzureKinectFrameProvider::GetDurationHNS()
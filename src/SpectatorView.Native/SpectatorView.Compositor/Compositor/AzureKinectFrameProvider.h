@@ -13,11 +13,13 @@ class AzureKinectFrameProvider : public IFrameProvider
 {
 public:
 
-    AzureKinectFrameProvider(ProviderType providerType);
+    AzureKinectFrameProvider(ProviderType providerType, int deviceIndex = 0);
 
     // Inherited via IFrameProvider
     virtual HRESULT Initialize(ID3D11ShaderResourceView* colorSRV, ID3D11ShaderResourceView* depthSRV, ID3D11ShaderResourceView* bodySRV, ID3D11Texture2D* outputTexture) override;
     virtual LONGLONG GetTimestamp(int frame) override;
+    virtual FrameBracket<LONGLONG> FindFramesAtTimestamp(LONGLONG timestamp) override;
+    virtual bool GetTimestampClockFit(ClockDomainFit* fit) override;
     virtual LONGLONG GetDurationHNS() override;
     virtual void Update(int compositeFrameIndex) override;
     virtual ProviderType GetProviderType() override { return _providerType; }
@@ -31,6 +33,14 @@ public:
         return cameraInput == nullptr ? 0 : cameraInput->GetCaptureFrameIndex();
     }
 
+    virtual void SetLatencyPreference(float latencyPreference) override
+    {
+        if (cameraInput != nullptr)
+        {
+            cameraInput->SetLatencyPreference(latencyPreference);
+        }
+    }
+
     virtual bool IsCameraCalibrationInformationAvailable() override
     {
         return true;
@@ -60,6 +70,7 @@ private:
     std::shared_ptr<AzureKinectCameraInput> cameraInput;
 
     ProviderType _providerType;
+    int _deviceIndex;
     ID3D11ShaderResourceView* _colorSRV;
     ID3D11ShaderResourceView* _depthSRV;
     ID3D11ShaderResourceView* _bodySRV;
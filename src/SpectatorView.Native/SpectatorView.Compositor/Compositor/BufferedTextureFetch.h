@@ -36,21 +36,22 @@ public:
         dataAvailable = true;
     }
 
+    // Copy dataSize * bpp bytes of the last prepared texture into a packed buffer.
     void FetchTextureData(ID3D11Device* device, BYTE* const & bytes, float bpp)
     {
-        if (!dataAvailable)
-            return;
-
-        ID3D11DeviceContext* d3d11DevCon;
-        device->GetImmediateContext(&d3d11DevCon);
-
-        D3D11_MAPPED_SUBRESOURCE  mapResource;
-        d3d11DevCon->Map(textures[textureIndex], 0, D3D11_MAP_READ, NULL, &mapResource);
-
-        memcpy(bytes, mapResource.pData, (size_t)(dataSize * bpp));
+        ReadMappedTexture(device, [&](const D3D11_MAPPED_SUBRESOURCE& mapResource)
+        {
+            DirectXHelper::CopyFromMappedStream(mapResource, texelRowBytes, 0, (size_t)(dataSize * bpp), bytes);
+        });
+    }
 
-        d3d11DevCon->Unmap(textures[textureIndex], 0);
-        dataAvailable = false;
+    // Copy the last prepared texture into every row of destination, which may be padded.
+    void FetchTextureData(ID3D11Device* device, const ImageView& destination)
+    {
+        ReadMappedTexture(device, [&](const D3D11_MAPPED_SUBRESOURCE& mapResource)
+        {
+            DirectXHelper::CopyFromMappedStream(mapResource, texelRowBytes, destination);
+        });
     }
 
     bool IsDataAvailable()
@@ -75,8 +76,29 @@ private:
     ID3D11Texture2D* textures[2];
     int textureIndex;
     size_t dataSize;
+    size_t texelRowBytes;
     bool dataAvailable;
 
+    template <typename Fn>
+    void ReadMappedTexture(ID3D11Device* device, const Fn& read)
+    {
+        if (!dataAvailable)
+            return;
+
+        ID3D11DeviceContext* d3d11DevCon;
+        device->GetImmediateContext(&d3d11DevCon);
+
+        D3D11_MAPPED_SUBRESOURCE  mapResource;
+        if (SUCCEEDED(d3d11DevCon->Map(textures[textureIndex], 0, D3D11_MAP_READ, NULL, &mapResource)))
+        {
+            read(mapResource);
+            d3d11DevCon->Unmap(textures[textureIndex], 0);
+        }
+
+        d3d11DevCon->Release();
+        dataAvailable = false;
+    }
+
     bool CreateTextureBuffers(ID3D11Device* device, ID3D11Texture2D* texture)
     {
         for (int i = 0; i < 2; i++)
@@ -102,6 +124,7 @@ private:
                 device->CreateTexture2D(&textureDesc, NULL, &textures[i]);
 
                 dataSize = (size_t)(textureDesc.Width * textureDesc.Height);
+                texelRowBytes = (size_t)textureDesc.Width * DirectXHelper::GetBytesPerTexel(textureDesc.Format);
             }
         }
         return (textures[0] != nullptr && textures[1] != nullptr);
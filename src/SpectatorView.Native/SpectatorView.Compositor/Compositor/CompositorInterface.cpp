@@ -22,7 +22,7 @@ void CompositorInterface::SetFrameProvider(IFrameProvider::ProviderType type)
     DisableOutputFrameProvider();
     if (frameProvider)
     {
-        if (frameProvider->GetProviderType() == type)
+        if (frameProvider->GetProviderType() == type && frameProviderDeviceIndex == captureDeviceIndex)
             return;
         frameProvider->Dispose();
         delete frameProvider;
@@ -36,17 +36,24 @@ void CompositorInterface::SetFrameProvider(IFrameProvider::ProviderType type)
 
 #if defined(INCLUDE_BLACKMAGIC)
     if (type == IFrameProvider::ProviderType::BlackMagic)
-        frameProvider = new DeckLinkManager();
+        frameProvider = new DeckLinkManager(false, false, captureDeviceIndex);
 #endif
 
 #if defined(INCLUDE_AZUREKINECT)
     if (type == IFrameProvider::ProviderType::AzureKinect_DepthCamera_Off)
-        frameProvider = new AzureKinectFrameProvider(IFrameProvider::ProviderType::AzureKinect_DepthCamera_Off);
+        frameProvider = new AzureKinectFrameProvider(IFrameProvider::ProviderType::AzureKinect_DepthCamera_Off, captureDeviceIndex);
     else if (type == IFrameProvider::ProviderType::AzureKinect_DepthCamera_NFOV)
-        frameProvider = new AzureKinectFrameProvider(IFrameProvider::ProviderType::AzureKinect_DepthCamera_NFOV);
+        frameProvider = new AzureKinectFrameProvider(IFrameProvider::ProviderType::AzureKinect_DepthCamera_NFOV, captureDeviceIndex);
     else if (type == IFrameProvider::ProviderType::AzureKinect_DepthCamera_WFOV)
-        frameProvider = new AzureKinectFrameProvider(IFrameProvider::ProviderType::AzureKinect_DepthCamera_WFOV);
+        frameProvider = new AzureKinectFrameProvider(IFrameProvider::ProviderType::AzureKinect_DepthCamera_WFOV, captureDeviceIndex);
 #endif
+
+    frameProviderDeviceIndex = captureDeviceIndex;
+}
+
+void CompositorInterface::SetCaptureDeviceIndex(int index)
+{
+    captureDeviceIndex = (std::max)(index, 0);
 }
 
 void CompositorInterface::SetOutputFrameProvider(IFrameProvider::ProviderType type)
@@ -62,7 +69,7 @@ void CompositorInterface::SetOutputFrameProvider(IFrameProvider::ProviderType ty
 
 #if defined (INCLUDE_BLACKMAGIC)
     if (type == IFrameProvider::ProviderType::BlackMagic)
-        outputFrameProvider = new DeckLinkManager();
+        outputFrameProvider = new DeckLinkManager(false, false, captureDeviceIndex);
 #endif
 }
 
@@ -224,14 +231,6 @@ void CompositorInterface::UpdateFrameProvider()
     }
 }
 
-void CompositorInterface::Update()
-{
-    if (activeVideoEncoder != nullptr)
-    {
-        activeVideoEncoder->Update();
-    }
-}
-
 void CompositorInterface::StopFrameProvider()
 {
     if (frameProvider != nullptr)
@@ -251,6 +250,37 @@ LONGLONG CompositorInterface::GetTimestamp(int frame)
     return INVALID_TIMESTAMP;
 }
 
+int CompositorInterface::GetFrameNearestTimestamp(LONGLONG timestamp, int* earlierFrame, int* laterFrame)
+{
+    FrameBracket<LONGLONG> bracket;
+    if (frameProvider != nullptr)
+    {
+        bracket = frameProvider->FindFramesAtTimestamp(timestamp);
+    }
+
+    if (earlierFrame != nullptr)
+    {
+        *earlierFrame = bracket.earlier;
+    }
+
+    if (laterFrame != nullptr)
+    {
+        *laterFrame = bracket.later;
+    }
+
+    return bracket.Nearest(timestamp);
+}
+
+bool CompositorInterface::GetTimestampClockFit(ClockDomainFit* fit)
+{
+    if (frameProvider != nullptr)
+    {
+        return frameProvider->GetTimestampClockFit(fit);
+    }
+
+    return false;
+}
+
 LONGLONG CompositorInterface::GetColorDuration()
 {
     if (frameProvider != nullptr)
@@ -306,6 +336,14 @@ void CompositorInterface::SetLatencyPreference(float latencyPreference)
     }
 }
 
+void CompositorInterface::SetDeinterlaceMode(DeinterlaceMode mode)
+{
+    if (frameProvider != nullptr)
+    {
+        frameProvider->SetDeinterlaceMode(mode);
+    }
+}
+
 void CompositorInterface::SetCompositeFrameIndex(int index)
 {
     compositeFrameIndex = index;
@@ -336,9 +374,42 @@ bool CompositorInterface::InitializeVideoEncoder(ID3D11Device* device)
     videoEncoder4K = new VideoEncoder(QUAD_FRAME_WIDTH, QUAD_FRAME_HEIGHT, QUAD_FRAME_WIDTH * FRAME_BPP_RGBA, VIDEO_FPS,
         AUDIO_SAMPLE_RATE, AUDIO_CHANNELS, AUDIO_BPS, VIDEO_BITRATE_4K, VIDEO_MPEG_LEVEL_4K);
 
+    videoEncoder1080p->SetQueuePolicy(encoderQueuePolicy, encoderQueueCapacity);
+    videoEncoder4K->SetQueuePolicy(encoderQueuePolicy, encoderQueueCapacity);
+
     return videoEncoder1080p->Initialize(device) && videoEncoder4K->Initialize(device);
 }
 
+void CompositorInterface::SetEncoderQueuePolicy(QueueFullPolicy policy, int capacity)
+{
+    std::unique_lock<std::shared_mutex> lock(encoderLock);
+    encoderQueuePolicy = policy;
+    encoderQueueCapacity = capacity;
+
+    if (videoEncoder1080p != nullptr)
+    {
+        videoEncoder1080p->SetQueuePolicy(policy, capacity);
+    }
+
+    if (videoEncoder4K != nullptr)
+    {
+        videoEncoder4K->SetQueuePolicy(policy, capacity);
+    }
+}
+
+bool CompositorInterface::GetEncoderQueueStats(BoundedQueueStats* stats)
+{
+    std::shared_lock<std::shared_mutex> lock(encoderLock);
+    if (activeVideoEncoder == nullptr)
+    {
+        *stats = {};
+        return false;
+    }
+
+    *stats = activeVideoEncoder->GetQueueStats();
+    return true;
+}
+
 bool CompositorInterface::StartRecording(VideoRecordingFrameLayout frameLayout, LPCWSTR lpcDesiredFileName, const int desiredFileNameLength, const int inputFileNameLength, LPWSTR lpFileName, int* fileNameLength)
 {
 	*fileNameLength = 0;
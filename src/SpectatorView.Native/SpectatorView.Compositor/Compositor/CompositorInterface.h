@@ -23,6 +23,8 @@ class CompositorInterface
 private:
     IFrameProvider* frameProvider;
     IFrameProvider* outputFrameProvider = nullptr;
+    int captureDeviceIndex = 0;
+    int frameProviderDeviceIndex = 0;
     float alpha = 0.9f;
 
     VideoEncoder* videoEncoder1080p = nullptr;
@@ -37,12 +39,18 @@ private:
 
     LONGLONG stubVideoTime = 0;
 
+    QueueFullPolicy encoderQueuePolicy = QueueFullPolicy::Block;
+    int encoderQueueCapacity = VideoEncoder::DefaultQueueCapacity;
+
 	// Audio write calls may occur off the main thread so we need to lock around encoder access.
 	std::shared_mutex encoderLock;
 
 public:
     DLLEXPORT CompositorInterface();
     DLLEXPORT void SetFrameProvider(IFrameProvider::ProviderType type);
+    // Which device of the provider type to capture from, when several are connected. Takes effect on the next
+    // SetFrameProvider, so each compositor can own a different camera.
+    DLLEXPORT void SetCaptureDeviceIndex(int index);
     DLLEXPORT void SetOutputFrameProvider(IFrameProvider::ProviderType type);
     DLLEXPORT void DisableOutputFrameProvider();
 	DLLEXPORT bool IsFrameProviderSupported(IFrameProvider::ProviderType providerType);
@@ -60,16 +68,21 @@ public:
     DLLEXPORT bool Initialize(ID3D11Device* device, ID3D11ShaderResourceView* colorSRV, ID3D11ShaderResourceView* depthSRV, ID3D11ShaderResourceView* bodySRV, ID3D11Texture2D* outputTexture);
 
     DLLEXPORT void UpdateFrameProvider();
-    DLLEXPORT void Update();
     DLLEXPORT void StopFrameProvider();
 
     DLLEXPORT LONGLONG GetTimestamp(int frame);
+    // The cached frame captured nearest to timestamp, on the clock of GetTimestamp, 0 if none is cached.
+    // earlierFrame and laterFrame, if not null, get the frames bracketing timestamp, 0 where there is none.
+    DLLEXPORT int GetFrameNearestTimestamp(LONGLONG timestamp, int* earlierFrame, int* laterFrame);
+    // False if the frame provider stamps frames with the host clock alone.
+    DLLEXPORT bool GetTimestampClockFit(ClockDomainFit* fit);
 
     DLLEXPORT LONGLONG GetColorDuration();
     DLLEXPORT int GetCaptureFrameIndex();
     DLLEXPORT int GetPixelChange(int frame);
     DLLEXPORT int GetNumQueuedOutputFrames();
     DLLEXPORT void SetLatencyPreference(float latencyPreference);
+    DLLEXPORT void SetDeinterlaceMode(DeinterlaceMode mode);
 
     DLLEXPORT void SetCompositeFrameIndex(int index);
 
@@ -78,6 +91,11 @@ public:
     DLLEXPORT bool InitializeVideoEncoder(ID3D11Device* device);
     DLLEXPORT bool StartRecording(VideoRecordingFrameLayout frameLayout, LPCWSTR lpcDesiredFileName, const int desiredFileNameLength, const int inputFileNameLength, LPWSTR lpFileName, int* fileNameLength);
     DLLEXPORT void StopRecording();
+
+    // How frames queue up for the encoder thread when it falls behind, capacity counts video frames and audio buffers.
+    DLLEXPORT void SetEncoderQueuePolicy(QueueFullPolicy policy, int capacity);
+    // The queue of the encoder that is recording, false if none is.
+    DLLEXPORT bool GetEncoderQueueStats(BoundedQueueStats* stats);
     
 	// frameTime is in hundred nano seconds
 	DLLEXPORT void RecordFrameAsync(BYTE* videoFrame, LONGLONG frameTime, int numFrames);
@@ -58,7 +58,11 @@ public:
     {
         enabled = false;
         started = false;
-        outputVideoFrames[0] = NULL;
+        framesQueued = 0;
+        for (int i = 0; i < MAX_NUM_OUTPUT_FRAMES; i++)
+        {
+            outputVideoFrames[i] = NULL;
+        }
     }
 
     void InitScaleAndDeltaFromDisplayMode(BMDDisplayMode videoDisplayMode)
@@ -323,7 +327,189 @@ private:
     IDeckLinkOutput * m_deckLinkOutput;
 };
 
-static OutputScheduler s_outputScheduler;
+// Hands the card page aligned capture buffers from a pool, so captured frames can be kept in the buffer cache and
+// uploaded straight from the buffer the card wrote, without a copy.
+// Buffers are at least FRAME_BUFSIZE_RGBA bytes, because the color texture is always uploaded with an RGBA pitch.
+// The render thread may still be uploading a frame when the capture callback lets go of it, so released buffers are
+// retired rather than handed out again, and only go back to the pool, or are freed if the display mode changed their
+// size, once RecycleRetiredBuffers is told no read of the buffer cache is running.
+class DeckLinkFrameAllocator : public IDeckLinkMemoryAllocator
+{
+public:
+    DeckLinkFrameAllocator()
+    {
+        InitializeCriticalSection(&m_poolCriticalSection);
+    }
+
+    virtual ~DeckLinkFrameAllocator()
+    {
+        for (auto& buffer : bufferSizes)
+        {
+            _aligned_free(buffer.first);
+        }
+
+        DeleteCriticalSection(&m_poolCriticalSection);
+    }
+
+    // Capture thread: take the buffers released since the last call out of use. Call this before checking that no
+    // read is running, so the check covers every buffer a later RecycleRetiredBuffers hands out again.
+    void RetireReleasedBuffers()
+    {
+        EnterCriticalSection(&m_poolCriticalSection);
+        retiredBuffers.insert(retiredBuffers.end(), releasedBuffers.begin(), releasedBuffers.end());
+        releasedBuffers.clear();
+        LeaveCriticalSection(&m_poolCriticalSection);
+    }
+
+    // Capture thread: no read started before the last RetireReleasedBuffers is still running, so the buffers it
+    // retired can be reused.
+    void RecycleRetiredBuffers()
+    {
+        EnterCriticalSection(&m_poolCriticalSection);
+        for (void* buffer : retiredBuffers)
+        {
+            PoolBuffer(buffer);
+        }
+
+        retiredBuffers.clear();
+        LeaveCriticalSection(&m_poolCriticalSection);
+    }
+
+    HRESULT STDMETHODCALLTYPE AllocateBuffer(unsigned int size, void** allocatedBuffer)
+    {
+        if (allocatedBuffer == NULL)
+        {
+            return E_POINTER;
+        }
+
+        EnterCriticalSection(&m_poolCriticalSection);
+
+        unsigned int requiredSize = (std::max)(size, (unsigned int)FRAME_BUFSIZE_RGBA);
+        if (requiredSize != bufferSize)
+        {
+            // The display mode changed, free the pooled buffers of the old size. Those still in use are freed once
+            // they are recycled.
+            bufferSize = requiredSize;
+            for (void* buffer : freeBuffers)
+            {
+                FreeBuffer(buffer);
+            }
+
+            freeBuffers.clear();
+        }
+
+        void* buffer = NULL;
+        if (!freeBuffers.empty())
+        {
+            buffer = freeBuffers.back();
+            freeBuffers.pop_back();
+        }
+        else
+        {
+            buffer = _aligned_malloc(bufferSize, BufferAlignment);
+            if (buffer != NULL)
+            {
+                bufferSizes[buffer] = bufferSize;
+            }
+        }
+
+        LeaveCriticalSection(&m_poolCriticalSection);
+
+        *allocatedBuffer = buffer;
+        return (buffer != NULL) ? S_OK : E_OUTOFMEMORY;
+    }
+
+    HRESULT STDMETHODCALLTYPE ReleaseBuffer(void* buffer)
+    {
+        EnterCriticalSection(&m_poolCriticalSection);
+
+        if (bufferSizes.find(buffer) != bufferSizes.end())
+        {
+            releasedBuffers.push_back(buffer);
+        }
+
+        LeaveCriticalSection(&m_poolCriticalSection);
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE Commit()
+    {
+        return S_OK;
+    }
+
+    // Buffers stay allocated until they are recycled at another size or the allocator is destroyed, see above.
+    HRESULT STDMETHODCALLTYPE Decommit()
+    {
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, LPVOID *ppv)
+    {
+        if (ppv == NULL)
+        {
+            return E_INVALIDARG;
+        }
+
+        if (iid == IID_IUnknown || iid == IID_IDeckLinkMemoryAllocator)
+        {
+            *ppv = (IDeckLinkMemoryAllocator*)this;
+            AddRef();
+            return S_OK;
+        }
+
+        *ppv = NULL;
+        return E_NOINTERFACE;
+    }
+
+    ULONG STDMETHODCALLTYPE AddRef()
+    {
+        return InterlockedIncrement(&m_refCount);
+    }
+
+    ULONG STDMETHODCALLTYPE Release()
+    {
+        ULONG newRefValue = InterlockedDecrement(&m_refCount);
+        if (newRefValue == 0)
+        {
+            delete this;
+        }
+
+        return newRefValue;
+    }
+
+private:
+    static const size_t BufferAlignment = 4096;
+
+    // Call these with m_poolCriticalSection held.
+    void PoolBuffer(void* buffer)
+    {
+        if (bufferSizes[buffer] == bufferSize)
+        {
+            freeBuffers.push_back(buffer);
+        }
+        else
+        {
+            FreeBuffer(buffer);
+        }
+    }
+
+    void FreeBuffer(void* buffer)
+    {
+        bufferSizes.erase(buffer);
+        _aligned_free(buffer);
+    }
+
+    ULONG m_refCount = 1;
+    CRITICAL_SECTION m_poolCriticalSection;
+    unsigned int bufferSize = 0;
+    std::vector<void*> freeBuffers;
+    // Released by the card since the last RetireReleasedBuffers.
+    std::vector<void*> releasedBuffers;
+    // Released, but possibly still read by the render thread.
+    std::vector<void*> retiredBuffers;
+    // Every buffer allocated and not freed yet, with its size.
+    std::map<void*, unsigned int> bufferSizes;
+};
 
 
 DeckLinkDevice::DeckLinkDevice(IDeckLink* device) :
@@ -332,13 +518,18 @@ DeckLinkDevice::DeckLinkDevice(IDeckLink* device) :
     m_deckLinkOutput(NULL),
     m_supportsFormatDetection(false),
     m_refCount(1),
-    m_currentlyCapturing(false)
+    m_currentlyCapturing(false),
+    outputScheduler(new OutputScheduler())
 {
 
     for (int i = 0; i < MAX_NUM_CACHED_BUFFERS; i++)
     {
-        bufferCache[i].buffer = new BYTE[FRAME_BUFSIZE_RGBA];
-        bufferCache[i].timeStamp = 0;
+        bufferCache.SlotAt(i).cacheBuffer = NULL;
+        bufferCache.SlotAt(i).buffer = NULL;
+        bufferCache.SlotAt(i).frame = NULL;
+        bufferCache.SlotAt(i).format = ImageFormat::UYVY;
+        bufferCache.SlotAt(i).timeStamp = 0;
+        bufferCache.SlotAt(i).pixelChange = 0;
     }
 
     if (m_deckLink != NULL)
@@ -346,6 +537,9 @@ DeckLinkDevice::DeckLinkDevice(IDeckLink* device) :
         m_deckLink->AddRef();
     }
 
+    QueryPerformanceFrequency(&qpcFrequency);
+    timestampClock.SetClockRates(QPC_MULTIPLIER, qpcFrequency.QuadPart);
+
     InitializeCriticalSection(&m_captureCardCriticalSection);
     InitializeCriticalSection(&m_outputCriticalSection);
 }
@@ -353,7 +547,14 @@ DeckLinkDevice::DeckLinkDevice(IDeckLink* device) :
 DeckLinkDevice::~DeckLinkDevice()
 {
     StopCapture();
-    s_outputScheduler.Clear();
+    outputScheduler->Clear();
+    delete outputScheduler;
+    outputScheduler = nullptr;
+
+    for (int i = 0; i < MAX_NUM_CACHED_BUFFERS; i++)
+    {
+        bufferCache.SlotAt(i).ReleaseFrame();
+    }
 
     if (m_deckLinkInput != NULL)
     {
@@ -367,6 +568,12 @@ DeckLinkDevice::~DeckLinkDevice()
         m_deckLinkOutput = NULL;
     }
 
+    if (frameAllocator != NULL)
+    {
+        frameAllocator->Release();
+        frameAllocator = NULL;
+    }
+
     if (m_deckLink != NULL)
     {
         m_deckLink->Release();
@@ -378,17 +585,28 @@ DeckLinkDevice::~DeckLinkDevice()
 
     for (int i = 0; i < MAX_NUM_CACHED_BUFFERS; i++)
     {
-        delete[] bufferCache[i].buffer;
+        FrameBufferPool::Instance().Release(bufferCache.SlotAt(i).cacheBuffer);
     }
 
-    delete[] stagingBuffer;
-    delete[] outputBuffer;
-    delete[] outputBufferRaw;
+    FrameBufferPool::Instance().Release(outputBuffer);
+    FrameBufferPool::Instance().Release(outputBufferRaw);
+    FrameBufferPool::Instance().Release(convertedBuffer);
 }
 
-DeckLinkDevice::BufferCache& DeckLinkDevice::GetOldestBuffer()
+// SDI and HDMI carry studio range YUV, SD modes use BT.601 and HD modes use BT.709.
+ColorMatrix DeckLinkDevice::GetColorMatrix(BMDDisplayMode videoDisplayMode)
 {
-    return bufferCache[(captureFrameIndex + 1) % MAX_NUM_CACHED_BUFFERS];
+    switch (videoDisplayMode)
+    {
+    case bmdModeNTSC:
+    case bmdModeNTSC2398:
+    case bmdModeNTSCp:
+    case bmdModePAL:
+    case bmdModePALp:
+        return ColorMatrix::BT601Limited;
+    default:
+        return ColorMatrix::BT709Limited;
+    }
 }
 
 
@@ -453,14 +671,21 @@ bool DeckLinkDevice::Init(ID3D11ShaderResourceView* colorSRV, ID3D11Texture2D* o
     IDeckLinkDisplayMode*           displayMode = NULL;
     BSTR                            deviceNameBSTR = NULL;
 
-    ZeroMemory(rawBuffer, FRAME_BUFSIZE_YUV);
     ZeroMemory(outputBuffer, FRAME_BUFSIZE_RGBA);
     ZeroMemory(outputBufferRaw, FRAME_BUFSIZE_YUV);
 
     for (int i = 0; i < MAX_NUM_CACHED_BUFFERS; i++)
-        ZeroMemory(bufferCache[i].buffer, FRAME_BUFSIZE_RGBA);
+    {
+        bufferCache.SlotAt(i).ReleaseFrame();
+        if (bufferCache.SlotAt(i).cacheBuffer != NULL)
+        {
+            ZeroMemory(bufferCache.SlotAt(i).cacheBuffer, FRAME_BUFSIZE_RGBA);
+        }
+    }
 
+    bufferCache.Reset();
     captureFrameIndex = 0;
+    convertedFrameIndex = 0;
 
     _useCPU = useCPU;
     _passthroughOutput = passthroughOutput;
@@ -475,6 +700,18 @@ bool DeckLinkDevice::Init(ID3D11ShaderResourceView* colorSRV, ID3D11Texture2D* o
         // Get input interface
         if (m_deckLink->QueryInterface(IID_IDeckLinkInput, (void**)&m_deckLinkInput) != S_OK)
             return false;
+
+        // Capture into our own buffers, so frames can be kept in the buffer cache instead of copied.
+        if (frameAllocator == NULL)
+        {
+            frameAllocator = new DeckLinkFrameAllocator();
+            if (m_deckLinkInput->SetVideoInputFrameMemoryAllocator(frameAllocator) != S_OK)
+            {
+                OutputDebugString(L"Unable to set the capture buffer allocator, frames will be copied.\n");
+                frameAllocator->Release();
+                frameAllocator = NULL;
+            }
+        }
     }
     else if (outputTexture != nullptr)
     {
@@ -502,6 +739,38 @@ bool DeckLinkDevice::Init(ID3D11ShaderResourceView* colorSRV, ID3D11Texture2D* o
     return true;
 }
 
+BMDPixelFormat DeckLinkDevice::GetYUVInputFormat(BMDDisplayMode videoDisplayMode)
+{
+#if CAPTURE_10BIT_YUV
+    // 10 bit frames are decoded to BGRA on capture, which only the CPU upload takes. The shader that decodes on the
+    // GPU only reads 8 bit UYVY.
+    BMDDisplayModeSupport support = bmdDisplayModeNotSupported;
+    if (_useCPU && m_deckLinkInput->DoesSupportVideoMode(videoDisplayMode, bmdFormat10BitYUV, bmdVideoInputFlagDefault, &support, NULL) == S_OK
+        && support == bmdDisplayModeSupported)
+    {
+        return bmdFormat10BitYUV;
+    }
+#else
+    (void)videoDisplayMode;
+#endif
+
+    return bmdFormat8BitYUV;
+}
+
+BMDFieldDominance DeckLinkDevice::GetFieldDominance(BMDDisplayMode videoDisplayMode)
+{
+    BMDFieldDominance dominance = bmdProgressiveFrame;
+    BMDDisplayModeSupport support = bmdDisplayModeNotSupported;
+    IDeckLinkDisplayMode* displayMode = NULL;
+    if (m_deckLinkInput->DoesSupportVideoMode(videoDisplayMode, bmdFormat8BitYUV, bmdVideoInputFlagDefault, &support, &displayMode) == S_OK && displayMode != NULL)
+    {
+        dominance = displayMode->GetFieldDominance();
+        displayMode->Release();
+    }
+
+    return dominance;
+}
+
 bool DeckLinkDevice::StartCapture(BMDDisplayMode videoDisplayMode)
 {
     if (m_deckLinkInput == NULL)
@@ -518,11 +787,14 @@ bool DeckLinkDevice::StartCapture(BMDDisplayMode videoDisplayMode)
         videoInputFlags |= bmdVideoInputEnableFormatDetection;
     }
 
+    colorMatrix = GetColorMatrix(videoDisplayMode);
+    fieldDominance = GetFieldDominance(videoDisplayMode);
+
     // Set capture callback
     m_deckLinkInput->SetCallback(this);
 
     // Set the video input mode
-    if (m_deckLinkInput->EnableVideoInput(videoDisplayMode, bmdFormat8BitYUV, videoInputFlags) != S_OK)
+    if (m_deckLinkInput->EnableVideoInput(videoDisplayMode, GetYUVInputFormat(videoDisplayMode), videoInputFlags) != S_OK)
     {
         OutputDebugString(L"Unable to set the chosen video mode.\n");
         return false;
@@ -542,11 +814,11 @@ bool DeckLinkDevice::StartCapture(BMDDisplayMode videoDisplayMode)
 
 void DeckLinkDevice::SetupVideoOutputFrame(BMDDisplayMode videoDisplayMode)
 {
-    s_outputScheduler.Clear();
+    outputScheduler->Clear();
 
     if (supportsOutput)
     {
-        if(!s_outputScheduler.Init(m_deckLinkOutput, videoDisplayMode, (pixelFormat == PixelFormat::YUV) ? BMDPixelFormat::bmdFormat8BitYUV : BMDPixelFormat::bmdFormat8BitBGRA))
+        if(!outputScheduler->Init(m_deckLinkOutput, videoDisplayMode, (pixelFormat == PixelFormat::YUV) ? BMDPixelFormat::bmdFormat8BitYUV : BMDPixelFormat::bmdFormat8BitBGRA))
             supportsOutput = false;
     }
 }
@@ -609,7 +881,9 @@ HRESULT DeckLinkDevice::VideoInputFormatChanged(/* in */ BMDVideoInputFormatChan
     }
 
     pixelFormat = PixelFormat::YUV;
-    BMDPixelFormat bmdPixelFormat = bmdFormat8BitYUV;
+    BMDPixelFormat bmdPixelFormat = GetYUVInputFormat(newMode->GetDisplayMode());
+    colorMatrix = GetColorMatrix(newMode->GetDisplayMode());
+    fieldDominance = newMode->GetFieldDominance();
 
     if ((detectedSignalFlags & bmdDetectedVideoInputRGB444) != 0)
     {
@@ -666,6 +940,9 @@ HRESULT DeckLinkDevice::VideoInputFrameArrived(/* in */ IDeckLinkVideoInputFrame
     LARGE_INTEGER time;
     QueryPerformanceCounter(&time);
 
+    // This runs on a thread of the driver, which keeps the capture settings from its first frame on.
+    ThreadRoles::Instance().Apply(ThreadRole::Capture);
+
     if (frame == nullptr)
     {
         return S_OK;
@@ -673,54 +950,82 @@ HRESULT DeckLinkDevice::VideoInputFrameArrived(/* in */ IDeckLinkVideoInputFrame
 
     BMDPixelFormat framePixelFormat = frame->GetPixelFormat();
 
-    EnterCriticalSection(&m_captureCardCriticalSection);
+    // Format changes arrive on this same thread, and readers go through bufferCache, so nothing here needs a lock.
+    int previousCaptureFrameIndex = captureFrameIndex;
+    ResizeBufferCache();
 
     //TODO: Create conversion to RGBA for any other pixel format your camera outputs at.
     if (framePixelFormat == BMDPixelFormat::bmdFormat8BitYUV)
     {
         if (frame->GetBytes((void**)&rawBuffer) == S_OK)
         {
-            captureFrameIndex++;
-            BYTE* buffer = bufferCache[captureFrameIndex % MAX_NUM_CACHED_BUFFERS].buffer;
-            // Always return the latest buffer when using the CPU.
-            if (_useCPU)
+            BufferCache& cache = BeginWriteFrame();
+            cache.format = ImageFormat::UYVY;
+            if (CanHoldFrame(frame, FRAME_BPP_YUV))
             {
-                DirectXHelper::ConvertYUVtoBGRA(rawBuffer, buffer, FRAME_WIDTH, FRAME_HEIGHT, true);
+                cache.HoldFrame(frame, rawBuffer);
             }
             else
             {
-                memcpy(buffer, rawBuffer, FRAME_BUFSIZE_YUV);
+                ImageView::Copy(ImageView(rawBuffer, FRAME_WIDTH, FRAME_HEIGHT, ImageFormat::UYVY, (int)frame->GetRowBytes()), ImageView(cache.buffer, FRAME_WIDTH, FRAME_HEIGHT, ImageFormat::UYVY));
             }
         }
     }
+    else if (framePixelFormat == BMDPixelFormat::bmdFormat10BitYUV)
+    {
+        if (frame->GetBytes((void**)&localFrameBuffer) == S_OK)
+        {
+            BufferCache& cache = BeginWriteFrame();
+            cache.format = ImageFormat::BGRA;
+            ImageView frameView(localFrameBuffer, FRAME_WIDTH, FRAME_HEIGHT, ImageFormat::V210, (int)frame->GetRowBytes());
+            // Decode the color from all 10 bits now, while they are still there. The rest of the pipeline is 8 bit.
+            PixelConversion::Convert(frameView, ImageView(cache.buffer, FRAME_WIDTH, FRAME_HEIGHT, ImageFormat::BGRA), colorMatrix, AlphaPolicy::Opaque);
+        }
+    }
     else if (framePixelFormat == BMDPixelFormat::bmdFormat8BitBGRA)
     {
         if (frame->GetBytes((void**)&localFrameBuffer) == S_OK)
         {
-            captureFrameIndex++;
-            BYTE* buffer = bufferCache[captureFrameIndex % MAX_NUM_CACHED_BUFFERS].buffer;
-            if (_useCPU)
+            BufferCache& cache = BeginWriteFrame();
+            cache.format = ImageFormat::BGRA;
+            if (CanHoldFrame(frame, FRAME_BPP_RGBA))
             {
-                //TODO: Remove this block if R and B components are swapped in color feed.
-                memcpy(stagingBuffer, localFrameBuffer, FRAME_BUFSIZE_RGBA);
-                DirectXHelper::ConvertBGRAtoRGBA(stagingBuffer, FRAME_WIDTH, FRAME_HEIGHT, true);
-                // Do not cache frames when using the CPU
-                memcpy(buffer, stagingBuffer, FRAME_BUFSIZE_RGBA);
+                cache.HoldFrame(frame, localFrameBuffer);
             }
             else
             {
-                memcpy(buffer, localFrameBuffer, FRAME_BUFSIZE_RGBA);
+                ImageView::Copy(ImageView(localFrameBuffer, FRAME_WIDTH, FRAME_HEIGHT, ImageFormat::BGRA, (int)frame->GetRowBytes()), ImageView(cache.buffer, FRAME_WIDTH, FRAME_HEIGHT, ImageFormat::BGRA));
             }
         }
     }
 
-    bufferCache[captureFrameIndex % MAX_NUM_CACHED_BUFFERS].ComputePixelChange(bufferCache[(captureFrameIndex-1) % MAX_NUM_CACHED_BUFFERS].buffer, framePixelFormat);
-
     LONGLONG t;
     frame->GetStreamTime(&t, &frameDuration, QPC_MULTIPLIER);
 
-    // Get frame time.
-    bufferCache[captureFrameIndex % MAX_NUM_CACHED_BUFFERS].timeStamp = time.QuadPart;
+    // The card stamps the frame with its hardware reference clock when it arrives, which is free of the jitter of this
+    // callback. Fall back to the callback time if it has no such timestamp.
+    LONGLONG captureTime = time.QuadPart;
+    BMDTimeValue hardwareTime, hardwareDuration;
+    if (frame->GetHardwareReferenceTimestamp(QPC_MULTIPLIER, &hardwareTime, &hardwareDuration) == S_OK)
+    {
+        captureTime = timestampClock.AddSample(hardwareTime, time.QuadPart);
+    }
+
+    if (captureFrameIndex != previousCaptureFrameIndex)
+    {
+        DeinterlaceCapturedFrame(bufferCache.Slot(captureFrameIndex).format, captureTime);
+
+        BufferCache& cache = bufferCache.Slot(captureFrameIndex);
+        cache.ComputePixelChange(GetCapturedBuffer(captureFrameIndex - 1));
+
+        cache.timeStamp = captureTime;
+
+        // Bob deinterlacing writes two frames per callback.
+        for (int sequence = previousCaptureFrameIndex + 1; sequence <= captureFrameIndex; sequence++)
+        {
+            bufferCache.Publish(sequence);
+        }
+    }
 
     if (supportsOutput && m_deckLinkOutput != NULL)
     {
@@ -733,30 +1038,196 @@ HRESULT DeckLinkDevice::VideoInputFrameArrived(/* in */ IDeckLinkVideoInputFrame
         }
     }
 
-    LeaveCriticalSection(&m_captureCardCriticalSection);
-
     return S_OK;
 }
 
+void DeckLinkDevice::DeinterlaceCapturedFrame(ImageFormat cacheFormat, LONGLONG captureTime)
+{
+    DeinterlaceMode mode = deinterlaceMode;
+    if ((fieldDominance != bmdUpperFieldFirst && fieldDominance != bmdLowerFieldFirst) || mode == DeinterlaceMode::Weave)
+    {
+        return;
+    }
+
+    // Field 0 holds the even rows, which are the upper field.
+    int firstField = (fieldDominance == bmdUpperFieldFirst) ? 0 : 1;
+    BufferCache& firstFrame = bufferCache.Slot(captureFrameIndex);
+    ImageView captured(firstFrame.buffer, FRAME_WIDTH, FRAME_HEIGHT, cacheFormat);
+
+    // A held frame is also what passthrough sends to the output, so it is deinterlaced into cacheBuffer rather than
+    // in place, and let go once its bytes are no longer needed.
+    bool held = (firstFrame.frame != NULL);
+    ImageView deinterlaced(firstFrame.cacheBuffer, FRAME_WIDTH, FRAME_HEIGHT, cacheFormat);
+
+    if (mode == DeinterlaceMode::MotionAdaptive)
+    {
+        if (held)
+        {
+            ImageView::Copy(captured, deinterlaced);
+            firstFrame.ReleaseFrame();
+        }
+
+        // Without the previous frame there is no motion to measure, so interpolate the whole field.
+        BYTE* previousBuffer = GetCapturedBuffer(captureFrameIndex - 1);
+        if (previousBuffer != NULL)
+        {
+            Deinterlacing::MotionAdaptive(deinterlaced, ImageView(previousBuffer, FRAME_WIDTH, FRAME_HEIGHT, cacheFormat), 1 - firstField);
+        }
+        else
+        {
+            Deinterlacing::Bob(deinterlaced, deinterlaced, 1 - firstField);
+        }
+        return;
+    }
+
+    // Bob: the second field goes to the next buffer before the first field is rebuilt, which overwrites it unless held.
+    BufferCache& secondFrame = BeginWriteFrame();
+    secondFrame.format = cacheFormat;
+    Deinterlacing::Bob(captured, ImageView(secondFrame.buffer, FRAME_WIDTH, FRAME_HEIGHT, cacheFormat), 1 - firstField);
+    Deinterlacing::Bob(captured, deinterlaced, firstField);
+    if (held)
+    {
+        firstFrame.ReleaseFrame();
+    }
+
+    // Each field becomes a frame of its own, the first was captured half a frame before the callback.
+    frameDuration /= 2;
+    firstFrame.timeStamp = captureTime - frameDuration * qpcFrequency.QuadPart / QPC_MULTIPLIER;
+    firstFrame.ComputePixelChange(GetCapturedBuffer(captureFrameIndex - 2));
+}
+
+DeckLinkDevice::BufferCache& DeckLinkDevice::BeginWriteFrame()
+{
+    captureFrameIndex++;
+    BufferCache& cache = bufferCache.BeginWrite(captureFrameIndex);
+    if (cache.cacheBuffer == NULL)
+    {
+        cache.cacheBuffer = FrameBufferPool::Instance().Acquire(FRAME_BUFSIZE_RGBA);
+        ZeroMemory(cache.cacheBuffer, FRAME_BUFSIZE_RGBA);
+    }
+
+    cache.ReleaseFrame();
+    return cache;
+}
+
+void DeckLinkDevice::ResizeBufferCache()
+{
+    int depth = ringDepth.Update();
+    if (depth != bufferCache.GetDepth())
+    {
+        bufferCache.SetDepth(depth);
+        releaseRetiredBuffers = true;
+    }
+
+    if (frameAllocator != NULL)
+    {
+        frameAllocator->RetireReleasedBuffers();
+    }
+
+    // The render thread may still be uploading from an entry it started reading before the resize, or from a frame
+    // the card has released since.
+    if (!bufferCache.IsQuiescent())
+    {
+        return;
+    }
+
+    if (frameAllocator != NULL)
+    {
+        frameAllocator->RecycleRetiredBuffers();
+    }
+
+    if (releaseRetiredBuffers)
+    {
+        for (int i = bufferCache.GetDepth(); i < MAX_NUM_CACHED_BUFFERS; i++)
+        {
+            BufferCache& cache = bufferCache.SlotAt(i);
+            cache.ReleaseFrame();
+            FrameBufferPool::Instance().Release(cache.cacheBuffer);
+            cache.cacheBuffer = NULL;
+            cache.buffer = NULL;
+        }
+
+        releaseRetiredBuffers = false;
+    }
+}
+
+BYTE* DeckLinkDevice::GetCapturedBuffer(int sequence)
+{
+    // Frames written in this callback are not published yet. Older ones may have been overwritten or dropped by a resize.
+    if (sequence > 0 && (bufferCache.IsPublished(sequence) || bufferCache.IsWriting(sequence)))
+    {
+        return bufferCache.Slot(sequence).buffer;
+    }
+
+    return NULL;
+}
+
+bool DeckLinkDevice::CanHoldFrame(IDeckLinkVideoInputFrame* frame, int bytesPerPixel)
+{
+    // The buffer cache is read with tightly packed rows.
+    return frameAllocator != NULL && frame->GetRowBytes() == FRAME_WIDTH * bytesPerPixel;
+}
+
+bool DeckLinkDevice::UploadFrame(int frameIndex)
+{
+    if (!_useCPU)
+    {
+        return bufferCache.Read(frameIndex, [&](const BufferCache& cache)
+        {
+            DirectXHelper::UpdateSRV(device, _colorSRV, cache.buffer, FRAME_WIDTH * FRAME_BPP_RGBA);
+        });
+    }
+
+    // Only the frame that is consumed is converted, and only once however often it is uploaded.
+    if (frameIndex != convertedFrameIndex)
+    {
+        convertedFrameIndex = 0;
+        bool converted = bufferCache.Read(frameIndex, [&](const BufferCache& cache)
+        {
+            //TODO: Use BGRA as the target format if R and B components are swapped in color feed.
+            PixelConversion::Convert(ImageView(cache.buffer, FRAME_WIDTH, FRAME_HEIGHT, cache.format), ImageView(convertedBuffer, FRAME_WIDTH, FRAME_HEIGHT, ImageFormat::RGBA), colorMatrix, AlphaPolicy::Opaque);
+        });
+
+        if (!converted)
+        {
+            return false;
+        }
+
+        convertedFrameIndex = frameIndex;
+    }
+
+    DirectXHelper::UpdateSRV(device, _colorSRV, convertedBuffer, FRAME_WIDTH * FRAME_BPP_RGBA);
+    return true;
+}
+
 int DeckLinkDevice::GetNumQueuedOutputFrames()
 {
-    return s_outputScheduler.framesQueued;
+    return outputScheduler->framesQueued;
 }
 
 void DeckLinkDevice::SetLatencyPreference(float latencyPreference)
 {
-    s_outputScheduler.SetLatencyPreference(latencyPreference);
+    outputScheduler->SetLatencyPreference(latencyPreference);
+    ringDepth.SetLatencyPreference(latencyPreference);
+}
+
+void DeckLinkDevice::SetDeinterlaceMode(DeinterlaceMode mode)
+{
+    deinterlaceMode = mode;
 }
 
 void DeckLinkDevice::Update(int compositeFrameIndex)
 {
+    ringDepth.ObserveLag(bufferCache.GetPublishedSequence(), compositeFrameIndex);
+
     if (_colorSRV != nullptr &&
         device != nullptr)
     {
-        const BufferCache& buffer = bufferCache[compositeFrameIndex % MAX_NUM_CACHED_BUFFERS];
-        if (buffer.buffer != nullptr)
+        // If the frame is not available or was overwritten during the upload, show the newest one instead,
+        // which is a whole ring ahead of the capture callback.
+        if (!UploadFrame(compositeFrameIndex))
         {
-            DirectXHelper::UpdateSRV(device, _colorSRV, buffer.buffer, FRAME_WIDTH * FRAME_BPP_RGBA);
+            UploadFrame(bufferCache.GetPublishedSequence());
         }
     }
 
@@ -764,26 +1235,22 @@ void DeckLinkDevice::Update(int compositeFrameIndex)
     {
         lastCompositorFrameIndex = compositeFrameIndex;
         //Output to video recording screen
-        if (supportsOutput && device != nullptr && _outputTexture != nullptr && s_outputScheduler.enabled)
+        if (supportsOutput && device != nullptr && _outputTexture != nullptr && outputScheduler->enabled)
         {
             unsigned char* outBytes = NULL;
             EnterCriticalSection(&m_outputCriticalSection);
 
             if (outputTextureBuffer.IsDataAvailable())
             {
-                IDeckLinkMutableVideoFrame* videoFrame = s_outputScheduler.GetAvailableVideoFrame();
+                IDeckLinkMutableVideoFrame* videoFrame = outputScheduler->GetAvailableVideoFrame();
                 if (videoFrame)
                 {
                     videoFrame->GetBytes((void**)&outBytes);
-                    if (pixelFormat == PixelFormat::YUV)
-                    {
-                        outputTextureBuffer.FetchTextureData(device, outBytes, FRAME_BPP_YUV);
-                    }
-                    else if (pixelFormat == PixelFormat::BGRA)
-                    {
-                        outputTextureBuffer.FetchTextureData(device, outBytes, FRAME_BPP_RGBA);
-                    }
-                    s_outputScheduler.QueueFrame(videoFrame);
+
+                    // Copy straight into the output frame, honoring its row pitch.
+                    ImageFormat outputFormat = (pixelFormat == PixelFormat::YUV) ? ImageFormat::UYVY : ImageFormat::BGRA;
+                    outputTextureBuffer.FetchTextureData(device, ImageView(outBytes, FRAME_WIDTH, FRAME_HEIGHT, outputFormat, (int)videoFrame->GetRowBytes()));
+                    outputScheduler->QueueFrame(videoFrame);
                 }
             }
             outputTextureBuffer.PrepareTextureFetch(device, _outputTexture);
@@ -802,10 +1269,34 @@ bool DeckLinkDevice::ExpectsYUV()
     return ProvidesYUV();
 }
 
-void DeckLinkDevice::BufferCache::ComputePixelChange(BYTE* prevBuffer, BMDPixelFormat framePixelFormat)
+void DeckLinkDevice::BufferCache::HoldFrame(IDeckLinkVideoInputFrame* inputFrame, BYTE* bytes)
+{
+    inputFrame->AddRef();
+    frame = inputFrame;
+    buffer = bytes;
+}
+
+void DeckLinkDevice::BufferCache::ReleaseFrame()
+{
+    if (frame != NULL)
+    {
+        frame->Release();
+        frame = NULL;
+    }
+
+    buffer = cacheBuffer;
+}
+
+void DeckLinkDevice::BufferCache::ComputePixelChange(BYTE* prevBuffer)
 {
     pixelChange = 0;
-    int bpp = framePixelFormat == BMDPixelFormat::bmdFormat8BitYUV ? FRAME_BPP_YUV : FRAME_BPP_RGBA;
+    if (prevBuffer == NULL)
+    {
+        return;
+    }
+
+    // 10 bit frames are decoded to BGRA before they reach the cache.
+    int bpp = (format == ImageFormat::UYVY) ? FRAME_BPP_YUV : FRAME_BPP_RGBA;
 
     for (int x = 50; x < FRAME_WIDTH - 50; x += 100)
     {
@@ -837,11 +1328,11 @@ DeckLinkDeviceDiscovery::~DeckLinkDeviceDiscovery()
         m_deckLinkDiscovery = NULL;
     }
 
-    if (m_deckLink != nullptr)
+    for (IDeckLink* deckLink : m_deckLinks)
     {
-        m_deckLink->Release();
-        m_deckLink = NULL;
+        deckLink->Release();
     }
+    m_deckLinks.clear();
 }
 
 bool DeckLinkDeviceDiscovery::Enable()
@@ -866,21 +1357,36 @@ void DeckLinkDeviceDiscovery::Disable()
     }
 }
 
-HRESULT DeckLinkDeviceDiscovery::DeckLinkDeviceArrived(/* in */ IDeckLink* deckLink)
+IDeckLink* DeckLinkDeviceDiscovery::GetDeckLink(int deviceIndex)
 {
-    if (m_deckLink == nullptr)
+    std::lock_guard<std::mutex> guard(m_deckLinksLock);
+    if (deviceIndex < 0 || deviceIndex >= (int)m_deckLinks.size())
     {
-        deckLink->AddRef();
-
-        m_deckLink = deckLink;
+        return nullptr;
     }
 
+    return m_deckLinks[deviceIndex];
+}
+
+HRESULT DeckLinkDeviceDiscovery::DeckLinkDeviceArrived(/* in */ IDeckLink* deckLink)
+{
+    std::lock_guard<std::mutex> guard(m_deckLinksLock);
+    deckLink->AddRef();
+    m_deckLinks.push_back(deckLink);
+
     return S_OK;
 }
 
 HRESULT DeckLinkDeviceDiscovery::DeckLinkDeviceRemoved(/* in */ IDeckLink* deckLink)
 {
-    deckLink->Release();
+    std::lock_guard<std::mutex> guard(m_deckLinksLock);
+    auto removed = std::find(m_deckLinks.begin(), m_deckLinks.end(), deckLink);
+    if (removed != m_deckLinks.end())
+    {
+        (*removed)->Release();
+        m_deckLinks.erase(removed);
+    }
+
     return S_OK;
 }
 
@@ -29,11 +29,23 @@
 
 #if defined(INCLUDE_BLACKMAGIC)
 #include <Windows.h>
+#include <algorithm>
+#include <map>
+#include <mutex>
 #include <vector>
 #include "DeckLinkAPI_h.h"
+#include "ClockDomain.h"
 #include "DirectXHelper.h"
+#include "FrameBufferPool.h"
+#include "Deinterlacing.h"
+#include "FrameRing.h"
+#include "RingDepth.h"
+#include "ThreadRoles.h"
 #include "BufferedTextureFetch.h"
 
+class OutputScheduler;
+class DeckLinkFrameAllocator;
+
 class DeckLinkDevice : public IDeckLinkInputCallback
 {
 private:
@@ -45,6 +57,13 @@ private:
     };
 
     PixelFormat pixelFormat = PixelFormat::YUV;
+    ColorMatrix colorMatrix = ColorMatrix::BT601Limited;
+    std::atomic<DeinterlaceMode> deinterlaceMode { DeinterlaceMode::MotionAdaptive };
+    // Progressive unless the current display mode is interlaced.
+    BMDFieldDominance fieldDominance = bmdProgressiveFrame;
+    LARGE_INTEGER qpcFrequency;
+    // Maps the card's hardware reference clock, in QPC_MULTIPLIER ticks, to QueryPerformanceCounter.
+    ClockDomainMapper timestampClock;
 
     ULONG                     m_refCount;
     IDeckLink*                m_deckLink;
@@ -56,29 +75,78 @@ private:
     CRITICAL_SECTION          m_outputCriticalSection;
 
     BYTE* localFrameBuffer;
-    BYTE* rawBuffer =           new BYTE[FRAME_BUFSIZE_YUV];
+    // Points into the frame being captured, owned by the card.
+    BYTE* rawBuffer =           nullptr;
+
+    BYTE* outputBuffer =        FrameBufferPool::Instance().Acquire(FRAME_BUFSIZE_RGBA);
+    BYTE* outputBufferRaw =     FrameBufferPool::Instance().Acquire(FRAME_BUFSIZE_YUV);
 
-    BYTE* stagingBuffer =       new BYTE[FRAME_BUFSIZE_RGBA];
-    BYTE* outputBuffer =        new BYTE[FRAME_BUFSIZE_RGBA];
-    BYTE* outputBufferRaw =     new BYTE[FRAME_BUFSIZE_YUV];
+    // RGBA copy of the frame last uploaded on the CPU path, only touched by the render thread.
+    BYTE* convertedBuffer =     FrameBufferPool::Instance().Acquire(FRAME_BUFSIZE_RGBA);
+    // Sequence convertedBuffer holds, 0 if none.
+    int convertedFrameIndex = 0;
 
     BMDTimeValue frameDuration = 0;
 
     class BufferCache
     {
     public:
+        // The frame as readers see it, either cacheBuffer or the bytes of frame.
         BYTE* buffer;
+        // Storage for frames that are converted on capture, allocated the first time the entry is written.
+        BYTE* cacheBuffer;
+        // A captured frame kept instead of copied, its bytes come from frameAllocator.
+        IDeckLinkVideoInputFrame* frame;
+        // Frames are cached as captured, UYVY or BGRA, and converted to RGBA when they are consumed.
+        ImageFormat format;
         LONGLONG timeStamp;
         int pixelChange;
 
-        void ComputePixelChange(BYTE* prevBuffer, BMDPixelFormat framePixelFormat);
+        // prevBuffer is null if the previous frame is no longer cached.
+        void ComputePixelChange(BYTE* prevBuffer);
+        void HoldFrame(IDeckLinkVideoInputFrame* inputFrame, BYTE* bytes);
+        void ReleaseFrame();
     };
 
     #define MAX_NUM_CACHED_BUFFERS 20
-    BufferCache bufferCache[MAX_NUM_CACHED_BUFFERS];
+    // Written by the capture callback, read by the render thread.
+    FrameRing<BufferCache, MAX_NUM_CACHED_BUFFERS> bufferCache;
+    // Sequence of the last frame the capture callback wrote, only touched on the capture thread.
     int captureFrameIndex;
 
-    BufferCache& GetOldestBuffer();
+    // Sizes bufferCache from the latency preference and how far the compositor trails capture.
+    RingDepthController ringDepth { MAX_NUM_CACHED_BUFFERS };
+    // True while entries dropped from bufferCache still hold their buffers, only touched on the capture thread.
+    bool releaseRetiredBuffers = false;
+
+    // Supplies capture buffers the buffer cache can hold on to, null if the card would not take it.
+    DeckLinkFrameAllocator* frameAllocator = nullptr;
+
+    // Schedules composited frames on this device's output, each device has its own.
+    OutputScheduler* outputScheduler;
+
+    // Claim the next buffer cache entry for a captured frame.
+    BufferCache& BeginWriteFrame();
+    // Resize bufferCache to the depth ringDepth asks for, free the buffers of entries it no longer uses, and hand the
+    // capture buffers the card released back to frameAllocator once no read can still use them.
+    void ResizeBufferCache();
+    // The buffer of a frame the capture callback wrote, or null if it is no longer in bufferCache.
+    BYTE* GetCapturedBuffer(int sequence);
+    // True if frame can be kept in the buffer cache as is, rather than copied.
+    bool CanHoldFrame(IDeckLinkVideoInputFrame* frame, int bytesPerPixel);
+    // Upload a published frame to the color texture, converting it first on the CPU path. False if it was not available.
+    bool UploadFrame(int frameIndex);
+
+    static ColorMatrix GetColorMatrix(BMDDisplayMode videoDisplayMode);
+
+    // 10 bit v210 if CAPTURE_10BIT_YUV is set, frames are converted on the CPU and the card can capture it in this mode,
+    // 8 bit UYVY otherwise.
+    // The SDK does not report the bit depth of the signal, so this cannot follow the camera.
+    BMDPixelFormat GetYUVInputFormat(BMDDisplayMode videoDisplayMode);
+    BMDFieldDominance GetFieldDominance(BMDDisplayMode videoDisplayMode);
+
+    // Deinterlace the frame just written to the buffer cache. Bob mode adds a second buffer for the second field.
+    void DeinterlaceCapturedFrame(ImageFormat cacheFormat, LONGLONG captureTime);
 
     bool dirtyFrame = true;
 
@@ -120,7 +188,19 @@ public:
 
     LONGLONG GetTimestamp(int frame)
     {
-        return bufferCache[frame % MAX_NUM_CACHED_BUFFERS].timeStamp;
+        LONGLONG timeStamp = 0;
+        bufferCache.Read(frame, [&](const BufferCache& cache) { timeStamp = cache.timeStamp; });
+        return timeStamp;
+    }
+
+    FrameBracket<LONGLONG> FindFramesAtTimestamp(LONGLONG timestamp)
+    {
+        return bufferCache.FindBracket(timestamp, [](const BufferCache& cache) { return cache.timeStamp; });
+    }
+
+    ClockDomainFit GetTimestampClockFit()
+    {
+        return timestampClock.GetFit();
     }
 
     LONGLONG GetDurationHNS()
@@ -130,16 +210,19 @@ public:
 
     int GetCaptureFrameIndex()
     {
-        return captureFrameIndex;
+        return bufferCache.GetPublishedSequence();
     }
 
     int GetPixelChange(int frame)
     {
-        return bufferCache[frame % MAX_NUM_CACHED_BUFFERS].pixelChange;
+        int pixelChange = 0;
+        bufferCache.Read(frame, [&](const BufferCache& cache) { pixelChange = cache.pixelChange; });
+        return pixelChange;
     }
 
     int GetNumQueuedOutputFrames();
     void SetLatencyPreference(float latencyPreference);
+    void SetDeinterlaceMode(DeinterlaceMode mode);
 
     bool ProvidesYUV();
     bool ExpectsYUV();
@@ -150,13 +233,16 @@ class DeckLinkDeviceDiscovery :  public IDeckLinkDeviceNotificationCallback
 private:
     IDeckLinkDiscovery*                 m_deckLinkDiscovery;
     ULONG                               m_refCount;
-    IDeckLink*                          m_deckLink = nullptr;
+    // Devices in the order they arrived, which for devices present at startup is the order the driver enumerates them.
+    std::vector<IDeckLink*>             m_deckLinks;
+    std::mutex                          m_deckLinksLock;
 
 public:
     DeckLinkDeviceDiscovery();
     virtual ~DeckLinkDeviceDiscovery();
 
-    IDeckLink*                          GetDeckLink() { return m_deckLink; }
+    // The deviceIndex-th device that arrived, null if there are not that many.
+    IDeckLink*                          GetDeckLink(int deviceIndex = 0);
 
     bool                                Enable();
     void                                Disable();
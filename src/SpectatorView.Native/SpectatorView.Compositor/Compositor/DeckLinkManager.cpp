@@ -7,10 +7,11 @@
 #include "DeckLinkManager.h"
 
 
-DeckLinkManager::DeckLinkManager(bool useCPU, bool passthroughOutput)
+DeckLinkManager::DeckLinkManager(bool useCPU, bool passthroughOutput, int deviceIndex)
 {
     _useCPU = useCPU;
     _passthroughOutput = passthroughOutput;
+    _deviceIndex = deviceIndex;
 
     deckLinkDiscovery = new DeckLinkDeviceDiscovery();
     if (!deckLinkDiscovery->Enable())
@@ -46,7 +47,7 @@ HRESULT DeckLinkManager::Initialize(ID3D11ShaderResourceView* colorSRV, ID3D11Sh
 
     if (supportsBlackMagic && (deckLinkDevice == nullptr || deckLink == nullptr))
     {
-        deckLink = deckLinkDiscovery->GetDeckLink();
+        deckLink = deckLinkDiscovery->GetDeckLink(_deviceIndex);
         if (deckLink != nullptr)
         {
             deckLinkDevice = new DeckLinkDevice(deckLink);
@@ -141,6 +142,27 @@ LONGLONG DeckLinkManager::GetTimestamp(int frame)
     return 0;
 }
 
+FrameBracket<LONGLONG> DeckLinkManager::FindFramesAtTimestamp(LONGLONG timestamp)
+{
+    if (IsEnabled())
+    {
+        return deckLinkDevice->FindFramesAtTimestamp(timestamp);
+    }
+
+    return FrameBracket<LONGLONG>();
+}
+
+bool DeckLinkManager::GetTimestampClockFit(ClockDomainFit* fit)
+{
+    if (IsEnabled())
+    {
+        *fit = deckLinkDevice->GetTimestampClockFit();
+        return true;
+    }
+
+    return false;
+}
+
 LONGLONG DeckLinkManager::GetDurationHNS()
 {
     if (IsEnabled())
@@ -189,6 +211,14 @@ void DeckLinkManager::SetLatencyPreference(float latencyPreference)
     }
 }
 
+void DeckLinkManager::SetDeinterlaceMode(DeinterlaceMode mode)
+{
+    if (IsEnabled())
+    {
+        deckLinkDevice->SetDeinterlaceMode(mode);
+    }
+}
+
 bool DeckLinkManager::IsEnabled()
 {
     if (deckLinkDevice == nullptr)
@@ -10,7 +10,8 @@
 class DeckLinkManager : public IFrameProvider
 {
 public:
-    DeckLinkManager(bool useCPU = false, bool passthroughOutput = false);
+    // deviceIndex picks the card input, in the order the driver reports them.
+    DeckLinkManager(bool useCPU = false, bool passthroughOutput = false, int deviceIndex = 0);
     ~DeckLinkManager();
 
     HRESULT Initialize(ID3D11ShaderResourceView* colorSRV, ID3D11ShaderResourceView* depthSRV, ID3D11ShaderResourceView* bodySRV, ID3D11Texture2D* outputTexture);
@@ -18,6 +19,8 @@ public:
 
     // Get the timestamp of the earliest (and currently rendered) cached frame.
     LONGLONG GetTimestamp(int frame);
+    FrameBracket<LONGLONG> FindFramesAtTimestamp(LONGLONG timestamp);
+    bool GetTimestampClockFit(ClockDomainFit* fit);
 
     LONGLONG GetDurationHNS();
 
@@ -25,6 +28,7 @@ public:
     int GetPixelChange(int frame);
     int GetNumQueuedOutputFrames();
     void SetLatencyPreference(float latencyPreference);
+    void SetDeinterlaceMode(DeinterlaceMode mode);
 
     void Update(int compositeFrameIndex);
 
@@ -44,6 +48,7 @@ private:
 
     bool _useCPU;
     bool _passthroughOutput;
+    int _deviceIndex;
 };
 #endif
 
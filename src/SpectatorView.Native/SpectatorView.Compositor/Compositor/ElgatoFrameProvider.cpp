@@ -78,12 +78,33 @@ LONGLONG ElgatoFrameProvider::GetTimestamp(int frame)
 {
     if (frameCallback != nullptr)
     {
-        return frameCallback->GetTimestamp();
+        return frameCallback->GetTimestamp(frame);
     }
 
     return -1;
 }
 
+FrameBracket<LONGLONG> ElgatoFrameProvider::FindFramesAtTimestamp(LONGLONG timestamp)
+{
+    if (frameCallback != nullptr)
+    {
+        return frameCallback->FindFramesAtTimestamp(timestamp);
+    }
+
+    return FrameBracket<LONGLONG>();
+}
+
+bool ElgatoFrameProvider::GetTimestampClockFit(ClockDomainFit* fit)
+{
+    if (frameCallback != nullptr)
+    {
+        *fit = frameCallback->GetTimestampClockFit();
+        return true;
+    }
+
+    return false;
+}
+
 LONGLONG ElgatoFrameProvider::GetDurationHNS()
 {
     return (LONGLONG)((1.0f / 30.0f) * QPC_MULTIPLIER);
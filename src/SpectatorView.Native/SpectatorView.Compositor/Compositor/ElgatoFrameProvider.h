@@ -43,6 +43,8 @@ public:
 
     virtual HRESULT Initialize(ID3D11ShaderResourceView* colorSRV, ID3D11ShaderResourceView* depthSRV, ID3D11ShaderResourceView* bodySRV, ID3D11Texture2D* outputTexture);
     virtual LONGLONG GetTimestamp(int frame);
+    virtual FrameBracket<LONGLONG> FindFramesAtTimestamp(LONGLONG timestamp);
+    virtual bool GetTimestampClockFit(ClockDomainFit* fit);
 
     virtual LONGLONG GetDurationHNS();
 
@@ -72,6 +74,11 @@ public:
         return 0;
     }
 
+    void SetLatencyPreference(float latencyPreference)
+    {
+        if (frameCallback)
+            frameCallback->SetLatencyPreference(latencyPreference);
+    }
 
 private:
     ID3D11ShaderResourceView* _colorSRV;
@@ -9,12 +9,17 @@
 ElgatoSampleCallback::ElgatoSampleCallback(ID3D11Device* device) :
     _device(device)
 {
-    InitializeCriticalSection(&frameAccessCriticalSection);
+    for (int i = 0; i < MAX_NUM_CACHED_BUFFERS; i++)
+    {
+        bufferCache.SlotAt(i).bytes = nullptr;
+        bufferCache.SlotAt(i).timeStamp = 0;
+    }
 
-    for(int i =0; i < MAX_NUM_CACHED_BUFFERS; i++)
-        bufferCache[i] = new BYTE[FRAME_BUFSIZE_RGBA];
+    stagingBytes = FrameBufferPool::Instance().Acquire(FRAME_BUFSIZE_RGBA);
 
-    stagingBytes = new BYTE[FRAME_BUFSIZE_RGBA];
+    LARGE_INTEGER qpcFrequency;
+    QueryPerformanceFrequency(&qpcFrequency);
+    timestampClock.SetClockRates(QPC_MULTIPLIER, qpcFrequency.QuadPart);
 
     captureFrameIndex = 0;
 }
@@ -23,45 +28,116 @@ ElgatoSampleCallback::~ElgatoSampleCallback()
 {
     isEnabled = false;
     for (int i = 0; i < MAX_NUM_CACHED_BUFFERS; i++)
-        delete [] bufferCache[i];
+        FrameBufferPool::Instance().Release(bufferCache.SlotAt(i).bytes);
 
-    delete[] stagingBytes;
+    FrameBufferPool::Instance().Release(stagingBytes);
 }
 
 STDMETHODIMP ElgatoSampleCallback::BufferCB(double time, BYTE *pBuffer, long length)
 {
     isEnabled = true;
 
-    // Get frame time.
+    // This runs on the DirectShow streaming thread, which keeps the capture settings from its first frame on.
+    ThreadRoles::Instance().Apply(ThreadRole::Capture);
+
+    // Get frame time. The filter stamps samples when the device delivers them, which is free of the jitter of this
+    // callback, so map that time to QueryPerformanceCounter.
     LARGE_INTEGER t;
     QueryPerformanceCounter(&t);
-    latestTimeStamp = t.QuadPart;
+    latestTimeStamp = timestampClock.AddSample((LONGLONG)(time * QPC_MULTIPLIER), t.QuadPart);
 
     int copyLength = length;
-    if (copyLength > FRAME_BUFSIZE_RGBA)
+    if (copyLength > FRAME_BUFSIZE_YUV)
     {
         // This might happen if the camera is outputting 4K but the system is expecting 1080.
-        copyLength = FRAME_BUFSIZE_RGBA;
+        copyLength = FRAME_BUFSIZE_YUV;
     }
 
+    ResizeBufferCache();
+
     captureFrameIndex++;
-    memcpy(bufferCache[captureFrameIndex%MAX_NUM_CACHED_BUFFERS], pBuffer, copyLength);
+    CachedFrame& cachedFrame = bufferCache.BeginWrite(captureFrameIndex);
+    if (cachedFrame.bytes == nullptr)
+    {
+        cachedFrame.bytes = FrameBufferPool::Instance().Acquire(FRAME_BUFSIZE_YUV);
+        ZeroMemory(cachedFrame.bytes, FRAME_BUFSIZE_YUV);
+    }
+
+    memcpy(cachedFrame.bytes, pBuffer, copyLength);
+    cachedFrame.timeStamp = latestTimeStamp;
+    bufferCache.Publish(captureFrameIndex);
     return S_OK;
 }
 
+void ElgatoSampleCallback::ResizeBufferCache()
+{
+    int depth = ringDepth.Update();
+    if (depth != bufferCache.GetDepth())
+    {
+        bufferCache.SetDepth(depth);
+        releaseRetiredBuffers = true;
+    }
+
+    // The render thread may still be reading a buffer it started on before the resize.
+    if (releaseRetiredBuffers && bufferCache.IsQuiescent())
+    {
+        for (int i = bufferCache.GetDepth(); i < MAX_NUM_CACHED_BUFFERS; i++)
+        {
+            FrameBufferPool::Instance().Release(bufferCache.SlotAt(i).bytes);
+            bufferCache.SlotAt(i).bytes = nullptr;
+        }
+
+        releaseRetiredBuffers = false;
+    }
+}
+
 // Call this from the Render thread.
 void ElgatoSampleCallback::UpdateSRV(ID3D11ShaderResourceView* srv, bool useCPU, int bufferIndex)
 {
-    BYTE* srcBuffer = bufferCache[bufferIndex%MAX_NUM_CACHED_BUFFERS];
+    ringDepth.ObserveLag(bufferCache.GetPublishedSequence(), bufferIndex);
+
     if (useCPU)
     {
-        // Do not cache when using the CPU
-        DirectXHelper::ConvertYUVtoBGRA(srcBuffer, stagingBytes, FRAME_WIDTH, FRAME_HEIGHT, true);
-        DirectXHelper::UpdateSRV(_device, srv, stagingBytes, FRAME_WIDTH * FRAME_BPP_RGBA);
+        // Convert the consumed frame once, however often it is uploaded.
+        auto convert = [&](int frameIndex)
+        {
+            if (frameIndex == stagedFrameIndex)
+            {
+                return true;
+            }
+
+            stagedFrameIndex = 0;
+            bool converted = bufferCache.Read(frameIndex, [&](const CachedFrame& cachedFrame)
+            {
+                PixelConversion::Convert(ImageView(cachedFrame.bytes, FRAME_WIDTH, FRAME_HEIGHT, ImageFormat::UYVY), ImageView(stagingBytes, FRAME_WIDTH, FRAME_HEIGHT, ImageFormat::RGBA), ColorMatrix::BT601Limited, AlphaPolicy::Opaque);
+            });
+
+            if (converted)
+            {
+                stagedFrameIndex = frameIndex;
+            }
+            return converted;
+        };
+
+        // A frame that was overwritten during the conversion is torn, so it is never uploaded.
+        if (convert(bufferIndex) || convert(bufferCache.GetPublishedSequence()))
+        {
+            DirectXHelper::UpdateSRV(_device, srv, stagingBytes, FRAME_WIDTH * FRAME_BPP_RGBA);
+        }
     }
     else
     {
-        DirectXHelper::UpdateSRV(_device, srv, srcBuffer, FRAME_WIDTH * FRAME_BPP_RGBA);
+        // Frames are UYVY, so with the RGBA pitch of the texture they only fill its top rows.
+        auto upload = [&](const CachedFrame& cachedFrame)
+        {
+            DirectXHelper::UpdateSRVRows(_device, srv, cachedFrame.bytes, FRAME_WIDTH * FRAME_BPP_RGBA, FRAME_BUFSIZE_YUV / (FRAME_WIDTH * FRAME_BPP_RGBA));
+        };
+
+        // If the frame is not available or was overwritten during the upload, show the newest one instead.
+        if (!bufferCache.Read(bufferIndex, upload))
+        {
+            bufferCache.Read(bufferCache.GetPublishedSequence(), upload);
+        }
     }
 }
 #endif
\ No newline at end of file
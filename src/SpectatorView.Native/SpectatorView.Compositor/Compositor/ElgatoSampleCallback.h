@@ -8,7 +8,12 @@
 #include "qedit.h"
 #include <dshow.h>
 
+#include "ClockDomain.h"
 #include "DirectXHelper.h"
+#include "FrameBufferPool.h"
+#include "FrameRing.h"
+#include "RingDepth.h"
+#include "ThreadRoles.h"
 
 class ElgatoSampleCallback : public ISampleGrabberCB
 {
@@ -62,6 +67,23 @@ public:
         return latestTimeStamp;
     }
 
+    LONGLONG GetTimestamp(int frame)
+    {
+        LONGLONG timeStamp = 0;
+        bufferCache.Read(frame, [&](const CachedFrame& cachedFrame) { timeStamp = cachedFrame.timeStamp; });
+        return timeStamp;
+    }
+
+    FrameBracket<LONGLONG> FindFramesAtTimestamp(LONGLONG timestamp)
+    {
+        return bufferCache.FindBracket(timestamp, [](const CachedFrame& cachedFrame) { return cachedFrame.timeStamp; });
+    }
+
+    ClockDomainFit GetTimestampClockFit()
+    {
+        return timestampClock.GetFit();
+    }
+
     bool IsEnabled()
     {
         return isEnabled;
@@ -69,7 +91,12 @@ public:
 
     int GetCaptureFrameIndex()
     {
-        return captureFrameIndex;
+        return bufferCache.GetPublishedSequence();
+    }
+
+    void SetLatencyPreference(float latencyPreference)
+    {
+        ringDepth.SetLatencyPreference(latencyPreference);
     }
 
 private:
@@ -78,14 +105,30 @@ private:
     ID3D11Device* _device;
 
     #define MAX_NUM_CACHED_BUFFERS 20
-    BYTE* bufferCache[MAX_NUM_CACHED_BUFFERS];
+    // Written by BufferCB on the DirectShow streaming thread, read by UpdateSRV on the render thread.
+    // Frames are cached as captured, in UYVY, and only the frame that is consumed is converted.
+    struct CachedFrame
+    {
+        BYTE* bytes;
+        LONGLONG timeStamp;
+    };
+    FrameRing<CachedFrame, MAX_NUM_CACHED_BUFFERS> bufferCache;
     int captureFrameIndex;
 
+    // Sizes bufferCache from the latency preference and how far the compositor trails capture.
+    // Buffers are allocated the first time their slot is written, and freed once the slot is dropped.
+    RingDepthController ringDepth { MAX_NUM_CACHED_BUFFERS };
+    bool releaseRetiredBuffers = false;
+    void ResizeBufferCache();
+
+    // RGBA copy of the frame last uploaded on the CPU path, and its sequence, 0 if none.
     BYTE* stagingBytes;
+    int stagedFrameIndex = 0;
 
     LONGLONG latestTimeStamp = 0;
+    // Maps the sample times of the capture filter, in QPC_MULTIPLIER ticks, to QueryPerformanceCounter.
+    ClockDomainMapper timestampClock;
 
-    CRITICAL_SECTION frameAccessCriticalSection;
     bool isEnabled = false;
 };
 
@@ -3,7 +3,10 @@
 
 #pragma once
 
+#include "ClockDomain.h"
 #include "DataStructures.h"
+#include "Deinterlacing.h"
+#include "FrameRing.h"
 
 class IFrameProvider
 {
@@ -34,6 +37,11 @@ public:
 
     virtual LONGLONG GetDurationHNS() = 0;
 
+    // Find the cached frames captured around timestamp, on the same clock as GetTimestamp.
+    virtual FrameBracket<LONGLONG> FindFramesAtTimestamp(LONGLONG timestamp) { return FrameBracket<LONGLONG>(); }
+    // Return true if timestamps come from the device clock mapped to the host clock, and how well that mapping fits.
+    virtual bool GetTimestampClockFit(ClockDomainFit* fit) { return false; }
+
     virtual void Update(int compositeFrameIndex) = 0;
 
     virtual ProviderType GetProviderType() = 0;
@@ -54,6 +62,8 @@ public:
     virtual int GetPixelChange(int frame) { return 0; }
     virtual int GetNumQueuedOutputFrames() { return 0; }
     virtual void SetLatencyPreference(float latencyPreference) {}
+    // Only applies to providers that capture interlaced video.
+    virtual void SetDeinterlaceMode(DeinterlaceMode mode) {}
     virtual bool IsCameraCalibrationInformationAvailable() { return false; }
     virtual void GetCameraCalibrationInformation(CameraIntrinsics* calibration) {}
 
@@ -0,0 +1,339 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "MediaFoundationSink.h"
+
+#include "codecapi.h"
+
+MediaFoundationSink::MediaFoundationSink()
+{
+}
+
+MediaFoundationSink::~MediaFoundationSink()
+{
+    Close();
+
+    // Samples the sink writer still holds keep the pool alive until they are released.
+    if (videoSamplePool != nullptr)
+    {
+        videoSamplePool->Release();
+        videoSamplePool = nullptr;
+    }
+
+#if HARDWARE_ENCODE_VIDEO
+    SafeRelease(deviceManager);
+#endif
+
+    MFShutdown();
+}
+
+bool MediaFoundationSink::Initialize(ID3D11Device* device)
+{
+    HRESULT hr = MFStartup(MF_VERSION);
+
+#if HARDWARE_ENCODE_VIDEO
+    if (deviceManager == NULL)
+    {
+        MFCreateDXGIDeviceManager(&resetToken, &deviceManager);
+    }
+
+    if (deviceManager != nullptr)
+    {
+        OutputDebugString(L"Resetting device manager with graphics device.\n");
+        deviceManager->ResetDevice(device, resetToken);
+    }
+#endif
+
+    return SUCCEEDED(hr);
+}
+
+bool MediaFoundationSink::Open(const std::wstring& path, const MediaSinkFormat& recordingFormat)
+{
+    if (sinkWriter != NULL)
+    {
+        OutputDebugString(L"Open called when the sink was already recording.\n");
+        return false;
+    }
+
+    format = recordingFormat;
+    videoStreamIndex = MAXDWORD;
+    audioStreamIndex = MAXDWORD;
+
+    DWORD videoBufferSize = (DWORD)format.VideoBufferSize();
+    if (videoSamplePool != nullptr && videoSamplePool->GetBufferSize() != videoBufferSize)
+    {
+        videoSamplePool->Release();
+        videoSamplePool = nullptr;
+    }
+
+    if (videoSamplePool == nullptr)
+    {
+        videoSamplePool = new MediaSamplePool(videoBufferSize);
+    }
+
+    HRESULT hr = S_OK;
+
+    IMFMediaType*    pVideoTypeOut = NULL;
+    IMFMediaType*    pVideoTypeIn = NULL;
+    IMFMediaType*    pAudioTypeOut = NULL;
+    IMFMediaType*    pAudioTypeIn = NULL;
+
+    IMFAttributes *attr = nullptr;
+    hr = MFCreateAttributes(&attr, 3);
+
+    // Throttling is left on, so WriteSample blocks the encoder thread while the encoder is behind. The backlog then
+    // builds up in the recorder queue, where its policy applies, instead of in samples the sink writer holds.
+
+#if HARDWARE_ENCODE_VIDEO
+    if (SUCCEEDED(hr)) { hr = attr->SetUINT32(MF_READWRITE_ENABLE_HARDWARE_TRANSFORMS, true); }
+    if (SUCCEEDED(hr)) { hr = attr->SetUINT32(MF_READWRITE_DISABLE_CONVERTERS, false); }
+#endif
+
+    if (SUCCEEDED(hr)) { hr = MFCreateSinkWriterFromURL(path.c_str(), NULL, attr, &sinkWriter); }
+
+    // Set the output media types.
+    if (SUCCEEDED(hr)) { hr = MFCreateMediaType(&pVideoTypeOut); }
+    if (SUCCEEDED(hr)) { hr = pVideoTypeOut->SetGUID(MF_MT_MAJOR_TYPE, MFMediaType_Video); }
+    if (SUCCEEDED(hr)) { hr = pVideoTypeOut->SetGUID(MF_MT_SUBTYPE, MFVideoFormat_H264); }
+    if (SUCCEEDED(hr)) { hr = pVideoTypeOut->SetUINT32(MF_MT_AVG_BITRATE, format.videoBitrate); }
+    if (SUCCEEDED(hr)) { hr = pVideoTypeOut->SetUINT32(MF_MT_INTERLACE_MODE, MFVideoInterlace_Progressive); }
+    if (SUCCEEDED(hr)) { hr = MFSetAttributeSize(pVideoTypeOut, MF_MT_FRAME_SIZE, format.width, format.height); }
+    if (SUCCEEDED(hr)) { hr = MFSetAttributeRatio(pVideoTypeOut, MF_MT_FRAME_RATE, format.fps, 1); }
+    if (SUCCEEDED(hr)) { hr = MFSetAttributeRatio(pVideoTypeOut, MF_MT_PIXEL_ASPECT_RATIO, 1, 1); }
+
+    if (SUCCEEDED(hr)) { hr = pVideoTypeOut->SetUINT32(MF_MT_MPEG2_LEVEL, format.videoMpegLevel); }
+    if (SUCCEEDED(hr)) { hr = pVideoTypeOut->SetUINT32(MF_MT_MPEG2_PROFILE, eAVEncH264VProfile_High); }
+
+    if (SUCCEEDED(hr)) { hr = sinkWriter->AddStream(pVideoTypeOut, &videoStreamIndex); }
+
+    if (format.encodeAudio)
+    {
+        if (SUCCEEDED(hr)) { hr = MFCreateMediaType(&pAudioTypeOut); }
+        if (SUCCEEDED(hr)) { hr = pAudioTypeOut->SetGUID(MF_MT_MAJOR_TYPE, MFMediaType_Audio); }
+        if (SUCCEEDED(hr)) { hr = pAudioTypeOut->SetGUID(MF_MT_SUBTYPE, MFAudioFormat_AAC); }
+        if (SUCCEEDED(hr)) { hr = pAudioTypeOut->SetUINT32(MF_MT_AUDIO_BITS_PER_SAMPLE, 16); }
+        if (SUCCEEDED(hr)) { hr = pAudioTypeOut->SetUINT32(MF_MT_AUDIO_SAMPLES_PER_SECOND, format.audioSampleRate); }
+        if (SUCCEEDED(hr)) { hr = pAudioTypeOut->SetUINT32(MF_MT_AUDIO_NUM_CHANNELS, format.audioChannels); }
+        if (SUCCEEDED(hr)) { hr = pAudioTypeOut->SetUINT32(MF_MT_AUDIO_AVG_BYTES_PER_SECOND, format.audioBPS); }
+        if (SUCCEEDED(hr)) { hr = pAudioTypeOut->SetUINT32(MF_MT_AUDIO_PREFER_WAVEFORMATEX, 1); }
+        if (SUCCEEDED(hr)) { hr = pAudioTypeOut->SetUINT32(MF_MT_ALL_SAMPLES_INDEPENDENT, 1); }
+        if (SUCCEEDED(hr)) { hr = pAudioTypeOut->SetUINT32(MF_MT_FIXED_SIZE_SAMPLES, 1); }
+        if (SUCCEEDED(hr)) { hr = sinkWriter->AddStream(pAudioTypeOut, &audioStreamIndex); }
+    }
+
+    // Set the input media types.
+    if (SUCCEEDED(hr)) { hr = MFCreateMediaType(&pVideoTypeIn); }
+    if (SUCCEEDED(hr)) { hr = pVideoTypeIn->SetGUID(MF_MT_MAJOR_TYPE, MFMediaType_Video); }
+    if (SUCCEEDED(hr)) { hr = pVideoTypeIn->SetGUID(MF_MT_SUBTYPE, (format.videoFormat == ImageFormat::NV12) ? MFVideoFormat_NV12 : MFVideoFormat_RGB32); }
+    if (SUCCEEDED(hr)) { hr = pVideoTypeIn->SetUINT32(MF_MT_INTERLACE_MODE, MFVideoInterlace_Progressive); }
+    if (SUCCEEDED(hr)) { hr = MFSetAttributeSize(pVideoTypeIn, MF_MT_FRAME_SIZE, format.width, format.height); }
+    if (SUCCEEDED(hr)) { hr = MFSetAttributeRatio(pVideoTypeIn, MF_MT_FRAME_RATE, format.fps, 1); }
+    if (SUCCEEDED(hr)) { hr = MFSetAttributeRatio(pVideoTypeIn, MF_MT_PIXEL_ASPECT_RATIO, 1, 1); }
+    if (SUCCEEDED(hr)) { hr = sinkWriter->SetInputMediaType(videoStreamIndex, pVideoTypeIn, NULL); }
+
+    if (format.encodeAudio)
+    {
+        if (SUCCEEDED(hr)) { hr = MFCreateMediaType(&pAudioTypeIn); }
+        if (SUCCEEDED(hr)) { hr = pAudioTypeIn->SetGUID(MF_MT_MAJOR_TYPE, MFMediaType_Audio); }
+        if (SUCCEEDED(hr)) { hr = pAudioTypeIn->SetGUID(MF_MT_SUBTYPE, MFAudioFormat_PCM); }
+        if (SUCCEEDED(hr)) { hr = pAudioTypeIn->SetUINT32(MF_MT_AUDIO_BITS_PER_SAMPLE, 16); }
+        if (SUCCEEDED(hr)) { hr = pAudioTypeIn->SetUINT32(MF_MT_AUDIO_SAMPLES_PER_SECOND, format.audioSampleRate); }
+        if (SUCCEEDED(hr)) { hr = pAudioTypeIn->SetUINT32(MF_MT_AUDIO_NUM_CHANNELS, format.audioChannels); }
+        if (SUCCEEDED(hr)) { hr = sinkWriter->SetInputMediaType(audioStreamIndex, pAudioTypeIn, NULL); }
+    }
+
+    // Tell the sink writer to start accepting data.
+    if (SUCCEEDED(hr)) { hr = sinkWriter->BeginWriting(); }
+
+    SafeRelease(attr);
+    SafeRelease(pVideoTypeOut);
+    SafeRelease(pVideoTypeIn);
+    SafeRelease(pAudioTypeOut);
+    SafeRelease(pAudioTypeIn);
+
+    if (FAILED(hr))
+    {
+        OutputDebugString(L"Error starting recording.\n");
+        SafeRelease(sinkWriter);
+        videoStreamIndex = MAXDWORD;
+        audioStreamIndex = MAXDWORD;
+        return false;
+    }
+
+    return true;
+}
+
+void MediaFoundationSink::Close()
+{
+    if (sinkWriter == NULL)
+    {
+        return;
+    }
+
+    if (videoStreamIndex != MAXDWORD)
+    {
+        OutputDebugString(L"Flushing video stream\n");
+        sinkWriter->Flush(videoStreamIndex);
+        videoStreamIndex = MAXDWORD;
+    }
+    if (audioStreamIndex != MAXDWORD)
+    {
+        OutputDebugString(L"Flushing audio stream\n");
+        sinkWriter->Flush(audioStreamIndex);
+        audioStreamIndex = MAXDWORD;
+    }
+
+    sinkWriter->Finalize();
+    SafeRelease(sinkWriter);
+
+    // Frame sized samples add up to a lot of memory, especially for quad recordings, so they are not kept between recordings.
+    if (videoSamplePool != nullptr)
+    {
+        videoSamplePool->Trim();
+    }
+}
+
+void MediaFoundationSink::ReserveVideoBuffers(int count)
+{
+    if (videoSamplePool != nullptr)
+    {
+        videoSamplePool->Reserve(count + SinkWriterSamples);
+    }
+}
+
+HRESULT MediaFoundationSink::LockSample(IMFSample* sample, DWORD length, MediaSinkBuffer* buffer)
+{
+    IMFMediaBuffer* mediaBuffer = NULL;
+    BYTE* pData = NULL;
+
+    // The buffer stays locked while the producer fills it and it waits in the queue, and is unlocked before it is written.
+    HRESULT hr = sample->GetBufferByIndex(0, &mediaBuffer);
+    if (SUCCEEDED(hr)) { hr = mediaBuffer->SetCurrentLength(length); }
+    if (SUCCEEDED(hr)) { hr = mediaBuffer->Lock(&pData, NULL, NULL); }
+
+    SafeRelease(mediaBuffer);
+
+    if (SUCCEEDED(hr))
+    {
+        buffer->data = pData;
+        buffer->size = (int)length;
+        buffer->sinkData = sample;
+    }
+
+    return hr;
+}
+
+bool MediaFoundationSink::AcquireVideoBuffer(MediaSinkBuffer* buffer)
+{
+    if (videoSamplePool == nullptr)
+    {
+        return false;
+    }
+
+    // Frames are copied once, straight into a pooled sample.
+    IMFSample* pVideoSample = NULL;
+    HRESULT hr = videoSamplePool->Acquire(&pVideoSample);
+    if (SUCCEEDED(hr)) { hr = LockSample(pVideoSample, videoSamplePool->GetBufferSize(), buffer); }
+
+    if (FAILED(hr))
+    {
+        SafeRelease(pVideoSample);
+        OutputDebugString(L"Error allocating video frame.\n");
+        return false;
+    }
+
+    return true;
+}
+
+bool MediaFoundationSink::AcquireAudioBuffer(int size, MediaSinkBuffer* buffer)
+{
+    IMFSample* pAudioSample = NULL;
+    IMFMediaBuffer* pAudioBuffer = NULL;
+
+    HRESULT hr = MFCreateMemoryBuffer((DWORD)size, &pAudioBuffer);
+    if (SUCCEEDED(hr)) { hr = MFCreateSample(&pAudioSample); }
+    if (SUCCEEDED(hr)) { hr = pAudioSample->AddBuffer(pAudioBuffer); }
+    if (SUCCEEDED(hr)) { hr = LockSample(pAudioSample, (DWORD)size, buffer); }
+
+    SafeRelease(pAudioBuffer);
+
+    if (FAILED(hr))
+    {
+        SafeRelease(pAudioSample);
+        OutputDebugString(L"Error allocating audio frame.\n");
+        return false;
+    }
+
+    return true;
+}
+
+void MediaFoundationSink::ReleaseBuffer(MediaSinkBuffer* buffer)
+{
+    IMFSample* sample = static_cast<IMFSample*>(buffer->sinkData);
+    if (sample == NULL)
+    {
+        return;
+    }
+
+    IMFMediaBuffer* mediaBuffer = NULL;
+    if (SUCCEEDED(sample->GetBufferByIndex(0, &mediaBuffer)))
+    {
+        mediaBuffer->Unlock();
+        SafeRelease(mediaBuffer);
+    }
+
+    // Pooled samples return to the pool once the sink writer is done with them too.
+    SafeRelease(sample);
+    buffer->data = nullptr;
+    buffer->sinkData = nullptr;
+}
+
+bool MediaFoundationSink::WriteSample(DWORD streamIndex, MediaSinkBuffer* buffer, int64_t sampleTime, int64_t duration)
+{
+    IMFSample* sample = static_cast<IMFSample*>(buffer->sinkData);
+    if (sinkWriter == NULL || streamIndex == MAXDWORD || sample == NULL)
+    {
+        ReleaseBuffer(buffer);
+        return false;
+    }
+
+    IMFMediaBuffer* mediaBuffer = NULL;
+    HRESULT hr = sample->GetBufferByIndex(0, &mediaBuffer);
+    if (SUCCEEDED(hr)) { hr = mediaBuffer->Unlock(); }
+    SafeRelease(mediaBuffer);
+
+    if (SUCCEEDED(hr)) { hr = sample->SetSampleTime(sampleTime); } //100-nanosecond units
+    if (SUCCEEDED(hr)) { hr = sample->SetSampleDuration(duration); } //100-nanosecond units
+
+    // Send the sample to the Sink Writer.
+    if (SUCCEEDED(hr)) { hr = sinkWriter->WriteSample(streamIndex, sample); }
+
+    SafeRelease(sample);
+    buffer->data = nullptr;
+    buffer->sinkData = nullptr;
+
+    return SUCCEEDED(hr);
+}
+
+bool MediaFoundationSink::WriteVideo(MediaSinkBuffer* buffer, int64_t sampleTime, int64_t duration)
+{
+    bool written = WriteSample(videoStreamIndex, buffer, sampleTime, duration);
+    if (!written)
+    {
+        OutputDebugString(L"Error writing video frame.\n");
+    }
+
+    return written;
+}
+
+bool MediaFoundationSink::WriteAudio(MediaSinkBuffer* buffer, int64_t sampleTime, int64_t duration)
+{
+    bool written = WriteSample(audioStreamIndex, buffer, sampleTime, duration);
+    if (!written)
+    {
+        OutputDebugString(L"Error writing audio frame.\n");
+    }
+
+    return written;
+}
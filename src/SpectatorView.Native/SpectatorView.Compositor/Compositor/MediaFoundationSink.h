@@ -0,0 +1,66 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+// Recording backend that encodes H.264 video and AAC audio into an MP4 with the Media Foundation sink writer.
+// IMFSinkWriter:
+// https://msdn.microsoft.com/en-us/library/windows/desktop/ff819477(v=vs.85).aspx
+
+#pragma once
+
+#include <Windows.h>
+#include <mfapi.h>
+#include <mfidl.h>
+#include <Mfreadwrite.h>
+#include <mferror.h>
+
+#include "DirectXHelper.h"
+#include "MediaSamplePool.h"
+#include "MediaSink.h"
+
+#pragma comment(lib, "mf")
+#pragma comment(lib, "mfreadwrite")
+#pragma comment(lib, "mfplat")
+#pragma comment(lib, "mfuuid")
+
+class MediaFoundationSink : public IMediaSink
+{
+public:
+    MediaFoundationSink();
+    ~MediaFoundationSink();
+
+    // Start Media Foundation, and give hardware encoders the graphics device.
+    bool Initialize(ID3D11Device* device);
+
+    virtual bool Open(const std::wstring& path, const MediaSinkFormat& recordingFormat) override;
+    virtual void Close() override;
+
+    virtual void ReserveVideoBuffers(int count) override;
+    virtual bool AcquireVideoBuffer(MediaSinkBuffer* buffer) override;
+    virtual bool AcquireAudioBuffer(int size, MediaSinkBuffer* buffer) override;
+    virtual void ReleaseBuffer(MediaSinkBuffer* buffer) override;
+
+    virtual bool WriteVideo(MediaSinkBuffer* buffer, int64_t sampleTime, int64_t duration) override;
+    virtual bool WriteAudio(MediaSinkBuffer* buffer, int64_t sampleTime, int64_t duration) override;
+
+private:
+    // Video samples the sink writer holds on to while the encoder works on them, on top of the queued ones.
+    // The sink writer throttles WriteSample, so it does not take many more than this.
+    static const int SinkWriterSamples = 8;
+
+    // Lock the buffer of a sample for the producer to fill.
+    static HRESULT LockSample(IMFSample* sample, DWORD length, MediaSinkBuffer* buffer);
+    bool WriteSample(DWORD streamIndex, MediaSinkBuffer* buffer, int64_t sampleTime, int64_t duration);
+
+    MediaSinkFormat format = {};
+
+    IMFSinkWriter* sinkWriter = NULL;
+    DWORD videoStreamIndex = MAXDWORD;
+    DWORD audioStreamIndex = MAXDWORD;
+
+    MediaSamplePool* videoSamplePool = nullptr;
+
+#if HARDWARE_ENCODE_VIDEO
+    IMFDXGIDeviceManager* deviceManager = NULL;
+    UINT resetToken = 0;
+#endif
+};
@@ -0,0 +1,236 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+// Pool of media samples for the sink writer, each with one frame sized memory buffer attached.
+// Samples are tracked: once the encoder and the sink writer release the last reference to a sample, it comes back to
+// the pool through Invoke instead of being freed, so recording a frame costs one copy into a pooled buffer and no
+// allocation. Samples handed out hold a reference to the pool, so it outlives its owner until they have all returned.
+
+#pragma once
+
+#include <Windows.h>
+#include <mfapi.h>
+#include <mfidl.h>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+class MediaSamplePool : public IMFAsyncCallback
+{
+public:
+    MediaSamplePool(DWORD bufferSize) :
+        bufferSize(bufferSize)
+    {
+    }
+
+    // Allocate samples until the pool owns at least count, for example as many as can be queued for encoding.
+    HRESULT Reserve(int count)
+    {
+        HRESULT hr = S_OK;
+        while (SUCCEEDED(hr) && sampleCount < count)
+        {
+            IMFSample* sample = NULL;
+            hr = CreateSample(&sample);
+            if (SUCCEEDED(hr))
+            {
+                std::lock_guard<std::mutex> guard(poolLock);
+                freeSamples.push_back(sample);
+            }
+        }
+
+        return hr;
+    }
+
+    // A free sample with its buffer, allocating one if every sample is in use. The caller owns the returned reference,
+    // and the sample comes back to the pool once it and everyone it was passed to have released it.
+    HRESULT Acquire(IMFSample** sample)
+    {
+        if (sample == NULL)
+        {
+            return E_POINTER;
+        }
+
+        IMFSample* pooledSample = NULL;
+        {
+            std::lock_guard<std::mutex> guard(poolLock);
+            if (!freeSamples.empty())
+            {
+                pooledSample = freeSamples.back();
+                freeSamples.pop_back();
+            }
+        }
+
+        HRESULT hr = S_OK;
+        if (pooledSample == NULL)
+        {
+            hr = CreateSample(&pooledSample);
+        }
+
+        // The allocator only applies to the next time the sample is released, so it is set on every Acquire.
+        IMFTrackedSample* trackedSample = NULL;
+        if (SUCCEEDED(hr)) { hr = pooledSample->QueryInterface(IID_PPV_ARGS(&trackedSample)); }
+        if (SUCCEEDED(hr)) { hr = trackedSample->SetAllocator(this, NULL); }
+
+        if (trackedSample != NULL)
+        {
+            trackedSample->Release();
+        }
+
+        if (FAILED(hr))
+        {
+            if (pooledSample != NULL)
+            {
+                pooledSample->Release();
+            }
+
+            return hr;
+        }
+
+        *sample = pooledSample;
+        return S_OK;
+    }
+
+    // Free the samples that are not in use, for example once recording stops. Samples in use return to the pool as usual.
+    void Trim()
+    {
+        std::vector<IMFSample*> samples;
+        {
+            std::lock_guard<std::mutex> guard(poolLock);
+            samples.swap(freeSamples);
+            sampleCount -= (int)samples.size();
+        }
+
+        for (IMFSample* sample : samples)
+        {
+            sample->Release();
+        }
+    }
+
+    // Samples the pool owns, free or in use.
+    int GetSampleCount()
+    {
+        return sampleCount;
+    }
+
+    DWORD GetBufferSize()
+    {
+        return bufferSize;
+    }
+
+    HRESULT STDMETHODCALLTYPE GetParameters(DWORD* flags, DWORD* queue)
+    {
+        return E_NOTIMPL;
+    }
+
+    // Called by a tracked sample once its last reference is released. The result holds the sample.
+    HRESULT STDMETHODCALLTYPE Invoke(IMFAsyncResult* result)
+    {
+        IUnknown* object = NULL;
+        IMFSample* sample = NULL;
+
+        HRESULT hr = result->GetObject(&object);
+        if (SUCCEEDED(hr)) { hr = object->QueryInterface(IID_PPV_ARGS(&sample)); }
+
+        if (object != NULL)
+        {
+            object->Release();
+        }
+
+        if (SUCCEEDED(hr))
+        {
+            // Drop whatever the encoder attached, the buffer stays.
+            sample->DeleteAllItems();
+
+            std::lock_guard<std::mutex> guard(poolLock);
+            freeSamples.push_back(sample);
+        }
+
+        return hr;
+    }
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, LPVOID *ppv)
+    {
+        if (ppv == NULL)
+        {
+            return E_INVALIDARG;
+        }
+
+        if (iid == IID_IUnknown || iid == IID_IMFAsyncCallback)
+        {
+            *ppv = (IMFAsyncCallback*)this;
+            AddRef();
+            return S_OK;
+        }
+
+        *ppv = NULL;
+        return E_NOINTERFACE;
+    }
+
+    ULONG STDMETHODCALLTYPE AddRef()
+    {
+        return InterlockedIncrement(&m_refCount);
+    }
+
+    ULONG STDMETHODCALLTYPE Release()
+    {
+        ULONG newRefValue = InterlockedDecrement(&m_refCount);
+        if (newRefValue == 0)
+        {
+            delete this;
+        }
+
+        return newRefValue;
+    }
+
+private:
+    // Only destroyed through Release, once no sample is in use.
+    virtual ~MediaSamplePool()
+    {
+        for (IMFSample* sample : freeSamples)
+        {
+            sample->Release();
+        }
+    }
+
+    HRESULT CreateSample(IMFSample** sample)
+    {
+        IMFTrackedSample* trackedSample = NULL;
+        IMFSample* newSample = NULL;
+        IMFMediaBuffer* buffer = NULL;
+
+        HRESULT hr = MFCreateTrackedSample(&trackedSample);
+        if (SUCCEEDED(hr)) { hr = trackedSample->QueryInterface(IID_PPV_ARGS(&newSample)); }
+        if (SUCCEEDED(hr)) { hr = MFCreateAlignedMemoryBuffer(bufferSize, MF_64_BYTE_ALIGNMENT, &buffer); }
+        if (SUCCEEDED(hr)) { hr = newSample->AddBuffer(buffer); }
+
+        if (trackedSample != NULL)
+        {
+            trackedSample->Release();
+        }
+
+        if (buffer != NULL)
+        {
+            buffer->Release();
+        }
+
+        if (FAILED(hr))
+        {
+            if (newSample != NULL)
+            {
+                newSample->Release();
+            }
+
+            return hr;
+        }
+
+        sampleCount++;
+        *sample = newSample;
+        return S_OK;
+    }
+
+    ULONG m_refCount = 1;
+    const DWORD bufferSize;
+    std::mutex poolLock;
+    std::vector<IMFSample*> freeSamples;
+    std::atomic<int> sampleCount { 0 };
+};
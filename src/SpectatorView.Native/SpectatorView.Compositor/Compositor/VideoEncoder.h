@@ -1,26 +1,16 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT License. See LICENSE in the project root for license information.
 
-// IMFSinkWriter:
-// https://msdn.microsoft.com/en-us/library/windows/desktop/ff819477(v=vs.85).aspx
+// Records the composited video, and the audio from Unity, into an MP4.
+// Scheduling the frames is up to MediaRecorder, encoding and writing them up to MediaFoundationSink.
 
 #pragma once
 
 #include <Windows.h>
-#include <mfapi.h>
-#include <mfidl.h>
-#include <Mfreadwrite.h>
-#include <mferror.h>
-#include <shared_mutex>
 
 #include "DirectXHelper.h"
-
-#include <queue>
-
-#pragma comment(lib, "mf")
-#pragma comment(lib, "mfreadwrite")
-#pragma comment(lib, "mfplat")
-#pragma comment(lib, "mfuuid")
+#include "MediaFoundationSink.h"
+#include "MediaRecorder.h"
 
 #define INVALID_TIMESTAMP -1
 
@@ -37,85 +27,21 @@ public:
     bool IsRecording();
     void StopRecording();
 
-    // Used for recording video from a background thread.
+    // Used for recording from any thread. The frame is copied before this returns, and written to the file in the
+    // order it was queued by the encoder thread.
     void QueueVideoFrame(byte* buffer, LONGLONG timestamp, LONGLONG duration);
     void QueueAudioFrame(byte* buffer, int bufferSize, LONGLONG timestamp);
 
-    // Do not call this from a background thread.
-    void Update();
-
-private:
-    void WriteVideo(byte* buffer, LONGLONG timestamp, LONGLONG duration);
-    void WriteAudio(byte* buffer, int bufferSize, LONGLONG timestamp);
-
-    LARGE_INTEGER freq;
-
-    class VideoInput
-    {
-    public:
-        byte * sharedBuffer;
-
-        LONGLONG timestamp;
-        LONGLONG duration;
-
-        VideoInput(byte* buffer, LONGLONG timestamp, LONGLONG duration)
-        {
-            this->sharedBuffer = buffer;
-            this->timestamp = timestamp;
-            this->duration = duration;
-        }
-    };
-
-    class AudioInput
-    {
-    public:
-        byte* buffer;
-        LONGLONG timestamp;
-        int bufferSize;
+    static const int DefaultQueueCapacity = MediaRecorder::DefaultQueueCapacity;
 
-        AudioInput(byte* buffer, int buffSize, LONGLONG timestamp)
-        {
-            bufferSize = buffSize;
-            this->buffer = new byte[buffSize];
-            memcpy(this->buffer, buffer, buffSize);
-            this->timestamp = timestamp;
-        }
-    };
+    // What queueing does once the encoder thread has capacity frames and audio buffers waiting.
+    void SetQueuePolicy(QueueFullPolicy policy, int capacity);
+    BoundedQueueStats GetQueueStats();
 
-    IMFSinkWriter* sinkWriter;
-    DWORD videoStreamIndex = MAXDWORD;
-    DWORD audioStreamIndex = MAXDWORD;
-
-    bool isRecording = false;
-    bool acceptQueuedFrames = false;
-
-    // Video Parameters.
-    UINT frameWidth;
-    UINT frameHeight;
-    UINT frameStride;
-    UINT32 fps;
-    UINT32 bitRate;
-    UINT32 videoEncodingMpegLevel;
-    GUID videoEncodingFormat;
-    GUID inputFormat;
-    LONGLONG prevVideoTime = INVALID_TIMESTAMP;
-
-    // Audio Parameters.
-    UINT32 audioSampleRate;
-    UINT32 audioChannels;
-    UINT32 audioBPS;
-    LONGLONG prevAudioTime = INVALID_TIMESTAMP;
-
-    LONGLONG startTime = INVALID_TIMESTAMP;
-
-    std::queue<VideoInput> videoQueue;
-    std::queue<AudioInput> audioQueue;
-
-    std::shared_mutex videoStateLock;
+private:
+    MediaSinkFormat format;
 
-#if HARDWARE_ENCODE_VIDEO
-    IMFDXGIDeviceManager* deviceManager = NULL;
-    UINT resetToken = 0;
-#endif
+    // The recorder stops before the sink it writes to goes away.
+    MediaFoundationSink sink;
+    MediaRecorder recorder { &sink };
 };
-
@@ -0,0 +1,240 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+// CPU kernels for blending one 32 bit image over another with a global alpha factor.
+// All math is integer, every SIMD kernel produces output that is bit-identical to the _Scalar reference.
+
+#pragma once
+
+#include <stdint.h>
+#include "CpuFeatures.h"
+
+enum class BlendMode
+{
+    // Front color is already multiplied by its alpha: back = back * (1 - alpha * frontAlpha) + alpha * front.
+    Premultiplied,
+    // Front color is not multiplied by its alpha: back = back * (1 - alpha * frontAlpha) + alpha * frontAlpha * front.
+    Straight
+};
+
+class AlphaBlending
+{
+public:
+    // Convert a global alpha in [0, 1] to the 8 bit factor used by the kernels.
+    static uint8_t AlphaToByte(float alpha)
+    {
+        if (alpha <= 0.0f)
+        {
+            return 0;
+        }
+
+        if (alpha >= 1.0f)
+        {
+            return 255;
+        }
+
+        return (uint8_t)(alpha * 255.0f + 0.5f);
+    }
+
+    // Blend pixelCount pixels of front over back in place. Alpha is the last byte of each pixel, the other three
+    // channels are treated alike, so BGRA and RGBA both work as long as both images use the same order.
+    // Output alpha is opaque.
+    static void BlendRow(uint8_t* back, const uint8_t* front, int pixelCount, uint8_t alpha, BlendMode mode = BlendMode::Premultiplied)
+    {
+        switch (CpuFeatures::GetSimdLevel())
+        {
+#if defined(SV_SIMD_X86)
+        case SimdLevel::AVX2:
+            BlendRow_AVX2(back, front, pixelCount, alpha, mode);
+            return;
+        case SimdLevel::SSE41:
+            BlendRow_SSE41(back, front, pixelCount, alpha, mode);
+            return;
+#elif defined(SV_SIMD_NEON)
+        case SimdLevel::NEON:
+            BlendRow_NEON(back, front, pixelCount, alpha, mode);
+            return;
+#endif
+        default:
+            BlendRow_Scalar(back, front, pixelCount, alpha, mode);
+            return;
+        }
+    }
+
+    // x / 255 rounded to nearest, exact for every product of two bytes.
+    static inline int DivideBy255(int x)
+    {
+        x += 128;
+        return (x + (x >> 8)) >> 8;
+    }
+
+    // Reference implementation.
+    static void BlendRow_Scalar(uint8_t* back, const uint8_t* front, int pixelCount, uint8_t alpha, BlendMode mode)
+    {
+        const bool premultiplied = (mode == BlendMode::Premultiplied);
+
+        for (int i = 0; i < pixelCount * 4; i += 4)
+        {
+            int frontAlpha = DivideBy255(alpha * front[i + 3]);
+            int inverse = 255 - frontAlpha;
+
+            for (int c = 0; c < 3; c++)
+            {
+                int value;
+                if (premultiplied)
+                {
+                    value = DivideBy255(back[i + c] * inverse) + DivideBy255(front[i + c] * alpha);
+                }
+                else
+                {
+                    value = DivideBy255(back[i + c] * inverse + front[i + c] * frontAlpha);
+                }
+
+                back[i + c] = (uint8_t)(value > 255 ? 255 : value);
+            }
+
+            back[i + 3] = 255;
+        }
+    }
+
+#if defined(SV_SIMD_X86)
+    // 4 pixels per iteration, each pixel takes four 16 bit lanes.
+    SV_TARGET_SSE41 static void BlendRow_SSE41(uint8_t* back, const uint8_t* front, int pixelCount, uint8_t alpha, BlendMode mode)
+    {
+        const bool premultiplied = (mode == BlendMode::Premultiplied);
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i globalAlpha = _mm_set1_epi16(alpha);
+        const __m128i opaque = _mm_set1_epi32((int)0xFF000000);
+
+        int i = 0;
+        for (; i + 4 <= pixelCount; i += 4)
+        {
+            __m128i b = _mm_loadu_si128((const __m128i*)(back + i * 4));
+            __m128i f = _mm_loadu_si128((const __m128i*)(front + i * 4));
+
+            __m128i low = BlendSSE(_mm_unpacklo_epi8(b, zero), _mm_unpacklo_epi8(f, zero), globalAlpha, premultiplied);
+            __m128i high = BlendSSE(_mm_unpackhi_epi8(b, zero), _mm_unpackhi_epi8(f, zero), globalAlpha, premultiplied);
+
+            _mm_storeu_si128((__m128i*)(back + i * 4), _mm_or_si128(_mm_packus_epi16(low, high), opaque));
+        }
+
+        BlendRow_Scalar(back + i * 4, front + i * 4, pixelCount - i, alpha, mode);
+    }
+
+    // 8 pixels per iteration. Unpacking and packing both stay inside each 128 bit lane, so pixel order is kept.
+    SV_TARGET_AVX2 static void BlendRow_AVX2(uint8_t* back, const uint8_t* front, int pixelCount, uint8_t alpha, BlendMode mode)
+    {
+        const bool premultiplied = (mode == BlendMode::Premultiplied);
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i globalAlpha = _mm256_set1_epi16(alpha);
+        const __m256i opaque = _mm256_set1_epi32((int)0xFF000000);
+
+        int i = 0;
+        for (; i + 8 <= pixelCount; i += 8)
+        {
+            __m256i b = _mm256_loadu_si256((const __m256i*)(back + i * 4));
+            __m256i f = _mm256_loadu_si256((const __m256i*)(front + i * 4));
+
+            __m256i low = BlendAVX2(_mm256_unpacklo_epi8(b, zero), _mm256_unpacklo_epi8(f, zero), globalAlpha, premultiplied);
+            __m256i high = BlendAVX2(_mm256_unpackhi_epi8(b, zero), _mm256_unpackhi_epi8(f, zero), globalAlpha, premultiplied);
+
+            _mm256_storeu_si256((__m256i*)(back + i * 4), _mm256_or_si256(_mm256_packus_epi16(low, high), opaque));
+        }
+
+        BlendRow_SSE41(back + i * 4, front + i * 4, pixelCount - i, alpha, mode);
+    }
+#endif
+
+#if defined(SV_SIMD_NEON)
+    // 8 pixels per iteration, channels are split into separate registers on load.
+    static void BlendRow_NEON(uint8_t* back, const uint8_t* front, int pixelCount, uint8_t alpha, BlendMode mode)
+    {
+        const bool premultiplied = (mode == BlendMode::Premultiplied);
+        const uint8x8_t globalAlpha = vdup_n_u8(alpha);
+        const uint8x8_t max = vdup_n_u8(255);
+
+        int i = 0;
+        for (; i + 8 <= pixelCount; i += 8)
+        {
+            uint8x8x4_t b = vld4_u8(back + i * 4);
+            uint8x8x4_t f = vld4_u8(front + i * 4);
+
+            uint8x8_t frontAlpha = vmovn_u16(DivideBy255NEON(vmull_u8(f.val[3], globalAlpha)));
+            uint8x8_t inverse = vsub_u8(max, frontAlpha);
+
+            for (int c = 0; c < 3; c++)
+            {
+                if (premultiplied)
+                {
+                    uint16x8_t backTerm = DivideBy255NEON(vmull_u8(b.val[c], inverse));
+                    uint16x8_t frontTerm = DivideBy255NEON(vmull_u8(f.val[c], globalAlpha));
+                    b.val[c] = vqmovn_u16(vaddq_u16(backTerm, frontTerm));
+                }
+                else
+                {
+                    b.val[c] = vmovn_u16(DivideBy255NEON(vmlal_u8(vmull_u8(b.val[c], inverse), f.val[c], frontAlpha)));
+                }
+            }
+
+            b.val[3] = max;
+            vst4_u8(back + i * 4, b);
+        }
+
+        BlendRow_Scalar(back + i * 4, front + i * 4, pixelCount - i, alpha, mode);
+    }
+#endif
+
+private:
+#if defined(SV_SIMD_X86)
+    SV_TARGET_SSE41 static inline __m128i DivideBy255SSE(__m128i x)
+    {
+        x = _mm_add_epi16(x, _mm_set1_epi16(128));
+        return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+    }
+
+    // Blend two pixels given as 16 bit lanes. The alpha lane is overwritten by the caller.
+    SV_TARGET_SSE41 static inline __m128i BlendSSE(__m128i back, __m128i front, __m128i globalAlpha, bool premultiplied)
+    {
+        __m128i frontAlpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(front, 0xFF), 0xFF);
+        frontAlpha = DivideBy255SSE(_mm_mullo_epi16(frontAlpha, globalAlpha));
+        __m128i inverse = _mm_sub_epi16(_mm_set1_epi16(255), frontAlpha);
+
+        if (premultiplied)
+        {
+            // Each term is at most 255, the final pack saturates the sum.
+            return _mm_add_epi16(DivideBy255SSE(_mm_mullo_epi16(back, inverse)), DivideBy255SSE(_mm_mullo_epi16(front, globalAlpha)));
+        }
+
+        // The weights sum to 255, so the unsigned 16 bit sum cannot overflow.
+        return DivideBy255SSE(_mm_add_epi16(_mm_mullo_epi16(back, inverse), _mm_mullo_epi16(front, frontAlpha)));
+    }
+
+    SV_TARGET_AVX2 static inline __m256i DivideBy255AVX2(__m256i x)
+    {
+        x = _mm256_add_epi16(x, _mm256_set1_epi16(128));
+        return _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+    }
+
+    SV_TARGET_AVX2 static inline __m256i BlendAVX2(__m256i back, __m256i front, __m256i globalAlpha, bool premultiplied)
+    {
+        __m256i frontAlpha = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(front, 0xFF), 0xFF);
+        frontAlpha = DivideBy255AVX2(_mm256_mullo_epi16(frontAlpha, globalAlpha));
+        __m256i inverse = _mm256_sub_epi16(_mm256_set1_epi16(255), frontAlpha);
+
+        if (premultiplied)
+        {
+            return _mm256_add_epi16(DivideBy255AVX2(_mm256_mullo_epi16(back, inverse)), DivideBy255AVX2(_mm256_mullo_epi16(front, globalAlpha)));
+        }
+
+        return DivideBy255AVX2(_mm256_add_epi16(_mm256_mullo_epi16(back, inverse), _mm256_mullo_epi16(front, frontAlpha)));
+    }
+#endif
+
+#if defined(SV_SIMD_NEON)
+    static inline uint16x8_t DivideBy255NEON(uint16x8_t x)
+    {
+        x = vaddq_u16(x, vdupq_n_u16(128));
+        return vshrq_n_u16(vaddq_u16(x, vshrq_n_u16(x, 8)), 8);
+    }
+#endif
+};
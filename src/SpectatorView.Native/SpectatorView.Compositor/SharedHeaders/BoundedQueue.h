@@ -0,0 +1,212 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+// First in, first out queue of bounded length, with any number of producers and one consumer thread.
+// A producer that finds the queue full either waits for the consumer to make room, which pushes back on the producer,
+// or drops the oldest item to make room for its own, which keeps the producer running at the cost of the consumer
+// skipping items. Either way the queue counts how often producers found it full and for how long they waited.
+
+#pragma once
+
+#include <stdint.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+enum class QueueFullPolicy
+{
+    // Producers wait until the consumer has taken an item.
+    Block = 0,
+    // Producers drop the oldest queued item.
+    DropOldest
+};
+
+struct BoundedQueueStats
+{
+    // Items queued now, and the most that have been queued at once.
+    int depth;
+    int peakDepth;
+    int capacity;
+    uint64_t pushed;
+    // Items dropped to make room for newer ones.
+    uint64_t dropped;
+    // Pushes that found the queue full, and the time producers spent waiting for room in total.
+    uint64_t stalls;
+    double stallMilliseconds;
+};
+
+enum class QueuePushResult
+{
+    Pushed = 0,
+    // Pushed after dropping the oldest item, which the producer now owns.
+    PushedDroppingOldest,
+    // The queue is closed, the item was not pushed and the producer still owns it.
+    Closed
+};
+
+template <typename T>
+class BoundedQueue
+{
+public:
+    BoundedQueue(int capacity, QueueFullPolicy policy = QueueFullPolicy::Block)
+    {
+        SetCapacity(capacity);
+        SetPolicy(policy);
+    }
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    // Applies to pushes from now on, items already queued stay.
+    void SetCapacity(int newCapacity)
+    {
+        {
+            std::lock_guard<std::mutex> guard(queueLock);
+            capacity = (newCapacity < 1) ? 1 : newCapacity;
+        }
+
+        notFull.notify_all();
+    }
+
+    int GetCapacity() const
+    {
+        std::lock_guard<std::mutex> guard(queueLock);
+        return capacity;
+    }
+
+    void SetPolicy(QueueFullPolicy newPolicy)
+    {
+        {
+            std::lock_guard<std::mutex> guard(queueLock);
+            policy = newPolicy;
+        }
+
+        notFull.notify_all();
+    }
+
+    // Producers: queue item. If the oldest item was dropped for it, dropped gets that item.
+    QueuePushResult Push(const T& item, T* dropped)
+    {
+        std::unique_lock<std::mutex> guard(queueLock);
+        if (closed)
+        {
+            return QueuePushResult::Closed;
+        }
+
+        QueuePushResult result = QueuePushResult::Pushed;
+        if ((int)items.size() >= capacity)
+        {
+            stalls++;
+
+            if (policy == QueueFullPolicy::DropOldest)
+            {
+                *dropped = items.front();
+                items.pop_front();
+                droppedItems++;
+                result = QueuePushResult::PushedDroppingOldest;
+            }
+            else
+            {
+                auto waitStart = std::chrono::steady_clock::now();
+                notFull.wait(guard, [&] { return closed || (int)items.size() < capacity || policy != QueueFullPolicy::Block; });
+                stallTime += std::chrono::steady_clock::now() - waitStart;
+
+                if (closed)
+                {
+                    return QueuePushResult::Closed;
+                }
+
+                // The policy changed while waiting.
+                if ((int)items.size() >= capacity)
+                {
+                    *dropped = items.front();
+                    items.pop_front();
+                    droppedItems++;
+                    result = QueuePushResult::PushedDroppingOldest;
+                }
+            }
+        }
+
+        items.push_back(item);
+        pushed++;
+        peakDepth = ((int)items.size() > peakDepth) ? (int)items.size() : peakDepth;
+
+        guard.unlock();
+        notEmpty.notify_one();
+        return result;
+    }
+
+    // Consumer: wait for the oldest item. Returns false once the queue is closed and every item has been taken.
+    bool Pop(T* item)
+    {
+        std::unique_lock<std::mutex> guard(queueLock);
+        notEmpty.wait(guard, [&] { return closed || !items.empty(); });
+        if (items.empty())
+        {
+            return false;
+        }
+
+        *item = items.front();
+        items.pop_front();
+
+        guard.unlock();
+        notFull.notify_one();
+        return true;
+    }
+
+    // Refuse new items and wake every waiting producer. The consumer still takes the items already queued.
+    void Close()
+    {
+        {
+            std::lock_guard<std::mutex> guard(queueLock);
+            closed = true;
+        }
+
+        notFull.notify_all();
+        notEmpty.notify_all();
+    }
+
+    // Accept items again, starting the counters over. Only call this while the queue is empty.
+    void Open()
+    {
+        std::lock_guard<std::mutex> guard(queueLock);
+        closed = false;
+        peakDepth = 0;
+        pushed = 0;
+        droppedItems = 0;
+        stalls = 0;
+        stallTime = std::chrono::steady_clock::duration::zero();
+    }
+
+    BoundedQueueStats GetStats() const
+    {
+        std::lock_guard<std::mutex> guard(queueLock);
+
+        BoundedQueueStats stats;
+        stats.depth = (int)items.size();
+        stats.peakDepth = peakDepth;
+        stats.capacity = capacity;
+        stats.pushed = pushed;
+        stats.dropped = droppedItems;
+        stats.stalls = stalls;
+        stats.stallMilliseconds = std::chrono::duration<double, std::milli>(stallTime).count();
+        return stats;
+    }
+
+private:
+    mutable std::mutex queueLock;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    std::deque<T> items;
+
+    int capacity = 1;
+    QueueFullPolicy policy = QueueFullPolicy::Block;
+    bool closed = false;
+
+    int peakDepth = 0;
+    uint64_t pushed = 0;
+    uint64_t droppedItems = 0;
+    uint64_t stalls = 0;
+    std::chrono::steady_clock::duration stallTime = std::chrono::steady_clock::duration::zero();
+};
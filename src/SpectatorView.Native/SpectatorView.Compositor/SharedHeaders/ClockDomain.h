@@ -0,0 +1,219 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+// Maps timestamps from a capture device's clock into the host clock, QueryPerformanceCounter for the compositor.
+// Devices stamp frames when their hardware receives them, which is free of the jitter of the callback that delivers
+// them, but on a clock of their own that runs at a slightly different rate. Each frame pairs its device timestamp
+// with the host time its callback ran, and an online linear regression over those pairs tracks the offset and drift
+// between the clocks. The regression forgets old pairs exponentially, so it follows slow drift, like a warming
+// crystal, and a pair that lands far off the fit, like a callback that was held up, is left out of it.
+
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+
+struct ClockDomainFit
+{
+    // Pairs the current fit is made of, and pairs left out of it as outliers.
+    int samples;
+    int rejectedSamples;
+    // How much faster the device clock runs than the host clock, in parts per million.
+    double driftPpm;
+    // Root mean square distance of the host times from the fit, in microseconds.
+    // This is mostly the jitter of the callbacks, mapped timestamps are far closer than this.
+    double residualMicroseconds;
+};
+
+class ClockDomainMapper
+{
+public:
+    // Until the fit has this many pairs, the clocks are assumed to run at their nominal rates.
+    static const int MinimumSamples = 30;
+    // Pairs weigh in with a time constant of about a minute of 30 fps capture.
+    static const int WindowSamples = 1800;
+    // A pair further from the fit than this many residuals, and at least a millisecond, is an outlier.
+    static const int OutlierResiduals = 4;
+    // After this many outliers in a row the device clock is assumed to have jumped, and the fit starts over.
+    static const int MaximumConsecutiveOutliers = 30;
+
+    ClockDomainMapper()
+    {
+        SetClockRates(1, 1);
+    }
+
+    // Ticks per second of the device and host clocks. This forgets the current fit.
+    void SetClockRates(int64_t deviceTicksPerSecond, int64_t hostTicksPerSecond)
+    {
+        nominalSlope = (double)hostTicksPerSecond / (double)deviceTicksPerSecond;
+        hostTicksPerMicrosecond = (double)hostTicksPerSecond / 1000000.0;
+        Reset();
+    }
+
+    // Forget the current fit, for example when the device restarts its clock.
+    void Reset()
+    {
+        samples = 0;
+        rejectedSamples = 0;
+        consecutiveOutliers = 0;
+        weight = 0.0;
+        meanDevice = 0.0;
+        meanHost = 0.0;
+        deviceDeviceMoment = 0.0;
+        deviceHostMoment = 0.0;
+        hostHostMoment = 0.0;
+        PublishFit();
+    }
+
+    // Capture thread: add the device timestamp of a frame and the host time its callback ran.
+    // Returns the device timestamp mapped into the host clock by the fit that includes it.
+    int64_t AddSample(int64_t deviceTime, int64_t hostTime)
+    {
+        if (samples == 0)
+        {
+            deviceOrigin = deviceTime;
+            hostOrigin = hostTime;
+        }
+
+        double x = (double)(deviceTime - deviceOrigin);
+        double y = (double)(hostTime - hostOrigin);
+
+        if (samples >= MinimumSamples)
+        {
+            double residual = fabs(y - Predict(x));
+            double limit = (std::max)(OutlierResiduals * ResidualTicks(), 1000.0 * hostTicksPerMicrosecond);
+            if (residual > limit)
+            {
+                rejectedSamples++;
+                if (++consecutiveOutliers < MaximumConsecutiveOutliers)
+                {
+                    PublishFit();
+                    return ToHost(deviceTime);
+                }
+
+                Reset();
+                return AddSample(deviceTime, hostTime);
+            }
+        }
+
+        consecutiveOutliers = 0;
+
+        // Exponentially weighted running means and co-moments, updated in the stable form rather than as raw sums,
+        // so the precision does not depend on how far the clocks have run from their origins.
+        const double forget = 1.0 - 1.0 / WindowSamples;
+        weight = weight * forget + 1.0;
+        double deviceDelta = x - meanDevice;
+        double hostDelta = y - meanHost;
+        meanDevice += deviceDelta / weight;
+        meanHost += hostDelta / weight;
+        deviceDeviceMoment = deviceDeviceMoment * forget + deviceDelta * (x - meanDevice);
+        deviceHostMoment = deviceHostMoment * forget + deviceDelta * (y - meanHost);
+        hostHostMoment = hostHostMoment * forget + hostDelta * (y - meanHost);
+        samples++;
+
+        PublishFit();
+        return ToHost(deviceTime);
+    }
+
+    // Capture thread: a device timestamp mapped into the host clock, or unchanged before the first pair.
+    int64_t ToHost(int64_t deviceTime) const
+    {
+        if (samples == 0)
+        {
+            return deviceTime;
+        }
+
+        return hostOrigin + (int64_t)llround(Predict((double)(deviceTime - deviceOrigin)));
+    }
+
+    // The quality of the fit, from any thread. Retries while the capture thread publishes, which never waits on this.
+    ClockDomainFit GetFit() const
+    {
+        ClockDomainFit current;
+        while (true)
+        {
+            unsigned int before = fitSequence.load(std::memory_order_acquire);
+            current.samples = fitSamples.load(std::memory_order_relaxed);
+            current.rejectedSamples = fitRejectedSamples.load(std::memory_order_relaxed);
+            current.driftPpm = fitDriftPpm.load(std::memory_order_relaxed);
+            current.residualMicroseconds = fitResidualMicroseconds.load(std::memory_order_relaxed);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if ((before & 1) == 0 && fitSequence.load(std::memory_order_relaxed) == before)
+            {
+                return current;
+            }
+        }
+    }
+
+private:
+    double Slope() const
+    {
+        if (samples < MinimumSamples || deviceDeviceMoment <= 0.0)
+        {
+            return nominalSlope;
+        }
+
+        return deviceHostMoment / deviceDeviceMoment;
+    }
+
+    double Predict(double x) const
+    {
+        return meanHost + Slope() * (x - meanDevice);
+    }
+
+    double ResidualTicks() const
+    {
+        if (weight <= 0.0)
+        {
+            return 0.0;
+        }
+
+        double slope = Slope();
+        double squaredResiduals = hostHostMoment - 2.0 * slope * deviceHostMoment + slope * slope * deviceDeviceMoment;
+        return sqrt((std::max)(squaredResiduals, 0.0) / weight);
+    }
+
+    // Like a seqlock: the sequence is odd while the fit is written, and readers retry if it changed under them.
+    void PublishFit()
+    {
+        double driftPpm = (samples < MinimumSamples) ? 0.0 : (nominalSlope / Slope() - 1.0) * 1000000.0;
+        double residualMicroseconds = ResidualTicks() / hostTicksPerMicrosecond;
+
+        unsigned int sequence = fitSequence.load(std::memory_order_relaxed);
+        fitSequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        fitSamples.store(samples, std::memory_order_relaxed);
+        fitRejectedSamples.store(rejectedSamples, std::memory_order_relaxed);
+        fitDriftPpm.store(driftPpm, std::memory_order_relaxed);
+        fitResidualMicroseconds.store(residualMicroseconds, std::memory_order_relaxed);
+
+        fitSequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    double nominalSlope;
+    double hostTicksPerMicrosecond;
+
+    // Only touched by the capture thread. Times are kept relative to the first pair, so doubles hold them exactly.
+    int64_t deviceOrigin = 0;
+    int64_t hostOrigin = 0;
+    int samples;
+    int rejectedSamples;
+    int consecutiveOutliers;
+    double weight;
+    double meanDevice;
+    double meanHost;
+    double deviceDeviceMoment;
+    double deviceHostMoment;
+    double hostHostMoment;
+
+    // The fit as GetFit reads it, only written by PublishFit.
+    std::atomic<unsigned int> fitSequence { 0 };
+    std::atomic<int> fitSamples { 0 };
+    std::atomic<int> fitRejectedSamples { 0 };
+    std::atomic<double> fitDriftPpm { 0.0 };
+    std::atomic<double> fitResidualMicroseconds { 0.0 };
+};
@@ -9,6 +9,12 @@
 //TODO: Set this to true if using a USB 3 external BlackMagic Shuttle capture card.
 #define USE_DECKLINK_SHUTTLE    FALSE
 
+//TODO: Set this to true to capture 10 bit YUV from a BlackMagic card that supports it, if your camera outputs 10 bit.
+// Only used when frames are converted on the CPU. Each frame is decoded to RGB from all 10 bits on capture, so it is
+// rounded once instead of being cut to 8 bit YUV first, which keeps gradients smoother but costs a few milliseconds
+// of CPU time per 1080p frame.
+#define CAPTURE_10BIT_YUV       FALSE
+
 // Audio
 //TODO: Set this to true to encode audio with captured video.
 //NOTE: If you do not have Audio data, set this to false or the video may encode incorrectly.
@@ -0,0 +1,216 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+// Persistent worker threads that split pixel conversions into row bands.
+// Jobs are described by a pointer to the caller's callable, so dispatching a conversion never allocates.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "ThreadRoles.h"
+
+class ConversionThreadPool
+{
+public:
+    // Bands are sized to stay resident in a per-core L2 cache while they are converted.
+    static const int BandBytes = 256 * 1024;
+
+    // Upper bound for the default worker count, more threads than this only compete with capture and rendering.
+    static const int MaxDefaultWorkers = 8;
+
+    // The pool is never destroyed: joining threads from a static destructor deadlocks on the loader lock when the plugin unloads.
+    static ConversionThreadPool& Instance()
+    {
+        static ConversionThreadPool* pool = new ConversionThreadPool();
+        return *pool;
+    }
+
+    // Number of threads that help the calling thread, 0 converts everything on the calling thread.
+    // A negative count restores the default, which is based on the number of logical processors.
+    void SetWorkerCount(int workerCount)
+    {
+        std::lock_guard<std::mutex> dispatch(dispatchLock);
+
+        if (workerCount < 0)
+        {
+            workerCount = GetDefaultWorkerCount();
+        }
+
+        if (workerCount == (int)workers.size())
+        {
+            return;
+        }
+
+        StopWorkers();
+        StartWorkers(workerCount);
+    }
+
+    int GetWorkerCount()
+    {
+        std::lock_guard<std::mutex> dispatch(dispatchLock);
+        return (int)workers.size();
+    }
+
+    static int RowsPerBand(int rowBytes)
+    {
+        return (std::max)(1, BandBytes / (std::max)(1, rowBytes));
+    }
+
+    // Call convertRows(firstRow, endRow) for consecutive bands covering [0, rowCount).
+    // Bands run on the workers and the calling thread, this returns once every band is done.
+    // If another thread is already dispatching, the bands run on the calling thread instead of waiting.
+    template <typename Fn>
+    void ParallelFor(int rowCount, int rowsPerBand, const Fn& convertRows)
+    {
+        if (rowCount <= 0)
+        {
+            return;
+        }
+
+        rowsPerBand = (std::max)(1, rowsPerBand);
+        int bands = (rowCount + rowsPerBand - 1) / rowsPerBand;
+
+        std::unique_lock<std::mutex> dispatch(dispatchLock, std::try_to_lock);
+        if (!dispatch.owns_lock() || workers.empty() || bands == 1)
+        {
+            convertRows(0, rowCount);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            job.invoke = &Invoke<Fn>;
+            job.context = &convertRows;
+            job.rowCount = rowCount;
+            job.rowsPerBand = rowsPerBand;
+            job.bandCount = bands;
+            nextBand.store(0);
+            busyWorkers = (int)workers.size();
+            generation++;
+        }
+        workAvailable.notify_all();
+
+        RunBands(job);
+
+        std::unique_lock<std::mutex> guard(lock);
+        workDone.wait(guard, [this] { return busyWorkers == 0; });
+    }
+
+private:
+    struct Job
+    {
+        void(*invoke)(const void* context, int firstRow, int endRow) = nullptr;
+        const void* context = nullptr;
+        int rowCount = 0;
+        int rowsPerBand = 1;
+        int bandCount = 0;
+    };
+
+    ConversionThreadPool()
+    {
+        StartWorkers(GetDefaultWorkerCount());
+    }
+
+    ConversionThreadPool(const ConversionThreadPool&) = delete;
+    ConversionThreadPool& operator=(const ConversionThreadPool&) = delete;
+
+    static int GetDefaultWorkerCount()
+    {
+        int processors = (int)std::thread::hardware_concurrency();
+        return (std::max)(0, (std::min)(processors, (int)MaxDefaultWorkers) - 1);
+    }
+
+    template <typename Fn>
+    static void Invoke(const void* context, int firstRow, int endRow)
+    {
+        (*static_cast<const Fn*>(context))(firstRow, endRow);
+    }
+
+    void RunBands(const Job& current)
+    {
+        for (int band = nextBand.fetch_add(1); band < current.bandCount; band = nextBand.fetch_add(1))
+        {
+            int firstRow = band * current.rowsPerBand;
+            int endRow = (std::min)(current.rowCount, firstRow + current.rowsPerBand);
+            current.invoke(current.context, firstRow, endRow);
+        }
+    }
+
+    void WorkerLoop(unsigned long long seenGeneration)
+    {
+        ThreadRoleScope threadRole(ThreadRole::Transform);
+
+        while (true)
+        {
+            Job current;
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                workAvailable.wait(guard, [&] { return stopping || generation != seenGeneration; });
+                if (stopping)
+                {
+                    return;
+                }
+
+                seenGeneration = generation;
+                current = job;
+            }
+
+            ThreadRoles::Instance().Apply(ThreadRole::Transform);
+            RunBands(current);
+
+            bool lastWorker = false;
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                lastWorker = (--busyWorkers == 0);
+            }
+
+            if (lastWorker)
+            {
+                workDone.notify_one();
+            }
+        }
+    }
+
+    // Callers must hold dispatchLock.
+    void StartWorkers(int workerCount)
+    {
+        stopping = false;
+        workers.reserve(workerCount);
+        for (int i = 0; i < workerCount; i++)
+        {
+            workers.emplace_back(&ConversionThreadPool::WorkerLoop, this, generation);
+        }
+    }
+
+    void StopWorkers()
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        workAvailable.notify_all();
+
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+        workers.clear();
+    }
+
+    std::mutex dispatchLock;
+    std::mutex lock;
+    std::condition_variable workAvailable;
+    std::condition_variable workDone;
+    std::vector<std::thread> workers;
+
+    Job job;
+    std::atomic<int> nextBand{ 0 };
+    int busyWorkers = 0;
+    unsigned long long generation = 0;
+    bool stopping = false;
+};
@@ -0,0 +1,128 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+// Runtime detection of the SIMD instruction sets used by the CPU pixel kernels.
+
+#pragma once
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SV_SIMD_X86 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#include <immintrin.h>
+#elif defined(_M_ARM64) || defined(_M_ARM) || defined(__aarch64__) || defined(__ARM_NEON)
+#define SV_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+// MSVC allows any intrinsic in any function, GCC and Clang need the target ISA on the function itself.
+#if defined(SV_SIMD_X86) && !defined(_MSC_VER)
+#define SV_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define SV_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SV_TARGET_SSE41
+#define SV_TARGET_AVX2
+#endif
+
+enum class SimdLevel
+{
+    Scalar = 0,
+    SSE41,
+    AVX2,
+    NEON
+};
+
+class CpuFeatures
+{
+public:
+    // Highest instruction set the pixel kernels may use on this machine.
+    static SimdLevel GetSimdLevel()
+    {
+        static const SimdLevel level = DetectSimdLevel();
+        return level;
+    }
+
+    static const char* GetSimdLevelName(SimdLevel level)
+    {
+        switch (level)
+        {
+        case SimdLevel::SSE41: return "SSE4.1";
+        case SimdLevel::AVX2: return "AVX2";
+        case SimdLevel::NEON: return "NEON";
+        default: return "Scalar";
+        }
+    }
+
+private:
+    static SimdLevel DetectSimdLevel()
+    {
+#if defined(SV_SIMD_X86)
+        int info[4] = { 0 };
+        Cpuid(info, 0, 0);
+        int maxLeaf = info[0];
+
+        Cpuid(info, 1, 0);
+        bool sse41 = (info[2] & (1 << 19)) != 0;
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+
+        bool avx2 = false;
+        if (maxLeaf >= 7 && avx && osxsave)
+        {
+            // The OS must save the YMM registers on context switches before AVX can be used.
+            if ((ReadXCR0() & 0x6) == 0x6)
+            {
+                Cpuid(info, 7, 0);
+                avx2 = (info[1] & (1 << 5)) != 0;
+            }
+        }
+
+        if (avx2)
+        {
+            return SimdLevel::AVX2;
+        }
+
+        if (sse41)
+        {
+            return SimdLevel::SSE41;
+        }
+
+        return SimdLevel::Scalar;
+#elif defined(SV_SIMD_NEON)
+        // NEON is mandatory on every ARM target this plugin builds for.
+        return SimdLevel::NEON;
+#else
+        return SimdLevel::Scalar;
+#endif
+    }
+
+#if defined(SV_SIMD_X86)
+    static void Cpuid(int info[4], int leaf, int subleaf)
+    {
+#if defined(_MSC_VER)
+        __cpuidex(info, leaf, subleaf);
+#else
+        unsigned int a, b, c, d;
+        __cpuid_count(leaf, subleaf, a, b, c, d);
+        info[0] = (int)a;
+        info[1] = (int)b;
+        info[2] = (int)c;
+        info[3] = (int)d;
+#endif
+    }
+
+    static unsigned long long ReadXCR0()
+    {
+#if defined(_MSC_VER)
+        return _xgetbv(0);
+#else
+        unsigned int lo, hi;
+        __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+        return ((unsigned long long)hi << 32) | lo;
+#endif
+    }
+#endif
+};
@@ -0,0 +1,269 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+// CPU deinterlacing for interlaced capture modes like 1080i, where each frame holds two fields captured half a frame apart.
+// Field 0 is the even rows (0, 2, 4, ...), field 1 the odd rows. Every byte is filtered on its own, so the kernels
+// work on any interleaved 8 bit format, like UYVY and BGRA.
+// Every SIMD kernel produces output that is bit-identical to the _Scalar reference.
+
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ConversionThreadPool.h"
+#include "CpuFeatures.h"
+#include "ImageView.h"
+
+enum class DeinterlaceMode
+{
+    // Frames are used as captured. Correct for progressive sources, combs on motion for interlaced ones.
+    Weave,
+    // Each field is stretched to a full frame on its own, so every captured frame yields two at twice the rate.
+    Bob,
+    // One frame per captured frame. Rows of the second field are kept, rows of the first field are woven in where
+    // nothing moved since the previous frame and interpolated where something did.
+    MotionAdaptive
+};
+
+class Deinterlacing
+{
+public:
+    // Largest change between frames, per byte, that still counts as static. Sensor noise stays below this.
+    static const uint8_t DefaultMotionThreshold = 12;
+
+    // Rebuild a full frame from the rows of one field of frame, interpolating the rows of the other field.
+    // Writing to frame itself is supported, the rows of the kept field are left untouched.
+    static void Bob(const ImageView& frame, const ImageView& output, int field)
+    {
+        int height = frame.height;
+        int rowBytes = frame.RowBytes();
+
+        ConversionThreadPool::Instance().ParallelFor(height, ConversionThreadPool::RowsPerBand(rowBytes * 2), [&](int firstRow, int endRow)
+        {
+            for (int y = firstRow; y < endRow; y++)
+            {
+                if ((y & 1) == field)
+                {
+                    if (output.Row(y) != frame.Row(y))
+                    {
+                        memcpy(output.Row(y), frame.Row(y), rowBytes);
+                    }
+
+                    continue;
+                }
+
+                int above = (y > 0) ? y - 1 : y + 1;
+                int below = (y + 1 < height) ? y + 1 : y - 1;
+                InterpolateRow(frame.Row(above), frame.Row(below), output.Row(y), rowBytes);
+            }
+        });
+    }
+
+    // Deinterlace frame in place, keeping the rows of keptField. previousFrame is the frame captured before it,
+    // only its rows of keptField are read, so it may itself have been deinterlaced this way.
+    static void MotionAdaptive(const ImageView& frame, const ImageView& previousFrame, int keptField, uint8_t threshold = DefaultMotionThreshold)
+    {
+        int height = frame.height;
+        int rowBytes = frame.RowBytes();
+
+        ConversionThreadPool::Instance().ParallelFor(height, ConversionThreadPool::RowsPerBand(rowBytes * 4), [&](int firstRow, int endRow)
+        {
+            for (int y = firstRow; y < endRow; y++)
+            {
+                if ((y & 1) == keptField)
+                {
+                    continue;
+                }
+
+                int above = (y > 0) ? y - 1 : y + 1;
+                int below = (y + 1 < height) ? y + 1 : y - 1;
+                MotionAdaptiveRow(frame.Row(above), frame.Row(below), previousFrame.Row(above), previousFrame.Row(below), frame.Row(y), rowBytes, threshold);
+            }
+        });
+    }
+
+    // output = average of the rows above and below, rounded up.
+    static void InterpolateRow(const uint8_t* above, const uint8_t* below, uint8_t* output, int byteCount)
+    {
+        switch (CpuFeatures::GetSimdLevel())
+        {
+#if defined(SV_SIMD_X86)
+        case SimdLevel::AVX2:
+            InterpolateRow_AVX2(above, below, output, byteCount);
+            return;
+        case SimdLevel::SSE41:
+            InterpolateRow_SSE41(above, below, output, byteCount);
+            return;
+#elif defined(SV_SIMD_NEON)
+        case SimdLevel::NEON:
+            InterpolateRow_NEON(above, below, output, byteCount);
+            return;
+#endif
+        default:
+            InterpolateRow_Scalar(above, below, output, byteCount);
+            return;
+        }
+    }
+
+    // Motion is the larger change of the rows above and below since the previous frame. Where it is above threshold,
+    // current is replaced by the average of above and below, elsewhere it is kept.
+    static void MotionAdaptiveRow(const uint8_t* above, const uint8_t* below, const uint8_t* previousAbove, const uint8_t* previousBelow, uint8_t* current, int byteCount, uint8_t threshold)
+    {
+        switch (CpuFeatures::GetSimdLevel())
+        {
+#if defined(SV_SIMD_X86)
+        case SimdLevel::AVX2:
+            MotionAdaptiveRow_AVX2(above, below, previousAbove, previousBelow, current, byteCount, threshold);
+            return;
+        case SimdLevel::SSE41:
+            MotionAdaptiveRow_SSE41(above, below, previousAbove, previousBelow, current, byteCount, threshold);
+            return;
+#elif defined(SV_SIMD_NEON)
+        case SimdLevel::NEON:
+            MotionAdaptiveRow_NEON(above, below, previousAbove, previousBelow, current, byteCount, threshold);
+            return;
+#endif
+        default:
+            MotionAdaptiveRow_Scalar(above, below, previousAbove, previousBelow, current, byteCount, threshold);
+            return;
+        }
+    }
+
+    // Reference implementations.
+    static void InterpolateRow_Scalar(const uint8_t* above, const uint8_t* below, uint8_t* output, int byteCount)
+    {
+        for (int x = 0; x < byteCount; x++)
+        {
+            output[x] = (uint8_t)((above[x] + below[x] + 1) >> 1);
+        }
+    }
+
+    static void MotionAdaptiveRow_Scalar(const uint8_t* above, const uint8_t* below, const uint8_t* previousAbove, const uint8_t* previousBelow, uint8_t* current, int byteCount, uint8_t threshold)
+    {
+        for (int x = 0; x < byteCount; x++)
+        {
+            int motionAbove = abs(above[x] - previousAbove[x]);
+            int motionBelow = abs(below[x] - previousBelow[x]);
+            int motion = (motionAbove > motionBelow) ? motionAbove : motionBelow;
+            if (motion > threshold)
+            {
+                current[x] = (uint8_t)((above[x] + below[x] + 1) >> 1);
+            }
+        }
+    }
+
+#if defined(SV_SIMD_X86)
+    // 16 bytes per iteration, pavgb rounds the same way as the reference.
+    SV_TARGET_SSE41 static void InterpolateRow_SSE41(const uint8_t* above, const uint8_t* below, uint8_t* output, int byteCount)
+    {
+        int x = 0;
+        for (; x + 16 <= byteCount; x += 16)
+        {
+            __m128i a = _mm_loadu_si128((const __m128i*)(above + x));
+            __m128i b = _mm_loadu_si128((const __m128i*)(below + x));
+            _mm_storeu_si128((__m128i*)(output + x), _mm_avg_epu8(a, b));
+        }
+
+        InterpolateRow_Scalar(above + x, below + x, output + x, byteCount - x);
+    }
+
+    // 16 bytes per iteration. Static bytes are those where the saturated excess of motion over threshold is zero.
+    SV_TARGET_SSE41 static void MotionAdaptiveRow_SSE41(const uint8_t* above, const uint8_t* below, const uint8_t* previousAbove, const uint8_t* previousBelow, uint8_t* current, int byteCount, uint8_t threshold)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i limit = _mm_set1_epi8((char)threshold);
+
+        int x = 0;
+        for (; x + 16 <= byteCount; x += 16)
+        {
+            __m128i a = _mm_loadu_si128((const __m128i*)(above + x));
+            __m128i b = _mm_loadu_si128((const __m128i*)(below + x));
+            __m128i motion = _mm_max_epu8(AbsDiffSSE(a, _mm_loadu_si128((const __m128i*)(previousAbove + x))), AbsDiffSSE(b, _mm_loadu_si128((const __m128i*)(previousBelow + x))));
+            __m128i isStatic = _mm_cmpeq_epi8(_mm_subs_epu8(motion, limit), zero);
+
+            __m128i c = _mm_loadu_si128((const __m128i*)(current + x));
+            _mm_storeu_si128((__m128i*)(current + x), _mm_blendv_epi8(_mm_avg_epu8(a, b), c, isStatic));
+        }
+
+        MotionAdaptiveRow_Scalar(above + x, below + x, previousAbove + x, previousBelow + x, current + x, byteCount - x, threshold);
+    }
+
+    SV_TARGET_AVX2 static void InterpolateRow_AVX2(const uint8_t* above, const uint8_t* below, uint8_t* output, int byteCount)
+    {
+        int x = 0;
+        for (; x + 32 <= byteCount; x += 32)
+        {
+            __m256i a = _mm256_loadu_si256((const __m256i*)(above + x));
+            __m256i b = _mm256_loadu_si256((const __m256i*)(below + x));
+            _mm256_storeu_si256((__m256i*)(output + x), _mm256_avg_epu8(a, b));
+        }
+
+        InterpolateRow_SSE41(above + x, below + x, output + x, byteCount - x);
+    }
+
+    SV_TARGET_AVX2 static void MotionAdaptiveRow_AVX2(const uint8_t* above, const uint8_t* below, const uint8_t* previousAbove, const uint8_t* previousBelow, uint8_t* current, int byteCount, uint8_t threshold)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i limit = _mm256_set1_epi8((char)threshold);
+
+        int x = 0;
+        for (; x + 32 <= byteCount; x += 32)
+        {
+            __m256i a = _mm256_loadu_si256((const __m256i*)(above + x));
+            __m256i b = _mm256_loadu_si256((const __m256i*)(below + x));
+            __m256i motion = _mm256_max_epu8(AbsDiffAVX2(a, _mm256_loadu_si256((const __m256i*)(previousAbove + x))), AbsDiffAVX2(b, _mm256_loadu_si256((const __m256i*)(previousBelow + x))));
+            __m256i isStatic = _mm256_cmpeq_epi8(_mm256_subs_epu8(motion, limit), zero);
+
+            __m256i c = _mm256_loadu_si256((const __m256i*)(current + x));
+            _mm256_storeu_si256((__m256i*)(current + x), _mm256_blendv_epi8(_mm256_avg_epu8(a, b), c, isStatic));
+        }
+
+        MotionAdaptiveRow_SSE41(above + x, below + x, previousAbove + x, previousBelow + x, current + x, byteCount - x, threshold);
+    }
+#endif
+
+#if defined(SV_SIMD_NEON)
+    // 16 bytes per iteration, vrhadd rounds the same way as the reference.
+    static void InterpolateRow_NEON(const uint8_t* above, const uint8_t* below, uint8_t* output, int byteCount)
+    {
+        int x = 0;
+        for (; x + 16 <= byteCount; x += 16)
+        {
+            vst1q_u8(output + x, vrhaddq_u8(vld1q_u8(above + x), vld1q_u8(below + x)));
+        }
+
+        InterpolateRow_Scalar(above + x, below + x, output + x, byteCount - x);
+    }
+
+    static void MotionAdaptiveRow_NEON(const uint8_t* above, const uint8_t* below, const uint8_t* previousAbove, const uint8_t* previousBelow, uint8_t* current, int byteCount, uint8_t threshold)
+    {
+        const uint8x16_t limit = vdupq_n_u8(threshold);
+
+        int x = 0;
+        for (; x + 16 <= byteCount; x += 16)
+        {
+            uint8x16_t a = vld1q_u8(above + x);
+            uint8x16_t b = vld1q_u8(below + x);
+            uint8x16_t motion = vmaxq_u8(vabdq_u8(a, vld1q_u8(previousAbove + x)), vabdq_u8(b, vld1q_u8(previousBelow + x)));
+            uint8x16_t moving = vcgtq_u8(motion, limit);
+            vst1q_u8(current + x, vbslq_u8(moving, vrhaddq_u8(a, b), vld1q_u8(current + x)));
+        }
+
+        MotionAdaptiveRow_Scalar(above + x, below + x, previousAbove + x, previousBelow + x, current + x, byteCount - x, threshold);
+    }
+#endif
+
+private:
+#if defined(SV_SIMD_X86)
+    SV_TARGET_SSE41 static inline __m128i AbsDiffSSE(__m128i a, __m128i b)
+    {
+        return _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a));
+    }
+
+    SV_TARGET_AVX2 static inline __m256i AbsDiffAVX2(__m256i a, __m256i b)
+    {
+        return _mm256_or_si256(_mm256_subs_epu8(a, b), _mm256_subs_epu8(b, a));
+    }
+#endif
+};
@@ -6,7 +6,12 @@
 #pragma once
 
 #include <d3d11_1.h>
+#include "AlphaBlending.h"
 #include "CompositorShared.h"
+#include "ConversionThreadPool.h"
+#include "ImageView.h"
+#include "PixelConversion.h"
+#include "Resampling.h"
 #include <amp.h>
 
 class DirectXHelper
@@ -53,6 +58,39 @@ public:
         ctx->Release();
     }
 
+    // Update only the top rows of the texture, for buffers smaller than the texture.
+    // UYVY frames uploaded with an RGBA pitch only fill the top half of the texture, which is all the YUV shaders sample.
+    static void UpdateSRVRows(ID3D11Device* device, ID3D11ShaderResourceView* srv, const byte* bytes, int stride, int rows)
+    {
+        ID3D11Texture2D* tex = NULL;
+        srv->GetResource((ID3D11Resource**)(&tex));
+
+        if (tex == NULL)
+        {
+            return;
+        }
+
+        ID3D11DeviceContext *ctx = NULL;
+        device->GetImmediateContext(&ctx);
+
+        if (ctx == NULL)
+        {
+            return;
+        }
+
+        D3D11_TEXTURE2D_DESC desc;
+        tex->GetDesc(&desc);
+
+        D3D11_BOX box = { 0, 0, 0, desc.Width, (std::min)((UINT)rows, desc.Height), 1 };
+        ctx->UpdateSubresource(tex, 0, &box, bytes, stride, 0);
+        ctx->Release();
+    }
+
+    static void UpdateSRV(ID3D11Device* device, ID3D11ShaderResourceView* srv, const ImageView& image)
+    {
+        UpdateSRV(device, srv, image.data, image.pitch);
+    }
+
     // Create a texture with the given bytes.
     static ID3D11Texture2D* CreateTexture(ID3D11Device* device, const byte* bytes, int width, int height, int bpp, DXGI_FORMAT textureFormat = DXGI_FORMAT_R8G8B8A8_UNORM)
     {
@@ -183,271 +221,302 @@ public:
         }
     }
 
+    // Copy width * height * bpp bytes of texture data into a packed buffer.
     static void GetBytesFromTexture(ID3D11Device* device, ID3D11Texture2D* texture, float bpp, BYTE* const & bytes)
     {
-        D3D11_TEXTURE2D_DESC existingDesc;
-        texture->GetDesc(&existingDesc);
-
-        ID3D11Texture2D* textureBuf;
-        D3D11_TEXTURE2D_DESC textureDesc;
-        ZeroMemory(&textureDesc, sizeof(textureDesc));
-        textureDesc.Width = existingDesc.Width;
-        textureDesc.Height = existingDesc.Height;
-        textureDesc.MipLevels = existingDesc.MipLevels;
-        textureDesc.ArraySize = existingDesc.ArraySize;
-        textureDesc.Format = existingDesc.Format;
-        textureDesc.SampleDesc.Count = existingDesc.SampleDesc.Count;
-        textureDesc.SampleDesc.Quality = existingDesc.SampleDesc.Quality;
-        textureDesc.Usage = D3D11_USAGE_STAGING;
-        textureDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
-        textureDesc.MiscFlags = 0;
-
-        device->CreateTexture2D(&textureDesc, NULL, &textureBuf);
-
-        ID3D11DeviceContext* d3d11DevCon;
-        device->GetImmediateContext(&d3d11DevCon);
-
-        d3d11DevCon->CopyResource(textureBuf, texture);
+        ReadTexture(device, texture, [&](const D3D11_MAPPED_SUBRESOURCE& mapResource, const D3D11_TEXTURE2D_DESC& textureDesc)
+        {
+            CopyFromMappedStream(mapResource, textureDesc.Width * GetBytesPerTexel(textureDesc.Format), 0, (size_t)(textureDesc.Width * textureDesc.Height * bpp), bytes);
+        });
+    }
 
-        D3D11_MAPPED_SUBRESOURCE  mapResource;
-        d3d11DevCon->Map(textureBuf, 0, D3D11_MAP_READ, NULL, &mapResource);
+    // Copy texture data into every row of destination, which may be padded or bottom-up.
+    static void GetBytesFromTexture(ID3D11Device* device, ID3D11Texture2D* texture, const ImageView& destination)
+    {
+        ReadTexture(device, texture, [&](const D3D11_MAPPED_SUBRESOURCE& mapResource, const D3D11_TEXTURE2D_DESC& textureDesc)
+        {
+            CopyFromMappedStream(mapResource, textureDesc.Width * GetBytesPerTexel(textureDesc.Format), destination);
+        });
+    }
 
-        memcpy(bytes, mapResource.pData, (size_t)(textureDesc.Width * textureDesc.Height * bpp));
+    // Textures written by the compositor shaders hold a packed byte stream that runs across texel rows,
+    // while mapped rows may be padded to RowPitch. Copy count bytes starting at offset in that stream.
+    static void CopyFromMappedStream(const D3D11_MAPPED_SUBRESOURCE& mapResource, size_t texelRowBytes, size_t offset, size_t count, BYTE* destination)
+    {
+        const BYTE* source = (const BYTE*)mapResource.pData;
+        if (mapResource.RowPitch == texelRowBytes)
+        {
+            memcpy(destination, source + offset, count);
+            return;
+        }
 
-        d3d11DevCon->Unmap(textureBuf, 0);
-        if (textureBuf != nullptr)
+        while (count > 0)
         {
-            textureBuf->Release();
-            textureBuf = nullptr;
+            size_t row = offset / texelRowBytes;
+            size_t column = offset % texelRowBytes;
+            size_t span = (count < texelRowBytes - column) ? count : texelRowBytes - column;
+
+            memcpy(destination, source + row * mapResource.RowPitch + column, span);
+            destination += span;
+            offset += span;
+            count -= span;
         }
     }
 
-    static void FlipHorizontally(BYTE*& bytes, int height, int stride, bool rgba = false)
+    // Fill each row of destination from consecutive bytes of the stream.
+    static void CopyFromMappedStream(const D3D11_MAPPED_SUBRESOURCE& mapResource, size_t texelRowBytes, const ImageView& destination)
     {
-        BYTE* swap = new BYTE[stride];
-        for (int i = 0, j = height - 1; i < height / 2.0f; i++, j--)
+        size_t rowBytes = destination.RowBytes();
+        int rows = (destination.format == ImageFormat::NV12) ? destination.height + destination.height / 2 : destination.height;
+        if (destination.IsPacked())
         {
-            int topRow = stride * i;
-            int bottomRow = stride * j;
+            CopyFromMappedStream(mapResource, texelRowBytes, 0, rows * rowBytes, destination.data);
+            return;
+        }
 
-            CopyMemory(swap, bytes + topRow, stride);
-            CopyMemory(bytes + topRow, bytes + bottomRow, stride);
-            CopyMemory(bytes + bottomRow, swap, stride);
+        for (int y = 0; y < rows; y++)
+        {
+            CopyFromMappedStream(mapResource, texelRowBytes, y * rowBytes, rowBytes, destination.Row(y));
         }
+    }
 
-        delete[] swap;
+    static UINT GetBytesPerTexel(DXGI_FORMAT format)
+    {
+        switch (format)
+        {
+        case DXGI_FORMAT_R32G32B32A32_TYPELESS:
+        case DXGI_FORMAT_R32G32B32A32_FLOAT:
+        case DXGI_FORMAT_R32G32B32A32_UINT:
+        case DXGI_FORMAT_R32G32B32A32_SINT:
+            return 16;
+        case DXGI_FORMAT_R16G16B16A16_TYPELESS:
+        case DXGI_FORMAT_R16G16B16A16_FLOAT:
+        case DXGI_FORMAT_R16G16B16A16_UNORM:
+        case DXGI_FORMAT_R16G16B16A16_UINT:
+        case DXGI_FORMAT_R16G16B16A16_SNORM:
+        case DXGI_FORMAT_R16G16B16A16_SINT:
+        case DXGI_FORMAT_R32G32_TYPELESS:
+        case DXGI_FORMAT_R32G32_FLOAT:
+        case DXGI_FORMAT_R32G32_UINT:
+        case DXGI_FORMAT_R32G32_SINT:
+            return 8;
+        case DXGI_FORMAT_R16_TYPELESS:
+        case DXGI_FORMAT_R16_FLOAT:
+        case DXGI_FORMAT_R16_UNORM:
+        case DXGI_FORMAT_R16_UINT:
+        case DXGI_FORMAT_R16_SNORM:
+        case DXGI_FORMAT_R16_SINT:
+        case DXGI_FORMAT_R8G8_TYPELESS:
+        case DXGI_FORMAT_R8G8_UNORM:
+        case DXGI_FORMAT_R8G8_UINT:
+        case DXGI_FORMAT_R8G8_SNORM:
+        case DXGI_FORMAT_R8G8_SINT:
+            return 2;
+        case DXGI_FORMAT_R8_TYPELESS:
+        case DXGI_FORMAT_R8_UNORM:
+        case DXGI_FORMAT_R8_UINT:
+        case DXGI_FORMAT_R8_SNORM:
+        case DXGI_FORMAT_R8_SINT:
+        case DXGI_FORMAT_A8_UNORM:
+            return 1;
+        default:
+            // 8 bit RGBA and BGRA variants, R32 and the packed 32 bit formats.
+            return 4;
+        }
     }
 
+    // Reverse the row order of an image in place. Row pairs are swapped in parallel bands through a small stack buffer.
+    static void FlipVertically(const ImageView& image)
+    {
+        int rowBytes = image.RowBytes();
+        ForEachRowBand(image.height / 2, rowBytes * 2, [&](int firstRow, int endRow)
+        {
+            BYTE swap[1024];
+            for (int y = firstRow; y < endRow; y++)
+            {
+                BYTE* top = image.Row(y);
+                BYTE* bottom = image.Row(image.height - 1 - y);
+                for (int x = 0; x < rowBytes; x += sizeof(swap))
+                {
+                    size_t count = (rowBytes - x < (int)sizeof(swap)) ? rowBytes - x : sizeof(swap);
+                    memcpy(swap, top + x, count);
+                    memcpy(top + x, bottom + x, count);
+                    memcpy(bottom + x, swap, count);
+                }
+            }
+        });
+    }
 
-    // Conversions.
-    // Convert a YUV input buffer to a BGRA output buffer.
-    static void ConvertYUVtoBGRA(BYTE* input, BYTE* alphaInput, BYTE*& output, int width, int height, bool rgba = false)
+    // Flips rows, the name is kept for existing callers.
+    static void FlipHorizontally(BYTE*& bytes, int height, int stride, bool rgba = false)
     {
-        ConvertYUVtoBGRA_CPU(input, alphaInput, output, width, height, rgba);
+        FlipVertically(ImageView(bytes, stride, height, ImageFormat::Alpha8));
     }
 
-    static void ConvertYUVtoBGRA(BYTE* input, BYTE*& output, int width, int height, bool rgba = false)
+    // Convert input into output and optionally flip it vertically, reading each source byte once.
+    // Combines a swizzle such as BGRA to RGBA with the flip, the images must not overlap.
+    static void OrientAndConvert(const ImageView& input, const ImageView& output, bool flipVertically, AlphaPolicy alpha = AlphaPolicy::Preserve)
     {
-        ConvertYUVtoBGRA_CPU(input, nullptr, output, width, height, rgba);
+        PixelConversion::Convert(input, flipVertically ? output.FlippedVertically() : output, ColorMatrix::BT601Limited, alpha);
     }
 
-    // Convert a BGRA input buffer to a YUV output buffer.
-    static void ConvertBGRAtoYUV(BYTE* input, BYTE*& output, BYTE*& alphaOut, int width, int height)
+    // Scale input to the size of output, both in the same format, so later stages can work on a smaller image.
+    static bool Resize(const ImageView& input, const ImageView& output, ResampleFilter filter = ResampleFilter::Area)
     {
-        ConvertBGRAtoYUV_CPU(input, output, alphaOut, width, height);
+        return Resampling::Resample(input, output, filter);
     }
 
-    static void ConvertRGBAtoYUV(BYTE* input, BYTE*& output, int width, int height)
+
+    // Conversions.
+    // Format conversions are dispatched through PixelConversion, each is split into row bands that run on the ConversionThreadPool.
+    // The ImageView overloads honor the pitch of both images, the BYTE* overloads expect tightly packed rows.
+    static void SetConversionWorkerCount(int workerCount)
     {
-        ConvertRGBAtoYUV_CPU(input, output, width, height);
+        ConversionThreadPool::Instance().SetWorkerCount(workerCount);
     }
 
-    static void ConvertBGRAtoYUV(BYTE* input, BYTE*& output, int width, int height)
+    // Convert a YUV input image to a BGRA or RGBA output image, alphaInput is an optional Alpha8 image.
+    static void ConvertYUVtoBGRA(const ImageView& input, const ImageView& alphaInput, const ImageView& output, ColorMatrix matrix = ColorMatrix::BT601Limited)
     {
-        ConvertBGRAtoYUV_CPU(input, output, width, height);
+        PixelConversion::Convert(input, output, matrix, alphaInput.IsValid() ? AlphaPolicy::Separate : AlphaPolicy::Opaque, alphaInput);
     }
 
-    static void ConvertRGBAtoNV12(BYTE* input, BYTE*& outputYUV, int width, int height)
+    static void ConvertYUVtoBGRA(const ImageView& input, const ImageView& output, ColorMatrix matrix = ColorMatrix::BT601Limited)
     {
-        for (int i = 0, j = 0, k = 0; i < width * height * FRAME_BPP_RGBA - 4 * FRAME_BPP_RGBA; i += 4 * FRAME_BPP_RGBA, j += FRAME_BPP_YUV * 2)
-        {
-            int row = (int)(i / (width * FRAME_BPP_RGBA));
+        ConvertYUVtoBGRA(input, ImageView(), output, matrix);
+    }
 
-            int b1, g1, r1, a1;
-            int b2, g2, r2, a2;
-            int b3, g3, r3, a3;
-            int b4, g4, r4, a4;
+    // Convert a YUV input buffer to a BGRA output buffer.
+    static void ConvertYUVtoBGRA(BYTE* input, BYTE* alphaInput, BYTE*& output, int width, int height, bool rgba = false, ColorMatrix matrix = ColorMatrix::BT601Limited)
+    {
+        ConvertYUVtoBGRA(
+            ImageView(input, width, height, ImageFormat::UYVY),
+            ImageView(alphaInput, width, height, ImageFormat::Alpha8),
+            ImageView(output, width, height, rgba ? ImageFormat::RGBA : ImageFormat::BGRA),
+            matrix);
+    }
 
-            r1 = (int)input[i];
-            g1 = (int)input[i + 1];
-            b1 = (int)input[i + 2];
-            a1 = (int)input[i + 3];
+    static void ConvertYUVtoBGRA(BYTE* input, BYTE*& output, int width, int height, bool rgba = false, ColorMatrix matrix = ColorMatrix::BT601Limited)
+    {
+        ConvertYUVtoBGRA(input, nullptr, output, width, height, rgba, matrix);
+    }
 
-            r2 = (int)input[i + 4];
-            g2 = (int)input[i + 5];
-            b2 = (int)input[i + 6];
-            a2 = (int)input[i + 7];
+    // Convert a BGRA or RGBA input image to a YUV output image, alphaOut is an optional Alpha8 image.
+    static void ConvertBGRAtoYUV(const ImageView& input, const ImageView& output, const ImageView& alphaOut, ColorMatrix matrix = ColorMatrix::BT601Limited)
+    {
+        PixelConversion::Convert(input, output, matrix, alphaOut.IsValid() ? AlphaPolicy::Separate : AlphaPolicy::Opaque, alphaOut);
+    }
 
-            r3 = (int)input[i + 8];
-            g3 = (int)input[i + 9];
-            b3 = (int)input[i + 10];
-            a3 = (int)input[i + 11];
+    static void ConvertBGRAtoYUV(const ImageView& input, const ImageView& output, ColorMatrix matrix = ColorMatrix::BT601Limited)
+    {
+        ConvertBGRAtoYUV(input, output, ImageView(), matrix);
+    }
 
-            r4 = (int)input[i + 12];
-            g4 = (int)input[i + 13];
-            b4 = (int)input[i + 14];
-            a4 = (int)input[i + 15];
+    // Convert a BGRA input buffer to a YUV output buffer.
+    static void ConvertBGRAtoYUV(BYTE* input, BYTE*& output, BYTE*& alphaOut, int width, int height, ColorMatrix matrix = ColorMatrix::BT601Limited)
+    {
+        ConvertBGRAtoYUV(
+            ImageView(input, width, height, ImageFormat::BGRA),
+            ImageView(output, width, height, ImageFormat::UYVY),
+            ImageView(alphaOut, width, height, ImageFormat::Alpha8),
+            matrix);
+    }
 
-            int u, y0, v, y1;
-            int u2, y02, v2, y12;
+    static void ConvertRGBAtoYUV(BYTE* input, BYTE*& output, int width, int height, ColorMatrix matrix = ColorMatrix::BT601Limited)
+    {
+        ConvertBGRAtoYUV(ImageView(input, width, height, ImageFormat::RGBA), ImageView(output, width, height, ImageFormat::UYVY), matrix);
+    }
 
-            GetYUV(r1, g1, b1, r2, g2, b2, u, y0, v, y1);
-            GetYUV(r3, g3, b3, r4, g4, b4, u2, y02, v2, y12);
+    static void ConvertBGRAtoYUV(BYTE* input, BYTE*& output, int width, int height, ColorMatrix matrix = ColorMatrix::BT601Limited)
+    {
+        ConvertBGRAtoYUV(ImageView(input, width, height, ImageFormat::BGRA), ImageView(output, width, height, ImageFormat::UYVY), matrix);
+    }
 
-            outputYUV[j] = (byte)Clamp(y0);
-            outputYUV[j + 1] = (byte)Clamp(y1);
-            outputYUV[j + 2] = (byte)Clamp(y02);
-            outputYUV[j + 3] = (byte)Clamp(y12);
+    // Convert a BGRA or RGBA input image to an NV12 output image, chroma is averaged over each 2x2 block.
+    static void ConvertToNV12(const ImageView& input, const ImageView& output, ColorMatrix matrix = ColorMatrix::BT601Limited)
+    {
+        PixelConversion::Convert(input, output, matrix);
+    }
 
-            if (row % 2 == 0)
-            {
-                outputYUV[width * height + k] = (byte)Clamp(u);
-                outputYUV[width * height + k + 1] = (byte)Clamp(v);
-                outputYUV[width * height + k + 2] = (byte)Clamp(u2);
-                outputYUV[width * height + k + 3] = (byte)Clamp(v2);
+    static void ConvertRGBAtoNV12(BYTE* input, BYTE*& outputYUV, int width, int height, ColorMatrix matrix = ColorMatrix::BT601Limited)
+    {
+        ConvertToNV12(ImageView(input, width, height, ImageFormat::RGBA), ImageView(outputYUV, width, height, ImageFormat::NV12), matrix);
+    }
 
-                k += 4;
-            }
-        }
+    // Swap B and R components in place and optionally force alpha to 255.
+    static void ConvertBGRAtoRGBA(const ImageView& image, bool forceOpaque = true)
+    {
+        ImageView swapped = image;
+        swapped.format = (image.format == ImageFormat::RGBA) ? ImageFormat::BGRA : ImageFormat::RGBA;
+        PixelConversion::Convert(image, swapped, ColorMatrix::BT601Limited, forceOpaque ? AlphaPolicy::Opaque : AlphaPolicy::Preserve);
     }
 
-    // Swap B and R components and force alpha to 255.
     static void ConvertBGRAtoRGBA(BYTE*& bytes, int width, int height, bool forceOpaque = true)
     {
-        for (int i = 0; i < width * height * FRAME_BPP_RGBA - FRAME_BPP_RGBA; i += 4)
-        {
-            byte swap = bytes[i];
-            bytes[i] = bytes[i + 2];
-            bytes[i + 2] = swap;
+        ConvertBGRAtoRGBA(ImageView(bytes, width, height, ImageFormat::BGRA), forceOpaque);
+    }
 
-            if (forceOpaque)
-            {
-                bytes[i + 3] = 255;
-            }
-        }
+    // Expand an RGB input image to an opaque BGRA or RGBA output image.
+    static void ConvertRGBtoBGRA(const ImageView& input, const ImageView& output)
+    {
+        PixelConversion::Convert(input, output);
     }
 
     static void ConvertRGBtoBGRA(BYTE* input, BYTE*& output, int width, int height, bool rgba)
     {
-        for (int i = 0, j = 0; i <= width * height * 3 - 3 * 4; i += 3 * 4, j += 4 * 4)
-        {
-            byte r, g, b;
-            byte r2, g2, b2;
-            byte r3, g3, b3;
-            byte r4, g4, b4;
-
-            r = input[i];
-            g = input[i + 1];
-            b = input[i + 2];
-
-            r2 = input[i + 3];
-            g2 = input[i + 4];
-            b2 = input[i + 5];
-
-            r3 = input[i + 6];
-            g3 = input[i + 7];
-            b3 = input[i + 8];
-
-            r4 = input[i + 9];
-            g4 = input[i + 10];
-            b4 = input[i + 11];
-
-
-            output[j] = b;
-            output[j + 1] = g;
-            output[j + 2] = r;
-            output[j + 3] = 255;
-
-            output[j + 4] = b2;
-            output[j + 5] = g2;
-            output[j + 6] = r2;
-            output[j + 7] = 255;
-
-            output[j + 8] = b3;
-            output[j + 9] = g3;
-            output[j + 10] = r3;
-            output[j + 11] = 255;
-
-            output[j + 12] = b4;
-            output[j + 13] = g4;
-            output[j + 14] = r4;
-            output[j + 15] = 255;
+        ConvertRGBtoBGRA(ImageView(input, width, height, ImageFormat::RGB), ImageView(output, width, height, rgba ? ImageFormat::RGBA : ImageFormat::BGRA));
+    }
 
-            if (rgba)
+    // Blend front over back in place, scaling front by alpha. Output alpha is opaque.
+    static void AlphaBlend(const ImageView& back, const ImageView& front, float alpha, BlendMode mode = BlendMode::Premultiplied)
+    {
+        uint8_t globalAlpha = AlphaBlending::AlphaToByte(alpha);
+        ForEachRowBand(back.height, back.RowBytes(), [&](int firstRow, int endRow)
+        {
+            for (int y = firstRow; y < endRow; y++)
             {
-                output[j] = r;
-                output[j + 2] = b;
-
-                output[j + 4] = r2;
-                output[j + 6] = b2;
-
-                output[j + 8] = r3;
-                output[j + 10] = b3;
-
-                output[j + 12] = r4;
-                output[j + 14] = b4;
+                AlphaBlending::BlendRow(back.Row(y), front.Row(y), back.width, globalAlpha, mode);
             }
-        }
+        });
     }
 
-    static void AlphaBlend(/*[in out]*/ BYTE*& back, const BYTE* front, int bufferSize, float alpha)
+    static void AlphaBlend(/*[in out]*/ BYTE*& back, const BYTE* front, int bufferSize, float alpha, BlendMode mode = BlendMode::Premultiplied)
     {
-        for (int i = 0; i < bufferSize - FRAME_BPP_RGBA; i += FRAME_BPP_RGBA)
+        BYTE* dst = back;
+        uint8_t globalAlpha = AlphaBlending::AlphaToByte(alpha);
+
+        int pixelCount = bufferSize / FRAME_BPP_RGBA;
+        ForEachRowBand(pixelCount, FRAME_BPP_RGBA, [&](int firstPixel, int endPixel)
         {
-            byte br, bg, bb, ba;
-            byte fr, fg, fb, fa;
-
-            br = back[i];
-            bg = back[i + 1];
-            bb = back[i + 2];
-            ba = back[i + 3];
-
-            fr = front[i];
-            fg = front[i + 1];
-            fb = front[i + 2];
-            fa = front[i + 3];
-
-
-            float frontAlpha = Saturate(fa);
-
-            br = (byte)DirectXHelper::Clamp((int)
-                (((1 - alpha * frontAlpha) * (float)br) +
-                (alpha * (float)fr)));
-            bg = (byte)DirectXHelper::Clamp((int)
-                (((1 - alpha * frontAlpha) * (float)bg) +
-                (alpha * (float)fg)));
-            bb = (byte)DirectXHelper::Clamp((int)
-                (((1 - alpha * frontAlpha) * (float)bb) +
-                (alpha * (float)fb)));
-
-            back[i] = br;
-            back[i + 1] = bg;
-            back[i + 2] = bb;
-            back[i + 3] = 255;
-        }
+            AlphaBlending::BlendRow(dst + firstPixel * FRAME_BPP_RGBA, front + firstPixel * FRAME_BPP_RGBA, endPixel - firstPixel, globalAlpha, mode);
+        });
     }
 
-    static void AlphaAsRGBA(BYTE* input, BYTE*& output, int width, int height)
+    // Replicate the alpha channel of the input image into every channel of the output image.
+    static void AlphaAsRGBA(const ImageView& input, const ImageView& output)
     {
-        for (int i = 0; i < width * height * FRAME_BPP_RGBA - 4; i += 4)
+        ForEachRowBand(output.height, output.RowBytes(), [&](int firstRow, int endRow)
         {
-            byte a = input[i + 3];
+            for (int y = firstRow; y < endRow; y++)
+            {
+                const BYTE* src = input.Row(y);
+                BYTE* dst = output.Row(y);
+                for (int i = 0; i < output.width * FRAME_BPP_RGBA; i += FRAME_BPP_RGBA)
+                {
+                    byte a = src[i + 3];
+
+                    dst[i] = a;
+                    dst[i + 1] = a;
+                    dst[i + 2] = a;
+                    dst[i + 3] = a;
+                }
+            }
+        });
+    }
 
-            output[i] = a;
-            output[i + 1] = a;
-            output[i + 2] = a;
-            output[i + 3] = a;
-        }
+    static void AlphaAsRGBA(BYTE* input, BYTE*& output, int width, int height)
+    {
+        AlphaAsRGBA(ImageView(input, width, height, ImageFormat::BGRA), ImageView(output, width, height, ImageFormat::BGRA));
     }
 
     // Byte value sanitation.
@@ -471,264 +540,80 @@ public:
         return ((float)input / 255.0f);
     }
 
+    // Single pixel pair conversions in 8 bit fixed point, chroma is taken from the first pixel.
     static void GetYUV(
         int r, int g, int b,
         int r2, int g2, int b2,
-        int& u, int& y, int& v, int& y2)
+        int& u, int& y, int& v, int& y2,
+        ColorMatrix matrix = ColorMatrix::BT601Limited)
     {
-        // Conversion requires > 8 bit precision.
-        // https://msdn.microsoft.com/en-us/library/ms893078.aspx
-        y = (int)((float)((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
-        y2 = (int)((float)((66 * r2 + 129 * g2 + 25 * b2 + 128) >> 8) + 16);
-        u = (int)((float)((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
-        v = (int)((float)((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+        const YUVCoefficients& coefficients = YUVConversion::GetCoefficients(matrix);
+        y = YUVConversion::LumaFromRGB(r, g, b, coefficients);
+        y2 = YUVConversion::LumaFromRGB(r2, g2, b2, coefficients);
+        u = YUVConversion::BlueChromaFromRGB(r, g, b, coefficients);
+        v = YUVConversion::RedChromaFromRGB(r, g, b, coefficients);
     }
 
+    // Results are clamped to [0, 255].
     static void GetRGB(
         int y0, int y1, int u, int v,
         int& r, int& g, int& b,
-        int& r2, int& g2, int& b2)
+        int& r2, int& g2, int& b2,
+        ColorMatrix matrix = ColorMatrix::BT601Limited)
     {
-        // Conversion requires > 8 bit precision.
-        // https://msdn.microsoft.com/en-us/library/ms893078.aspx
-        int c0 = (int)(y0 - 16);
-        int c1 = (int)(y1 - 16);
-        int d = (int)(u - 128);
-        int e = (int)(v - 128);
-
-        b = (298 * c0 + 409 * e + 128) >> 8;
-        g = (298 * c0 - 100 * d - 208 * e + 128) >> 8;
-        r = (298 * c0 + 516 * d + 128) >> 8;
-
-        b2 = (298 * c1 + 409 * e + 128) >> 8;
-        g2 = (298 * c1 - 100 * d - 208 * e + 128) >> 8;
-        r2 = (298 * c1 + 516 * d + 128) >> 8;
+        const YUVCoefficients& coefficients = YUVConversion::GetCoefficients(matrix);
+        YUVConversion::RGBFromYUV(y0, u, v, coefficients, r, g, b);
+        YUVConversion::RGBFromYUV(y1, u, v, coefficients, r2, g2, b2);
     }
 
 private:
-    static void ConvertYUVtoBGRA_CPU(BYTE* input, BYTE* alphaInput, BYTE*& output, int width, int height, bool rgba = false)
+    // Run convertRows over bands of rows sized for the cache, rowBytes is the size of the largest row touched.
+    template <typename Fn>
+    static void ForEachRowBand(int rowCount, int rowBytes, const Fn& convertRows)
     {
-        for (int i = 0, j = 0, a = 0; i < width * height * FRAME_BPP_YUV - (FRAME_BPP_YUV * 4); i += FRAME_BPP_YUV * 4, j += FRAME_BPP_RGBA * 4, a += 4)
-        {
-            int u, y0, v, y1;
-            int u2, y02, v2, y12;
-
-            u = (int)input[i];
-            y0 = (int)input[i + 1];
-            v = (int)input[i + 2];
-            y1 = (int)input[i + 3];
-
-            u2 = (int)input[i + 4];
-            y02 = (int)input[i + 5];
-            v2 = (int)input[i + 6];
-            y12 = (int)input[i + 7];
-
-            int b1, g1, r1, a1;
-            int b2, g2, r2, a2;
-            int b3, g3, r3, a3;
-            int b4, g4, r4, a4;
-
-            GetRGB(y0, y1, u, v, r1, g1, b1, r2, g2, b2);
-            GetRGB(y02, y12, u2, v2, r3, g3, b3, r4, g4, b4);
-
-            a1 = 255;
-            a2 = 255;
-            a3 = 255;
-            a4 = 255;
-
-            if (alphaInput != nullptr)
-            {
-                a1 = (int)alphaInput[a];
-                a2 = (int)alphaInput[a + 1];
-                a3 = (int)alphaInput[a + 2];
-                a4 = (int)alphaInput[a + 3];
-            }
-
-            if (rgba)
-            {
-                int swap = r1;
-                r1 = b1;
-                b1 = swap;
-
-                swap = r2;
-                r2 = b2;
-                b2 = swap;
-
-                swap = r3;
-                r3 = b3;
-                b3 = swap;
-
-                swap = r4;
-                r4 = b4;
-                b4 = swap;
-            }
-
-            output[j] = (byte)Clamp(r1);
-            output[j + 1] = (byte)Clamp(g1);
-            output[j + 2] = (byte)Clamp(b1);
-            output[j + 3] = (byte)Clamp(a1);
-
-            output[j + 4] = (byte)Clamp(r2);
-            output[j + 5] = (byte)Clamp(g2);
-            output[j + 6] = (byte)Clamp(b2);
-            output[j + 7] = (byte)Clamp(a2);
-
-            output[j + 8] = (byte)Clamp(r3);
-            output[j + 9] = (byte)Clamp(g3);
-            output[j + 10] = (byte)Clamp(b3);
-            output[j + 11] = (byte)Clamp(a3);
-
-            output[j + 12] = (byte)Clamp(r4);
-            output[j + 13] = (byte)Clamp(g4);
-            output[j + 14] = (byte)Clamp(b4);
-            output[j + 15] = (byte)Clamp(a4);
-        }
+        ConversionThreadPool::Instance().ParallelFor(rowCount, ConversionThreadPool::RowsPerBand(rowBytes), convertRows);
     }
 
-    static void ConvertBGRAtoYUV_CPU(BYTE* input, BYTE*& output, BYTE*& alphaOut, int width, int height)
+    // Copy a texture to a temporary staging texture and call read(mapResource, textureDesc) while it is mapped.
+    template <typename Fn>
+    static void ReadTexture(ID3D11Device* device, ID3D11Texture2D* texture, const Fn& read)
     {
-        for (int i = 0, j = 0, a = 0; i < width * height * FRAME_BPP_RGBA - 4 * FRAME_BPP_RGBA; i += 4 * FRAME_BPP_RGBA, j += 4 * FRAME_BPP_YUV, a += FRAME_BPP_RGBA)
-        {
-            int b1, g1, r1, a1;
-            int b2, g2, r2, a2;
-            int b3, g3, r3, a3;
-            int b4, g4, r4, a4;
-
-            b1 = (int)input[i];
-            g1 = (int)input[i + 1];
-            r1 = (int)input[i + 2];
-            a1 = (int)input[i + 3];
-
-            b2 = (int)input[i + 4];
-            g2 = (int)input[i + 5];
-            r2 = (int)input[i + 6];
-            a2 = (int)input[i + 7];
-
-            b3 = (int)input[i + 8];
-            g3 = (int)input[i + 9];
-            r3 = (int)input[i + 10];
-            a3 = (int)input[i + 11];
-
-            b4 = (int)input[i + 12];
-            g4 = (int)input[i + 13];
-            r4 = (int)input[i + 14];
-            a4 = (int)input[i + 15];
-
-            int u, y0, v, y1;
-            int u2, y02, v2, y12;
-
-            GetYUV(r1, g1, b1, r2, g2, b2, u, y0, v, y1);
-            GetYUV(r3, g3, b3, r4, g4, b4, u2, y02, v2, y12);
-
-            output[j] = (byte)Clamp(u);
-            output[j + 1] = (byte)Clamp(y0);
-            output[j + 2] = (byte)Clamp(v);
-            output[j + 3] = (byte)Clamp(y1);
-
-            output[j + 4] = (byte)Clamp(u2);
-            output[j + 5] = (byte)Clamp(y02);
-            output[j + 6] = (byte)Clamp(v2);
-            output[j + 7] = (byte)Clamp(y12);
-
-            alphaOut[a] = a1;
-            alphaOut[a + 1] = a2;
-            alphaOut[a + 2] = a3;
-            alphaOut[a + 3] = a4;
-        }
-    }
+        D3D11_TEXTURE2D_DESC existingDesc;
+        texture->GetDesc(&existingDesc);
 
-    static void ConvertRGBAtoYUV_CPU(BYTE* input, BYTE*& output, int width, int height)
-    {
-        for (int i = 0, j = 0; i < width * height * FRAME_BPP_RGBA - 4 * FRAME_BPP_RGBA; i += 4 * FRAME_BPP_RGBA, j += 4 * FRAME_BPP_YUV)
+        ID3D11Texture2D* textureBuf = nullptr;
+        D3D11_TEXTURE2D_DESC textureDesc;
+        ZeroMemory(&textureDesc, sizeof(textureDesc));
+        textureDesc.Width = existingDesc.Width;
+        textureDesc.Height = existingDesc.Height;
+        textureDesc.MipLevels = existingDesc.MipLevels;
+        textureDesc.ArraySize = existingDesc.ArraySize;
+        textureDesc.Format = existingDesc.Format;
+        textureDesc.SampleDesc.Count = existingDesc.SampleDesc.Count;
+        textureDesc.SampleDesc.Quality = existingDesc.SampleDesc.Quality;
+        textureDesc.Usage = D3D11_USAGE_STAGING;
+        textureDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+        textureDesc.MiscFlags = 0;
+
+        if (FAILED(device->CreateTexture2D(&textureDesc, NULL, &textureBuf)))
         {
-            int b1, g1, r1, a1;
-            int b2, g2, r2, a2;
-            int b3, g3, r3, a3;
-            int b4, g4, r4, a4;
-
-            r1 = (int)input[i];
-            g1 = (int)input[i + 1];
-            b1 = (int)input[i + 2];
-            a1 = (int)input[i + 3];
-
-            r2 = (int)input[i + 4];
-            g2 = (int)input[i + 5];
-            b2 = (int)input[i + 6];
-            a2 = (int)input[i + 7];
-
-            r3 = (int)input[i + 8];
-            g3 = (int)input[i + 9];
-            b3 = (int)input[i + 10];
-            a3 = (int)input[i + 11];
-
-            r4 = (int)input[i + 12];
-            g4 = (int)input[i + 13];
-            b4 = (int)input[i + 14];
-            a4 = (int)input[i + 15];
-
-            int u, y0, v, y1;
-            int u2, y02, v2, y12;
-
-            GetYUV(r1, g1, b1, r2, g2, b2, u, y0, v, y1);
-            GetYUV(r3, g3, b3, r4, g4, b4, u2, y02, v2, y12);
-
-            output[j] = (byte)Clamp(u);
-            output[j + 1] = (byte)Clamp(y0);
-            output[j + 2] = (byte)Clamp(v);
-            output[j + 3] = (byte)Clamp(y1);
-
-            output[j + 4] = (byte)Clamp(u2);
-            output[j + 5] = (byte)Clamp(y02);
-            output[j + 6] = (byte)Clamp(v2);
-            output[j + 7] = (byte)Clamp(y12);
+            return;
         }
-    }
 
-    static void ConvertBGRAtoYUV_CPU(BYTE* input, BYTE*& output, int width, int height)
-    {
-        for (int i = 0, j = 0; i < width * height * FRAME_BPP_RGBA - 4 * FRAME_BPP_RGBA; i += 4 * FRAME_BPP_RGBA, j += 4 * FRAME_BPP_YUV)
+        ID3D11DeviceContext* d3d11DevCon;
+        device->GetImmediateContext(&d3d11DevCon);
+
+        d3d11DevCon->CopyResource(textureBuf, texture);
+
+        D3D11_MAPPED_SUBRESOURCE  mapResource;
+        if (SUCCEEDED(d3d11DevCon->Map(textureBuf, 0, D3D11_MAP_READ, NULL, &mapResource)))
         {
-            int b1, g1, r1, a1;
-            int b2, g2, r2, a2;
-            int b3, g3, r3, a3;
-            int b4, g4, r4, a4;
-
-            b1 = (int)input[i];
-            g1 = (int)input[i + 1];
-            r1 = (int)input[i + 2];
-            a1 = (int)input[i + 3];
-
-            b2 = (int)input[i + 4];
-            g2 = (int)input[i + 5];
-            r2 = (int)input[i + 6];
-            a2 = (int)input[i + 7];
-
-            b3 = (int)input[i + 8];
-            g3 = (int)input[i + 9];
-            r3 = (int)input[i + 10];
-            a3 = (int)input[i + 11];
-
-            b4 = (int)input[i + 12];
-            g4 = (int)input[i + 13];
-            r4 = (int)input[i + 14];
-            a4 = (int)input[i + 15];
-
-            int u, y0, v, y1;
-            int u2, y02, v2, y12;
-
-            GetYUV(r1, g1, b1, r2, g2, b2, u, y0, v, y1);
-            GetYUV(r3, g3, b3, r4, g4, b4, u2, y02, v2, y12);
-
-            output[j] = (byte)Clamp(u);
-            output[j + 1] = (byte)Clamp(y0);
-            output[j + 2] = (byte)Clamp(v);
-            output[j + 3] = (byte)Clamp(y1);
-
-            output[j + 4] = (byte)Clamp(u2);
-            output[j + 5] = (byte)Clamp(y02);
-            output[j + 6] = (byte)Clamp(v2);
-            output[j + 7] = (byte)Clamp(y12);
+            read(mapResource, textureDesc);
+            d3d11DevCon->Unmap(textureBuf, 0);
         }
+
+        d3d11DevCon->Release();
+        textureBuf->Release();
     }
 };
 
@@ -0,0 +1,281 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+// Process wide pool of frame sized buffers, shared by the capture providers, the Unity plugin and the video encoder.
+// Buffers are 64 byte aligned, so the SIMD pixel kernels never split a cache line on their aligned rows.
+// Released buffers go back to a free list for their size class, and frame formats only come in a handful of sizes,
+// so once capture and recording have warmed up, acquiring a buffer never reaches the system allocator.
+// New buffers can optionally be backed by large pages, which cuts TLB misses when whole frames are streamed through.
+
+#pragma once
+
+#if defined(_WIN32)
+#include <Windows.h>
+#include <malloc.h>
+#else
+#include <stdlib.h>
+#endif
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <vector>
+
+struct FrameBufferPoolStats
+{
+    // Bytes held by buffers that are acquired, and by all buffers the pool owns.
+    size_t bytesInUse;
+    size_t bytesReserved;
+    size_t buffersInUse;
+    // Calls into the system allocator since the pool was created. This stops growing once the pool has warmed up.
+    size_t systemAllocations;
+    size_t largePageBytes;
+};
+
+class FrameBufferPool
+{
+public:
+    static const size_t Alignment = 64;
+
+    // Like ConversionThreadPool, the pool is never destroyed, so buffers released from static destructors stay valid.
+    static FrameBufferPool& Instance()
+    {
+        static FrameBufferPool* pool = new FrameBufferPool();
+        return *pool;
+    }
+
+    // A buffer of at least size bytes, its contents are undefined.
+    uint8_t* Acquire(size_t size)
+    {
+        size_t sizeClass = SizeClass(size);
+        uint8_t* buffer = nullptr;
+
+        {
+            std::lock_guard<std::mutex> guard(poolLock);
+            std::vector<uint8_t*>& freeBuffers = freeLists[sizeClass];
+            if (!freeBuffers.empty())
+            {
+                buffer = freeBuffers.back();
+                freeBuffers.pop_back();
+            }
+        }
+
+        if (buffer == nullptr)
+        {
+            buffer = Allocate(sizeClass);
+            if (buffer == nullptr)
+            {
+                return nullptr;
+            }
+        }
+
+        bytesInUse += sizeClass;
+        buffersInUse++;
+        return buffer;
+    }
+
+    // Return a buffer from Acquire to the pool. Null is ignored.
+    void Release(void* buffer)
+    {
+        if (buffer == nullptr)
+        {
+            return;
+        }
+
+        uint8_t* bytes = static_cast<uint8_t*>(buffer);
+        size_t sizeClass = GetHeader(bytes)->sizeClass;
+        bytesInUse -= sizeClass;
+        buffersInUse--;
+
+        std::lock_guard<std::mutex> guard(poolLock);
+        freeLists[sizeClass].push_back(bytes);
+    }
+
+    // Back buffers allocated from now on with large pages, if the process may lock memory. Returns false if it may not,
+    // in which case buffers keep using regular pages. Buffers already in the pool keep their pages.
+    bool SetUseLargePages(bool enable)
+    {
+        if (!enable)
+        {
+            useLargePages = false;
+            return true;
+        }
+
+#if defined(_WIN32)
+        if (largePageMinimum == 0)
+        {
+            largePageMinimum = GetLargePageMinimum();
+            if (largePageMinimum == 0 || !EnableLockMemoryPrivilege())
+            {
+                largePageMinimum = 0;
+                return false;
+            }
+        }
+
+        useLargePages = true;
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // Free every buffer that is not acquired, for example once recording stops.
+    void Trim()
+    {
+        std::vector<uint8_t*> buffers;
+        {
+            std::lock_guard<std::mutex> guard(poolLock);
+            for (auto& freeList : freeLists)
+            {
+                buffers.insert(buffers.end(), freeList.second.begin(), freeList.second.end());
+                freeList.second.clear();
+            }
+        }
+
+        for (uint8_t* buffer : buffers)
+        {
+            Free(buffer);
+        }
+    }
+
+    FrameBufferPoolStats GetStats() const
+    {
+        FrameBufferPoolStats stats;
+        stats.bytesInUse = bytesInUse;
+        stats.bytesReserved = bytesReserved;
+        stats.buffersInUse = buffersInUse;
+        stats.systemAllocations = systemAllocations;
+        stats.largePageBytes = largePageBytes;
+        return stats;
+    }
+
+private:
+    // Sits in front of every buffer, one alignment unit long so the buffer itself stays aligned.
+    struct BufferHeader
+    {
+        size_t sizeClass;
+        size_t allocatedBytes;
+        bool largePage;
+    };
+
+    static_assert(sizeof(BufferHeader) <= Alignment, "The buffer header must fit in front of an aligned buffer");
+
+    FrameBufferPool() {}
+
+    static size_t SizeClass(size_t size)
+    {
+        return (((size == 0) ? 1 : size) + Alignment - 1) / Alignment * Alignment;
+    }
+
+    static BufferHeader* GetHeader(uint8_t* buffer)
+    {
+        return reinterpret_cast<BufferHeader*>(buffer - Alignment);
+    }
+
+    uint8_t* Allocate(size_t sizeClass)
+    {
+        size_t bytes = sizeClass + Alignment;
+        uint8_t* base = nullptr;
+        bool largePage = false;
+
+#if defined(_WIN32)
+        if (useLargePages && largePageMinimum != 0)
+        {
+            size_t largePageSize = (bytes + largePageMinimum - 1) / largePageMinimum * largePageMinimum;
+            base = static_cast<uint8_t*>(VirtualAlloc(NULL, largePageSize, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE));
+            if (base != nullptr)
+            {
+                bytes = largePageSize;
+                largePage = true;
+            }
+        }
+
+        if (base == nullptr)
+        {
+            base = static_cast<uint8_t*>(_aligned_malloc(bytes, Alignment));
+        }
+#else
+        void* allocated = nullptr;
+        if (posix_memalign(&allocated, Alignment, bytes) == 0)
+        {
+            base = static_cast<uint8_t*>(allocated);
+        }
+#endif
+
+        if (base == nullptr)
+        {
+            return nullptr;
+        }
+
+        uint8_t* buffer = base + Alignment;
+        BufferHeader* header = GetHeader(buffer);
+        header->sizeClass = sizeClass;
+        header->allocatedBytes = bytes;
+        header->largePage = largePage;
+
+        bytesReserved += bytes;
+        systemAllocations++;
+        if (largePage)
+        {
+            largePageBytes += bytes;
+        }
+
+        return buffer;
+    }
+
+    void Free(uint8_t* buffer)
+    {
+        BufferHeader* header = GetHeader(buffer);
+        bytesReserved -= header->allocatedBytes;
+        uint8_t* base = buffer - Alignment;
+
+#if defined(_WIN32)
+        if (header->largePage)
+        {
+            largePageBytes -= header->allocatedBytes;
+            VirtualFree(base, 0, MEM_RELEASE);
+            return;
+        }
+
+        _aligned_free(base);
+#else
+        free(base);
+#endif
+    }
+
+#if defined(_WIN32)
+    // Large pages need SeLockMemoryPrivilege, which has to be granted to the user and enabled on the process token.
+    static bool EnableLockMemoryPrivilege()
+    {
+        HANDLE token = NULL;
+        if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token))
+        {
+            return false;
+        }
+
+        TOKEN_PRIVILEGES privileges = {};
+        privileges.PrivilegeCount = 1;
+        privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+
+        bool enabled = LookupPrivilegeValue(NULL, SE_LOCK_MEMORY_NAME, &privileges.Privileges[0].Luid)
+            && AdjustTokenPrivileges(token, FALSE, &privileges, 0, NULL, NULL)
+            && GetLastError() == ERROR_SUCCESS;
+
+        CloseHandle(token);
+        return enabled;
+    }
+
+    size_t largePageMinimum = 0;
+#endif
+
+    std::mutex poolLock;
+    std::map<size_t, std::vector<uint8_t*>> freeLists;
+    std::atomic<bool> useLargePages { false };
+
+    std::atomic<size_t> bytesInUse { 0 };
+    std::atomic<size_t> bytesReserved { 0 };
+    std::atomic<size_t> buffersInUse { 0 };
+    std::atomic<size_t> systemAllocations { 0 };
+    std::atomic<size_t> largePageBytes { 0 };
+};
@@ -0,0 +1,316 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+// Fixed size ring of captured frames, shared between a capture thread that writes them and the render thread that reads them.
+// Frames are addressed by sequence number, starting at 1. Each sequence is written into the slot holding the oldest frame,
+// and a table indexed by sequence % Capacity remembers which slot that was, so a frame stays where it was written until
+// it is overwritten, whatever the depth does in between.
+// Each slot carries a generation that holds the sequence it was last published as, or a marker while it is written.
+// Readers check the generation before and after reading, like a seqlock, so a frame overwritten under them is detected
+// instead of silently torn. Neither side ever takes a lock or waits for the other.
+// The depth can change at runtime, up to Capacity. Growing keeps every frame. Shrinking first moves the newest frames
+// out of the slots it drops, then retires those, and the writer can release whatever they own once IsQuiescent shows
+// no read started before the change is still running.
+
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+// The published frames around a key, like a capture timestamp, found by FrameRing::FindBracket.
+template <typename Key>
+struct FrameBracket
+{
+    // The last sequence keyed at or before the target and the first one keyed after it, 0 if there is none.
+    int earlier = 0;
+    int later = 0;
+    Key earlierKey = Key();
+    Key laterKey = Key();
+
+    // Whichever of earlier and later is keyed nearest to target, 0 if neither exists.
+    int Nearest(const Key& target) const
+    {
+        if (earlier == 0 || later == 0)
+        {
+            return (earlier == 0) ? later : earlier;
+        }
+
+        return (target - earlierKey <= laterKey - target) ? earlier : later;
+    }
+};
+
+template <typename Frame, int Capacity>
+class FrameRing
+{
+public:
+    static_assert(Capacity > 1, "A frame ring needs room for the frame being written and the one being read");
+
+    FrameRing()
+    {
+        Reset();
+    }
+
+    FrameRing(const FrameRing&) = delete;
+    FrameRing& operator=(const FrameRing&) = delete;
+
+    // Forget every published frame. Only call this while no frame is being written or read. The depth is kept.
+    void Reset()
+    {
+        for (int i = 0; i < Capacity; i++)
+        {
+            generations[i].store(Empty, std::memory_order_relaxed);
+            slots[i].store(i, std::memory_order_relaxed);
+            sequences[i] = 0;
+        }
+
+        published.store(0, std::memory_order_release);
+    }
+
+    // Writer: claim the slot holding the oldest frame for sequence. Readers of the frame it held fail from now on.
+    Frame& BeginWrite(int sequence)
+    {
+        int index = NextIndex();
+        generations[index].store(Writing, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        sequences[index] = sequence;
+        slots[Entry(sequence)].store(index, std::memory_order_release);
+        return frames[index];
+    }
+
+    // Writer: make sequence readable. The latest published sequence only moves forward, so frames that finish out of
+    // order, like those waiting on body tracking, are published once they are done.
+    void Publish(int sequence)
+    {
+        generations[Index(sequence)].store(sequence, std::memory_order_release);
+
+        int latest = published.load(std::memory_order_relaxed);
+        while (latest < sequence && !published.compare_exchange_weak(latest, sequence, std::memory_order_release, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    // Writer: the slot for sequence, whatever it holds. Used to look back at frames the writer published itself, check
+    // IsPublished or IsWriting first if it may have been overwritten since.
+    Frame& Slot(int sequence)
+    {
+        return frames[Index(sequence)];
+    }
+
+    // Writer: the slot at index, between 0 and Capacity, to set up or release the storage it owns.
+    Frame& SlotAt(int index)
+    {
+        return frames[index];
+    }
+
+    // Writer: use depth slots from the next BeginWrite on. The newest depth frames stay readable, readers of older ones
+    // and of frames moved out of the dropped slots fail from now on. Frames that are still being written are not moved.
+    void SetDepth(int newDepth)
+    {
+        newDepth = (newDepth < 2) ? 2 : ((newDepth > Capacity) ? Capacity : newDepth);
+        int oldDepth = depth.load(std::memory_order_relaxed);
+        for (int i = newDepth; i < oldDepth; i++)
+        {
+            // Swap the frame with the oldest one kept if it is newer, so the kept slots end up with the newest frames.
+            int oldest = OldestIndex(newDepth, true);
+            if (sequences[i] != 0 && !IsClaimed(i) && oldest >= 0 && sequences[oldest] < sequences[i])
+            {
+                Move(i, oldest);
+            }
+        }
+
+        for (int i = newDepth; i < oldDepth; i++)
+        {
+            generations[i].store(Retired, std::memory_order_relaxed);
+            sequences[i] = 0;
+        }
+
+        depth.store(newDepth, std::memory_order_release);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+
+    int GetDepth() const
+    {
+        return depth.load(std::memory_order_acquire);
+    }
+
+    // Writer: true if no read is running, so no reader still uses a slot retired or overwritten before this call.
+    bool IsQuiescent() const
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return readers.load(std::memory_order_relaxed) == 0;
+    }
+
+    bool IsPublished(int sequence) const
+    {
+        return generations[Index(sequence)].load(std::memory_order_acquire) == sequence;
+    }
+
+    // Writer: true while sequence is claimed by BeginWrite and not published yet.
+    bool IsWriting(int sequence) const
+    {
+        int index = Index(sequence);
+        return sequences[index] == sequence && IsClaimed(index);
+    }
+
+    // Writer: true while the slot the next BeginWrite claims holds a frame that is not published yet.
+    bool IsNextSlotWriting() const
+    {
+        return IsClaimed(NextIndex());
+    }
+
+    // The most recent sequence published, 0 before the first frame.
+    int GetPublishedSequence() const
+    {
+        return published.load(std::memory_order_acquire);
+    }
+
+    // Reader: call reader(const Frame&) if sequence is published. Returns false if it is not, or if the writer claimed the
+    // slot while reader ran, in which case whatever reader produced is torn and must be dropped.
+    template <typename Reader>
+    bool Read(int sequence, const Reader& reader) const
+    {
+        if (sequence <= 0)
+        {
+            return false;
+        }
+
+        // Pairs with the fence in SetDepth and IsQuiescent: either this sees a slot retired, or the writer sees this read.
+        readers.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        int index = Index(sequence);
+        const std::atomic<int>& generation = generations[index];
+        bool read = false;
+        if (generation.load(std::memory_order_acquire) == sequence)
+        {
+            reader(frames[index]);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            read = generation.load(std::memory_order_relaxed) == sequence;
+        }
+
+        readers.fetch_sub(1, std::memory_order_release);
+        return read;
+    }
+
+    // Reader: find the published frames whose key, from keyOf(const Frame&), brackets target. Keys must not decrease
+    // with sequence, like capture timestamps do, so this is a binary search over the frames the ring still holds.
+    // Frames that are not published, or are overwritten during the search, are skipped.
+    template <typename Key, typename KeyOf>
+    FrameBracket<Key> FindBracket(const Key& target, const KeyOf& keyOf) const
+    {
+        FrameBracket<Key> bracket;
+        int high = GetPublishedSequence();
+        int low = high - GetDepth() + 1;
+        low = (low < 1) ? 1 : low;
+
+        while (low <= high)
+        {
+            int middle = low + (high - low) / 2;
+
+            // Use the nearest readable frame at or below the middle, the ones above it are no candidates.
+            Key key = Key();
+            int probe = middle;
+            while (probe >= low && !Read(probe, [&](const Frame& frame) { key = keyOf(frame); }))
+            {
+                probe--;
+            }
+
+            if (probe < low)
+            {
+                low = middle + 1;
+            }
+            else if (!(target < key))
+            {
+                bracket.earlier = probe;
+                bracket.earlierKey = key;
+                low = middle + 1;
+            }
+            else
+            {
+                bracket.later = probe;
+                bracket.laterKey = key;
+                high = probe - 1;
+            }
+        }
+
+        return bracket;
+    }
+
+private:
+    static const int Empty = -1;
+    static const int Writing = -2;
+    static const int Retired = -3;
+
+    // The entry of slots that sequence is looked up in. Sequences Capacity apart share one, but the ring never holds
+    // both, and the generation check tells a stale entry apart.
+    static int Entry(int sequence)
+    {
+        int entry = sequence % Capacity;
+        return (entry < 0) ? entry + Capacity : entry;
+    }
+
+    int Index(int sequence) const
+    {
+        return slots[Entry(sequence)].load(std::memory_order_acquire);
+    }
+
+    bool IsClaimed(int index) const
+    {
+        return generations[index].load(std::memory_order_acquire) == Writing;
+    }
+
+    // Writer: the slot below count holding the oldest frame, or none yet. Skips slots still being written if asked to,
+    // and returns -1 if that leaves none.
+    int OldestIndex(int count, bool skipClaimed) const
+    {
+        int oldest = -1;
+        for (int i = 0; i < count; i++)
+        {
+            if ((!skipClaimed || !IsClaimed(i)) && (oldest < 0 || sequences[i] < sequences[oldest]))
+            {
+                oldest = i;
+            }
+        }
+
+        return oldest;
+    }
+
+    int NextIndex() const
+    {
+        return OldestIndex(depth.load(std::memory_order_relaxed), false);
+    }
+
+    // Writer: swap the frames in slots from and to, and point their sequences at their new slots.
+    void Move(int from, int to)
+    {
+        int fromSequence = sequences[from];
+        int toSequence = sequences[to];
+        int toGeneration = generations[to].load(std::memory_order_relaxed);
+        generations[from].store(Writing, std::memory_order_relaxed);
+        generations[to].store(Writing, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        std::swap(frames[from], frames[to]);
+        std::swap(sequences[from], sequences[to]);
+        slots[Entry(fromSequence)].store(to, std::memory_order_release);
+        if (toSequence != 0)
+        {
+            slots[Entry(toSequence)].store(from, std::memory_order_release);
+        }
+
+        generations[to].store(fromSequence, std::memory_order_release);
+        generations[from].store(toGeneration, std::memory_order_release);
+    }
+
+    Frame frames[Capacity];
+    std::atomic<int> generations[Capacity];
+    // The slot each sequence was written into, by Entry(sequence).
+    std::atomic<int> slots[Capacity];
+    // The sequence each slot was last claimed for, 0 if none, only touched by the writer that calls BeginWrite.
+    int sequences[Capacity];
+    std::atomic<int> published;
+    std::atomic<int> depth { Capacity };
+    mutable std::atomic<int> readers { 0 };
+};
@@ -0,0 +1,177 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+// Non-owning description of an image in memory, including the distance between rows.
+// Lets the conversion helpers read from and write to pitch-padded memory, like mapped textures, without a packed copy.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+enum class ImageFormat
+{
+    BGRA,
+    RGBA,
+    UYVY,
+    // Full resolution Y plane followed by an interleaved UV plane at half resolution, both using the same pitch.
+    NV12,
+    Alpha8,
+    RGB,
+    // 10 bit 4:2:2, six pixels in every 16 bytes with rows padded to 48 pixels. See V210Conversion.h.
+    V210
+};
+
+struct ImageView
+{
+    uint8_t* data = nullptr;
+    int width = 0;
+    int height = 0;
+    // Bytes between the start of two rows, at least RowBytes() in magnitude. Negative for bottom-up views.
+    int pitch = 0;
+    ImageFormat format = ImageFormat::BGRA;
+
+    ImageView() {}
+
+    // A pitch of 0 describes tightly packed rows.
+    // Views of source images are never written to, so read-only memory may be wrapped as well.
+    ImageView(const void* data, int width, int height, ImageFormat format, int pitch = 0) :
+        data((uint8_t*)data),
+        width(width),
+        height(height),
+        pitch((pitch > 0) ? pitch : RowBytes(width, format)),
+        format(format)
+    {
+    }
+
+    // Bytes per pixel of the first plane, rounded down for V210.
+    static int BytesPerPixel(ImageFormat format)
+    {
+        switch (format)
+        {
+        case ImageFormat::BGRA:
+        case ImageFormat::RGBA:
+            return 4;
+        case ImageFormat::RGB:
+            return 3;
+        case ImageFormat::UYVY:
+            return 2;
+        default:
+            return 1;
+        }
+    }
+
+    bool IsValid() const
+    {
+        return data != nullptr && width > 0 && height > 0;
+    }
+
+    bool IsPacked() const
+    {
+        return pitch == RowBytes();
+    }
+
+    int RowBytes() const
+    {
+        return RowBytes(width, format);
+    }
+
+    static int RowBytes(int width, ImageFormat format)
+    {
+        if (format == ImageFormat::V210)
+        {
+            return ((width + 47) / 48) * 128;
+        }
+
+        return width * BytesPerPixel(format);
+    }
+
+    uint8_t* Row(int y) const
+    {
+        return data + (ptrdiff_t)y * pitch;
+    }
+
+    // Row of the UV plane of an NV12 image, each covers two rows of the Y plane.
+    // Only valid on views of the whole image, since the plane starts after the last Y row.
+    uint8_t* ChromaRow(int y) const
+    {
+        return data + (ptrdiff_t)(height + y) * pitch;
+    }
+
+    // Total number of bytes the view spans, including every plane. Only valid for top-down views.
+    size_t ByteSize() const
+    {
+        size_t rows = (format == ImageFormat::NV12) ? (size_t)height + height / 2 : (size_t)height;
+        return (rows - 1) * pitch + RowBytes();
+    }
+
+    // The same rows of a single plane image in bottom-up order. Writing through it stores an upside down copy,
+    // so a conversion can reorient its output in the same pass.
+    ImageView FlippedVertically() const
+    {
+        ImageView flipped = *this;
+        flipped.data = Row(height - 1);
+        flipped.pitch = -pitch;
+        return flipped;
+    }
+
+    // Rows [firstRow, endRow) of a single plane image.
+    ImageView Rows(int firstRow, int endRow) const
+    {
+        ImageView rows = *this;
+        rows.data = Row(firstRow);
+        rows.height = endRow - firstRow;
+        return rows;
+    }
+
+    // The UV plane of an NV12 image, as a single plane view of half the height. For a bottom-up view of an image,
+    // this is the bottom-up view of its UV plane, which still follows the Y plane in memory.
+    ImageView ChromaPlane() const
+    {
+        ImageView chroma = *this;
+        chroma.format = ImageFormat::Alpha8;
+        chroma.height = height / 2;
+        if (pitch >= 0)
+        {
+            chroma.data = data + (ptrdiff_t)height * pitch;
+        }
+        else
+        {
+            uint8_t* top = Row(height - 1);
+            chroma.data = top + (ptrdiff_t)(height + chroma.height - 1) * -pitch;
+        }
+
+        return chroma;
+    }
+
+    // Copy the overlapping rows of source into destination, converting between pitches.
+    // Each plane of an NV12 image is copied from the start of its own plane, so the heights may differ.
+    static void Copy(const ImageView& source, const ImageView& destination)
+    {
+        CopyPlane(source, destination);
+
+        if (source.format == ImageFormat::NV12 && destination.format == ImageFormat::NV12)
+        {
+            CopyPlane(source.ChromaPlane(), destination.ChromaPlane());
+        }
+    }
+
+private:
+    static void CopyPlane(const ImageView& source, const ImageView& destination)
+    {
+        int rowBytes = (source.RowBytes() < destination.RowBytes()) ? source.RowBytes() : destination.RowBytes();
+        int rows = (source.height < destination.height) ? source.height : destination.height;
+
+        if (source.IsPacked() && destination.IsPacked() && source.pitch == destination.pitch)
+        {
+            memcpy(destination.data, source.data, (size_t)rows * rowBytes);
+            return;
+        }
+
+        for (int y = 0; y < rows; y++)
+        {
+            memcpy(destination.Row(y), source.Row(y), rowBytes);
+        }
+    }
+};
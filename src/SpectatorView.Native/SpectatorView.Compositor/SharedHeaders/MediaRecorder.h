@@ -0,0 +1,248 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+// Records video frames and audio buffers into an IMediaSink.
+// Any thread can queue frames and audio. Each one is copied into a sink buffer and queued for a single encoder thread,
+// which turns capture timestamps into times from the start of the recording and writes the samples in the order they
+// were queued. The queue is bounded, so a sink that falls behind either holds up the producers or drops the oldest
+// samples, see BoundedQueue. Nothing here depends on the backend, so recording can be run and measured with any sink.
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include "BoundedQueue.h"
+#include "MediaSink.h"
+#include "ThreadRoles.h"
+
+class MediaRecorder
+{
+public:
+    // About a quarter of a second of frames with the audio between them.
+    static const int DefaultQueueCapacity = 16;
+
+    explicit MediaRecorder(IMediaSink* sink) :
+        sink(sink),
+        inputQueue(DefaultQueueCapacity)
+    {
+    }
+
+    ~MediaRecorder()
+    {
+        Stop();
+    }
+
+    MediaRecorder(const MediaRecorder&) = delete;
+    MediaRecorder& operator=(const MediaRecorder&) = delete;
+
+    // Returns false if already recording, or if the sink cannot record to path.
+    bool Start(const std::wstring& path, const MediaSinkFormat& recordingFormat)
+    {
+        std::lock_guard<std::mutex> control(controlLock);
+        std::unique_lock<std::shared_mutex> lock(stateLock);
+        if (isRecording || !sink->Open(path, recordingFormat))
+        {
+            return false;
+        }
+
+        format = recordingFormat;
+        startTime = InvalidTimestamp;
+        prevVideoTime = InvalidTimestamp;
+        prevAudioTime = InvalidTimestamp;
+
+        // The sink holds on to some frames while its encoder works on them, on top of the queued ones.
+        sink->ReserveVideoBuffers(inputQueue.GetCapacity());
+
+        isRecording = true;
+        inputQueue.Open();
+        encoderThread = std::thread(&MediaRecorder::EncoderThread, this);
+        return true;
+    }
+
+    bool IsRecording()
+    {
+        return isRecording;
+    }
+
+    // Frames queued before this still make it into the file.
+    void Stop()
+    {
+        std::lock_guard<std::mutex> control(controlLock);
+        {
+            std::unique_lock<std::shared_mutex> lock(stateLock);
+            if (!isRecording)
+            {
+                return;
+            }
+
+            isRecording = false;
+        }
+
+        // The encoder thread writes what is still queued, then exits.
+        inputQueue.Close();
+        encoderThread.join();
+
+        sink->Close();
+    }
+
+    // Any thread: the frame is copied before this returns. Timestamps and durations are in 100 ns units.
+    void QueueVideoFrame(const uint8_t* frame, int64_t timestamp, int64_t duration)
+    {
+        std::shared_lock<std::shared_mutex> lock(stateLock);
+        if (!isRecording)
+        {
+            return;
+        }
+
+        MediaSinkBuffer buffer = {};
+        if (!sink->AcquireVideoBuffer(&buffer))
+        {
+            return;
+        }
+
+        memcpy(buffer.data, frame, buffer.size);
+        QueueInput({ buffer, false, timestamp, duration });
+    }
+
+    void QueueAudioFrame(const uint8_t* audio, int size, int64_t timestamp)
+    {
+        std::shared_lock<std::shared_mutex> lock(stateLock);
+        if (!isRecording || !format.encodeAudio)
+        {
+            return;
+        }
+
+        MediaSinkBuffer buffer = {};
+        if (!sink->AcquireAudioBuffer(size, &buffer))
+        {
+            return;
+        }
+
+        memcpy(buffer.data, audio, size);
+        QueueInput({ buffer, true, timestamp, 0 });
+    }
+
+    // What queueing does once the encoder thread has capacity frames and audio buffers waiting.
+    void SetQueuePolicy(QueueFullPolicy policy, int capacity)
+    {
+        inputQueue.SetPolicy(policy);
+        inputQueue.SetCapacity(capacity);
+    }
+
+    BoundedQueueStats GetQueueStats()
+    {
+        return inputQueue.GetStats();
+    }
+
+private:
+    static const int64_t InvalidTimestamp = -1;
+
+    struct EncoderInput
+    {
+        MediaSinkBuffer buffer;
+        bool isAudio;
+        int64_t timestamp;
+        int64_t duration;
+    };
+
+    void QueueInput(const EncoderInput& input)
+    {
+        EncoderInput dropped = {};
+        QueuePushResult result = inputQueue.Push(input, &dropped);
+        if (result == QueuePushResult::Closed)
+        {
+            EncoderInput closed = input;
+            sink->ReleaseBuffer(&closed.buffer);
+        }
+        else if (result == QueuePushResult::PushedDroppingOldest)
+        {
+            sink->ReleaseBuffer(&dropped.buffer);
+        }
+    }
+
+    void EncoderThread()
+    {
+        // The thread lives for one recording.
+        ThreadRoleScope threadRole(ThreadRole::Encode);
+
+        EncoderInput input;
+        while (inputQueue.Pop(&input))
+        {
+            ThreadRoles::Instance().Apply(ThreadRole::Encode);
+            Write(input);
+        }
+    }
+
+    // Encoder thread only.
+    void Write(EncoderInput& input)
+    {
+        // The recording starts with whichever of video and audio comes first, anything older is left out.
+        if (startTime == InvalidTimestamp)
+        {
+            startTime = input.timestamp;
+        }
+        else if (input.timestamp < startTime)
+        {
+            sink->ReleaseBuffer(&input.buffer);
+            return;
+        }
+
+        int64_t sampleTime = input.timestamp - startTime;
+
+        if (input.isAudio)
+        {
+            // Until there is a previous buffer, the duration is the length of the audio itself.
+            int64_t duration = 0;
+            if (prevAudioTime != InvalidTimestamp)
+            {
+                duration = sampleTime - prevAudioTime;
+            }
+            else if (format.audioChannels > 0 && format.audioSampleRate > 0)
+            {
+                duration = (int64_t)input.buffer.size / (2 * format.audioChannels) * MEDIA_TICKS_PER_SECOND / format.audioSampleRate;
+            }
+
+            sink->WriteAudio(&input.buffer, sampleTime, duration);
+            prevAudioTime = sampleTime;
+            return;
+        }
+
+        // The same frame queued twice.
+        if (sampleTime == prevVideoTime)
+        {
+            sink->ReleaseBuffer(&input.buffer);
+            return;
+        }
+
+        int64_t duration = input.duration;
+        if (prevVideoTime != InvalidTimestamp)
+        {
+            duration = sampleTime - prevVideoTime;
+        }
+
+        sink->WriteVideo(&input.buffer, sampleTime, duration);
+        prevVideoTime = sampleTime;
+    }
+
+    IMediaSink* sink;
+    MediaSinkFormat format = {};
+
+    // Held for the whole of Start and Stop, so a recording cannot start while the last one is still being written.
+    std::mutex controlLock;
+    // Producers hold it shared while they queue.
+    std::shared_mutex stateLock;
+    std::atomic<bool> isRecording { false };
+
+    BoundedQueue<EncoderInput> inputQueue;
+    std::thread encoderThread;
+
+    // Encoder thread only.
+    int64_t startTime = InvalidTimestamp;
+    int64_t prevVideoTime = InvalidTimestamp;
+    int64_t prevAudioTime = InvalidTimestamp;
+};
@@ -0,0 +1,76 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+// Backend of a recording: the part that encodes samples and writes them into a file. MediaRecorder decides which
+// samples are written and when, and hands them to a sink in order from a single thread.
+// Sinks own the buffers samples are copied into, so a backend can hand out memory its encoder takes without another
+// copy, like the pooled media samples of the Media Foundation sink.
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include "ImageView.h"
+
+// Sample times and durations are in 100 nanosecond units, like the compositor's timestamps.
+#define MEDIA_TICKS_PER_SECOND 10000000LL
+
+struct MediaSinkFormat
+{
+    int width;
+    int height;
+    // Bytes from one row to the next, of the luma plane for NV12.
+    int stride;
+    // BGRA or NV12.
+    ImageFormat videoFormat;
+    uint32_t fps;
+    uint32_t videoBitrate;
+    uint32_t videoMpegLevel;
+
+    // Audio is 16 bit PCM.
+    bool encodeAudio;
+    uint32_t audioSampleRate;
+    uint32_t audioChannels;
+    // Average bytes per second of the encoded audio.
+    uint32_t audioBPS;
+
+    // Bytes in one video frame.
+    int VideoBufferSize() const
+    {
+        return (videoFormat == ImageFormat::NV12) ? stride * height * 3 / 2 : stride * height;
+    }
+};
+
+// A video frame or audio buffer owned by a sink.
+struct MediaSinkBuffer
+{
+    uint8_t* data;
+    int size;
+    // Whatever the sink needs to find the buffer again, such as the media sample it belongs to.
+    void* sinkData;
+};
+
+class IMediaSink
+{
+public:
+    virtual ~IMediaSink() {}
+
+    // Create the file at path for samples in format. Returns false if it cannot be recorded.
+    virtual bool Open(const std::wstring& path, const MediaSinkFormat& format) = 0;
+    // Write whatever the encoder still holds and finish the file. Every buffer must have been written or released.
+    virtual void Close() = 0;
+
+    // Keep at least count video buffers ready, so the first frames of a recording do not allocate.
+    virtual void ReserveVideoBuffers(int /*count*/) {}
+
+    // Any thread while open: a buffer for one video frame, or for size bytes of audio. The producer fills data.
+    virtual bool AcquireVideoBuffer(MediaSinkBuffer* buffer) = 0;
+    virtual bool AcquireAudioBuffer(int size, MediaSinkBuffer* buffer) = 0;
+    // Give back a buffer that will not be written.
+    virtual void ReleaseBuffer(MediaSinkBuffer* buffer) = 0;
+
+    // One thread at a time, in order: write a filled buffer at sampleTime from the start of the recording.
+    // The buffer is released whether or not it could be written.
+    virtual bool WriteVideo(MediaSinkBuffer* buffer, int64_t sampleTime, int64_t duration) = 0;
+    virtual bool WriteAudio(MediaSinkBuffer* buffer, int64_t sampleTime, int64_t duration) = 0;
+};
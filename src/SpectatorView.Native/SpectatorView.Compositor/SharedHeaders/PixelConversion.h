@@ -0,0 +1,476 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+// Registry of CPU pixel format conversions keyed on (source format, destination format, color matrix, alpha policy).
+// Each combination is a separate template instantiation, so format and alpha decisions are made at compile time
+// and never inside the per pixel loop. Combinations with a SIMD kernel specialize PixelConverter to forward to it,
+// everything else goes through the generic converter, which is assembled from PixelFormatTraits.
+//
+// To support a new camera format, add an ImageFormat, a PixelFormatTraits specialization and registry entries.
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include "ConversionThreadPool.h"
+#include "ImageView.h"
+#include "V210Conversion.h"
+#include "YUVConversion.h"
+
+enum class AlphaPolicy
+{
+    // Destination alpha is 255.
+    Opaque,
+    // Destination alpha is copied from the source, or 255 if the source has none.
+    Preserve,
+    // Alpha travels in a separate Alpha8 plane: read from it when the source has no alpha channel,
+    // written to it when the destination has none.
+    Separate
+};
+
+struct RgbaPixel
+{
+    int r;
+    int g;
+    int b;
+    int a;
+};
+
+// Fixed point YUV math for one ColorMatrix, using the precomputed YUVConversion coefficients.
+template <ColorMatrix Matrix>
+struct ColorMatrixTraits
+{
+    static const YUVCoefficients& Coefficients()
+    {
+        return YUVConversion::GetCoefficients(Matrix);
+    }
+
+    static void ToRGB(int y, int u, int v, RgbaPixel& pixel)
+    {
+        YUVConversion::RGBFromYUV(y, u, v, Coefficients(), pixel.r, pixel.g, pixel.b);
+    }
+
+    static uint8_t Luma(const RgbaPixel& pixel)
+    {
+        return YUVConversion::LumaFromRGB(pixel.r, pixel.g, pixel.b, Coefficients());
+    }
+
+    static uint8_t BlueChroma(const RgbaPixel& pixel)
+    {
+        return YUVConversion::BlueChromaFromRGB(pixel.r, pixel.g, pixel.b, Coefficients());
+    }
+
+    static uint8_t RedChroma(const RgbaPixel& pixel)
+    {
+        return YUVConversion::RedChromaFromRGB(pixel.r, pixel.g, pixel.b, Coefficients());
+    }
+};
+
+// Formats are read and written two horizontal pixels at a time, the smallest unit that holds whole UYVY samples.
+template <ImageFormat Format>
+struct PixelFormatTraits;
+
+template <int RedOffset, int BlueOffset>
+struct FourChannelTraits
+{
+    static const int BytesPerPixel = 4;
+    static const bool HasAlpha = true;
+    static const bool IsYUV = false;
+
+    template <ColorMatrix Matrix>
+    static void ReadPair(const uint8_t* source, RgbaPixel* pixels)
+    {
+        for (int i = 0; i < 2; i++, source += 4)
+        {
+            pixels[i].r = source[RedOffset];
+            pixels[i].g = source[1];
+            pixels[i].b = source[BlueOffset];
+            pixels[i].a = source[3];
+        }
+    }
+
+    template <ColorMatrix Matrix>
+    static void WritePair(uint8_t* destination, const RgbaPixel* pixels)
+    {
+        for (int i = 0; i < 2; i++, destination += 4)
+        {
+            destination[RedOffset] = (uint8_t)pixels[i].r;
+            destination[1] = (uint8_t)pixels[i].g;
+            destination[BlueOffset] = (uint8_t)pixels[i].b;
+            destination[3] = (uint8_t)pixels[i].a;
+        }
+    }
+};
+
+template <>
+struct PixelFormatTraits<ImageFormat::BGRA> : FourChannelTraits<2, 0> {};
+
+template <>
+struct PixelFormatTraits<ImageFormat::RGBA> : FourChannelTraits<0, 2> {};
+
+template <>
+struct PixelFormatTraits<ImageFormat::RGB>
+{
+    static const int BytesPerPixel = 3;
+    static const bool HasAlpha = false;
+    static const bool IsYUV = false;
+
+    template <ColorMatrix Matrix>
+    static void ReadPair(const uint8_t* source, RgbaPixel* pixels)
+    {
+        for (int i = 0; i < 2; i++, source += 3)
+        {
+            pixels[i].r = source[0];
+            pixels[i].g = source[1];
+            pixels[i].b = source[2];
+            pixels[i].a = 255;
+        }
+    }
+
+    template <ColorMatrix Matrix>
+    static void WritePair(uint8_t* destination, const RgbaPixel* pixels)
+    {
+        for (int i = 0; i < 2; i++, destination += 3)
+        {
+            destination[0] = (uint8_t)pixels[i].r;
+            destination[1] = (uint8_t)pixels[i].g;
+            destination[2] = (uint8_t)pixels[i].b;
+        }
+    }
+};
+
+template <>
+struct PixelFormatTraits<ImageFormat::UYVY>
+{
+    static const int BytesPerPixel = 2;
+    static const bool HasAlpha = false;
+    static const bool IsYUV = true;
+
+    template <ColorMatrix Matrix>
+    static void ReadPair(const uint8_t* source, RgbaPixel* pixels)
+    {
+        ColorMatrixTraits<Matrix>::ToRGB(source[1], source[0], source[2], pixels[0]);
+        ColorMatrixTraits<Matrix>::ToRGB(source[3], source[0], source[2], pixels[1]);
+        pixels[0].a = 255;
+        pixels[1].a = 255;
+    }
+
+    // Chroma is co-sited with the first pixel of the pair.
+    template <ColorMatrix Matrix>
+    static void WritePair(uint8_t* destination, const RgbaPixel* pixels)
+    {
+        destination[0] = ColorMatrixTraits<Matrix>::BlueChroma(pixels[0]);
+        destination[1] = ColorMatrixTraits<Matrix>::Luma(pixels[0]);
+        destination[2] = ColorMatrixTraits<Matrix>::RedChroma(pixels[0]);
+        destination[3] = ColorMatrixTraits<Matrix>::Luma(pixels[1]);
+    }
+};
+
+// Generic converter, decodes each pixel pair of a row to RGBA and encodes it into the destination format.
+// Rows are converted in place safely, since every pair is read before it is written. The last pixel of an odd width
+// row goes through a scratch pair, UYVY rows always hold whole pairs.
+template <ImageFormat Source, ImageFormat Destination, ColorMatrix Matrix, AlphaPolicy Alpha>
+struct PixelConverter
+{
+    typedef PixelFormatTraits<Source> SourceTraits;
+    typedef PixelFormatTraits<Destination> DestinationTraits;
+
+    // Number of rows that have to be converted together.
+    static const int RowsPerUnit = 1;
+
+    static void ConvertRow(const uint8_t* source, uint8_t* alphaPlane, uint8_t* destination, int width)
+    {
+        int x = 0;
+        for (; x + 1 < width; x += 2)
+        {
+            ConvertPair(source + x * SourceTraits::BytesPerPixel, (alphaPlane != nullptr) ? alphaPlane + x : nullptr, destination + x * DestinationTraits::BytesPerPixel, 2);
+        }
+
+        if (x < width && !SourceTraits::IsYUV)
+        {
+            uint8_t sourcePair[2 * SourceTraits::BytesPerPixel];
+            uint8_t destinationPair[2 * DestinationTraits::BytesPerPixel];
+            memcpy(sourcePair, source + x * SourceTraits::BytesPerPixel, SourceTraits::BytesPerPixel);
+            memcpy(sourcePair + SourceTraits::BytesPerPixel, sourcePair, SourceTraits::BytesPerPixel);
+
+            ConvertPair(sourcePair, (alphaPlane != nullptr) ? alphaPlane + x : nullptr, destinationPair, 1);
+            memcpy(destination + x * DestinationTraits::BytesPerPixel, destinationPair, DestinationTraits::BytesPerPixel);
+        }
+    }
+
+    // Only the first count pixels of the pair use the alpha plane.
+    static void ConvertPair(const uint8_t* source, uint8_t* alphaPlane, uint8_t* destination, int count)
+    {
+        RgbaPixel pixels[2];
+        SourceTraits::template ReadPair<Matrix>(source, pixels);
+
+        for (int i = 0; i < 2; i++)
+        {
+            if (Alpha == AlphaPolicy::Opaque)
+            {
+                pixels[i].a = 255;
+            }
+            else if (Alpha == AlphaPolicy::Separate && !SourceTraits::HasAlpha)
+            {
+                pixels[i].a = (i < count) ? alphaPlane[i] : pixels[0].a;
+            }
+
+            if (Alpha == AlphaPolicy::Separate && !DestinationTraits::HasAlpha && i < count)
+            {
+                alphaPlane[i] = (uint8_t)pixels[i].a;
+            }
+        }
+
+        DestinationTraits::template WritePair<Matrix>(destination, pixels);
+    }
+
+    static void ConvertRows(const ImageView& source, const ImageView& alphaPlane, const ImageView& destination, int firstRow, int endRow)
+    {
+        for (int y = firstRow; y < endRow; y++)
+        {
+            PixelConverter::ConvertRow(source.Row(y), alphaPlane.IsValid() ? alphaPlane.Row(y) : nullptr, destination.Row(y), destination.width);
+        }
+    }
+};
+
+// Same format with alpha kept, each row is a plain copy. Used to reorient an image through a flipped view.
+struct RowCopier
+{
+    static const int RowsPerUnit = 1;
+
+    static void ConvertRows(const ImageView& source, const ImageView& /*alphaPlane*/, const ImageView& destination, int firstRow, int endRow)
+    {
+        for (int y = firstRow; y < endRow; y++)
+        {
+            if (source.Row(y) != destination.Row(y))
+            {
+                memcpy(destination.Row(y), source.Row(y), destination.RowBytes());
+            }
+        }
+    }
+};
+
+template <ColorMatrix Matrix> struct PixelConverter<ImageFormat::BGRA, ImageFormat::BGRA, Matrix, AlphaPolicy::Preserve> : RowCopier {};
+template <ColorMatrix Matrix> struct PixelConverter<ImageFormat::RGBA, ImageFormat::RGBA, Matrix, AlphaPolicy::Preserve> : RowCopier {};
+
+// Specializations backed by the YUVConversion SIMD kernels, instantiated for the channel order and alpha plane.
+template <ColorMatrix Matrix, bool Rgba, bool UseAlphaPlane>
+struct UYVYDecoder
+{
+    static const int RowsPerUnit = 1;
+
+    static void ConvertRows(const ImageView& source, const ImageView& alphaPlane, const ImageView& destination, int firstRow, int endRow)
+    {
+        const YUVCoefficients& coefficients = ColorMatrixTraits<Matrix>::Coefficients();
+        for (int y = firstRow; y < endRow; y++)
+        {
+            YUVConversion::ConvertUYVYtoBGRA<Rgba, UseAlphaPlane>(source.Row(y), UseAlphaPlane ? alphaPlane.Row(y) : nullptr, destination.Row(y), destination.width, coefficients);
+        }
+    }
+};
+
+template <ColorMatrix Matrix, bool Rgba, bool UseAlphaPlane>
+struct UYVYEncoder
+{
+    static const int RowsPerUnit = 1;
+
+    static void ConvertRows(const ImageView& source, const ImageView& alphaPlane, const ImageView& destination, int firstRow, int endRow)
+    {
+        const YUVCoefficients& coefficients = ColorMatrixTraits<Matrix>::Coefficients();
+        for (int y = firstRow; y < endRow; y++)
+        {
+            YUVConversion::ConvertBGRAtoUYVY<Rgba, UseAlphaPlane>(source.Row(y), destination.Row(y), UseAlphaPlane ? alphaPlane.Row(y) : nullptr, destination.width, coefficients);
+        }
+    }
+};
+
+template <ColorMatrix Matrix, bool Rgba>
+struct NV12Encoder
+{
+    // Each pair of rows shares one row of chroma.
+    static const int RowsPerUnit = 2;
+
+    static void ConvertRows(const ImageView& source, const ImageView& /*alphaPlane*/, const ImageView& destination, int firstRow, int endRow)
+    {
+        const YUVCoefficients& coefficients = ColorMatrixTraits<Matrix>::Coefficients();
+        for (int y = firstRow; y + 1 < endRow; y += 2)
+        {
+            YUVConversion::ConvertBGRAtoNV12Rows<Rgba>(source.Row(y), source.Row(y + 1), destination.Row(y), destination.Row(y + 1), destination.ChromaRow(y / 2), destination.width, coefficients);
+        }
+    }
+};
+
+// Specializations backed by the V210Conversion SIMD kernels.
+struct V210Unpacker
+{
+    static const int RowsPerUnit = 1;
+
+    static void ConvertRows(const ImageView& source, const ImageView& /*alphaPlane*/, const ImageView& destination, int firstRow, int endRow)
+    {
+        for (int y = firstRow; y < endRow; y++)
+        {
+            V210Conversion::ConvertV210toUYVY(source.Row(y), destination.Row(y), destination.width);
+        }
+    }
+};
+
+// Rows are unpacked to 10 bit components in chunks small enough for the stack, then decoded while still in cache.
+// The color is computed from all 10 bits, so it is only rounded once, on the way to 8 bit RGB.
+template <ColorMatrix Matrix, bool Rgba>
+struct V210Decoder
+{
+    static const int RowsPerUnit = 1;
+    // A multiple of the 6 pixel v210 group.
+    static const int ChunkPixels = 768;
+
+    static void ConvertRows(const ImageView& source, const ImageView& /*alphaPlane*/, const ImageView& destination, int firstRow, int endRow)
+    {
+        uint16_t components[ChunkPixels * 2];
+        const YUVCoefficients& coefficients = ColorMatrixTraits<Matrix>::Coefficients();
+
+        for (int y = firstRow; y < endRow; y++)
+        {
+            const uint8_t* input = source.Row(y);
+            uint8_t* output = destination.Row(y);
+
+            for (int x = 0; x < destination.width; x += ChunkPixels)
+            {
+                int count = (destination.width - x < ChunkPixels) ? destination.width - x : ChunkPixels;
+                V210Conversion::UnpackV210(input + x / 6 * 16, components, count);
+                V210Conversion::ConvertUYVY10toBGRA<Rgba>(components, output + x * 4, count, coefficients);
+            }
+        }
+    }
+};
+
+template <ColorMatrix Matrix> struct PixelConverter<ImageFormat::V210, ImageFormat::UYVY, Matrix, AlphaPolicy::Opaque> : V210Unpacker {};
+template <ColorMatrix Matrix> struct PixelConverter<ImageFormat::V210, ImageFormat::BGRA, Matrix, AlphaPolicy::Opaque> : V210Decoder<Matrix, false> {};
+template <ColorMatrix Matrix> struct PixelConverter<ImageFormat::V210, ImageFormat::RGBA, Matrix, AlphaPolicy::Opaque> : V210Decoder<Matrix, true> {};
+
+template <ColorMatrix Matrix> struct PixelConverter<ImageFormat::UYVY, ImageFormat::BGRA, Matrix, AlphaPolicy::Opaque> : UYVYDecoder<Matrix, false, false> {};
+template <ColorMatrix Matrix> struct PixelConverter<ImageFormat::UYVY, ImageFormat::RGBA, Matrix, AlphaPolicy::Opaque> : UYVYDecoder<Matrix, true, false> {};
+template <ColorMatrix Matrix> struct PixelConverter<ImageFormat::UYVY, ImageFormat::BGRA, Matrix, AlphaPolicy::Separate> : UYVYDecoder<Matrix, false, true> {};
+template <ColorMatrix Matrix> struct PixelConverter<ImageFormat::UYVY, ImageFormat::RGBA, Matrix, AlphaPolicy::Separate> : UYVYDecoder<Matrix, true, true> {};
+template <ColorMatrix Matrix> struct PixelConverter<ImageFormat::BGRA, ImageFormat::UYVY, Matrix, AlphaPolicy::Opaque> : UYVYEncoder<Matrix, false, false> {};
+template <ColorMatrix Matrix> struct PixelConverter<ImageFormat::RGBA, ImageFormat::UYVY, Matrix, AlphaPolicy::Opaque> : UYVYEncoder<Matrix, true, false> {};
+template <ColorMatrix Matrix> struct PixelConverter<ImageFormat::BGRA, ImageFormat::UYVY, Matrix, AlphaPolicy::Separate> : UYVYEncoder<Matrix, false, true> {};
+template <ColorMatrix Matrix> struct PixelConverter<ImageFormat::RGBA, ImageFormat::UYVY, Matrix, AlphaPolicy::Separate> : UYVYEncoder<Matrix, true, true> {};
+template <ColorMatrix Matrix> struct PixelConverter<ImageFormat::BGRA, ImageFormat::NV12, Matrix, AlphaPolicy::Opaque> : NV12Encoder<Matrix, false> {};
+template <ColorMatrix Matrix> struct PixelConverter<ImageFormat::RGBA, ImageFormat::NV12, Matrix, AlphaPolicy::Opaque> : NV12Encoder<Matrix, true> {};
+
+class PixelConversion
+{
+public:
+    typedef void(*ConvertRowsFunction)(const ImageView& source, const ImageView& alphaPlane, const ImageView& destination, int firstRow, int endRow);
+
+    struct Entry
+    {
+        ImageFormat source;
+        ImageFormat destination;
+        ColorMatrix matrix;
+        AlphaPolicy alpha;
+        ConvertRowsFunction convertRows;
+        int rowsPerUnit;
+    };
+
+    // Convert source into destination, splitting the work into row bands on the ConversionThreadPool.
+    // Both images must have the same dimensions. alphaPlane is only used with AlphaPolicy::Separate.
+    // Converting in place is supported, otherwise the images must not overlap. A bottom-up destination view
+    // (ImageView::FlippedVertically) reorients the image in the same pass.
+    // Returns false if the combination is not registered.
+    static bool Convert(const ImageView& source, const ImageView& destination, ColorMatrix matrix = ColorMatrix::BT601Limited, AlphaPolicy alpha = AlphaPolicy::Opaque, const ImageView& alphaPlane = ImageView())
+    {
+        const Entry* entry = Find(source.format, destination.format, matrix, alpha);
+        if (entry == nullptr || (alpha == AlphaPolicy::Separate && !alphaPlane.IsValid()))
+        {
+            return false;
+        }
+
+        int rowsPerUnit = entry->rowsPerUnit;
+        int rowBytes = ((source.RowBytes() > destination.RowBytes()) ? source.RowBytes() : destination.RowBytes()) * rowsPerUnit;
+        ConversionThreadPool::Instance().ParallelFor(destination.height / rowsPerUnit, ConversionThreadPool::RowsPerBand(rowBytes), [&](int firstUnit, int endUnit)
+        {
+            entry->convertRows(source, alphaPlane, destination, firstUnit * rowsPerUnit, endUnit * rowsPerUnit);
+        });
+
+        return true;
+    }
+
+    static bool IsSupported(ImageFormat source, ImageFormat destination, ColorMatrix matrix, AlphaPolicy alpha)
+    {
+        return Find(source, destination, matrix, alpha) != nullptr;
+    }
+
+    static bool IsYUV(ImageFormat format)
+    {
+        return format == ImageFormat::UYVY || format == ImageFormat::NV12 || format == ImageFormat::V210;
+    }
+
+private:
+    template <ImageFormat Source, ImageFormat Destination, ColorMatrix Matrix, AlphaPolicy Alpha>
+    static Entry MakeEntry()
+    {
+        typedef PixelConverter<Source, Destination, Matrix, Alpha> Converter;
+
+        Entry entry;
+        entry.source = Source;
+        entry.destination = Destination;
+        entry.matrix = Matrix;
+        entry.alpha = Alpha;
+        entry.convertRows = &Converter::ConvertRows;
+        entry.rowsPerUnit = Converter::RowsPerUnit;
+        return entry;
+    }
+
+    static const Entry* Find(ImageFormat source, ImageFormat destination, ColorMatrix matrix, AlphaPolicy alpha)
+    {
+        // Every YUV conversion is registered once per color matrix.
+#define SV_YUV_ENTRIES(matrix) \
+            MakeEntry<ImageFormat::UYVY, ImageFormat::BGRA, matrix, AlphaPolicy::Opaque>(), \
+            MakeEntry<ImageFormat::UYVY, ImageFormat::RGBA, matrix, AlphaPolicy::Opaque>(), \
+            MakeEntry<ImageFormat::UYVY, ImageFormat::BGRA, matrix, AlphaPolicy::Separate>(), \
+            MakeEntry<ImageFormat::UYVY, ImageFormat::RGBA, matrix, AlphaPolicy::Separate>(), \
+            MakeEntry<ImageFormat::BGRA, ImageFormat::UYVY, matrix, AlphaPolicy::Opaque>(), \
+            MakeEntry<ImageFormat::RGBA, ImageFormat::UYVY, matrix, AlphaPolicy::Opaque>(), \
+            MakeEntry<ImageFormat::BGRA, ImageFormat::UYVY, matrix, AlphaPolicy::Separate>(), \
+            MakeEntry<ImageFormat::RGBA, ImageFormat::UYVY, matrix, AlphaPolicy::Separate>(), \
+            MakeEntry<ImageFormat::BGRA, ImageFormat::NV12, matrix, AlphaPolicy::Opaque>(), \
+            MakeEntry<ImageFormat::RGBA, ImageFormat::NV12, matrix, AlphaPolicy::Opaque>(), \
+            MakeEntry<ImageFormat::V210, ImageFormat::BGRA, matrix, AlphaPolicy::Opaque>(), \
+            MakeEntry<ImageFormat::V210, ImageFormat::RGBA, matrix, AlphaPolicy::Opaque>()
+
+        static const Entry entries[] =
+        {
+            SV_YUV_ENTRIES(ColorMatrix::BT601Limited),
+            SV_YUV_ENTRIES(ColorMatrix::BT709Limited),
+            SV_YUV_ENTRIES(ColorMatrix::BT601Full),
+            SV_YUV_ENTRIES(ColorMatrix::BT709Full),
+
+            // The color matrix does not apply to these, they match any requested matrix.
+            MakeEntry<ImageFormat::V210, ImageFormat::UYVY, ColorMatrix::BT601Limited, AlphaPolicy::Opaque>(),
+            MakeEntry<ImageFormat::BGRA, ImageFormat::RGBA, ColorMatrix::BT601Limited, AlphaPolicy::Opaque>(),
+            MakeEntry<ImageFormat::BGRA, ImageFormat::RGBA, ColorMatrix::BT601Limited, AlphaPolicy::Preserve>(),
+            MakeEntry<ImageFormat::RGBA, ImageFormat::BGRA, ColorMatrix::BT601Limited, AlphaPolicy::Opaque>(),
+            MakeEntry<ImageFormat::RGBA, ImageFormat::BGRA, ColorMatrix::BT601Limited, AlphaPolicy::Preserve>(),
+            MakeEntry<ImageFormat::RGB, ImageFormat::BGRA, ColorMatrix::BT601Limited, AlphaPolicy::Opaque>(),
+            MakeEntry<ImageFormat::RGB, ImageFormat::RGBA, ColorMatrix::BT601Limited, AlphaPolicy::Opaque>(),
+            MakeEntry<ImageFormat::BGRA, ImageFormat::BGRA, ColorMatrix::BT601Limited, AlphaPolicy::Opaque>(),
+            MakeEntry<ImageFormat::BGRA, ImageFormat::BGRA, ColorMatrix::BT601Limited, AlphaPolicy::Preserve>(),
+            MakeEntry<ImageFormat::RGBA, ImageFormat::RGBA, ColorMatrix::BT601Limited, AlphaPolicy::Opaque>(),
+            MakeEntry<ImageFormat::RGBA, ImageFormat::RGBA, ColorMatrix::BT601Limited, AlphaPolicy::Preserve>(),
+        };
+#undef SV_YUV_ENTRIES
+
+        for (const Entry& entry : entries)
+        {
+            // Only conversions between YUV and RGB depend on the color matrix.
+            bool matrixMatches = (entry.matrix == matrix) || (IsYUV(entry.source) == IsYUV(entry.destination));
+            if (entry.source == source && entry.destination == destination && entry.alpha == alpha && matrixMatches)
+            {
+                return &entry;
+            }
+        }
+
+        return nullptr;
+    }
+};
@@ -0,0 +1,310 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+// Portable recording backend that writes uncompressed video into a YUV4MPEG2 file (.y4m) and 16 bit PCM audio into a
+// WAV file next to it, so recording can run and be measured without Media Foundation. Both files play back at a
+// constant rate, so a frame is repeated to fill a gap in the video and silence fills a gap in the audio, which keeps
+// them in sync the way sample times do in an MP4. Video is stored as 4:2:0, BGRA frames go through the NV12 kernel.
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "FrameBufferPool.h"
+#include "MediaSink.h"
+#include "YUVConversion.h"
+
+class RawFileMediaSink : public IMediaSink
+{
+public:
+    // Gaps longer than this are taken as a jump in the timestamps rather than missing samples, and are not filled.
+    static const int MaximumGapSeconds = 1;
+
+    ~RawFileMediaSink()
+    {
+        Close();
+    }
+
+    virtual bool Open(const std::wstring& path, const MediaSinkFormat& recordingFormat) override
+    {
+        Close();
+
+        // 4:2:0 needs whole chroma samples.
+        if ((recordingFormat.videoFormat != ImageFormat::BGRA && recordingFormat.videoFormat != ImageFormat::NV12)
+            || recordingFormat.width <= 0 || recordingFormat.height <= 0 || (recordingFormat.width % 2) != 0 || (recordingFormat.height % 2) != 0
+            || recordingFormat.fps == 0)
+        {
+            return false;
+        }
+
+        if (recordingFormat.encodeAudio && (recordingFormat.audioChannels == 0 || recordingFormat.audioSampleRate == 0))
+        {
+            return false;
+        }
+
+        format = recordingFormat;
+        videoFile = OpenFile(ReplaceExtension(path, L".y4m"));
+        if (videoFile == nullptr)
+        {
+            return false;
+        }
+
+        // Limited range BT.601, like the NV12 kernel and the Media Foundation encoder.
+        fprintf(videoFile, "YUV4MPEG2 W%d H%d F%u:1 Ip A1:1 C420jpeg XCOLORRANGE=LIMITED\n", format.width, format.height, format.fps);
+
+        if (format.encodeAudio)
+        {
+            audioFile = OpenFile(ReplaceExtension(path, L".wav"));
+            if (audioFile == nullptr)
+            {
+                Close();
+                return false;
+            }
+
+            // The sizes are filled in on Close.
+            WriteWaveHeader(0);
+        }
+
+        int chromaSize = (format.width / 2) * (format.height / 2);
+        lumaPlane.resize((format.videoFormat == ImageFormat::BGRA) ? (size_t)format.width * format.height : 0);
+        chromaRow.resize(format.width);
+        bluePlane.resize(chromaSize);
+        redPlane.resize(chromaSize);
+
+        nextFrameIndex = 0;
+        nextAudioSample = 0;
+        framesWritten = 0;
+        audioBytesWritten = 0;
+        return true;
+    }
+
+    virtual void Close() override
+    {
+        if (videoFile != nullptr)
+        {
+            fclose(videoFile);
+            videoFile = nullptr;
+        }
+
+        if (audioFile != nullptr)
+        {
+            fseek(audioFile, 0, SEEK_SET);
+            WriteWaveHeader(audioBytesWritten);
+            fclose(audioFile);
+            audioFile = nullptr;
+        }
+    }
+
+    virtual bool AcquireVideoBuffer(MediaSinkBuffer* buffer) override
+    {
+        return AcquireBuffer(format.VideoBufferSize(), buffer);
+    }
+
+    virtual bool AcquireAudioBuffer(int size, MediaSinkBuffer* buffer) override
+    {
+        return AcquireBuffer(size, buffer);
+    }
+
+    virtual void ReleaseBuffer(MediaSinkBuffer* buffer) override
+    {
+        FrameBufferPool::Instance().Release(buffer->data);
+        buffer->data = nullptr;
+    }
+
+    virtual bool WriteVideo(MediaSinkBuffer* buffer, int64_t sampleTime, int64_t /*duration*/) override
+    {
+        // The frame slot this sample starts in. A frame that lands in the slot of the last one is left out.
+        int64_t frameIndex = (sampleTime * format.fps + MEDIA_TICKS_PER_SECOND / 2) / MEDIA_TICKS_PER_SECOND;
+        if (videoFile == nullptr || frameIndex < nextFrameIndex)
+        {
+            ReleaseBuffer(buffer);
+            return false;
+        }
+
+        int64_t copies = frameIndex - nextFrameIndex + 1;
+        if (copies > (int64_t)MaximumGapSeconds * format.fps)
+        {
+            copies = 1;
+        }
+
+        const uint8_t* luma = SplitPlanes(buffer->data);
+        int lumaStride = (format.videoFormat == ImageFormat::BGRA) ? format.width : format.stride;
+
+        bool written = true;
+        for (int64_t copy = 0; copy < copies && written; copy++)
+        {
+            written = fwrite("FRAME\n", 1, 6, videoFile) == 6;
+            for (int y = 0; y < format.height && written; y++)
+            {
+                written = fwrite(luma + (size_t)y * lumaStride, 1, format.width, videoFile) == (size_t)format.width;
+            }
+
+            written = written
+                && fwrite(bluePlane.data(), 1, bluePlane.size(), videoFile) == bluePlane.size()
+                && fwrite(redPlane.data(), 1, redPlane.size(), videoFile) == redPlane.size();
+
+            framesWritten += written ? 1 : 0;
+        }
+
+        nextFrameIndex = frameIndex + 1;
+        ReleaseBuffer(buffer);
+        return written;
+    }
+
+    virtual bool WriteAudio(MediaSinkBuffer* buffer, int64_t sampleTime, int64_t /*duration*/) override
+    {
+        if (audioFile == nullptr)
+        {
+            ReleaseBuffer(buffer);
+            return false;
+        }
+
+        int blockAlign = 2 * format.audioChannels;
+        int64_t firstSample = sampleTime * format.audioSampleRate / MEDIA_TICKS_PER_SECOND;
+        int64_t gap = firstSample - nextAudioSample;
+
+        bool written = true;
+        if (gap > 0 && gap <= (int64_t)MaximumGapSeconds * format.audioSampleRate)
+        {
+            std::vector<uint8_t> silence((size_t)gap * blockAlign, 0);
+            written = fwrite(silence.data(), 1, silence.size(), audioFile) == silence.size();
+            audioBytesWritten += written ? (int64_t)silence.size() : 0;
+        }
+
+        // Audio that overlaps the last buffer is still written, rather than cutting words short.
+        written = written && fwrite(buffer->data, 1, buffer->size, audioFile) == (size_t)buffer->size;
+        audioBytesWritten += written ? buffer->size : 0;
+        nextAudioSample = (std::max)(firstSample, nextAudioSample) + buffer->size / blockAlign;
+
+        ReleaseBuffer(buffer);
+        return written;
+    }
+
+    // Frames in the video file, counting repeats, and bytes of audio in the WAV file.
+    int64_t GetFramesWritten() const
+    {
+        return framesWritten;
+    }
+
+    int64_t GetAudioBytesWritten() const
+    {
+        return audioBytesWritten;
+    }
+
+private:
+    static bool AcquireBuffer(int size, MediaSinkBuffer* buffer)
+    {
+        buffer->data = FrameBufferPool::Instance().Acquire(size);
+        buffer->size = size;
+        buffer->sinkData = nullptr;
+        return buffer->data != nullptr;
+    }
+
+    static std::wstring ReplaceExtension(const std::wstring& path, const wchar_t* extension)
+    {
+        size_t separator = path.find_last_of(L"/\\");
+        size_t dot = path.find_last_of(L'.');
+        if (dot == std::wstring::npos || (separator != std::wstring::npos && dot < separator))
+        {
+            return path + extension;
+        }
+
+        return path.substr(0, dot) + extension;
+    }
+
+    static FILE* OpenFile(const std::wstring& path)
+    {
+#if defined(_WIN32)
+        FILE* file = nullptr;
+        return (_wfopen_s(&file, path.c_str(), L"wb") == 0) ? file : nullptr;
+#else
+        std::string narrowPath(path.size() * 4 + 1, '\0');
+        size_t length = wcstombs(&narrowPath[0], path.c_str(), narrowPath.size());
+        if (length == (size_t)-1)
+        {
+            return nullptr;
+        }
+
+        narrowPath.resize(length);
+        return fopen(narrowPath.c_str(), "wb");
+#endif
+    }
+
+    // Split the chroma of a frame into the U and V planes, converting BGRA to YUV first. Returns the luma plane.
+    const uint8_t* SplitPlanes(const uint8_t* frame)
+    {
+        int chromaWidth = format.width / 2;
+        const uint8_t* luma = frame;
+        const uint8_t* chroma = frame + (size_t)format.stride * format.height;
+
+        for (int y = 0; y < format.height / 2; y++)
+        {
+            const uint8_t* chromaPairs = chroma + (size_t)y * format.stride;
+            if (format.videoFormat == ImageFormat::BGRA)
+            {
+                const uint8_t* row0 = frame + (size_t)(2 * y) * format.stride;
+                uint8_t* luma0 = &lumaPlane[(size_t)(2 * y) * format.width];
+                YUVConversion::ConvertBGRAtoNV12Rows(row0, row0 + format.stride, luma0, luma0 + format.width, chromaRow.data(), format.width);
+                chromaPairs = chromaRow.data();
+            }
+
+            uint8_t* blue = &bluePlane[(size_t)y * chromaWidth];
+            uint8_t* red = &redPlane[(size_t)y * chromaWidth];
+            for (int x = 0; x < chromaWidth; x++)
+            {
+                blue[x] = chromaPairs[2 * x];
+                red[x] = chromaPairs[2 * x + 1];
+            }
+        }
+
+        return (format.videoFormat == ImageFormat::BGRA) ? lumaPlane.data() : luma;
+    }
+
+    void WriteWaveHeader(int64_t dataBytes)
+    {
+        uint32_t blockAlign = 2 * format.audioChannels;
+        uint8_t header[44];
+        uint8_t* next = header;
+        auto put = [&](uint32_t value, int bytes)
+        {
+            for (int i = 0; i < bytes; i++)
+            {
+                *next++ = (uint8_t)(value >> (8 * i));
+            }
+        };
+
+        memcpy(next, "RIFF", 4); next += 4;
+        put((uint32_t)(36 + dataBytes), 4);
+        memcpy(next, "WAVEfmt ", 8); next += 8;
+        put(16, 4);
+        put(1, 2);
+        put(format.audioChannels, 2);
+        put(format.audioSampleRate, 4);
+        put(format.audioSampleRate * blockAlign, 4);
+        put(blockAlign, 2);
+        put(16, 2);
+        memcpy(next, "data", 4); next += 4;
+        put((uint32_t)dataBytes, 4);
+
+        fwrite(header, 1, sizeof(header), audioFile);
+    }
+
+    MediaSinkFormat format = {};
+    FILE* videoFile = nullptr;
+    FILE* audioFile = nullptr;
+
+    // Encoder thread only.
+    std::vector<uint8_t> lumaPlane;
+    std::vector<uint8_t> chromaRow;
+    std::vector<uint8_t> bluePlane;
+    std::vector<uint8_t> redPlane;
+    int64_t nextFrameIndex = 0;
+    int64_t nextAudioSample = 0;
+    int64_t framesWritten = 0;
+    int64_t audioBytesWritten = 0;
+};
@@ -0,0 +1,573 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+// Separable CPU resampler for BGRA, RGBA, Alpha8, UYVY and NV12 images, so later stages can work on smaller frames.
+// Each destination row is first filtered vertically into a row buffer, then horizontally into the destination.
+// Filter weights are 14 bit fixed point, computed once per (source size, destination size, filter) and cached.
+// Every SIMD kernel produces output that is bit-identical to the _Scalar reference.
+
+#pragma once
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
+#include "ConversionThreadPool.h"
+#include "CpuFeatures.h"
+#include "ImageView.h"
+
+enum class ResampleFilter
+{
+    // Average of the source pixels each destination pixel covers. Best for downscaling, bilinear when upscaling.
+    Area,
+    // Triangle filter, widened by the scale factor when downscaling so no source pixel is skipped.
+    Bilinear,
+    // Windowed sinc with three lobes, widened by the scale factor when downscaling. Sharpest, and the slowest.
+    Lanczos3
+};
+
+// Taps for every destination sample along one axis. Every sample uses the same number of taps, and its window
+// always lies inside the source, so the kernels never clamp indices.
+struct ResampleWeights
+{
+    static const int WeightBits = 14;
+
+    int taps = 0;
+    // Index of the first source sample for each destination sample.
+    std::vector<int> first;
+    // taps weights for each destination sample, each set sums to exactly 1 << WeightBits.
+    std::vector<int16_t> weights;
+
+    int DestinationSize() const
+    {
+        return (int)first.size();
+    }
+};
+
+class Resampling
+{
+public:
+    // Resample source into destination, both in the same format. Returns false if the format is not supported
+    // or the images are empty. UYVY widths and NV12 sizes must be even. The images must not overlap.
+    // level selects the kernels, it may be lowered to compare instruction sets but never raised above GetSimdLevel.
+    static bool Resample(const ImageView& source, const ImageView& destination, ResampleFilter filter = ResampleFilter::Area, SimdLevel level = CpuFeatures::GetSimdLevel())
+    {
+        if (!source.IsValid() || !destination.IsValid() || source.format != destination.format)
+        {
+            return false;
+        }
+
+        const SampleGrid rgba[] = { { 4, 4, 0, false } };
+        const SampleGrid alpha[] = { { 1, 1, 0, false } };
+        const SampleGrid uyvy[] = { { 1, 2, 1, false }, { 1, 4, 0, true }, { 1, 4, 2, true } };
+        const SampleGrid chroma[] = { { 2, 2, 0, false } };
+
+        switch (source.format)
+        {
+        case ImageFormat::BGRA:
+        case ImageFormat::RGBA:
+            ResamplePlane(source, destination, source.RowBytes(), destination.RowBytes(), rgba, 1, filter, level);
+            return true;
+        case ImageFormat::Alpha8:
+            ResamplePlane(source, destination, source.RowBytes(), destination.RowBytes(), alpha, 1, filter, level);
+            return true;
+        case ImageFormat::UYVY:
+            if ((source.width | destination.width) & 1)
+            {
+                return false;
+            }
+
+            ResamplePlane(source, destination, source.RowBytes(), destination.RowBytes(), uyvy, 3, filter, level);
+            return true;
+        case ImageFormat::NV12:
+        {
+            if ((source.width | source.height | destination.width | destination.height) & 1)
+            {
+                return false;
+            }
+
+            // The luma plane, then the interleaved UV plane at half resolution in both directions.
+            ResamplePlane(source, destination, source.width, destination.width, alpha, 1, filter, level);
+            ImageView sourceChroma(source.ChromaRow(0), source.width / 2, source.height / 2, ImageFormat::NV12, source.pitch);
+            ImageView destinationChroma(destination.ChromaRow(0), destination.width / 2, destination.height / 2, ImageFormat::NV12, destination.pitch);
+            ResamplePlane(sourceChroma, destinationChroma, source.width, destination.width, chroma, 1, filter, level);
+            return true;
+        }
+        default:
+            return false;
+        }
+    }
+
+    // Cached weights for resampling sourceSize samples to destinationSize samples.
+    static std::shared_ptr<const ResampleWeights> GetWeights(int sourceSize, int destinationSize, ResampleFilter filter)
+    {
+        // A compositor only ever uses a handful of size pairs, the limit only guards against unbounded growth.
+        static const size_t MaxCachedWeights = 64;
+        static std::mutex lock;
+        static std::map<std::tuple<int, int, int>, std::shared_ptr<const ResampleWeights>> cache;
+
+        std::tuple<int, int, int> key(sourceSize, destinationSize, (int)filter);
+
+        std::lock_guard<std::mutex> guard(lock);
+        auto cached = cache.find(key);
+        if (cached != cache.end())
+        {
+            return cached->second;
+        }
+
+        if (cache.size() >= MaxCachedWeights)
+        {
+            cache.clear();
+        }
+
+        std::shared_ptr<const ResampleWeights> weights = ComputeWeights(sourceSize, destinationSize, filter);
+        cache[key] = weights;
+        return weights;
+    }
+
+    static inline uint8_t Round(int sum)
+    {
+        sum = (sum + (1 << (ResampleWeights::WeightBits - 1))) >> ResampleWeights::WeightBits;
+        return (uint8_t)(sum < 0 ? 0 : (sum > 255 ? 255 : sum));
+    }
+
+    // Weighted sum of taps rows, starting at firstRow, for byteCount bytes.
+    // Every byte is filtered alone, so this works for any interleaved format.
+    static void VerticalRow_Scalar(const uint8_t* firstRow, ptrdiff_t pitch, const int16_t* weights, int taps, uint8_t* output, int byteCount)
+    {
+        for (int x = 0; x < byteCount; x++)
+        {
+            int sum = 0;
+            for (int k = 0; k < taps; k++)
+            {
+                sum += weights[k] * firstRow[k * pitch + x];
+            }
+
+            output[x] = Round(sum);
+        }
+    }
+
+    // Filter one grid of a row: sample i of channel c is at input[i * step + c], the same layout is written to output.
+    static void HorizontalRow_Scalar(const uint8_t* input, uint8_t* output, const ResampleWeights& weights, int channels, int step)
+    {
+        int taps = weights.taps;
+        for (int i = 0; i < weights.DestinationSize(); i++)
+        {
+            const uint8_t* samples = input + weights.first[i] * step;
+            const int16_t* w = &weights.weights[i * taps];
+            for (int c = 0; c < channels; c++)
+            {
+                int sum = 0;
+                for (int k = 0; k < taps; k++)
+                {
+                    sum += w[k] * samples[k * step + c];
+                }
+
+                output[i * step + c] = Round(sum);
+            }
+        }
+    }
+
+#if defined(SV_SIMD_X86)
+    // 16 bytes per iteration. Two rows at a time are interleaved into 16 bit pairs, so madd applies both weights at once.
+    SV_TARGET_SSE41 static void VerticalRow_SSE41(const uint8_t* firstRow, ptrdiff_t pitch, const int16_t* weights, int taps, uint8_t* output, int byteCount)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i rounding = _mm_set1_epi32(1 << (ResampleWeights::WeightBits - 1));
+
+        int x = 0;
+        for (; x + 16 <= byteCount; x += 16)
+        {
+            __m128i sum0 = rounding;
+            __m128i sum1 = rounding;
+            __m128i sum2 = rounding;
+            __m128i sum3 = rounding;
+
+            for (int k = 0; k < taps; k += 2)
+            {
+                __m128i a = _mm_loadu_si128((const __m128i*)(firstRow + k * pitch + x));
+                // An odd last tap pairs its row with itself at weight 0.
+                bool pair = (k + 1 < taps);
+                __m128i b = pair ? _mm_loadu_si128((const __m128i*)(firstRow + (k + 1) * pitch + x)) : a;
+                __m128i w = WeightPair(weights[k], pair ? weights[k + 1] : 0);
+
+                __m128i low = _mm_unpacklo_epi8(a, b);
+                __m128i high = _mm_unpackhi_epi8(a, b);
+                sum0 = _mm_add_epi32(sum0, _mm_madd_epi16(_mm_unpacklo_epi8(low, zero), w));
+                sum1 = _mm_add_epi32(sum1, _mm_madd_epi16(_mm_unpackhi_epi8(low, zero), w));
+                sum2 = _mm_add_epi32(sum2, _mm_madd_epi16(_mm_unpacklo_epi8(high, zero), w));
+                sum3 = _mm_add_epi32(sum3, _mm_madd_epi16(_mm_unpackhi_epi8(high, zero), w));
+            }
+
+            __m128i result = _mm_packus_epi16(
+                _mm_packs_epi32(_mm_srai_epi32(sum0, ResampleWeights::WeightBits), _mm_srai_epi32(sum1, ResampleWeights::WeightBits)),
+                _mm_packs_epi32(_mm_srai_epi32(sum2, ResampleWeights::WeightBits), _mm_srai_epi32(sum3, ResampleWeights::WeightBits)));
+            _mm_storeu_si128((__m128i*)(output + x), result);
+        }
+
+        VerticalRow_Scalar(firstRow + x, pitch, weights, taps, output + x, byteCount - x);
+    }
+
+    // Four channel pixels, two taps per iteration. Each channel of the two pixels is paired for madd.
+    // Other layouts are left to the scalar kernel.
+    SV_TARGET_SSE41 static void HorizontalRow_SSE41(const uint8_t* input, uint8_t* output, const ResampleWeights& weights, int channels, int step)
+    {
+        if (channels != 4 || step != 4)
+        {
+            HorizontalRow_Scalar(input, output, weights, channels, step);
+            return;
+        }
+
+        const __m128i pairChannels = _mm_setr_epi8(0, 4, 1, 5, 2, 6, 3, 7, -1, -1, -1, -1, -1, -1, -1, -1);
+        const __m128i rounding = _mm_set1_epi32(1 << (ResampleWeights::WeightBits - 1));
+        int taps = weights.taps;
+
+        for (int i = 0; i < weights.DestinationSize(); i++)
+        {
+            const uint8_t* pixels = input + weights.first[i] * 4;
+            const int16_t* w = &weights.weights[i * taps];
+            __m128i sum = rounding;
+
+            int k = 0;
+            for (; k + 2 <= taps; k += 2)
+            {
+                __m128i two = _mm_shuffle_epi8(_mm_loadl_epi64((const __m128i*)(pixels + k * 4)), pairChannels);
+                sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_cvtepu8_epi16(two), WeightPair(w[k], w[k + 1])));
+            }
+
+            if (k < taps)
+            {
+                // Only 4 bytes are left in the window, loading 8 could read past the end of the row.
+                __m128i one = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(ReadPixel(pixels + k * 4)));
+                sum = _mm_add_epi32(sum, _mm_mullo_epi32(one, _mm_set1_epi32(w[k])));
+            }
+
+            __m128i result = _mm_srai_epi32(sum, ResampleWeights::WeightBits);
+            result = _mm_packus_epi16(_mm_packs_epi32(result, result), result);
+            WritePixel(output + i * 4, _mm_cvtsi128_si32(result));
+        }
+    }
+
+    // 32 bytes per iteration. Unpacking and packing both stay inside each 128 bit lane, so byte order is kept.
+    SV_TARGET_AVX2 static void VerticalRow_AVX2(const uint8_t* firstRow, ptrdiff_t pitch, const int16_t* weights, int taps, uint8_t* output, int byteCount)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i rounding = _mm256_set1_epi32(1 << (ResampleWeights::WeightBits - 1));
+
+        int x = 0;
+        for (; x + 32 <= byteCount; x += 32)
+        {
+            __m256i sum0 = rounding;
+            __m256i sum1 = rounding;
+            __m256i sum2 = rounding;
+            __m256i sum3 = rounding;
+
+            for (int k = 0; k < taps; k += 2)
+            {
+                __m256i a = _mm256_loadu_si256((const __m256i*)(firstRow + k * pitch + x));
+                bool pair = (k + 1 < taps);
+                __m256i b = pair ? _mm256_loadu_si256((const __m256i*)(firstRow + (k + 1) * pitch + x)) : a;
+                __m256i w = _mm256_set1_epi32((int)(((uint32_t)(uint16_t)(pair ? weights[k + 1] : 0) << 16) | (uint16_t)weights[k]));
+
+                __m256i low = _mm256_unpacklo_epi8(a, b);
+                __m256i high = _mm256_unpackhi_epi8(a, b);
+                sum0 = _mm256_add_epi32(sum0, _mm256_madd_epi16(_mm256_unpacklo_epi8(low, zero), w));
+                sum1 = _mm256_add_epi32(sum1, _mm256_madd_epi16(_mm256_unpackhi_epi8(low, zero), w));
+                sum2 = _mm256_add_epi32(sum2, _mm256_madd_epi16(_mm256_unpacklo_epi8(high, zero), w));
+                sum3 = _mm256_add_epi32(sum3, _mm256_madd_epi16(_mm256_unpackhi_epi8(high, zero), w));
+            }
+
+            __m256i result = _mm256_packus_epi16(
+                _mm256_packs_epi32(_mm256_srai_epi32(sum0, ResampleWeights::WeightBits), _mm256_srai_epi32(sum1, ResampleWeights::WeightBits)),
+                _mm256_packs_epi32(_mm256_srai_epi32(sum2, ResampleWeights::WeightBits), _mm256_srai_epi32(sum3, ResampleWeights::WeightBits)));
+            _mm256_storeu_si256((__m256i*)(output + x), result);
+        }
+
+        VerticalRow_SSE41(firstRow + x, pitch, weights, taps, output + x, byteCount - x);
+    }
+
+    // A four channel pixel pair already fills the SSE registers, so the horizontal pass has no wider form.
+    SV_TARGET_AVX2 static void HorizontalRow_AVX2(const uint8_t* input, uint8_t* output, const ResampleWeights& weights, int channels, int step)
+    {
+        HorizontalRow_SSE41(input, output, weights, channels, step);
+    }
+#endif
+
+#if defined(SV_SIMD_NEON)
+    // 8 bytes per iteration, one widening multiply-accumulate per tap.
+    static void VerticalRow_NEON(const uint8_t* firstRow, ptrdiff_t pitch, const int16_t* weights, int taps, uint8_t* output, int byteCount)
+    {
+        const int32x4_t rounding = vdupq_n_s32(1 << (ResampleWeights::WeightBits - 1));
+
+        int x = 0;
+        for (; x + 8 <= byteCount; x += 8)
+        {
+            int32x4_t low = rounding;
+            int32x4_t high = rounding;
+            for (int k = 0; k < taps; k++)
+            {
+                int16x8_t row = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(firstRow + k * pitch + x)));
+                low = vmlal_n_s16(low, vget_low_s16(row), weights[k]);
+                high = vmlal_n_s16(high, vget_high_s16(row), weights[k]);
+            }
+
+            int16x8_t result = vcombine_s16(vqmovn_s32(vshrq_n_s32(low, ResampleWeights::WeightBits)), vqmovn_s32(vshrq_n_s32(high, ResampleWeights::WeightBits)));
+            vst1_u8(output + x, vqmovun_s16(result));
+        }
+
+        VerticalRow_Scalar(firstRow + x, pitch, weights, taps, output + x, byteCount - x);
+    }
+
+    // Four channel pixels, one tap per iteration. Other layouts are left to the scalar kernel.
+    static void HorizontalRow_NEON(const uint8_t* input, uint8_t* output, const ResampleWeights& weights, int channels, int step)
+    {
+        if (channels != 4 || step != 4)
+        {
+            HorizontalRow_Scalar(input, output, weights, channels, step);
+            return;
+        }
+
+        const int32x4_t rounding = vdupq_n_s32(1 << (ResampleWeights::WeightBits - 1));
+        int taps = weights.taps;
+
+        for (int i = 0; i < weights.DestinationSize(); i++)
+        {
+            const uint8_t* pixels = input + weights.first[i] * 4;
+            const int16_t* w = &weights.weights[i * taps];
+            int32x4_t sum = rounding;
+
+            for (int k = 0; k < taps; k++)
+            {
+                uint8x8_t pixel = vreinterpret_u8_u32(vld1_dup_u32((const uint32_t*)(pixels + k * 4)));
+                sum = vmlal_n_s16(sum, vget_low_s16(vreinterpretq_s16_u16(vmovl_u8(pixel))), w[k]);
+            }
+
+            int16x4_t narrow = vqmovn_s32(vshrq_n_s32(sum, ResampleWeights::WeightBits));
+            uint8x8_t result = vqmovun_s16(vcombine_s16(narrow, narrow));
+            vst1_lane_u32((uint32_t*)(output + i * 4), vreinterpret_u32_u8(result), 0);
+        }
+    }
+#endif
+
+private:
+    // One set of interleaved samples within a row: sample i of channel c is at row[offset + i * step + c].
+    // Half width grids hold chroma, which has one sample for every two pixels.
+    struct SampleGrid
+    {
+        int channels;
+        int step;
+        int offset;
+        bool halfWidth;
+    };
+
+    typedef void(*VerticalRowFunction)(const uint8_t* firstRow, ptrdiff_t pitch, const int16_t* weights, int taps, uint8_t* output, int byteCount);
+    typedef void(*HorizontalRowFunction)(const uint8_t* input, uint8_t* output, const ResampleWeights& weights, int channels, int step);
+
+    static void ResamplePlane(const ImageView& source, const ImageView& destination, int sourceRowBytes, int destinationRowBytes,
+        const SampleGrid* grids, int gridCount, ResampleFilter filter, SimdLevel level)
+    {
+        VerticalRowFunction verticalRow = &VerticalRow_Scalar;
+        HorizontalRowFunction horizontalRow = &HorizontalRow_Scalar;
+        switch (level)
+        {
+#if defined(SV_SIMD_X86)
+        case SimdLevel::AVX2:
+            verticalRow = &VerticalRow_AVX2;
+            horizontalRow = &HorizontalRow_AVX2;
+            break;
+        case SimdLevel::SSE41:
+            verticalRow = &VerticalRow_SSE41;
+            horizontalRow = &HorizontalRow_SSE41;
+            break;
+#elif defined(SV_SIMD_NEON)
+        case SimdLevel::NEON:
+            verticalRow = &VerticalRow_NEON;
+            horizontalRow = &HorizontalRow_NEON;
+            break;
+#endif
+        default:
+            break;
+        }
+
+        bool resizeVertically = (source.height != destination.height);
+        bool resizeHorizontally = (source.width != destination.width);
+
+        std::shared_ptr<const ResampleWeights> vertical = GetWeights(source.height, destination.height, filter);
+        std::shared_ptr<const ResampleWeights> horizontal = GetWeights(source.width, destination.width, filter);
+        std::shared_ptr<const ResampleWeights> horizontalHalf = horizontal;
+        for (int g = 0; g < gridCount; g++)
+        {
+            if (grids[g].halfWidth)
+            {
+                horizontalHalf = GetWeights(source.width / 2, destination.width / 2, filter);
+            }
+        }
+
+        int rowsPerBand = ConversionThreadPool::RowsPerBand(sourceRowBytes * (resizeVertically ? vertical->taps : 1));
+        ConversionThreadPool::Instance().ParallelFor(destination.height, rowsPerBand, [&](int firstRow, int endRow)
+        {
+            static thread_local std::vector<uint8_t> rowBuffer;
+            if (rowBuffer.size() < (size_t)sourceRowBytes)
+            {
+                rowBuffer.resize(sourceRowBytes);
+            }
+
+            for (int y = firstRow; y < endRow; y++)
+            {
+                const uint8_t* row = source.Row(y);
+                if (resizeVertically)
+                {
+                    verticalRow(source.Row(vertical->first[y]), source.pitch, &vertical->weights[y * vertical->taps], vertical->taps, rowBuffer.data(), sourceRowBytes);
+                    row = rowBuffer.data();
+                }
+
+                if (!resizeHorizontally)
+                {
+                    memcpy(destination.Row(y), row, destinationRowBytes);
+                    continue;
+                }
+
+                for (int g = 0; g < gridCount; g++)
+                {
+                    const SampleGrid& grid = grids[g];
+                    horizontalRow(row + grid.offset, destination.Row(y) + grid.offset, grid.halfWidth ? *horizontalHalf : *horizontal, grid.channels, grid.step);
+                }
+            }
+        });
+    }
+
+    static double FilterSupport(ResampleFilter filter)
+    {
+        switch (filter)
+        {
+        case ResampleFilter::Lanczos3:
+            return 3.0;
+        case ResampleFilter::Bilinear:
+            return 1.0;
+        default:
+            return 0.5;
+        }
+    }
+
+    static double Sinc(double x)
+    {
+        const double pi = 3.14159265358979323846;
+        if (x == 0.0)
+        {
+            return 1.0;
+        }
+
+        x *= pi;
+        return sin(x) / x;
+    }
+
+    static std::shared_ptr<const ResampleWeights> ComputeWeights(int sourceSize, int destinationSize, ResampleFilter filter)
+    {
+        double scale = (double)sourceSize / destinationSize;
+        double filterScale = (scale > 1.0) ? scale : 1.0;
+        double support = FilterSupport(filter) * filterScale;
+
+        std::vector<int> windowStart(destinationSize);
+        std::vector<std::vector<double>> windowWeights(destinationSize);
+        int taps = 1;
+
+        for (int i = 0; i < destinationSize; i++)
+        {
+            double center = (i + 0.5) * scale;
+            int start = (std::max)(0, (int)floor(center - support));
+            int end = (std::min)(sourceSize, (int)ceil(center + support));
+
+            std::vector<double>& w = windowWeights[i];
+            double total = 0.0;
+            for (int j = start; j < end; j++)
+            {
+                double value;
+                if (filter == ResampleFilter::Area)
+                {
+                    // Coverage of source pixel [j, j + 1) by the footprint of the destination pixel.
+                    double overlap = (std::min)(j + 1.0, center + support) - (std::max)((double)j, center - support);
+                    value = (overlap > 0.0) ? overlap : 0.0;
+                }
+                else
+                {
+                    double x = (j + 0.5 - center) / filterScale;
+                    value = (filter == ResampleFilter::Bilinear) ? (std::max)(0.0, 1.0 - fabs(x)) : (fabs(x) < 3.0 ? Sinc(x) * Sinc(x / 3.0) : 0.0);
+                }
+
+                w.push_back(value);
+                total += value;
+            }
+
+            if (total == 0.0)
+            {
+                // Only possible for a window of a single, zero weighted sample.
+                w.assign(1, 1.0);
+                total = 1.0;
+            }
+
+            for (double& value : w)
+            {
+                value /= total;
+            }
+
+            windowStart[i] = start;
+            taps = (std::max)(taps, (int)w.size());
+        }
+
+        std::shared_ptr<ResampleWeights> weights = std::make_shared<ResampleWeights>();
+        weights->taps = taps;
+        weights->first.resize(destinationSize);
+        weights->weights.assign((size_t)destinationSize * taps, 0);
+
+        const int one = 1 << ResampleWeights::WeightBits;
+        for (int i = 0; i < destinationSize; i++)
+        {
+            // Move the window left where needed so every tap stays inside the source.
+            int first = (std::max)(0, (std::min)(windowStart[i], sourceSize - taps));
+            int16_t* w = &weights->weights[(size_t)i * taps];
+
+            int sum = 0;
+            int largest = 0;
+            for (size_t j = 0; j < windowWeights[i].size(); j++)
+            {
+                int k = windowStart[i] - first + (int)j;
+                w[k] = (int16_t)floor(windowWeights[i][j] * one + 0.5);
+                sum += w[k];
+                if (w[k] > w[largest])
+                {
+                    largest = k;
+                }
+            }
+
+            // Rounding error goes to the largest tap, so flat areas keep their exact value.
+            w[largest] = (int16_t)(w[largest] + one - sum);
+            weights->first[i] = first;
+        }
+
+        return weights;
+    }
+
+#if defined(SV_SIMD_X86)
+    SV_TARGET_SSE41 static inline __m128i WeightPair(int16_t first, int16_t second)
+    {
+        return _mm_set1_epi32((int)(((uint32_t)(uint16_t)second << 16) | (uint16_t)first));
+    }
+#endif
+
+    static inline int ReadPixel(const uint8_t* pixel)
+    {
+        int value;
+        memcpy(&value, pixel, sizeof(value));
+        return value;
+    }
+
+    static inline void WritePixel(uint8_t* pixel, int value)
+    {
+        memcpy(pixel, &value, sizeof(value));
+    }
+};
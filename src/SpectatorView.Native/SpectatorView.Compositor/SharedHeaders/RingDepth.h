@@ -0,0 +1,97 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+// Chooses how many frames a capture provider keeps in its FrameRing.
+// The compositor renders a frame some way behind the newest captured one, and only needs history back to that frame.
+// The expected lag follows the latency preference, the same way the Unity compositor steps its composite frame, and
+// the lag the render thread actually observes grows the depth right away. The depth only shrinks once the lag has
+// stayed well below it for a long while, so neither a short stall nor lag that spikes now and then makes the ring resize
+// over and over.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+class RingDepthController
+{
+public:
+    // Keep room for the frame being written, the one being read, and a frame of jitter.
+    static const int MinimumDepth = 4;
+    static const int Headroom = 2;
+    // Lag behind the newest frame the compositor aims for at the lowest and highest latency preference.
+    static const int LowLatencyLag = 2;
+    static const int DefaultLag = 8;
+    // About thirty seconds of capture at 30 fps, longer than the gaps between the stalls of a jittery source.
+    static const int ShrinkDelayFrames = 900;
+    // Frames the depth must be able to drop by before it shrinks at all.
+    static const int ShrinkHysteresis = 2;
+
+    RingDepthController(int maximumDepth) :
+        maximumDepth(maximumDepth),
+        depth(maximumDepth)
+    {
+        SetLatencyPreference(1.0f);
+    }
+
+    // Between 0 for the lowest latency and 1 for the most stable output.
+    void SetLatencyPreference(float latencyPreference)
+    {
+        latencyPreference = (latencyPreference < 0.0f) ? 0.0f : ((latencyPreference > 1.0f) ? 1.0f : latencyPreference);
+        int expectedLag = (int)std::lround(LowLatencyLag + latencyPreference * (DefaultLag - LowLatencyLag));
+        preferredDepth.store(expectedLag + Headroom, std::memory_order_relaxed);
+    }
+
+    // Render thread: report how far the composited frame trails the newest captured frame.
+    void ObserveLag(int latestFrameIndex, int compositeFrameIndex)
+    {
+        int lag = latestFrameIndex - compositeFrameIndex;
+        if (lag < 0 || compositeFrameIndex <= 0)
+        {
+            return;
+        }
+
+        int observed = observedLag.load(std::memory_order_relaxed);
+        while (observed < lag && !observedLag.compare_exchange_weak(observed, lag, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    // Capture thread: call once per captured frame, before writing it, and resize the ring to the result.
+    int Update()
+    {
+        int lag = observedLag.load(std::memory_order_relaxed);
+        int desiredDepth = (std::max)(preferredDepth.load(std::memory_order_relaxed), lag + Headroom);
+        desiredDepth = (desiredDepth < MinimumDepth) ? MinimumDepth : ((desiredDepth > maximumDepth) ? maximumDepth : desiredDepth);
+
+        if (desiredDepth > depth)
+        {
+            depth = desiredDepth;
+            framesSinceChange = 0;
+        }
+        else if (++framesSinceChange >= ShrinkDelayFrames)
+        {
+            // Start a new window of observed lag, the depth follows the largest lag seen in the last one if that frees
+            // enough frames to be worth a resize.
+            if (desiredDepth <= depth - ShrinkHysteresis)
+            {
+                depth = desiredDepth;
+            }
+
+            framesSinceChange = 0;
+            observedLag.store(0, std::memory_order_relaxed);
+        }
+
+        return depth;
+    }
+
+private:
+    const int maximumDepth;
+    std::atomic<int> preferredDepth { MinimumDepth };
+    std::atomic<int> observedLag { 0 };
+
+    // Only touched by the capture thread.
+    int depth;
+    int framesSinceChange = 0;
+};
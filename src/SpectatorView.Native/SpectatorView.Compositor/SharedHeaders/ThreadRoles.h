@@ -0,0 +1,237 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+// Scheduling for the threads that capture, transform, detect, encode and write frames.
+// Each role has a priority, a set of logical processors and an optional MMCSS task, configured once for the process.
+// Threads take on their role with ThreadRoles::Apply, which is cheap enough to call for every frame or job, so a thread
+// picks up a new configuration on its next frame. Without it, Unity's job system and the render thread can starve
+// capture under load, and frames are dropped.
+
+#pragma once
+
+#if defined(_WIN32)
+#include <Windows.h>
+#include <avrt.h>
+#pragma comment(lib, "avrt")
+#endif
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+
+enum class ThreadRole
+{
+    // Threads that receive frames from a camera, including the driver threads of capture cards.
+    Capture = 0,
+    // Pixel conversion workers, and threads that transform depth into the color camera.
+    Transform,
+    // Body tracking and marker detection.
+    Detect,
+    // Threads that feed frames to the video encoder.
+    Encode,
+    // Threads that write recordings and pictures to disk.
+    IO,
+    Count
+};
+
+enum class MmcssTask
+{
+    None = 0,
+    Capture,
+    Playback
+};
+
+struct ThreadRoleSettings
+{
+    // A Windows THREAD_PRIORITY_ value. Only used while the thread is not registered with MMCSS, which schedules it
+    // by the priority of its task instead.
+    int priority;
+    // Logical processors the thread may run on, 0 for any processor of the process.
+    uint64_t affinityMask;
+    MmcssTask mmcssTask;
+};
+
+class ThreadRoles
+{
+public:
+    // THREAD_PRIORITY_ values, defined here so the settings mean the same without Windows.h.
+    static const int PriorityNormal = 0;
+    static const int PriorityAboveNormal = 1;
+    static const int PriorityHighest = 2;
+    static const int PriorityTimeCritical = 15;
+
+    // Like ConversionThreadPool, never destroyed, so threads that outlive static destructors can still apply roles.
+    static ThreadRoles& Instance()
+    {
+        static ThreadRoles* roles = new ThreadRoles();
+        return *roles;
+    }
+
+    // Threads with the role pick up settings on their next call to Apply.
+    void Configure(ThreadRole role, const ThreadRoleSettings& roleSettings)
+    {
+        if (role < ThreadRole::Capture || role >= ThreadRole::Count)
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> guard(lock);
+        settings[(int)role] = roleSettings;
+        generation++;
+    }
+
+    ThreadRoleSettings GetSettings(ThreadRole role) const
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return settings[(int)role];
+    }
+
+    // Give the calling thread the settings of role, unless it already has the current ones.
+    void Apply(ThreadRole role)
+    {
+        AppliedRole& applied = CurrentThread();
+        unsigned int currentGeneration = generation.load(std::memory_order_acquire);
+        if (applied.role == (int)role && applied.generation == currentGeneration)
+        {
+            return;
+        }
+
+        ThreadRoleSettings roleSettings = GetSettings(role);
+
+#if defined(_WIN32)
+        HANDLE thread = GetCurrentThread();
+        if (applied.role < 0)
+        {
+            applied.originalPriority = GetThreadPriority(thread);
+            applied.originalAffinity = GetThreadAffinity();
+        }
+
+        if (applied.mmcssTask != roleSettings.mmcssTask && applied.mmcssHandle != NULL)
+        {
+            AvRevertMmThreadCharacteristics(applied.mmcssHandle);
+            applied.mmcssHandle = NULL;
+        }
+
+        if (roleSettings.mmcssTask != MmcssTask::None && applied.mmcssHandle == NULL)
+        {
+            DWORD taskIndex = 0;
+            applied.mmcssHandle = AvSetMmThreadCharacteristicsW(roleSettings.mmcssTask == MmcssTask::Capture ? L"Capture" : L"Playback", &taskIndex);
+        }
+
+        if (applied.mmcssHandle == NULL)
+        {
+            SetThreadPriority(thread, roleSettings.priority);
+        }
+
+        SetThreadAffinity(roleSettings.affinityMask != 0 ? (DWORD_PTR)roleSettings.affinityMask : applied.originalAffinity);
+#endif
+
+        applied.role = (int)role;
+        applied.generation = currentGeneration;
+        applied.mmcssTask = roleSettings.mmcssTask;
+    }
+
+    // Give the calling thread back the scheduling it had before its first Apply.
+    void Restore()
+    {
+        AppliedRole& applied = CurrentThread();
+        if (applied.role < 0)
+        {
+            return;
+        }
+
+#if defined(_WIN32)
+        if (applied.mmcssHandle != NULL)
+        {
+            AvRevertMmThreadCharacteristics(applied.mmcssHandle);
+            applied.mmcssHandle = NULL;
+        }
+
+        SetThreadPriority(GetCurrentThread(), applied.originalPriority);
+        SetThreadAffinity(applied.originalAffinity);
+#endif
+
+        applied = AppliedRole();
+    }
+
+private:
+    struct AppliedRole
+    {
+        int role = -1;
+        unsigned int generation = 0;
+        MmcssTask mmcssTask = MmcssTask::None;
+#if defined(_WIN32)
+        HANDLE mmcssHandle = NULL;
+        int originalPriority = 0;
+        DWORD_PTR originalAffinity = 0;
+#endif
+    };
+
+    ThreadRoles()
+    {
+        // Capture must keep up with the camera whatever else runs, the other roles only need to stay ahead of Unity.
+        settings[(int)ThreadRole::Capture] = { PriorityHighest, 0, MmcssTask::Capture };
+        settings[(int)ThreadRole::Transform] = { PriorityAboveNormal, 0, MmcssTask::None };
+        settings[(int)ThreadRole::Detect] = { PriorityNormal, 0, MmcssTask::None };
+        settings[(int)ThreadRole::Encode] = { PriorityAboveNormal, 0, MmcssTask::None };
+        settings[(int)ThreadRole::IO] = { PriorityNormal, 0, MmcssTask::None };
+    }
+
+    ThreadRoles(const ThreadRoles&) = delete;
+    ThreadRoles& operator=(const ThreadRoles&) = delete;
+
+    static AppliedRole& CurrentThread()
+    {
+        static thread_local AppliedRole applied;
+        return applied;
+    }
+
+#if defined(_WIN32)
+    // Threads start out on every processor of the process, and SetThreadAffinityMask only reports the mask it replaced.
+    static DWORD_PTR GetThreadAffinity()
+    {
+        DWORD_PTR processAffinity = 0;
+        DWORD_PTR systemAffinity = 0;
+        GetProcessAffinityMask(GetCurrentProcess(), &processAffinity, &systemAffinity);
+
+        DWORD_PTR threadAffinity = SetThreadAffinityMask(GetCurrentThread(), processAffinity);
+        if (threadAffinity != 0)
+        {
+            SetThreadAffinityMask(GetCurrentThread(), threadAffinity);
+            return threadAffinity;
+        }
+
+        return processAffinity;
+    }
+
+    static void SetThreadAffinity(DWORD_PTR affinity)
+    {
+        if (affinity != 0)
+        {
+            SetThreadAffinityMask(GetCurrentThread(), affinity);
+        }
+    }
+#endif
+
+    mutable std::mutex lock;
+    ThreadRoleSettings settings[(int)ThreadRole::Count];
+    std::atomic<unsigned int> generation { 1 };
+};
+
+// Gives the calling thread a role for as long as the scope lasts, for threads that are borrowed from a shared
+// scheduler or that exit with the scope.
+class ThreadRoleScope
+{
+public:
+    explicit ThreadRoleScope(ThreadRole role)
+    {
+        ThreadRoles::Instance().Apply(role);
+    }
+
+    ~ThreadRoleScope()
+    {
+        ThreadRoles::Instance().Restore();
+    }
+
+    ThreadRoleScope(const ThreadRoleScope&) = delete;
+    ThreadRoleScope& operator=(const ThreadRoleScope&) = delete;
+};
@@ -0,0 +1,422 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+// CPU kernels for unpacking 10 bit 4:2:2 v210 video, as captured from 10 bit SDI and HDMI sources.
+// v210 packs three 10 bit components into each little endian 32 bit word, in the same Cb Y Cr Y order as UYVY.
+// Each group of four words holds six pixels, rows are padded to a multiple of 48 pixels (128 bytes).
+// Frames are either cut down to 8 bit UYVY for the 8 bit pipeline, or decoded to 32 bit color straight from their
+// 10 bit components, so they are only rounded once.
+// Every SIMD kernel produces output that is bit-identical to the _Scalar reference.
+
+#pragma once
+
+#include <stdint.h>
+#include "CpuFeatures.h"
+#include "YUVConversion.h"
+
+class V210Conversion
+{
+public:
+    // Bytes in one tightly packed v210 row.
+    static int RowBytes(int width)
+    {
+        return ((width + 47) / 48) * 128;
+    }
+
+    // Unpack pixelCount pixels to 8 bit UYVY by dropping the two least significant bits of each component.
+    // pixelCount must be even.
+    static void ConvertV210toUYVY(const uint8_t* input, uint8_t* output, int pixelCount)
+    {
+        switch (CpuFeatures::GetSimdLevel())
+        {
+#if defined(SV_SIMD_X86)
+        case SimdLevel::AVX2:
+            ConvertV210toUYVY_AVX2(input, output, pixelCount);
+            return;
+        case SimdLevel::SSE41:
+            ConvertV210toUYVY_SSE41(input, output, pixelCount);
+            return;
+#elif defined(SV_SIMD_NEON)
+        case SimdLevel::NEON:
+            ConvertV210toUYVY_NEON(input, output, pixelCount);
+            return;
+#endif
+        default:
+            ConvertV210toUYVY_Scalar(input, output, pixelCount);
+            return;
+        }
+    }
+
+    // Reference implementation, one word per iteration.
+    static void ConvertV210toUYVY_Scalar(const uint8_t* input, uint8_t* output, int pixelCount)
+    {
+        int components = pixelCount * 2;
+        for (int i = 0; i < components; i += 3, input += 4)
+        {
+            uint32_t word = ReadWord(input);
+            for (int k = 0; k < 3 && i + k < components; k++)
+            {
+                output[i + k] = (uint8_t)(word >> (10 * k + 2));
+            }
+        }
+    }
+
+#if defined(SV_SIMD_X86)
+    // One group of 6 pixels per iteration. Each word is reduced to three bytes in place, then the
+    // fourth byte of every word is squeezed out. The store writes 4 bytes past the group, so the last
+    // group is left to the scalar path.
+    SV_TARGET_SSE41 static void ConvertV210toUYVY_SSE41(const uint8_t* input, uint8_t* output, int pixelCount)
+    {
+        const __m128i compact = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+
+        int components = pixelCount * 2;
+        int i = 0;
+        for (; i + 16 <= components; i += 12, input += 16)
+        {
+            __m128i words = _mm_loadu_si128((const __m128i*)input);
+            _mm_storeu_si128((__m128i*)(output + i), _mm_shuffle_epi8(ReduceWordsSSE(words), compact));
+        }
+
+        ConvertV210toUYVY_Scalar(input, output + i, (components - i) / 2);
+    }
+
+    // Two groups per iteration, one in each 128 bit lane.
+    SV_TARGET_AVX2 static void ConvertV210toUYVY_AVX2(const uint8_t* input, uint8_t* output, int pixelCount)
+    {
+        const __m256i compact = _mm256_setr_epi8(
+            0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+            0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+        const __m256i joinLanes = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+
+        int components = pixelCount * 2;
+        int i = 0;
+        for (; i + 32 <= components; i += 24, input += 32)
+        {
+            __m256i words = _mm256_loadu_si256((const __m256i*)input);
+            __m256i bytes = _mm256_shuffle_epi8(ReduceWordsAVX2(words), compact);
+            _mm256_storeu_si256((__m256i*)(output + i), _mm256_permutevar8x32_epi32(bytes, joinLanes));
+        }
+
+        ConvertV210toUYVY_SSE41(input, output + i, (components - i) / 2);
+    }
+#endif
+
+#if defined(SV_SIMD_NEON)
+    // Two groups per iteration. Narrowing keeps the low byte of each shifted word and vst3 interleaves the results.
+    static void ConvertV210toUYVY_NEON(const uint8_t* input, uint8_t* output, int pixelCount)
+    {
+        int components = pixelCount * 2;
+        int i = 0;
+        for (; i + 24 <= components; i += 24, input += 32)
+        {
+            uint32x4_t words0 = vld1q_u32((const uint32_t*)input);
+            uint32x4_t words1 = vld1q_u32((const uint32_t*)(input + 16));
+
+            uint8x8x3_t bytes;
+            bytes.val[0] = vmovn_u16(vcombine_u16(vmovn_u32(vshrq_n_u32(words0, 2)), vmovn_u32(vshrq_n_u32(words1, 2))));
+            bytes.val[1] = vmovn_u16(vcombine_u16(vmovn_u32(vshrq_n_u32(words0, 12)), vmovn_u32(vshrq_n_u32(words1, 12))));
+            bytes.val[2] = vmovn_u16(vcombine_u16(vmovn_u32(vshrq_n_u32(words0, 22)), vmovn_u32(vshrq_n_u32(words1, 22))));
+            vst3_u8(output + i, bytes);
+        }
+
+        ConvertV210toUYVY_Scalar(input, output + i, (components - i) / 2);
+    }
+#endif
+
+    // Unpack pixelCount pixels to 10 bit components, one per uint16_t in the same Cb Y Cr Y order. pixelCount must be even.
+    static void UnpackV210(const uint8_t* input, uint16_t* output, int pixelCount)
+    {
+        switch (CpuFeatures::GetSimdLevel())
+        {
+#if defined(SV_SIMD_X86)
+        case SimdLevel::AVX2:
+        case SimdLevel::SSE41:
+            UnpackV210_SSE41(input, output, pixelCount);
+            return;
+#elif defined(SV_SIMD_NEON)
+        case SimdLevel::NEON:
+            UnpackV210_NEON(input, output, pixelCount);
+            return;
+#endif
+        default:
+            UnpackV210_Scalar(input, output, pixelCount);
+            return;
+        }
+    }
+
+    static void UnpackV210_Scalar(const uint8_t* input, uint16_t* output, int pixelCount)
+    {
+        int components = pixelCount * 2;
+        for (int i = 0; i < components; i += 3, input += 4)
+        {
+            uint32_t word = ReadWord(input);
+            for (int k = 0; k < 3 && i + k < components; k++)
+            {
+                output[i + k] = (uint16_t)((word >> (10 * k)) & 0x3FF);
+            }
+        }
+    }
+
+    // Convert pixelCount unpacked 10 bit UYVY pixels to BGRA, or RGBA when Rgba is set, with opaque alpha.
+    // This is the 8 bit decode of YUVConversion with two more bits of input: for components whose two low bits are 0
+    // the output is the same, otherwise it is rounded from the exact value instead of from the truncated one.
+    template <bool Rgba>
+    static void ConvertUYVY10toBGRA(const uint16_t* input, uint8_t* output, int pixelCount, const YUVCoefficients& coefficients)
+    {
+        switch (CpuFeatures::GetSimdLevel())
+        {
+#if defined(SV_SIMD_X86)
+        case SimdLevel::AVX2:
+            ConvertUYVY10toBGRA_AVX2<Rgba>(input, output, pixelCount, coefficients);
+            return;
+        case SimdLevel::SSE41:
+            ConvertUYVY10toBGRA_SSE41<Rgba>(input, output, pixelCount, coefficients);
+            return;
+#elif defined(SV_SIMD_NEON)
+        case SimdLevel::NEON:
+            ConvertUYVY10toBGRA_NEON<Rgba>(input, output, pixelCount, coefficients);
+            return;
+#endif
+        default:
+            ConvertUYVY10toBGRA_Scalar<Rgba>(input, output, pixelCount, coefficients);
+            return;
+        }
+    }
+
+    // Reference implementation, one pair of pixels per iteration.
+    template <bool Rgba>
+    static void ConvertUYVY10toBGRA_Scalar(const uint16_t* input, uint8_t* output, int pixelCount, const YUVCoefficients& coefficients)
+    {
+        for (int i = 0; i + 1 < pixelCount; i += 2)
+        {
+            const uint16_t* src = input + i * 2;
+            uint8_t* dst = output + i * 4;
+
+            int d = src[0] - 512;
+            int e = src[2] - 512;
+
+            int redChroma = coefficients.redV * e + 512;
+            int greenChroma = coefficients.greenU * d + coefficients.greenV * e + 512;
+            int blueChroma = coefficients.blueU * d + 512;
+
+            for (int p = 0; p < 2; p++)
+            {
+                int luma = coefficients.lumaScale * (src[1 + p * 2] - coefficients.lumaOffset * 4);
+
+                uint8_t r = YUVConversion::ClampToByte((luma + redChroma) >> 10);
+                uint8_t g = YUVConversion::ClampToByte((luma + greenChroma) >> 10);
+                uint8_t b = YUVConversion::ClampToByte((luma + blueChroma) >> 10);
+
+                dst[p * 4] = Rgba ? r : b;
+                dst[p * 4 + 1] = g;
+                dst[p * 4 + 2] = Rgba ? b : r;
+                dst[p * 4 + 3] = 255;
+            }
+        }
+    }
+
+#if defined(SV_SIMD_X86)
+    // One group of 6 pixels per iteration. The three components of each word are masked out into 32 bit lanes,
+    // and two shuffles put them back in v210 order.
+    SV_TARGET_SSE41 static void UnpackV210_SSE41(const uint8_t* input, uint16_t* output, int pixelCount)
+    {
+        const __m128i mask = _mm_set1_epi32(0x3FF);
+        // Lanes of the first two components, then lanes of the third, for the first 8 and the last 4 outputs.
+        const __m128i firstPairs = _mm_setr_epi8(0, 1, 2, 3, -1, -1, 4, 5, 6, 7, -1, -1, 8, 9, 10, 11);
+        const __m128i firstThirds = _mm_setr_epi8(-1, -1, -1, -1, 0, 1, -1, -1, -1, -1, 4, 5, -1, -1, -1, -1);
+        const __m128i lastPairs = _mm_setr_epi8(-1, -1, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+        const __m128i lastThirds = _mm_setr_epi8(8, 9, -1, -1, -1, -1, 12, 13, -1, -1, -1, -1, -1, -1, -1, -1);
+
+        int components = pixelCount * 2;
+        int i = 0;
+        for (; i + 12 <= components; i += 12, input += 16)
+        {
+            __m128i words = _mm_loadu_si128((const __m128i*)input);
+            __m128i pairs = _mm_or_si128(_mm_and_si128(words, mask), _mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(words, 10), mask), 16));
+            __m128i thirds = _mm_and_si128(_mm_srli_epi32(words, 20), mask);
+
+            _mm_storeu_si128((__m128i*)(output + i), _mm_or_si128(_mm_shuffle_epi8(pairs, firstPairs), _mm_shuffle_epi8(thirds, firstThirds)));
+            _mm_storel_epi64((__m128i*)(output + i + 8), _mm_or_si128(_mm_shuffle_epi8(pairs, lastPairs), _mm_shuffle_epi8(thirds, lastThirds)));
+        }
+
+        UnpackV210_Scalar(input, output + i, (components - i) / 2);
+    }
+
+    // Four pixels per iteration, in 32 bit lanes. Each pair of pixels shares the chroma of its first lane.
+    template <bool Rgba>
+    SV_TARGET_SSE41 static void ConvertUYVY10toBGRA_SSE41(const uint16_t* input, uint8_t* output, int pixelCount, const YUVCoefficients& coefficients)
+    {
+        const __m128i lowHalf = _mm_set1_epi32(0xFFFF);
+        const __m128i chromaOffset = _mm_set1_epi32(512);
+        const __m128i lumaOffset = _mm_set1_epi32(coefficients.lumaOffset * 4);
+        const __m128i lumaScale = _mm_set1_epi32(coefficients.lumaScale);
+        const __m128i redV = _mm_set1_epi32(coefficients.redV);
+        const __m128i greenU = _mm_set1_epi32(coefficients.greenU);
+        const __m128i greenV = _mm_set1_epi32(coefficients.greenV);
+        const __m128i blueU = _mm_set1_epi32(coefficients.blueU);
+        const __m128i maximum = _mm_set1_epi32(255);
+        const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+
+        int i = 0;
+        for (; i + 4 <= pixelCount; i += 4)
+        {
+            __m128i pixels = _mm_loadu_si128((const __m128i*)(input + i * 2));
+            __m128i y = _mm_srli_epi32(pixels, 16);
+            __m128i chroma = _mm_sub_epi32(_mm_and_si128(pixels, lowHalf), chromaOffset);
+            __m128i u = _mm_shuffle_epi32(chroma, _MM_SHUFFLE(2, 2, 0, 0));
+            __m128i v = _mm_shuffle_epi32(chroma, _MM_SHUFFLE(3, 3, 1, 1));
+
+            __m128i luma = _mm_add_epi32(_mm_mullo_epi32(_mm_sub_epi32(y, lumaOffset), lumaScale), chromaOffset);
+            __m128i r = Clamp10SSE(_mm_add_epi32(luma, _mm_mullo_epi32(v, redV)), maximum);
+            __m128i g = Clamp10SSE(_mm_add_epi32(luma, _mm_add_epi32(_mm_mullo_epi32(u, greenU), _mm_mullo_epi32(v, greenV))), maximum);
+            __m128i b = Clamp10SSE(_mm_add_epi32(luma, _mm_mullo_epi32(u, blueU)), maximum);
+
+            __m128i first = Rgba ? r : b;
+            __m128i third = Rgba ? b : r;
+            __m128i packed = _mm_or_si128(_mm_or_si128(first, _mm_slli_epi32(g, 8)), _mm_or_si128(_mm_slli_epi32(third, 16), alpha));
+            _mm_storeu_si128((__m128i*)(output + i * 4), packed);
+        }
+
+        ConvertUYVY10toBGRA_Scalar<Rgba>(input + i * 2, output + i * 4, pixelCount - i, coefficients);
+    }
+
+    // Eight pixels per iteration, four in each 128 bit lane.
+    template <bool Rgba>
+    SV_TARGET_AVX2 static void ConvertUYVY10toBGRA_AVX2(const uint16_t* input, uint8_t* output, int pixelCount, const YUVCoefficients& coefficients)
+    {
+        const __m256i lowHalf = _mm256_set1_epi32(0xFFFF);
+        const __m256i chromaOffset = _mm256_set1_epi32(512);
+        const __m256i lumaOffset = _mm256_set1_epi32(coefficients.lumaOffset * 4);
+        const __m256i lumaScale = _mm256_set1_epi32(coefficients.lumaScale);
+        const __m256i redV = _mm256_set1_epi32(coefficients.redV);
+        const __m256i greenU = _mm256_set1_epi32(coefficients.greenU);
+        const __m256i greenV = _mm256_set1_epi32(coefficients.greenV);
+        const __m256i blueU = _mm256_set1_epi32(coefficients.blueU);
+        const __m256i maximum = _mm256_set1_epi32(255);
+        const __m256i alpha = _mm256_set1_epi32((int)0xFF000000);
+
+        int i = 0;
+        for (; i + 8 <= pixelCount; i += 8)
+        {
+            __m256i pixels = _mm256_loadu_si256((const __m256i*)(input + i * 2));
+            __m256i y = _mm256_srli_epi32(pixels, 16);
+            __m256i chroma = _mm256_sub_epi32(_mm256_and_si256(pixels, lowHalf), chromaOffset);
+            __m256i u = _mm256_shuffle_epi32(chroma, _MM_SHUFFLE(2, 2, 0, 0));
+            __m256i v = _mm256_shuffle_epi32(chroma, _MM_SHUFFLE(3, 3, 1, 1));
+
+            __m256i luma = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_sub_epi32(y, lumaOffset), lumaScale), chromaOffset);
+            __m256i r = Clamp10AVX2(_mm256_add_epi32(luma, _mm256_mullo_epi32(v, redV)), maximum);
+            __m256i g = Clamp10AVX2(_mm256_add_epi32(luma, _mm256_add_epi32(_mm256_mullo_epi32(u, greenU), _mm256_mullo_epi32(v, greenV))), maximum);
+            __m256i b = Clamp10AVX2(_mm256_add_epi32(luma, _mm256_mullo_epi32(u, blueU)), maximum);
+
+            __m256i first = Rgba ? r : b;
+            __m256i third = Rgba ? b : r;
+            __m256i packed = _mm256_or_si256(_mm256_or_si256(first, _mm256_slli_epi32(g, 8)), _mm256_or_si256(_mm256_slli_epi32(third, 16), alpha));
+            _mm256_storeu_si256((__m256i*)(output + i * 4), packed);
+        }
+
+        ConvertUYVY10toBGRA_SSE41<Rgba>(input + i * 2, output + i * 4, pixelCount - i, coefficients);
+    }
+#endif
+
+#if defined(SV_SIMD_NEON)
+    // Two groups per iteration. Narrowing keeps the low half of each masked word and vst3 interleaves the results.
+    static void UnpackV210_NEON(const uint8_t* input, uint16_t* output, int pixelCount)
+    {
+        const uint32x4_t mask = vdupq_n_u32(0x3FF);
+
+        int components = pixelCount * 2;
+        int i = 0;
+        for (; i + 24 <= components; i += 24, input += 32)
+        {
+            uint32x4_t words0 = vld1q_u32((const uint32_t*)input);
+            uint32x4_t words1 = vld1q_u32((const uint32_t*)(input + 16));
+
+            uint16x8x3_t unpacked;
+            unpacked.val[0] = vcombine_u16(vmovn_u32(vandq_u32(words0, mask)), vmovn_u32(vandq_u32(words1, mask)));
+            unpacked.val[1] = vcombine_u16(vmovn_u32(vandq_u32(vshrq_n_u32(words0, 10), mask)), vmovn_u32(vandq_u32(vshrq_n_u32(words1, 10), mask)));
+            unpacked.val[2] = vcombine_u16(vmovn_u32(vandq_u32(vshrq_n_u32(words0, 20), mask)), vmovn_u32(vandq_u32(vshrq_n_u32(words1, 20), mask)));
+            vst3q_u16(output + i, unpacked);
+        }
+
+        UnpackV210_Scalar(input, output + i, (components - i) / 2);
+    }
+
+    // Eight pixels per iteration. vld4 splits them into chroma and the even and odd luma, which are decoded in 32 bit
+    // lanes and zipped back together.
+    template <bool Rgba>
+    static void ConvertUYVY10toBGRA_NEON(const uint16_t* input, uint8_t* output, int pixelCount, const YUVCoefficients& coefficients)
+    {
+        int i = 0;
+        for (; i + 8 <= pixelCount; i += 8)
+        {
+            uint16x4x4_t pixels = vld4_u16(input + i * 2);
+            int32x4_t u = vsubq_s32(vreinterpretq_s32_u32(vmovl_u16(pixels.val[0])), vdupq_n_s32(512));
+            int32x4_t v = vsubq_s32(vreinterpretq_s32_u32(vmovl_u16(pixels.val[2])), vdupq_n_s32(512));
+
+            int32x4_t redChroma = vmlaq_n_s32(vdupq_n_s32(512), v, coefficients.redV);
+            int32x4_t greenChroma = vmlaq_n_s32(vmlaq_n_s32(vdupq_n_s32(512), u, coefficients.greenU), v, coefficients.greenV);
+            int32x4_t blueChroma = vmlaq_n_s32(vdupq_n_s32(512), u, coefficients.blueU);
+
+            int32x4_t evenLuma = vmulq_n_s32(vsubq_s32(vreinterpretq_s32_u32(vmovl_u16(pixels.val[1])), vdupq_n_s32(coefficients.lumaOffset * 4)), coefficients.lumaScale);
+            int32x4_t oddLuma = vmulq_n_s32(vsubq_s32(vreinterpretq_s32_u32(vmovl_u16(pixels.val[3])), vdupq_n_s32(coefficients.lumaOffset * 4)), coefficients.lumaScale);
+
+            uint8x8x4_t bgra;
+            uint8x8_t r = Zip10NEON(vaddq_s32(evenLuma, redChroma), vaddq_s32(oddLuma, redChroma));
+            uint8x8_t b = Zip10NEON(vaddq_s32(evenLuma, blueChroma), vaddq_s32(oddLuma, blueChroma));
+            bgra.val[0] = Rgba ? r : b;
+            bgra.val[1] = Zip10NEON(vaddq_s32(evenLuma, greenChroma), vaddq_s32(oddLuma, greenChroma));
+            bgra.val[2] = Rgba ? b : r;
+            bgra.val[3] = vdup_n_u8(255);
+            vst4_u8(output + i * 4, bgra);
+        }
+
+        ConvertUYVY10toBGRA_Scalar<Rgba>(input + i * 2, output + i * 4, pixelCount - i, coefficients);
+    }
+#endif
+
+private:
+    static inline uint32_t ReadWord(const uint8_t* input)
+    {
+        return (uint32_t)input[0] | ((uint32_t)input[1] << 8) | ((uint32_t)input[2] << 16) | ((uint32_t)input[3] << 24);
+    }
+
+#if defined(SV_SIMD_X86)
+    // The top 8 bits of the three components of each word, in bytes 0 to 2 of the word.
+    SV_TARGET_SSE41 static inline __m128i ReduceWordsSSE(__m128i words)
+    {
+        __m128i first = _mm_and_si128(_mm_srli_epi32(words, 2), _mm_set1_epi32(0x0000FF));
+        __m128i second = _mm_and_si128(_mm_srli_epi32(words, 4), _mm_set1_epi32(0x00FF00));
+        __m128i third = _mm_and_si128(_mm_srli_epi32(words, 6), _mm_set1_epi32(0xFF0000));
+        return _mm_or_si128(_mm_or_si128(first, second), third);
+    }
+
+    SV_TARGET_AVX2 static inline __m256i ReduceWordsAVX2(__m256i words)
+    {
+        __m256i first = _mm256_and_si256(_mm256_srli_epi32(words, 2), _mm256_set1_epi32(0x0000FF));
+        __m256i second = _mm256_and_si256(_mm256_srli_epi32(words, 4), _mm256_set1_epi32(0x00FF00));
+        __m256i third = _mm256_and_si256(_mm256_srli_epi32(words, 6), _mm256_set1_epi32(0xFF0000));
+        return _mm256_or_si256(_mm256_or_si256(first, second), third);
+    }
+
+    // Scale a 10 bit fixed point sum down to 8 bits and clamp it to 0 to maximum.
+    SV_TARGET_SSE41 static inline __m128i Clamp10SSE(__m128i sum, __m128i maximum)
+    {
+        return _mm_min_epi32(_mm_max_epi32(_mm_srai_epi32(sum, 10), _mm_setzero_si128()), maximum);
+    }
+
+    SV_TARGET_AVX2 static inline __m256i Clamp10AVX2(__m256i sum, __m256i maximum)
+    {
+        return _mm256_min_epi32(_mm256_max_epi32(_mm256_srai_epi32(sum, 10), _mm256_setzero_si256()), maximum);
+    }
+#endif
+
+#if defined(SV_SIMD_NEON)
+    // Scale the 10 bit fixed point sums of the even and odd pixels down to 8 bits, clamp them, and interleave them.
+    static inline uint8x8_t Zip10NEON(int32x4_t even, int32x4_t odd)
+    {
+        uint16x4x2_t zipped = vzip_u16(vqmovun_s32(vshrq_n_s32(even, 10)), vqmovun_s32(vshrq_n_s32(odd, 10)));
+        return vqmovn_u16(vcombine_u16(zipped.val[0], zipped.val[1]));
+    }
+#endif
+};
@@ -0,0 +1,848 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+// CPU kernels for converting between 32 bit color and UYVY (http://www.fourcc.org/yuv.php#UYVY) or NV12.
+// Every SIMD kernel produces output that is bit-identical to the _Scalar reference, the widest
+// kernel supported by the CPU is chosen at runtime.
+// All math is 8 bit fixed point, the coefficients for each ColorMatrix are precomputed in YUVCoefficients.
+
+#pragma once
+
+#include <stdint.h>
+#include "CpuFeatures.h"
+
+enum class ColorMatrix
+{
+    // Studio range BT.601, https://msdn.microsoft.com/en-us/library/ms893078.aspx
+    BT601Limited = 0,
+    // Studio range BT.709, used by HD SDI and HDMI sources.
+    BT709Limited,
+    // Full range BT.601 (JPEG).
+    BT601Full,
+    // Full range BT.709.
+    BT709Full,
+    Count
+};
+
+// Fixed point coefficients scaled by 256.
+// Decode: R = (lumaScale * (Y - lumaOffset) + redV * (V - 128) + 128) >> 8, and likewise for G and B.
+// Encode: Y = ((yRed * R + yGreen * G + yBlue * B + 128) >> 8) + lumaOffset, U and V are offset by 128 instead.
+// Each encode row sums to 0 for chroma and never exceeds 256 for luma, so the SIMD kernels can stay in 16 bit lanes.
+struct YUVCoefficients
+{
+    int16_t lumaOffset;
+    int16_t lumaScale;
+    int16_t redV;
+    int16_t greenU;
+    int16_t greenV;
+    int16_t blueU;
+
+    int16_t yRed;
+    int16_t yGreen;
+    int16_t yBlue;
+    int16_t uRed;
+    int16_t uGreen;
+    int16_t uBlue;
+    int16_t vRed;
+    int16_t vGreen;
+    int16_t vBlue;
+};
+
+class YUVConversion
+{
+public:
+    static const YUVCoefficients& GetCoefficients(ColorMatrix matrix)
+    {
+        static const YUVCoefficients coefficients[(int)ColorMatrix::Count] =
+        {
+            // BT601Limited, matches the previous hard coded constants.
+            { 16, 298, 409, -100, -208, 516, 66, 129, 25, -38, -74, 112, 112, -94, -18 },
+            // BT709Limited
+            { 16, 298, 459, -55, -136, 541, 47, 157, 16, -26, -86, 112, 112, -102, -10 },
+            // BT601Full
+            { 0, 256, 359, -88, -183, 454, 77, 150, 29, -43, -84, 127, 127, -107, -20 },
+            // BT709Full
+            { 0, 256, 403, -48, -120, 475, 54, 183, 19, -29, -98, 127, 127, -116, -11 },
+        };
+
+        int index = (int)matrix;
+        return coefficients[(index >= 0 && index < (int)ColorMatrix::Count) ? index : 0];
+    }
+
+    // Convert pixelCount UYVY pixels to BGRA (or RGBA when rgba is set).
+    // alphaInput is an optional 8 bit alpha plane, output alpha is opaque without it.
+    static void ConvertUYVYtoBGRA(const uint8_t* input, const uint8_t* alphaInput, uint8_t* output, int pixelCount, bool rgba = false, ColorMatrix matrix = ColorMatrix::BT601Limited)
+    {
+        const YUVCoefficients& coefficients = GetCoefficients(matrix);
+        if (rgba && alphaInput != nullptr)
+        {
+            ConvertUYVYtoBGRA<true, true>(input, alphaInput, output, pixelCount, coefficients);
+        }
+        else if (rgba)
+        {
+            ConvertUYVYtoBGRA<true, false>(input, alphaInput, output, pixelCount, coefficients);
+        }
+        else if (alphaInput != nullptr)
+        {
+            ConvertUYVYtoBGRA<false, true>(input, alphaInput, output, pixelCount, coefficients);
+        }
+        else
+        {
+            ConvertUYVYtoBGRA<false, false>(input, alphaInput, output, pixelCount, coefficients);
+        }
+    }
+
+    // Same as above with the channel order and the alpha plane fixed at compile time, for callers that convert
+    // many rows the same way. alphaInput is ignored unless UseAlphaPlane is set.
+    template <bool Rgba, bool UseAlphaPlane>
+    static void ConvertUYVYtoBGRA(const uint8_t* input, const uint8_t* alphaInput, uint8_t* output, int pixelCount, const YUVCoefficients& coefficients)
+    {
+        switch (CpuFeatures::GetSimdLevel())
+        {
+#if defined(SV_SIMD_X86)
+        case SimdLevel::AVX2:
+            ConvertUYVYtoBGRA_AVX2<Rgba, UseAlphaPlane>(input, alphaInput, output, pixelCount, coefficients);
+            return;
+        case SimdLevel::SSE41:
+            ConvertUYVYtoBGRA_SSE41<Rgba, UseAlphaPlane>(input, alphaInput, output, pixelCount, coefficients);
+            return;
+#elif defined(SV_SIMD_NEON)
+        case SimdLevel::NEON:
+            ConvertUYVYtoBGRA_NEON<Rgba, UseAlphaPlane>(input, alphaInput, output, pixelCount, coefficients);
+            return;
+#endif
+        default:
+            ConvertUYVYtoBGRA_Scalar<Rgba, UseAlphaPlane>(input, alphaInput, output, pixelCount, coefficients);
+            return;
+        }
+    }
+
+    // Convert pixelCount BGRA (or RGBA when rgba is set) pixels to UYVY.
+    // Chroma is taken from the first pixel of each pair. alphaOut is an optional 8 bit alpha plane.
+    static void ConvertBGRAtoUYVY(const uint8_t* input, uint8_t* output, uint8_t* alphaOut, int pixelCount, bool rgba = false, ColorMatrix matrix = ColorMatrix::BT601Limited)
+    {
+        const YUVCoefficients& coefficients = GetCoefficients(matrix);
+        if (rgba && alphaOut != nullptr)
+        {
+            ConvertBGRAtoUYVY<true, true>(input, output, alphaOut, pixelCount, coefficients);
+        }
+        else if (rgba)
+        {
+            ConvertBGRAtoUYVY<true, false>(input, output, alphaOut, pixelCount, coefficients);
+        }
+        else if (alphaOut != nullptr)
+        {
+            ConvertBGRAtoUYVY<false, true>(input, output, alphaOut, pixelCount, coefficients);
+        }
+        else
+        {
+            ConvertBGRAtoUYVY<false, false>(input, output, alphaOut, pixelCount, coefficients);
+        }
+    }
+
+    // alphaOut is ignored unless UseAlphaPlane is set.
+    template <bool Rgba, bool UseAlphaPlane>
+    static void ConvertBGRAtoUYVY(const uint8_t* input, uint8_t* output, uint8_t* alphaOut, int pixelCount, const YUVCoefficients& coefficients)
+    {
+        switch (CpuFeatures::GetSimdLevel())
+        {
+#if defined(SV_SIMD_X86)
+        case SimdLevel::AVX2:
+            ConvertBGRAtoUYVY_AVX2<Rgba, UseAlphaPlane>(input, output, alphaOut, pixelCount, coefficients);
+            return;
+        case SimdLevel::SSE41:
+            ConvertBGRAtoUYVY_SSE41<Rgba, UseAlphaPlane>(input, output, alphaOut, pixelCount, coefficients);
+            return;
+#elif defined(SV_SIMD_NEON)
+        case SimdLevel::NEON:
+            ConvertBGRAtoUYVY_NEON<Rgba, UseAlphaPlane>(input, output, alphaOut, pixelCount, coefficients);
+            return;
+#endif
+        default:
+            ConvertBGRAtoUYVY_Scalar<Rgba, UseAlphaPlane>(input, output, alphaOut, pixelCount, coefficients);
+            return;
+        }
+    }
+
+    // Convert a BGRA (or RGBA) image to NV12: a full resolution Y plane followed by an interleaved UV plane
+    // with one sample per 2x2 block. Width and height must be even.
+    static void ConvertBGRAtoNV12(const uint8_t* input, uint8_t* output, int width, int height, bool rgba = false, ColorMatrix matrix = ColorMatrix::BT601Limited)
+    {
+        uint8_t* uvPlane = output + width * height;
+        for (int row = 0; row + 1 < height; row += 2)
+        {
+            ConvertBGRAtoNV12Rows(
+                input + row * width * 4,
+                input + (row + 1) * width * 4,
+                output + row * width,
+                output + (row + 1) * width,
+                uvPlane + (row / 2) * width,
+                width,
+                rgba,
+                matrix);
+        }
+    }
+
+    // Convert one pair of rows to NV12, writing both luma rows and the shared chroma row.
+    static void ConvertBGRAtoNV12Rows(const uint8_t* row0, const uint8_t* row1, uint8_t* luma0, uint8_t* luma1, uint8_t* chroma, int width, bool rgba = false, ColorMatrix matrix = ColorMatrix::BT601Limited)
+    {
+        const YUVCoefficients& coefficients = GetCoefficients(matrix);
+        if (rgba)
+        {
+            ConvertBGRAtoNV12Rows<true>(row0, row1, luma0, luma1, chroma, width, coefficients);
+        }
+        else
+        {
+            ConvertBGRAtoNV12Rows<false>(row0, row1, luma0, luma1, chroma, width, coefficients);
+        }
+    }
+
+    template <bool Rgba>
+    static void ConvertBGRAtoNV12Rows(const uint8_t* row0, const uint8_t* row1, uint8_t* luma0, uint8_t* luma1, uint8_t* chroma, int width, const YUVCoefficients& coefficients)
+    {
+        switch (CpuFeatures::GetSimdLevel())
+        {
+#if defined(SV_SIMD_X86)
+        case SimdLevel::AVX2:
+            ConvertBGRAtoNV12Rows_AVX2<Rgba>(row0, row1, luma0, luma1, chroma, width, coefficients);
+            return;
+        case SimdLevel::SSE41:
+            ConvertBGRAtoNV12Rows_SSE41<Rgba>(row0, row1, luma0, luma1, chroma, width, coefficients);
+            return;
+#elif defined(SV_SIMD_NEON)
+        case SimdLevel::NEON:
+            ConvertBGRAtoNV12Rows_NEON<Rgba>(row0, row1, luma0, luma1, chroma, width, coefficients);
+            return;
+#endif
+        default:
+            ConvertBGRAtoNV12Rows_Scalar<Rgba>(row0, row1, luma0, luma1, chroma, width, coefficients);
+            return;
+        }
+    }
+
+    static inline uint8_t ClampToByte(int input)
+    {
+        return (uint8_t)(input < 0 ? 0 : (input > 255 ? 255 : input));
+    }
+
+    // Reference implementation.
+    // Conversion requires > 8 bit precision.
+    // https://msdn.microsoft.com/en-us/library/ms893078.aspx
+    // The channel order and alpha source are template parameters, so the pixel loop does not branch on them.
+    template <bool Rgba, bool UseAlphaPlane>
+    static void ConvertUYVYtoBGRA_Scalar(const uint8_t* input, const uint8_t* alphaInput, uint8_t* output, int pixelCount, const YUVCoefficients& coefficients)
+    {
+        for (int i = 0; i + 1 < pixelCount; i += 2)
+        {
+            const uint8_t* src = input + i * 2;
+            uint8_t* dst = output + i * 4;
+
+            int d = src[0] - 128;
+            int e = src[2] - 128;
+
+            int redChroma = coefficients.redV * e + 128;
+            int greenChroma = coefficients.greenU * d + coefficients.greenV * e + 128;
+            int blueChroma = coefficients.blueU * d + 128;
+
+            for (int p = 0; p < 2; p++)
+            {
+                int luma = coefficients.lumaScale * (src[1 + p * 2] - coefficients.lumaOffset);
+
+                uint8_t r = ClampToByte((luma + redChroma) >> 8);
+                uint8_t g = ClampToByte((luma + greenChroma) >> 8);
+                uint8_t b = ClampToByte((luma + blueChroma) >> 8);
+
+                dst[p * 4] = Rgba ? r : b;
+                dst[p * 4 + 1] = g;
+                dst[p * 4 + 2] = Rgba ? b : r;
+                dst[p * 4 + 3] = UseAlphaPlane ? alphaInput[i + p] : 255;
+            }
+        }
+    }
+
+    // Single pixel encode and decode, shared with DirectXHelper::GetYUV and DirectXHelper::GetRGB.
+    static inline uint8_t LumaFromRGB(int r, int g, int b, const YUVCoefficients& coefficients)
+    {
+        return (uint8_t)(((coefficients.yRed * r + coefficients.yGreen * g + coefficients.yBlue * b + 128) >> 8) + coefficients.lumaOffset);
+    }
+
+    static inline uint8_t BlueChromaFromRGB(int r, int g, int b, const YUVCoefficients& coefficients)
+    {
+        return (uint8_t)(((coefficients.uRed * r + coefficients.uGreen * g + coefficients.uBlue * b + 128) >> 8) + 128);
+    }
+
+    static inline uint8_t RedChromaFromRGB(int r, int g, int b, const YUVCoefficients& coefficients)
+    {
+        return (uint8_t)(((coefficients.vRed * r + coefficients.vGreen * g + coefficients.vBlue * b + 128) >> 8) + 128);
+    }
+
+    static inline void RGBFromYUV(int y, int u, int v, const YUVCoefficients& coefficients, int& r, int& g, int& b)
+    {
+        int luma = coefficients.lumaScale * (y - coefficients.lumaOffset);
+        int d = u - 128;
+        int e = v - 128;
+
+        r = ClampToByte((luma + coefficients.redV * e + 128) >> 8);
+        g = ClampToByte((luma + coefficients.greenU * d + coefficients.greenV * e + 128) >> 8);
+        b = ClampToByte((luma + coefficients.blueU * d + 128) >> 8);
+    }
+
+    template <bool Rgba, bool UseAlphaPlane>
+    static void ConvertBGRAtoUYVY_Scalar(const uint8_t* input, uint8_t* output, uint8_t* alphaOut, int pixelCount, const YUVCoefficients& coefficients)
+    {
+        const int redOffset = Rgba ? 0 : 2;
+        const int blueOffset = Rgba ? 2 : 0;
+
+        for (int i = 0; i + 1 < pixelCount; i += 2)
+        {
+            const uint8_t* src = input + i * 4;
+            uint8_t* dst = output + i * 2;
+
+            int r = src[redOffset];
+            int g = src[1];
+            int b = src[blueOffset];
+
+            dst[0] = BlueChromaFromRGB(r, g, b, coefficients);
+            dst[1] = LumaFromRGB(r, g, b, coefficients);
+            dst[2] = RedChromaFromRGB(r, g, b, coefficients);
+            dst[3] = LumaFromRGB(src[4 + redOffset], src[5], src[4 + blueOffset], coefficients);
+
+            if (UseAlphaPlane)
+            {
+                alphaOut[i] = src[3];
+                alphaOut[i + 1] = src[7];
+            }
+        }
+    }
+
+    // Chroma is computed from the rounded average of each 2x2 block.
+    template <bool Rgba>
+    static void ConvertBGRAtoNV12Rows_Scalar(const uint8_t* row0, const uint8_t* row1, uint8_t* luma0, uint8_t* luma1, uint8_t* chroma, int width, const YUVCoefficients& coefficients)
+    {
+        const int redOffset = Rgba ? 0 : 2;
+        const int blueOffset = Rgba ? 2 : 0;
+
+        for (int x = 0; x + 1 < width; x += 2)
+        {
+            const uint8_t* top = row0 + x * 4;
+            const uint8_t* bottom = row1 + x * 4;
+
+            luma0[x] = LumaFromRGB(top[redOffset], top[1], top[blueOffset], coefficients);
+            luma0[x + 1] = LumaFromRGB(top[4 + redOffset], top[5], top[4 + blueOffset], coefficients);
+            luma1[x] = LumaFromRGB(bottom[redOffset], bottom[1], bottom[blueOffset], coefficients);
+            luma1[x + 1] = LumaFromRGB(bottom[4 + redOffset], bottom[5], bottom[4 + blueOffset], coefficients);
+
+            int r = (top[redOffset] + top[4 + redOffset] + bottom[redOffset] + bottom[4 + redOffset] + 2) >> 2;
+            int g = (top[1] + top[5] + bottom[1] + bottom[5] + 2) >> 2;
+            int b = (top[blueOffset] + top[4 + blueOffset] + bottom[blueOffset] + bottom[4 + blueOffset] + 2) >> 2;
+
+            chroma[x] = BlueChromaFromRGB(r, g, b, coefficients);
+            chroma[x + 1] = RedChromaFromRGB(r, g, b, coefficients);
+        }
+    }
+
+#if defined(SV_SIMD_X86)
+    // 8 pixels per iteration.
+    template <bool Rgba, bool UseAlphaPlane>
+    SV_TARGET_SSE41 static void ConvertUYVYtoBGRA_SSE41(const uint8_t* input, const uint8_t* alphaInput, uint8_t* output, int pixelCount, const YUVCoefficients& coefficients)
+    {
+        const __m128i lowByteMask = _mm_set1_epi16(0x00FF);
+        const __m128i lumaOffset = _mm_set1_epi16(coefficients.lumaOffset);
+        const __m128i chromaOffset = _mm_set1_epi16(128);
+        const __m128i lumaCoefficient = _mm_set1_epi16(coefficients.lumaScale);
+        const __m128i rounding = _mm_set1_epi32(128);
+        const __m128i opaque = _mm_set1_epi16(255);
+
+        // Chroma coefficients are applied to interleaved (d, e) pairs.
+        const __m128i redCoefficients = _mm_set1_epi32(ChromaPair(0, coefficients.redV));
+        const __m128i greenCoefficients = _mm_set1_epi32(ChromaPair(coefficients.greenU, coefficients.greenV));
+        const __m128i blueCoefficients = _mm_set1_epi32(ChromaPair(coefficients.blueU, 0));
+        const __m128i firstCoefficients = Rgba ? redCoefficients : blueCoefficients;
+        const __m128i thirdCoefficients = Rgba ? blueCoefficients : redCoefficients;
+
+        int i = 0;
+        for (; i + 8 <= pixelCount; i += 8)
+        {
+            __m128i src = _mm_loadu_si128((const __m128i*)(input + i * 2));
+            __m128i c = _mm_sub_epi16(_mm_srli_epi16(src, 8), lumaOffset);
+            __m128i de = _mm_sub_epi16(_mm_and_si128(src, lowByteMask), chromaOffset);
+
+            __m128i lumaLow = _mm_mullo_epi16(c, lumaCoefficient);
+            __m128i lumaHigh = _mm_mulhi_epi16(c, lumaCoefficient);
+            __m128i luma0 = _mm_unpacklo_epi16(lumaLow, lumaHigh);
+            __m128i luma1 = _mm_unpackhi_epi16(lumaLow, lumaHigh);
+
+            __m128i first = CombineSSE(luma0, luma1, _mm_add_epi32(_mm_madd_epi16(de, firstCoefficients), rounding));
+            __m128i green = CombineSSE(luma0, luma1, _mm_add_epi32(_mm_madd_epi16(de, greenCoefficients), rounding));
+            __m128i third = CombineSSE(luma0, luma1, _mm_add_epi32(_mm_madd_epi16(de, thirdCoefficients), rounding));
+            __m128i alpha = UseAlphaPlane ? _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*)(alphaInput + i))) : opaque;
+
+            __m128i firstThird = _mm_packus_epi16(first, third);
+            __m128i greenAlpha = _mm_packus_epi16(green, alpha);
+            __m128i firstGreen = _mm_unpacklo_epi8(firstThird, greenAlpha);
+            __m128i thirdAlpha = _mm_unpackhi_epi8(firstThird, greenAlpha);
+
+            _mm_storeu_si128((__m128i*)(output + i * 4), _mm_unpacklo_epi16(firstGreen, thirdAlpha));
+            _mm_storeu_si128((__m128i*)(output + i * 4 + 16), _mm_unpackhi_epi16(firstGreen, thirdAlpha));
+        }
+
+        ConvertUYVYtoBGRA_Scalar<Rgba, UseAlphaPlane>(input + i * 2, UseAlphaPlane ? alphaInput + i : nullptr, output + i * 4, pixelCount - i, coefficients);
+    }
+
+    // 16 pixels per iteration, each 128 bit lane holds 8 pixels.
+    template <bool Rgba, bool UseAlphaPlane>
+    SV_TARGET_AVX2 static void ConvertUYVYtoBGRA_AVX2(const uint8_t* input, const uint8_t* alphaInput, uint8_t* output, int pixelCount, const YUVCoefficients& coefficients)
+    {
+        const __m256i lowByteMask = _mm256_set1_epi16(0x00FF);
+        const __m256i lumaOffset = _mm256_set1_epi16(coefficients.lumaOffset);
+        const __m256i chromaOffset = _mm256_set1_epi16(128);
+        const __m256i lumaCoefficient = _mm256_set1_epi16(coefficients.lumaScale);
+        const __m256i rounding = _mm256_set1_epi32(128);
+        const __m256i opaque = _mm256_set1_epi16(255);
+
+        const __m256i redCoefficients = _mm256_set1_epi32(ChromaPair(0, coefficients.redV));
+        const __m256i greenCoefficients = _mm256_set1_epi32(ChromaPair(coefficients.greenU, coefficients.greenV));
+        const __m256i blueCoefficients = _mm256_set1_epi32(ChromaPair(coefficients.blueU, 0));
+        const __m256i firstCoefficients = Rgba ? redCoefficients : blueCoefficients;
+        const __m256i thirdCoefficients = Rgba ? blueCoefficients : redCoefficients;
+
+        int i = 0;
+        for (; i + 16 <= pixelCount; i += 16)
+        {
+            __m256i src = _mm256_loadu_si256((const __m256i*)(input + i * 2));
+            __m256i c = _mm256_sub_epi16(_mm256_srli_epi16(src, 8), lumaOffset);
+            __m256i de = _mm256_sub_epi16(_mm256_and_si256(src, lowByteMask), chromaOffset);
+
+            __m256i lumaLow = _mm256_mullo_epi16(c, lumaCoefficient);
+            __m256i lumaHigh = _mm256_mulhi_epi16(c, lumaCoefficient);
+            __m256i luma0 = _mm256_unpacklo_epi16(lumaLow, lumaHigh);
+            __m256i luma1 = _mm256_unpackhi_epi16(lumaLow, lumaHigh);
+
+            __m256i first = CombineAVX2(luma0, luma1, _mm256_add_epi32(_mm256_madd_epi16(de, firstCoefficients), rounding));
+            __m256i green = CombineAVX2(luma0, luma1, _mm256_add_epi32(_mm256_madd_epi16(de, greenCoefficients), rounding));
+            __m256i third = CombineAVX2(luma0, luma1, _mm256_add_epi32(_mm256_madd_epi16(de, thirdCoefficients), rounding));
+            __m256i alpha = UseAlphaPlane ? _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(alphaInput + i))) : opaque;
+
+            __m256i firstThird = _mm256_packus_epi16(first, third);
+            __m256i greenAlpha = _mm256_packus_epi16(green, alpha);
+            __m256i firstGreen = _mm256_unpacklo_epi8(firstThird, greenAlpha);
+            __m256i thirdAlpha = _mm256_unpackhi_epi8(firstThird, greenAlpha);
+            __m256i pixelsLow = _mm256_unpacklo_epi16(firstGreen, thirdAlpha);
+            __m256i pixelsHigh = _mm256_unpackhi_epi16(firstGreen, thirdAlpha);
+
+            // Restore pixel order across the two lanes.
+            _mm256_storeu_si256((__m256i*)(output + i * 4), _mm256_permute2x128_si256(pixelsLow, pixelsHigh, 0x20));
+            _mm256_storeu_si256((__m256i*)(output + i * 4 + 32), _mm256_permute2x128_si256(pixelsLow, pixelsHigh, 0x31));
+        }
+
+        ConvertUYVYtoBGRA_SSE41<Rgba, UseAlphaPlane>(input + i * 2, UseAlphaPlane ? alphaInput + i : nullptr, output + i * 4, pixelCount - i, coefficients);
+    }
+
+    // 16 pixels per iteration.
+    template <bool Rgba, bool UseAlphaPlane>
+    SV_TARGET_SSE41 static void ConvertBGRAtoUYVY_SSE41(const uint8_t* input, uint8_t* output, uint8_t* alphaOut, int pixelCount, const YUVCoefficients& coefficients)
+    {
+        const __m128i lowByteMask = _mm_set1_epi16(0x00FF);
+
+        int i = 0;
+        for (; i + 16 <= pixelCount; i += 16)
+        {
+            __m128i first, green, third, alpha;
+            LoadPlanarSSE(input + i * 4, first, green, third, alpha);
+            __m128i red = Rgba ? first : third;
+            __m128i blue = Rgba ? third : first;
+
+            // Chroma comes from the even pixels, which are the low bytes of each 16 bit lane.
+            __m128i luma = LumaSSE(red, green, blue, coefficients);
+            __m128i chroma = ChromaSSE(_mm_and_si128(red, lowByteMask), _mm_and_si128(green, lowByteMask), _mm_and_si128(blue, lowByteMask), coefficients);
+
+            _mm_storeu_si128((__m128i*)(output + i * 2), _mm_unpacklo_epi8(chroma, luma));
+            _mm_storeu_si128((__m128i*)(output + i * 2 + 16), _mm_unpackhi_epi8(chroma, luma));
+
+            if (UseAlphaPlane)
+            {
+                _mm_storeu_si128((__m128i*)(alphaOut + i), alpha);
+            }
+        }
+
+        ConvertBGRAtoUYVY_Scalar<Rgba, UseAlphaPlane>(input + i * 4, output + i * 2, UseAlphaPlane ? alphaOut + i : nullptr, pixelCount - i, coefficients);
+    }
+
+    // 16 pixels from each row per iteration.
+    template <bool Rgba>
+    SV_TARGET_SSE41 static void ConvertBGRAtoNV12Rows_SSE41(const uint8_t* row0, const uint8_t* row1, uint8_t* luma0, uint8_t* luma1, uint8_t* chroma, int width, const YUVCoefficients& coefficients)
+    {
+        int x = 0;
+        for (; x + 16 <= width; x += 16)
+        {
+            __m128i first0, green0, third0, alpha0;
+            __m128i first1, green1, third1, alpha1;
+            LoadPlanarSSE(row0 + x * 4, first0, green0, third0, alpha0);
+            LoadPlanarSSE(row1 + x * 4, first1, green1, third1, alpha1);
+            __m128i red0 = Rgba ? first0 : third0;
+            __m128i blue0 = Rgba ? third0 : first0;
+            __m128i red1 = Rgba ? first1 : third1;
+            __m128i blue1 = Rgba ? third1 : first1;
+
+            _mm_storeu_si128((__m128i*)(luma0 + x), LumaSSE(red0, green0, blue0, coefficients));
+            _mm_storeu_si128((__m128i*)(luma1 + x), LumaSSE(red1, green1, blue1, coefficients));
+            _mm_storeu_si128((__m128i*)(chroma + x), ChromaSSE(BlockAverageSSE(red0, red1), BlockAverageSSE(green0, green1), BlockAverageSSE(blue0, blue1), coefficients));
+        }
+
+        ConvertBGRAtoNV12Rows_Scalar<Rgba>(row0 + x * 4, row1 + x * 4, luma0 + x, luma1 + x, chroma + x, width - x, coefficients);
+    }
+
+    // 32 pixels per iteration.
+    template <bool Rgba, bool UseAlphaPlane>
+    SV_TARGET_AVX2 static void ConvertBGRAtoUYVY_AVX2(const uint8_t* input, uint8_t* output, uint8_t* alphaOut, int pixelCount, const YUVCoefficients& coefficients)
+    {
+        const __m256i lowByteMask = _mm256_set1_epi16(0x00FF);
+
+        int i = 0;
+        for (; i + 32 <= pixelCount; i += 32)
+        {
+            __m256i first, green, third, alpha;
+            LoadPlanarAVX2(input + i * 4, first, green, third, alpha);
+            __m256i red = Rgba ? first : third;
+            __m256i blue = Rgba ? third : first;
+
+            __m256i luma = LumaAVX2(red, green, blue, coefficients);
+            __m256i chroma = ChromaAVX2(_mm256_and_si256(red, lowByteMask), _mm256_and_si256(green, lowByteMask), _mm256_and_si256(blue, lowByteMask), coefficients);
+            __m256i pixelsLow = _mm256_unpacklo_epi8(chroma, luma);
+            __m256i pixelsHigh = _mm256_unpackhi_epi8(chroma, luma);
+
+            _mm256_storeu_si256((__m256i*)(output + i * 2), _mm256_permute2x128_si256(pixelsLow, pixelsHigh, 0x20));
+            _mm256_storeu_si256((__m256i*)(output + i * 2 + 32), _mm256_permute2x128_si256(pixelsLow, pixelsHigh, 0x31));
+
+            if (UseAlphaPlane)
+            {
+                _mm256_storeu_si256((__m256i*)(alphaOut + i), alpha);
+            }
+        }
+
+        ConvertBGRAtoUYVY_SSE41<Rgba, UseAlphaPlane>(input + i * 4, output + i * 2, UseAlphaPlane ? alphaOut + i : nullptr, pixelCount - i, coefficients);
+    }
+
+    // 32 pixels from each row per iteration.
+    template <bool Rgba>
+    SV_TARGET_AVX2 static void ConvertBGRAtoNV12Rows_AVX2(const uint8_t* row0, const uint8_t* row1, uint8_t* luma0, uint8_t* luma1, uint8_t* chroma, int width, const YUVCoefficients& coefficients)
+    {
+        int x = 0;
+        for (; x + 32 <= width; x += 32)
+        {
+            __m256i first0, green0, third0, alpha0;
+            __m256i first1, green1, third1, alpha1;
+            LoadPlanarAVX2(row0 + x * 4, first0, green0, third0, alpha0);
+            LoadPlanarAVX2(row1 + x * 4, first1, green1, third1, alpha1);
+            __m256i red0 = Rgba ? first0 : third0;
+            __m256i blue0 = Rgba ? third0 : first0;
+            __m256i red1 = Rgba ? first1 : third1;
+            __m256i blue1 = Rgba ? third1 : first1;
+
+            _mm256_storeu_si256((__m256i*)(luma0 + x), LumaAVX2(red0, green0, blue0, coefficients));
+            _mm256_storeu_si256((__m256i*)(luma1 + x), LumaAVX2(red1, green1, blue1, coefficients));
+            _mm256_storeu_si256((__m256i*)(chroma + x), ChromaAVX2(BlockAverageAVX2(red0, red1), BlockAverageAVX2(green0, green1), BlockAverageAVX2(blue0, blue1), coefficients));
+        }
+
+        ConvertBGRAtoNV12Rows_SSE41<Rgba>(row0 + x * 4, row1 + x * 4, luma0 + x, luma1 + x, chroma + x, width - x, coefficients);
+    }
+#endif
+
+#if defined(SV_SIMD_NEON)
+    // 16 pixels per iteration, even and odd pixels are computed separately and zipped on store.
+    template <bool Rgba, bool UseAlphaPlane>
+    static void ConvertUYVYtoBGRA_NEON(const uint8_t* input, const uint8_t* alphaInput, uint8_t* output, int pixelCount, const YUVCoefficients& coefficients)
+    {
+        const uint8x8_t lumaOffset = vdup_n_u8((uint8_t)coefficients.lumaOffset);
+        const uint8x8_t chromaOffset = vdup_n_u8(128);
+        const int32x4_t rounding = vdupq_n_s32(128);
+        const uint8x8_t opaque = vdup_n_u8(255);
+
+        int i = 0;
+        for (; i + 16 <= pixelCount; i += 16)
+        {
+            uint8x8x4_t src = vld4_u8(input + i * 2);
+            int16x8_t d = vreinterpretq_s16_u16(vsubl_u8(src.val[0], chromaOffset));
+            int16x8_t e = vreinterpretq_s16_u16(vsubl_u8(src.val[2], chromaOffset));
+            int16x8_t cEven = vreinterpretq_s16_u16(vsubl_u8(src.val[1], lumaOffset));
+            int16x8_t cOdd = vreinterpretq_s16_u16(vsubl_u8(src.val[3], lumaOffset));
+
+            int32x4_t redLow = vmlal_n_s16(rounding, vget_low_s16(e), coefficients.redV);
+            int32x4_t redHigh = vmlal_n_s16(rounding, vget_high_s16(e), coefficients.redV);
+            int32x4_t greenLow = vmlal_n_s16(vmlal_n_s16(rounding, vget_low_s16(d), coefficients.greenU), vget_low_s16(e), coefficients.greenV);
+            int32x4_t greenHigh = vmlal_n_s16(vmlal_n_s16(rounding, vget_high_s16(d), coefficients.greenU), vget_high_s16(e), coefficients.greenV);
+            int32x4_t blueLow = vmlal_n_s16(rounding, vget_low_s16(d), coefficients.blueU);
+            int32x4_t blueHigh = vmlal_n_s16(rounding, vget_high_s16(d), coefficients.blueU);
+
+            uint8x8x2_t red = vzip_u8(CombineNEON(cEven, redLow, redHigh, coefficients.lumaScale), CombineNEON(cOdd, redLow, redHigh, coefficients.lumaScale));
+            uint8x8x2_t green = vzip_u8(CombineNEON(cEven, greenLow, greenHigh, coefficients.lumaScale), CombineNEON(cOdd, greenLow, greenHigh, coefficients.lumaScale));
+            uint8x8x2_t blue = vzip_u8(CombineNEON(cEven, blueLow, blueHigh, coefficients.lumaScale), CombineNEON(cOdd, blueLow, blueHigh, coefficients.lumaScale));
+
+            for (int half = 0; half < 2; half++)
+            {
+                uint8x8x4_t dst;
+                dst.val[0] = Rgba ? red.val[half] : blue.val[half];
+                dst.val[1] = green.val[half];
+                dst.val[2] = Rgba ? blue.val[half] : red.val[half];
+                dst.val[3] = UseAlphaPlane ? vld1_u8(alphaInput + i + half * 8) : opaque;
+                vst4_u8(output + (i + half * 8) * 4, dst);
+            }
+        }
+
+        ConvertUYVYtoBGRA_Scalar<Rgba, UseAlphaPlane>(input + i * 2, UseAlphaPlane ? alphaInput + i : nullptr, output + i * 4, pixelCount - i, coefficients);
+    }
+    // 16 pixels per iteration.
+    template <bool Rgba, bool UseAlphaPlane>
+    static void ConvertBGRAtoUYVY_NEON(const uint8_t* input, uint8_t* output, uint8_t* alphaOut, int pixelCount, const YUVCoefficients& coefficients)
+    {
+        const uint16x8_t lowByteMask = vdupq_n_u16(0x00FF);
+
+        int i = 0;
+        for (; i + 16 <= pixelCount; i += 16)
+        {
+            uint8x16x4_t src = vld4q_u8(input + i * 4);
+            uint8x16_t red = Rgba ? src.val[0] : src.val[2];
+            uint8x16_t blue = Rgba ? src.val[2] : src.val[0];
+
+            uint16x8_t luma = vreinterpretq_u16_u8(LumaNEON(red, src.val[1], blue, coefficients));
+            uint8x8x2_t chroma = ChromaNEON(
+                vandq_u16(vreinterpretq_u16_u8(red), lowByteMask),
+                vandq_u16(vreinterpretq_u16_u8(src.val[1]), lowByteMask),
+                vandq_u16(vreinterpretq_u16_u8(blue), lowByteMask), coefficients);
+
+            uint8x8x4_t dst;
+            dst.val[0] = chroma.val[0];
+            dst.val[1] = vmovn_u16(luma);
+            dst.val[2] = chroma.val[1];
+            dst.val[3] = vshrn_n_u16(luma, 8);
+            vst4_u8(output + i * 2, dst);
+
+            if (UseAlphaPlane)
+            {
+                vst1q_u8(alphaOut + i, src.val[3]);
+            }
+        }
+
+        ConvertBGRAtoUYVY_Scalar<Rgba, UseAlphaPlane>(input + i * 4, output + i * 2, UseAlphaPlane ? alphaOut + i : nullptr, pixelCount - i, coefficients);
+    }
+
+    // 16 pixels from each row per iteration.
+    template <bool Rgba>
+    static void ConvertBGRAtoNV12Rows_NEON(const uint8_t* row0, const uint8_t* row1, uint8_t* luma0, uint8_t* luma1, uint8_t* chroma, int width, const YUVCoefficients& coefficients)
+    {
+        int x = 0;
+        for (; x + 16 <= width; x += 16)
+        {
+            uint8x16x4_t top = vld4q_u8(row0 + x * 4);
+            uint8x16x4_t bottom = vld4q_u8(row1 + x * 4);
+            uint8x16_t red0 = Rgba ? top.val[0] : top.val[2];
+            uint8x16_t blue0 = Rgba ? top.val[2] : top.val[0];
+            uint8x16_t red1 = Rgba ? bottom.val[0] : bottom.val[2];
+            uint8x16_t blue1 = Rgba ? bottom.val[2] : bottom.val[0];
+
+            vst1q_u8(luma0 + x, LumaNEON(red0, top.val[1], blue0, coefficients));
+            vst1q_u8(luma1 + x, LumaNEON(red1, bottom.val[1], blue1, coefficients));
+
+            // Rounded average of each 2x2 block.
+            uint16x8_t red = vrshrq_n_u16(vaddq_u16(vpaddlq_u8(red0), vpaddlq_u8(red1)), 2);
+            uint16x8_t green = vrshrq_n_u16(vaddq_u16(vpaddlq_u8(top.val[1]), vpaddlq_u8(bottom.val[1])), 2);
+            uint16x8_t blue = vrshrq_n_u16(vaddq_u16(vpaddlq_u8(blue0), vpaddlq_u8(blue1)), 2);
+            vst2_u8(chroma + x, ChromaNEON(red, green, blue, coefficients));
+        }
+
+        ConvertBGRAtoNV12Rows_Scalar<Rgba>(row0 + x * 4, row1 + x * 4, luma0 + x, luma1 + x, chroma + x, width - x, coefficients);
+    }
+#endif
+
+private:
+#if defined(SV_SIMD_X86)
+    // Pack a (d, e) coefficient pair for _mm_madd_epi16 against interleaved chroma.
+    static inline int ChromaPair(int16_t dCoefficient, int16_t eCoefficient)
+    {
+        return (int)(((uint32_t)(uint16_t)eCoefficient << 16) | (uint16_t)dCoefficient);
+    }
+
+    // Add the per pixel luma term to the chroma term shared by each pixel pair, then shift and saturate to 16 bit.
+    SV_TARGET_SSE41 static inline __m128i CombineSSE(__m128i luma0, __m128i luma1, __m128i chroma)
+    {
+        __m128i low = _mm_srai_epi32(_mm_add_epi32(luma0, _mm_unpacklo_epi32(chroma, chroma)), 8);
+        __m128i high = _mm_srai_epi32(_mm_add_epi32(luma1, _mm_unpackhi_epi32(chroma, chroma)), 8);
+        return _mm_packs_epi32(low, high);
+    }
+
+    SV_TARGET_AVX2 static inline __m256i CombineAVX2(__m256i luma0, __m256i luma1, __m256i chroma)
+    {
+        __m256i low = _mm256_srai_epi32(_mm256_add_epi32(luma0, _mm256_unpacklo_epi32(chroma, chroma)), 8);
+        __m256i high = _mm256_srai_epi32(_mm256_add_epi32(luma1, _mm256_unpackhi_epi32(chroma, chroma)), 8);
+        return _mm256_packs_epi32(low, high);
+    }
+
+    // Split 16 interleaved 4 byte pixels into one 16 byte register per channel.
+    SV_TARGET_SSE41 static inline void LoadPlanarSSE(const uint8_t* input, __m128i& channel0, __m128i& channel1, __m128i& channel2, __m128i& channel3)
+    {
+        const __m128i groupChannels = _mm_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+
+        __m128i p0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)input), groupChannels);
+        __m128i p1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(input + 16)), groupChannels);
+        __m128i p2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(input + 32)), groupChannels);
+        __m128i p3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(input + 48)), groupChannels);
+
+        __m128i low01 = _mm_unpacklo_epi32(p0, p1);
+        __m128i high01 = _mm_unpackhi_epi32(p0, p1);
+        __m128i low23 = _mm_unpacklo_epi32(p2, p3);
+        __m128i high23 = _mm_unpackhi_epi32(p2, p3);
+
+        channel0 = _mm_unpacklo_epi64(low01, low23);
+        channel1 = _mm_unpackhi_epi64(low01, low23);
+        channel2 = _mm_unpacklo_epi64(high01, high23);
+        channel3 = _mm_unpackhi_epi64(high01, high23);
+    }
+
+    // Y for 16 pixels. The weighted sum never exceeds 16 bits, so unsigned 16 bit math is exact.
+    SV_TARGET_SSE41 static inline __m128i LumaSSE(__m128i red, __m128i green, __m128i blue, const YUVCoefficients& coefficients)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        __m128i low = LumaSumSSE(_mm_unpacklo_epi8(red, zero), _mm_unpacklo_epi8(green, zero), _mm_unpacklo_epi8(blue, zero), coefficients);
+        __m128i high = LumaSumSSE(_mm_unpackhi_epi8(red, zero), _mm_unpackhi_epi8(green, zero), _mm_unpackhi_epi8(blue, zero), coefficients);
+        return _mm_packus_epi16(low, high);
+    }
+
+    SV_TARGET_SSE41 static inline __m128i LumaSumSSE(__m128i red, __m128i green, __m128i blue, const YUVCoefficients& coefficients)
+    {
+        __m128i sum = _mm_add_epi16(_mm_mullo_epi16(red, _mm_set1_epi16(coefficients.yRed)), _mm_mullo_epi16(green, _mm_set1_epi16(coefficients.yGreen)));
+        sum = _mm_add_epi16(sum, _mm_add_epi16(_mm_mullo_epi16(blue, _mm_set1_epi16(coefficients.yBlue)), _mm_set1_epi16(128)));
+        return _mm_add_epi16(_mm_srli_epi16(sum, 8), _mm_set1_epi16(coefficients.lumaOffset));
+    }
+
+    // U and V for 8 pixels given as 16 bit lanes, returned as interleaved UV bytes.
+    // Every partial sum stays within a signed 16 bit range.
+    SV_TARGET_SSE41 static inline __m128i ChromaSSE(__m128i red, __m128i green, __m128i blue, const YUVCoefficients& coefficients)
+    {
+        const __m128i rounding = _mm_set1_epi16(128);
+
+        __m128i u = _mm_add_epi16(_mm_mullo_epi16(red, _mm_set1_epi16(coefficients.uRed)), _mm_mullo_epi16(green, _mm_set1_epi16(coefficients.uGreen)));
+        u = _mm_add_epi16(u, _mm_add_epi16(_mm_mullo_epi16(blue, _mm_set1_epi16(coefficients.uBlue)), rounding));
+        u = _mm_add_epi16(_mm_srai_epi16(u, 8), rounding);
+
+        __m128i v = _mm_add_epi16(_mm_mullo_epi16(red, _mm_set1_epi16(coefficients.vRed)), _mm_mullo_epi16(green, _mm_set1_epi16(coefficients.vGreen)));
+        v = _mm_add_epi16(v, _mm_add_epi16(_mm_mullo_epi16(blue, _mm_set1_epi16(coefficients.vBlue)), rounding));
+        v = _mm_add_epi16(_mm_srai_epi16(v, 8), rounding);
+
+        return _mm_or_si128(u, _mm_slli_epi16(v, 8));
+    }
+
+    // Rounded average of each horizontal pixel pair across two rows, as 16 bit lanes.
+    SV_TARGET_SSE41 static inline __m128i BlockAverageSSE(__m128i row0, __m128i row1)
+    {
+        const __m128i ones = _mm_set1_epi8(1);
+        __m128i sum = _mm_add_epi16(_mm_maddubs_epi16(row0, ones), _mm_maddubs_epi16(row1, ones));
+        return _mm_srli_epi16(_mm_add_epi16(sum, _mm_set1_epi16(2)), 2);
+    }
+
+    // Same as LoadPlanarSSE for 32 pixels. Transposing inside each lane leaves groups of 4 pixels out of order,
+    // the final permute restores them.
+    SV_TARGET_AVX2 static inline void LoadPlanarAVX2(const uint8_t* input, __m256i& channel0, __m256i& channel1, __m256i& channel2, __m256i& channel3)
+    {
+        const __m256i groupChannels = _mm256_setr_epi8(
+            0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15,
+            0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+        const __m256i pixelOrder = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+        __m256i p0 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)input), groupChannels);
+        __m256i p1 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(input + 32)), groupChannels);
+        __m256i p2 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(input + 64)), groupChannels);
+        __m256i p3 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(input + 96)), groupChannels);
+
+        __m256i low01 = _mm256_unpacklo_epi32(p0, p1);
+        __m256i high01 = _mm256_unpackhi_epi32(p0, p1);
+        __m256i low23 = _mm256_unpacklo_epi32(p2, p3);
+        __m256i high23 = _mm256_unpackhi_epi32(p2, p3);
+
+        channel0 = _mm256_permutevar8x32_epi32(_mm256_unpacklo_epi64(low01, low23), pixelOrder);
+        channel1 = _mm256_permutevar8x32_epi32(_mm256_unpackhi_epi64(low01, low23), pixelOrder);
+        channel2 = _mm256_permutevar8x32_epi32(_mm256_unpacklo_epi64(high01, high23), pixelOrder);
+        channel3 = _mm256_permutevar8x32_epi32(_mm256_unpackhi_epi64(high01, high23), pixelOrder);
+    }
+
+    SV_TARGET_AVX2 static inline __m256i LumaAVX2(__m256i red, __m256i green, __m256i blue, const YUVCoefficients& coefficients)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        __m256i low = LumaSumAVX2(_mm256_unpacklo_epi8(red, zero), _mm256_unpacklo_epi8(green, zero), _mm256_unpacklo_epi8(blue, zero), coefficients);
+        __m256i high = LumaSumAVX2(_mm256_unpackhi_epi8(red, zero), _mm256_unpackhi_epi8(green, zero), _mm256_unpackhi_epi8(blue, zero), coefficients);
+        return _mm256_packus_epi16(low, high);
+    }
+
+    SV_TARGET_AVX2 static inline __m256i LumaSumAVX2(__m256i red, __m256i green, __m256i blue, const YUVCoefficients& coefficients)
+    {
+        __m256i sum = _mm256_add_epi16(_mm256_mullo_epi16(red, _mm256_set1_epi16(coefficients.yRed)), _mm256_mullo_epi16(green, _mm256_set1_epi16(coefficients.yGreen)));
+        sum = _mm256_add_epi16(sum, _mm256_add_epi16(_mm256_mullo_epi16(blue, _mm256_set1_epi16(coefficients.yBlue)), _mm256_set1_epi16(128)));
+        return _mm256_add_epi16(_mm256_srli_epi16(sum, 8), _mm256_set1_epi16(coefficients.lumaOffset));
+    }
+
+    SV_TARGET_AVX2 static inline __m256i ChromaAVX2(__m256i red, __m256i green, __m256i blue, const YUVCoefficients& coefficients)
+    {
+        const __m256i rounding = _mm256_set1_epi16(128);
+
+        __m256i u = _mm256_add_epi16(_mm256_mullo_epi16(red, _mm256_set1_epi16(coefficients.uRed)), _mm256_mullo_epi16(green, _mm256_set1_epi16(coefficients.uGreen)));
+        u = _mm256_add_epi16(u, _mm256_add_epi16(_mm256_mullo_epi16(blue, _mm256_set1_epi16(coefficients.uBlue)), rounding));
+        u = _mm256_add_epi16(_mm256_srai_epi16(u, 8), rounding);
+
+        __m256i v = _mm256_add_epi16(_mm256_mullo_epi16(red, _mm256_set1_epi16(coefficients.vRed)), _mm256_mullo_epi16(green, _mm256_set1_epi16(coefficients.vGreen)));
+        v = _mm256_add_epi16(v, _mm256_add_epi16(_mm256_mullo_epi16(blue, _mm256_set1_epi16(coefficients.vBlue)), rounding));
+        v = _mm256_add_epi16(_mm256_srai_epi16(v, 8), rounding);
+
+        return _mm256_or_si256(u, _mm256_slli_epi16(v, 8));
+    }
+
+    SV_TARGET_AVX2 static inline __m256i BlockAverageAVX2(__m256i row0, __m256i row1)
+    {
+        const __m256i ones = _mm256_set1_epi8(1);
+        __m256i sum = _mm256_add_epi16(_mm256_maddubs_epi16(row0, ones), _mm256_maddubs_epi16(row1, ones));
+        return _mm256_srli_epi16(_mm256_add_epi16(sum, _mm256_set1_epi16(2)), 2);
+    }
+#endif
+
+#if defined(SV_SIMD_NEON)
+    static inline uint8x8_t CombineNEON(int16x8_t c, int32x4_t chromaLow, int32x4_t chromaHigh, int16_t lumaScale)
+    {
+        int32x4_t low = vshrq_n_s32(vmlal_n_s16(chromaLow, vget_low_s16(c), lumaScale), 8);
+        int32x4_t high = vshrq_n_s32(vmlal_n_s16(chromaHigh, vget_high_s16(c), lumaScale), 8);
+        return vqmovun_s16(vcombine_s16(vqmovn_s32(low), vqmovn_s32(high)));
+    }
+
+    // Luma coefficients are positive and below 256, so they fit the unsigned 8 bit multiplies.
+    static inline uint8x16_t LumaNEON(uint8x16_t red, uint8x16_t green, uint8x16_t blue, const YUVCoefficients& coefficients)
+    {
+        const uint8x8_t redCoefficient = vdup_n_u8((uint8_t)coefficients.yRed);
+        const uint8x8_t greenCoefficient = vdup_n_u8((uint8_t)coefficients.yGreen);
+        const uint8x8_t blueCoefficient = vdup_n_u8((uint8_t)coefficients.yBlue);
+
+        uint16x8_t low = vmull_u8(vget_low_u8(red), redCoefficient);
+        low = vmlal_u8(low, vget_low_u8(green), greenCoefficient);
+        low = vmlal_u8(low, vget_low_u8(blue), blueCoefficient);
+
+        uint16x8_t high = vmull_u8(vget_high_u8(red), redCoefficient);
+        high = vmlal_u8(high, vget_high_u8(green), greenCoefficient);
+        high = vmlal_u8(high, vget_high_u8(blue), blueCoefficient);
+
+        return vaddq_u8(vcombine_u8(vrshrn_n_u16(low, 8), vrshrn_n_u16(high, 8)), vdupq_n_u8((uint8_t)coefficients.lumaOffset));
+    }
+
+    // U and V for 8 pixels given as 16 bit lanes.
+    static inline uint8x8x2_t ChromaNEON(uint16x8_t red, uint16x8_t green, uint16x8_t blue, const YUVCoefficients& coefficients)
+    {
+        int16x8_t r = vreinterpretq_s16_u16(red);
+        int16x8_t g = vreinterpretq_s16_u16(green);
+        int16x8_t b = vreinterpretq_s16_u16(blue);
+        const int16x8_t offset = vdupq_n_s16(128);
+
+        int16x8_t u = vmlaq_n_s16(vmlaq_n_s16(vmulq_n_s16(r, coefficients.uRed), g, coefficients.uGreen), b, coefficients.uBlue);
+        int16x8_t v = vmlaq_n_s16(vmlaq_n_s16(vmulq_n_s16(r, coefficients.vRed), g, coefficients.vGreen), b, coefficients.vBlue);
+
+        uint8x8x2_t uv;
+        uv.val[0] = vqmovun_s16(vaddq_s16(vrshrq_n_s16(u, 8), offset));
+        uv.val[1] = vqmovun_s16(vaddq_s16(vrshrq_n_s16(v, 8), offset));
+        return uv;
+    }
+#endif
+};
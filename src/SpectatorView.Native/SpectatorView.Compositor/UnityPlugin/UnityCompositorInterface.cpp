@@ -8,6 +8,8 @@
 
 #include "DirectXHelper.h"
 #include "CompositorInterface.h"
+#include "FrameBufferPool.h"
+#include "ThreadRoles.h"
 
 #include "PluginAPI\IUnityInterface.h"
 #include "PluginAPI\IUnityGraphics.h"
@@ -17,95 +19,156 @@
 
 #define UNITYDLL EXTERN_C __declspec(dllexport)
 
-static CompositorInterface* ci = nullptr;
-static bool isRecording = false;
-static bool videoInitialized = false;
-
-static BYTE* colorBytes = new BYTE[FRAME_BUFSIZE_RGBA];
-static BYTE* depthBytes = new BYTE[FRAME_BUFSIZE_DEPTH16];
-static BYTE* bodyMaskBytes = new BYTE[FRAME_BUFSIZE_DEPTH16];
-static BYTE* holoBytes = new BYTE[FRAME_BUFSIZE_RGBA];
-
 #define NUM_VIDEO_BUFFERS 10
 
-static byte** videoBytes = nullptr;
-static int videoBufferIndex = 0;
+// Compositor contexts are addressed by handle. The default context always exists, and the exports that take no handle
+// use it, so a single camera works as before. Every other context is made with CreateCompositorContext.
+#define MAX_COMPOSITOR_CONTEXTS 8
+#define DEFAULT_COMPOSITOR_CONTEXT 0
+
+// Texture initial data, only read while creating textures, so the contexts share it.
+static BYTE* colorBytes = FrameBufferPool::Instance().Acquire(FRAME_BUFSIZE_RGBA);
+static BYTE* depthBytes = FrameBufferPool::Instance().Acquire(FRAME_BUFSIZE_DEPTH16);
+static BYTE* bodyMaskBytes = FrameBufferPool::Instance().Acquire(FRAME_BUFSIZE_DEPTH16);
 
-void AllocateVideoBuffers(VideoRecordingFrameLayout frameLayout)
+// Everything one compositor needs to capture, composite and record a camera. The compositor interface owns the frame
+// provider, with its frame ring and capture threads, and the video encoder, so contexts capture and record side by side.
+struct CompositorContext
 {
-    if (videoBytes != nullptr)
-        return;
+    CompositorInterface* ci = nullptr;
+    bool isRecording = false;
+    bool videoInitialized = false;
+    bool isInitialized = false;
 
-    videoBytes = new byte*[NUM_VIDEO_BUFFERS];
+    BYTE* holoBytes = FrameBufferPool::Instance().Acquire(FRAME_BUFSIZE_RGBA);
+    byte** videoBytes = nullptr;
+    int videoBufferIndex = 0;
 
-    int frameBufferSize;
-    if (frameLayout == VideoRecordingFrameLayout::Quad)
+    ID3D11Texture2D* holoRenderTexture = nullptr;
+
+    ID3D11Texture2D* colorTexture = nullptr;
+    ID3D11Texture2D* depthCameraTexture = nullptr;
+    ID3D11Texture2D* bodyMaskTexture = nullptr;
+    ID3D11Texture2D* compositeTexture = nullptr;
+    ID3D11Texture2D* videoTexture = nullptr;
+    ID3D11Texture2D* outputTexture = nullptr;
+
+    ID3D11ShaderResourceView* unityColorSRV = nullptr;
+    ID3D11ShaderResourceView* unityDepthSRV = nullptr;
+    ID3D11ShaderResourceView* unityBodySRV = nullptr;
+
+    bool takePicture = false;
+    bool takeRawPicture = false;
+    std::wstring rawPicturePath;
+
+    int lastRecordedVideoFrame = -1;
+    int lastVideoFrame = -1;
+    BufferedTextureFetch videoTextureBuffer;
+
+    LONGLONG queuedVideoFrameTime = 0;
+    int queuedVideoFrameCount = 0;
+
+    CompositorInterface* GetCompositor()
+    {
+        if (ci == nullptr)
+        {
+            ci = new CompositorInterface();
+        }
+
+        return ci;
+    }
+
+    void AllocateVideoBuffers(VideoRecordingFrameLayout frameLayout)
     {
+        if (videoBytes != nullptr)
+            return;
+
+        videoBytes = new byte*[NUM_VIDEO_BUFFERS];
+
+        int frameBufferSize;
+        if (frameLayout == VideoRecordingFrameLayout::Quad)
+        {
 #if HARDWARE_ENCODE_VIDEO
-        frameBufferSize = QUAD_FRAME_BUFSIZE_NV12;
+            frameBufferSize = QUAD_FRAME_BUFSIZE_NV12;
 #else
-        frameBufferSize = QUAD_FRAME_BUFSIZE_RGBA;
+            frameBufferSize = QUAD_FRAME_BUFSIZE_RGBA;
 #endif
-    }
-    else
-    {
+        }
+        else
+        {
 #if HARDWARE_ENCODE_VIDEO
-        frameBufferSize = FRAME_BUFSIZE_NV12;
+            frameBufferSize = FRAME_BUFSIZE_NV12;
 #else
-        frameBufferSize = FRAME_BUFSIZE_RGBA;
+            frameBufferSize = FRAME_BUFSIZE_RGBA;
 #endif
-    }
+        }
 
-    for (int i = 0; i < NUM_VIDEO_BUFFERS; i++)
-    {
-        videoBytes[i] = new byte[frameBufferSize];
+        for (int i = 0; i < NUM_VIDEO_BUFFERS; i++)
+        {
+            videoBytes[i] = FrameBufferPool::Instance().Acquire(frameBufferSize);
+        }
     }
-}
-
-void FreeVideoBuffers()
-{
-    if (videoBytes == nullptr)
-        return;
 
-    for (int i = 0; i < NUM_VIDEO_BUFFERS; i++)
+    void FreeVideoBuffers()
     {
-        delete[] videoBytes[i];
-    }
-    delete[] videoBytes;
-    videoBytes = nullptr;
-}
+        if (videoBytes == nullptr)
+            return;
 
+        for (int i = 0; i < NUM_VIDEO_BUFFERS; i++)
+        {
+            FrameBufferPool::Instance().Release(videoBytes[i]);
+        }
+        delete[] videoBytes;
+        videoBytes = nullptr;
+    }
 
-static ID3D11Texture2D* g_holoRenderTexture = nullptr;
+    ~CompositorContext()
+    {
+        if (ci != nullptr)
+        {
+            ci->StopRecording();
+            ci->StopFrameProvider();
+            delete ci;
+            ci = nullptr;
+        }
 
-static ID3D11Texture2D* g_colorTexture = nullptr;
-static ID3D11Texture2D* g_depthCameraTexture = nullptr;
-static ID3D11Texture2D* g_bodyMaskTexture = nullptr;
-static ID3D11Texture2D* g_compositeTexture = nullptr;
-static ID3D11Texture2D* g_videoTexture = nullptr;
-static ID3D11Texture2D* g_outputTexture = nullptr;
+        FreeVideoBuffers();
+        FrameBufferPool::Instance().Release(holoBytes);
+    }
+};
 
-static ID3D11ShaderResourceView* g_UnityColorSRV = nullptr;
-static ID3D11ShaderResourceView* g_UnityDepthSRV = nullptr;
-static ID3D11ShaderResourceView* g_UnityBodySRV = nullptr;
+static CompositorContext* contexts[MAX_COMPOSITOR_CONTEXTS] = {};
 
 static ID3D11Device* g_pD3D11Device = NULL;
 
-static bool takePicture = false;
-static bool takeRawPicture = false;
-static std::wstring rawPicturePath;
-
+// Guards the contexts against the render thread.
 static CRITICAL_SECTION lock;
 
 static IUnityInterfaces *s_UnityInterfaces = nullptr;
 static IUnityGraphics *s_Graphics = nullptr;
 
-static int lastRecordedVideoFrame = -1;
-static int lastVideoFrame = -1;
-static BufferedTextureFetch VideoTextureBuffer;
+// The context for a handle, or nullptr if the handle is not one.
+static CompositorContext* GetContext(int handle)
+{
+    if (handle < 0 || handle >= MAX_COMPOSITOR_CONTEXTS)
+    {
+        return nullptr;
+    }
+
+    if (handle == DEFAULT_COMPOSITOR_CONTEXT && contexts[handle] == nullptr)
+    {
+        contexts[handle] = new CompositorContext();
+    }
 
-static bool isInitialized = false;
+    return contexts[handle];
+}
 
+// The compositor interface of a context, or nullptr if the handle is not a context or the context has none yet.
+static CompositorInterface* GetCompositor(int handle)
+{
+    CompositorContext* context = GetContext(handle);
+    return (context != nullptr) ? context->ci : nullptr;
+}
 
 static void UNITY_INTERFACE_API OnGraphicsDeviceEvent(UnityGfxDeviceEventType eventType)
 {
@@ -121,7 +184,13 @@ static void UNITY_INTERFACE_API OnGraphicsDeviceEvent(UnityGfxDeviceEventType ev
     }
     break;
     case kUnityGfxDeviceEventShutdown:
-        VideoTextureBuffer.ReleaseTextures();
+        for (CompositorContext* context : contexts)
+        {
+            if (context != nullptr)
+            {
+                context->videoTextureBuffer.ReleaseTextures();
+            }
+        }
         g_pD3D11Device = NULL;
         break;
     }
@@ -145,122 +214,163 @@ void UNITY_INTERFACE_API UnityPluginUnload()
 
     DeleteCriticalSection(&lock);
 
-	if (ci != nullptr)
-	{
-		delete ci;
-		ci = nullptr;
-	}
+    for (CompositorContext*& context : contexts)
+    {
+        delete context;
+        context = nullptr;
+    }
 }
 
-UNITYDLL void UpdateCompositor()
+// Returns the handle of a new compositor context, or -1 if every context is in use.
+UNITYDLL int CreateCompositorContext()
+{
+    EnterCriticalSection(&lock);
+
+    int handle = -1;
+    for (int i = 0; i < MAX_COMPOSITOR_CONTEXTS; i++)
+    {
+        if (i != DEFAULT_COMPOSITOR_CONTEXT && contexts[i] == nullptr)
+        {
+            contexts[i] = new CompositorContext();
+            handle = i;
+            break;
+        }
+    }
+
+    LeaveCriticalSection(&lock);
+    return handle;
+}
+
+// Stops the capture and recording of a context made with CreateCompositorContext and frees it.
+UNITYDLL void DestroyCompositorContext(int handle)
 {
-    if (ci == NULL)
+    if (handle == DEFAULT_COMPOSITOR_CONTEXT || GetContext(handle) == nullptr)
     {
         return;
     }
 
-    //Update video encoder
-    ci->Update();
+    EnterCriticalSection(&lock);
+    CompositorContext* context = contexts[handle];
+    contexts[handle] = nullptr;
+    LeaveCriticalSection(&lock);
+
+    delete context;
+}
+
+UNITYDLL int GetMaxCompositorContexts()
+{
+    return MAX_COMPOSITOR_CONTEXTS;
 }
 
-static LONGLONG queuedVideoFrameTime;
-static int queuedVideoFrameCount = 0;
+// Does nothing: recorded frames are written by the encoder thread as they are queued. Kept so scripts that still call it bind.
+UNITYDLL void UpdateCompositorForContext(int /*handle*/)
+{
+}
+
+UNITYDLL void UpdateCompositor()
+{
+    UpdateCompositorForContext(DEFAULT_COMPOSITOR_CONTEXT);
+}
 
-void UpdateVideoRecordingFrame()
+static void UpdateVideoRecordingFrame(CompositorContext* context)
 {
+    CompositorInterface* ci = context->ci;
+
     //We have an old frame, lets get the data and queue it now
-    if (VideoTextureBuffer.IsDataAvailable())
+    if (context->videoTextureBuffer.IsDataAvailable())
     {
-        videoBufferIndex = (videoBufferIndex + 1) % NUM_VIDEO_BUFFERS;
+        context->videoBufferIndex = (context->videoBufferIndex + 1) % NUM_VIDEO_BUFFERS;
 #if HARDWARE_ENCODE_VIDEO
         float bpp = FRAME_BPP_NV12;
 #else
         float bpp = FRAME_BPP_RGBA;
 #endif
 
-        VideoTextureBuffer.FetchTextureData(g_pD3D11Device, videoBytes[videoBufferIndex], bpp);
-        ci->RecordFrameAsync(videoBytes[videoBufferIndex], queuedVideoFrameTime, queuedVideoFrameCount);
+        context->videoTextureBuffer.FetchTextureData(g_pD3D11Device, context->videoBytes[context->videoBufferIndex], bpp);
+        ci->RecordFrameAsync(context->videoBytes[context->videoBufferIndex], context->queuedVideoFrameTime, context->queuedVideoFrameCount);
     }
 
-    if (lastVideoFrame >= 0 && lastRecordedVideoFrame != lastVideoFrame)
+    if (context->lastVideoFrame >= 0 && context->lastRecordedVideoFrame != context->lastVideoFrame)
     {
 #if _DEBUG
-		std::wstring debugString = L"Updating the video recording texture, compositeFrameIndex: " + std::to_wstring(ci->compositeFrameIndex) + L", lastVideoFrame:" + std::to_wstring(lastVideoFrame) + L", lastRecordedVideoFrame: " + std::to_wstring(lastRecordedVideoFrame) + L"\n";
-		OutputDebugString(debugString.data());
+        std::wstring debugString = L"Updating the video recording texture, compositeFrameIndex: " + std::to_wstring(ci->compositeFrameIndex) + L", lastVideoFrame:" + std::to_wstring(context->lastVideoFrame) + L", lastRecordedVideoFrame: " + std::to_wstring(context->lastRecordedVideoFrame) + L"\n";
+        OutputDebugString(debugString.data());
 #endif
 
-        queuedVideoFrameCount = ci->compositeFrameIndex - lastVideoFrame;
-		if (queuedVideoFrameCount <= 0)
-		{
+        context->queuedVideoFrameCount = ci->compositeFrameIndex - context->lastVideoFrame;
+        if (context->queuedVideoFrameCount <= 0)
+        {
 #if _DEBUG
-			debugString = L"compositeFrameIndex less than lastVideoFrame, updating queuedVideoFrameCount to be difference between lastVideoFrame and lastRecordedVideoFrame\n";
-			OutputDebugString(debugString.data());
+            debugString = L"compositeFrameIndex less than lastVideoFrame, updating queuedVideoFrameCount to be difference between lastVideoFrame and lastRecordedVideoFrame\n";
+            OutputDebugString(debugString.data());
 #endif
-			queuedVideoFrameCount = lastVideoFrame - lastRecordedVideoFrame;
-		}
+            context->queuedVideoFrameCount = context->lastVideoFrame - context->lastRecordedVideoFrame;
+        }
 
-		if (queuedVideoFrameCount <= 0)
-		{
+        if (context->queuedVideoFrameCount <= 0)
+        {
 #if _DEBUG
-			debugString = L"lastVideoFrame less than lastRecordedVideoFrame, setting queuedVideoFrameCount to one\n";
-			OutputDebugString(debugString.data());
+            debugString = L"lastVideoFrame less than lastRecordedVideoFrame, setting queuedVideoFrameCount to one\n";
+            OutputDebugString(debugString.data());
 #endif
-			queuedVideoFrameCount = 1;
-		}
+            context->queuedVideoFrameCount = 1;
+        }
 
-        lastRecordedVideoFrame = lastVideoFrame;
-        queuedVideoFrameTime = lastVideoFrame * ci->GetColorDuration();
-        VideoTextureBuffer.PrepareTextureFetch(g_pD3D11Device, g_videoTexture);
+        context->lastRecordedVideoFrame = context->lastVideoFrame;
+        context->queuedVideoFrameTime = context->lastVideoFrame * ci->GetColorDuration();
+        context->videoTextureBuffer.PrepareTextureFetch(g_pD3D11Device, context->videoTexture);
     }
 
-    lastVideoFrame = ci->compositeFrameIndex;
+    context->lastVideoFrame = ci->compositeFrameIndex;
 }
 
-// Plugin function to handle a specific rendering event
-static void __stdcall OnRenderEvent(int eventID)
+// Plugin function to handle a rendering event for the context whose handle is the event id
+static void __stdcall OnContextRenderEvent(int eventID)
 {
+    EnterCriticalSection(&lock);
+
+    CompositorContext* context = GetContext(eventID);
+    CompositorInterface* ci = (context != nullptr) ? context->ci : nullptr;
     if (ci == nullptr)
     {
+        LeaveCriticalSection(&lock);
         return;
     }
 
     //  Update hologram texture from the spectator view camera.
     ci->UpdateFrameProvider();
 
-    EnterCriticalSection(&lock);
-
     if (g_pD3D11Device != nullptr)
     {
-        if (!videoInitialized && ci != nullptr)
+        if (!context->videoInitialized)
         {
-            videoInitialized = ci->InitializeVideoEncoder(g_pD3D11Device);
+            context->videoInitialized = ci->InitializeVideoEncoder(g_pD3D11Device);
         }
 
-        if (isRecording &&
-            g_videoTexture != nullptr)
+        if (context->isRecording &&
+            context->videoTexture != nullptr)
         {
-            UpdateVideoRecordingFrame();
+            UpdateVideoRecordingFrame(context);
         }
 
-        if (takePicture && g_colorTexture != nullptr)
+        if (context->takePicture && context->colorTexture != nullptr)
         {
-            takePicture = false;
+            context->takePicture = false;
 
-            DirectXHelper::GetBytesFromTexture(g_pD3D11Device, g_compositeTexture, FRAME_BPP_RGBA, holoBytes);
-
-            DirectXHelper::FlipHorizontally(holoBytes, FRAME_HEIGHT, FRAME_WIDTH * FRAME_BPP_RGBA);
-            ci->TakePicture(g_pD3D11Device, FRAME_WIDTH, FRAME_HEIGHT, FRAME_BPP_RGBA, holoBytes);
+            // Read back straight into bottom-up row order instead of flipping the photo in a second pass.
+            DirectXHelper::GetBytesFromTexture(g_pD3D11Device, context->compositeTexture, ImageView(context->holoBytes, FRAME_WIDTH, FRAME_HEIGHT, ImageFormat::RGBA).FlippedVertically());
+            ci->TakePicture(g_pD3D11Device, FRAME_WIDTH, FRAME_HEIGHT, FRAME_BPP_RGBA, context->holoBytes);
         }
 
-        if (takeRawPicture && g_colorTexture != nullptr)
+        if (context->takeRawPicture && context->colorTexture != nullptr)
         {
-            takeRawPicture = false;
+            context->takeRawPicture = false;
 
-            DirectXHelper::GetBytesFromTexture(g_pD3D11Device, g_compositeTexture, FRAME_BPP_RGBA, holoBytes);
+            DirectXHelper::GetBytesFromTexture(g_pD3D11Device, context->compositeTexture, FRAME_BPP_RGBA, context->holoBytes);
 
             std::ofstream strm;
-            strm.open(rawPicturePath, std::ios::out | std::ios::binary | std::ios::trunc);
-            strm.write((const char*)(holoBytes), FRAME_BUFSIZE_RGBA);
+            strm.open(context->rawPicturePath, std::ios::out | std::ios::binary | std::ios::trunc);
+            strm.write((const char*)(context->holoBytes), FRAME_BUFSIZE_RGBA);
             strm.close();
         }
     }
@@ -268,8 +378,15 @@ static void __stdcall OnRenderEvent(int eventID)
     LeaveCriticalSection(&lock);
 }
 
-UNITYDLL LONGLONG GetColorDuration()
+// Plugin function to handle a specific rendering event
+static void __stdcall OnRenderEvent(int eventID)
+{
+    OnContextRenderEvent(DEFAULT_COMPOSITOR_CONTEXT);
+}
+
+UNITYDLL LONGLONG GetColorDurationForContext(int handle)
 {
+    CompositorInterface* ci = GetCompositor(handle);
     if (ci != nullptr)
     {
         return ci->GetColorDuration();
@@ -278,8 +395,14 @@ UNITYDLL LONGLONG GetColorDuration()
     return (LONGLONG)((1.0f / 30.0f) * QPC_MULTIPLIER);
 }
 
-UNITYDLL int GetCaptureFrameIndex()
+UNITYDLL LONGLONG GetColorDuration()
+{
+    return GetColorDurationForContext(DEFAULT_COMPOSITOR_CONTEXT);
+}
+
+UNITYDLL int GetCaptureFrameIndexForContext(int handle)
 {
+    CompositorInterface* ci = GetCompositor(handle);
     if (ci != nullptr)
     {
         return ci->GetCaptureFrameIndex();
@@ -288,8 +411,72 @@ UNITYDLL int GetCaptureFrameIndex()
     return 0;
 }
 
-UNITYDLL int GetPixelChange(int frame)
+UNITYDLL int GetCaptureFrameIndex()
+{
+    return GetCaptureFrameIndexForContext(DEFAULT_COMPOSITOR_CONTEXT);
+}
+
+UNITYDLL LONGLONG GetCaptureFrameTimestampForContext(int handle, int frame)
 {
+    CompositorInterface* ci = GetCompositor(handle);
+    if (ci != nullptr)
+    {
+        return ci->GetTimestamp(frame);
+    }
+
+    return INVALID_TIMESTAMP;
+}
+
+UNITYDLL LONGLONG GetCaptureFrameTimestamp(int frame)
+{
+    return GetCaptureFrameTimestampForContext(DEFAULT_COMPOSITOR_CONTEXT, frame);
+}
+
+UNITYDLL int GetFrameNearestTimestampForContext(int handle, LONGLONG timestamp, int* earlierFrame, int* laterFrame)
+{
+    CompositorInterface* ci = GetCompositor(handle);
+    if (ci != nullptr)
+    {
+        return ci->GetFrameNearestTimestamp(timestamp, earlierFrame, laterFrame);
+    }
+
+    if (earlierFrame != nullptr)
+    {
+        *earlierFrame = 0;
+    }
+
+    if (laterFrame != nullptr)
+    {
+        *laterFrame = 0;
+    }
+
+    return 0;
+}
+
+UNITYDLL int GetFrameNearestTimestamp(LONGLONG timestamp, int* earlierFrame, int* laterFrame)
+{
+    return GetFrameNearestTimestampForContext(DEFAULT_COMPOSITOR_CONTEXT, timestamp, earlierFrame, laterFrame);
+}
+
+UNITYDLL bool GetTimestampClockFitForContext(int handle, int* samples, double* driftPpm, double* residualMicroseconds)
+{
+    CompositorInterface* ci = GetCompositor(handle);
+    ClockDomainFit fit = {};
+    bool mapped = ci != nullptr && ci->GetTimestampClockFit(&fit);
+    *samples = fit.samples;
+    *driftPpm = fit.driftPpm;
+    *residualMicroseconds = fit.residualMicroseconds;
+    return mapped;
+}
+
+UNITYDLL bool GetTimestampClockFit(int* samples, double* driftPpm, double* residualMicroseconds)
+{
+    return GetTimestampClockFitForContext(DEFAULT_COMPOSITOR_CONTEXT, samples, driftPpm, residualMicroseconds);
+}
+
+UNITYDLL int GetPixelChangeForContext(int handle, int frame)
+{
+    CompositorInterface* ci = GetCompositor(handle);
     if (ci != nullptr)
     {
         return ci->GetPixelChange(frame);
@@ -298,8 +485,14 @@ UNITYDLL int GetPixelChange(int frame)
     return 0;
 }
 
-UNITYDLL int GetNumQueuedOutputFrames()
+UNITYDLL int GetPixelChange(int frame)
+{
+    return GetPixelChangeForContext(DEFAULT_COMPOSITOR_CONTEXT, frame);
+}
+
+UNITYDLL int GetNumQueuedOutputFramesForContext(int handle)
 {
+    CompositorInterface* ci = GetCompositor(handle);
     if (ci != nullptr)
     {
         return ci->GetNumQueuedOutputFrames();
@@ -308,22 +501,121 @@ UNITYDLL int GetNumQueuedOutputFrames()
     return 0;
 }
 
-UNITYDLL void SetLatencyPreference(float latencyPreference)
+UNITYDLL int GetNumQueuedOutputFrames()
 {
+    return GetNumQueuedOutputFramesForContext(DEFAULT_COMPOSITOR_CONTEXT);
+}
+
+UNITYDLL void SetLatencyPreferenceForContext(int handle, float latencyPreference)
+{
+    CompositorInterface* ci = GetCompositor(handle);
     if (ci != nullptr)
     {
         ci->SetLatencyPreference(latencyPreference);
     }
 }
 
-UNITYDLL void SetCompositeFrameIndex(int index)
+UNITYDLL void SetLatencyPreference(float latencyPreference)
+{
+    SetLatencyPreferenceForContext(DEFAULT_COMPOSITOR_CONTEXT, latencyPreference);
+}
+
+// policy 0 makes recording wait for the encoder once capacity frames and audio buffers are queued, 1 drops the oldest.
+UNITYDLL void SetEncoderQueuePolicyForContext(int handle, int policy, int capacity)
+{
+    CompositorContext* context = GetContext(handle);
+    if (context != nullptr)
+    {
+        context->GetCompositor()->SetEncoderQueuePolicy((policy == (int)QueueFullPolicy::DropOldest) ? QueueFullPolicy::DropOldest : QueueFullPolicy::Block, capacity);
+    }
+}
+
+UNITYDLL void SetEncoderQueuePolicy(int policy, int capacity)
+{
+    SetEncoderQueuePolicyForContext(DEFAULT_COMPOSITOR_CONTEXT, policy, capacity);
+}
+
+// Counters of the recording encoder's queue since recording started, false if the context is not recording.
+UNITYDLL bool GetEncoderQueueStatsForContext(int handle, int* depth, int* peakDepth, LONGLONG* dropped, LONGLONG* stalls, double* stallMilliseconds)
+{
+    CompositorInterface* ci = GetCompositor(handle);
+    BoundedQueueStats stats = {};
+    bool recording = ci != nullptr && ci->GetEncoderQueueStats(&stats);
+    *depth = stats.depth;
+    *peakDepth = stats.peakDepth;
+    *dropped = (LONGLONG)stats.dropped;
+    *stalls = (LONGLONG)stats.stalls;
+    *stallMilliseconds = stats.stallMilliseconds;
+    return recording;
+}
+
+UNITYDLL bool GetEncoderQueueStats(int* depth, int* peakDepth, LONGLONG* dropped, LONGLONG* stalls, double* stallMilliseconds)
+{
+    return GetEncoderQueueStatsForContext(DEFAULT_COMPOSITOR_CONTEXT, depth, peakDepth, dropped, stalls, stallMilliseconds);
+}
+
+// 0 weaves fields as captured, 1 bobs each field to a frame of its own, 2 is motion adaptive.
+UNITYDLL void SetDeinterlaceModeForContext(int handle, int mode)
+{
+    CompositorInterface* ci = GetCompositor(handle);
+    if (ci != nullptr)
+    {
+        ci->SetDeinterlaceMode((DeinterlaceMode)mode);
+    }
+}
+
+UNITYDLL void SetDeinterlaceMode(int mode)
+{
+    SetDeinterlaceModeForContext(DEFAULT_COMPOSITOR_CONTEXT, mode);
+}
+
+// Number of threads that help with CPU pixel conversions, 0 runs them on the calling thread and -1 restores the default.
+// The workers are shared by every context.
+UNITYDLL void SetConversionWorkerCount(int workerCount)
+{
+    DirectXHelper::SetConversionWorkerCount(workerCount);
+}
+
+// Scheduling for the threads of a ThreadRole: capture 0, transform 1, detect 2, encode 3 and I/O 4.
+// priority is a THREAD_PRIORITY_ value, affinityMask 0 allows any processor, and mmcssTask is none 0, Capture 1 or Playback 2.
+UNITYDLL void SetThreadRoleScheduling(int role, int priority, ULONGLONG affinityMask, int mmcssTask)
+{
+    ThreadRoleSettings settings;
+    settings.priority = priority;
+    settings.affinityMask = affinityMask;
+    settings.mmcssTask = (mmcssTask == (int)MmcssTask::Capture || mmcssTask == (int)MmcssTask::Playback) ? (MmcssTask)mmcssTask : MmcssTask::None;
+    ThreadRoles::Instance().Configure((ThreadRole)role, settings);
+}
+
+// Back frame buffers allocated from now on with large pages. Returns false if the process may not lock memory.
+UNITYDLL bool SetUseLargePageFrameBuffers(bool enable)
+{
+    return FrameBufferPool::Instance().SetUseLargePages(enable);
+}
+
+// Bytes of frame buffers acquired, and owned by the pool including free ones.
+UNITYDLL void GetFrameBufferPoolUsage(LONGLONG* bytesInUse, LONGLONG* bytesReserved)
+{
+    FrameBufferPoolStats stats = FrameBufferPool::Instance().GetStats();
+    *bytesInUse = (LONGLONG)stats.bytesInUse;
+    *bytesReserved = (LONGLONG)stats.bytesReserved;
+}
+
+UNITYDLL void SetCompositeFrameIndexForContext(int handle, int index)
 {
+    CompositorInterface* ci = GetCompositor(handle);
     if (ci != nullptr)
         return ci->SetCompositeFrameIndex(index);
 }
 
-UNITYDLL bool IsCameraCalibrationInformationAvailable()
+UNITYDLL void SetCompositeFrameIndex(int index)
+{
+    SetCompositeFrameIndexForContext(DEFAULT_COMPOSITOR_CONTEXT, index);
+}
+
+UNITYDLL bool IsCameraCalibrationInformationAvailableForContext(int handle)
 {
+    CompositorInterface* ci = GetCompositor(handle);
     if (ci != nullptr)
     {
         return ci->IsCameraCalibrationInformationAvailable();
@@ -334,20 +626,37 @@ UNITYDLL bool IsCameraCalibrationInformationAvailable()
     }
 }
 
-UNITYDLL void GetCameraCalibrationInformation(CameraIntrinsics* cameraIntrinsics)
+UNITYDLL bool IsCameraCalibrationInformationAvailable()
+{
+    return IsCameraCalibrationInformationAvailableForContext(DEFAULT_COMPOSITOR_CONTEXT);
+}
+
+UNITYDLL void GetCameraCalibrationInformationForContext(int handle, CameraIntrinsics* cameraIntrinsics)
 {
+    CompositorInterface* ci = GetCompositor(handle);
     if (ci != nullptr)
     {
         ci->GetCameraCalibrationInformation(cameraIntrinsics);
     }
 }
 
+UNITYDLL void GetCameraCalibrationInformation(CameraIntrinsics* cameraIntrinsics)
+{
+    GetCameraCalibrationInformationForContext(DEFAULT_COMPOSITOR_CONTEXT, cameraIntrinsics);
+}
+
 // Function to pass a callback to plugin-specific scripts
 EXTERN_C UnityRenderingEvent __declspec(dllexport) __stdcall GetRenderEventFunc()
 {
     return OnRenderEvent;
 }
 
+// Like GetRenderEventFunc, for contexts: issue the event with the handle of the context as its id.
+EXTERN_C UnityRenderingEvent __declspec(dllexport) __stdcall GetContextRenderEventFunc()
+{
+    return OnContextRenderEvent;
+}
+
 UNITYDLL int GetFrameWidth()
 {
     return FRAME_WIDTH;
@@ -384,139 +693,197 @@ UNITYDLL int GetVideoRecordingFrameHeight(VideoRecordingFrameLayout frameLayout)
 
 UNITYDLL bool IsFrameProviderSupported(int providerId)
 {
-	if (ci == nullptr)
-	{
-		ci = new CompositorInterface();
-	}
-
-	return ci->IsFrameProviderSupported((IFrameProvider::ProviderType) providerId);
+    return GetContext(DEFAULT_COMPOSITOR_CONTEXT)->GetCompositor()->IsFrameProviderSupported((IFrameProvider::ProviderType) providerId);
 }
 
 UNITYDLL bool IsOutputFrameProviderSupported(int providerId)
 {
-	if (ci == nullptr)
-	{
-		ci = new CompositorInterface();
-	}
-
-	return ci->IsOutputFrameProviderSupported((IFrameProvider::ProviderType) providerId);
+    return GetContext(DEFAULT_COMPOSITOR_CONTEXT)->GetCompositor()->IsOutputFrameProviderSupported((IFrameProvider::ProviderType) providerId);
 }
 
 UNITYDLL bool IsOcclusionSettingSupported(int setting)
 {
-    if (ci == nullptr)
+    return GetContext(DEFAULT_COMPOSITOR_CONTEXT)->GetCompositor()->IsOcclusionSettingSupported((IFrameProvider::OcclusionSetting) setting);
+}
+
+// Which camera of the provider type the context captures from, when several are connected, starting at 0.
+// Call before InitializeFrameProviderOnDeviceForContext.
+UNITYDLL void SetCaptureDeviceIndexForContext(int handle, int deviceIndex)
+{
+    CompositorContext* context = GetContext(handle);
+    if (context != nullptr)
     {
-        ci = new CompositorInterface();
+        context->GetCompositor()->SetCaptureDeviceIndex(deviceIndex);
     }
-
-    return ci->IsOcclusionSettingSupported((IFrameProvider::OcclusionSetting) setting);
 }
 
-UNITYDLL bool InitializeFrameProviderOnDevice(int providerId, int outputProviderId)
+UNITYDLL bool InitializeFrameProviderOnDeviceForContext(int handle, int providerId, int outputProviderId)
 {
-    if (g_outputTexture == nullptr ||
-        g_UnityColorSRV == nullptr ||
+    CompositorContext* context = GetContext(handle);
+    if (context == nullptr ||
+        context->outputTexture == nullptr ||
+        context->unityColorSRV == nullptr ||
         g_pD3D11Device == nullptr)
     {
         return false;
     }
 
-    if (isInitialized)
+    if (context->isInitialized)
     {
         return true;
     }
 
-    if (ci == nullptr)
-    {
-        ci = new CompositorInterface();
-    }
-
+    CompositorInterface* ci = context->GetCompositor();
     ci->SetFrameProvider((IFrameProvider::ProviderType) providerId);
     ci->SetOutputFrameProvider((IFrameProvider::ProviderType) outputProviderId);
-    isInitialized = ci->Initialize(g_pD3D11Device, g_UnityColorSRV, g_UnityDepthSRV, g_UnityBodySRV, g_outputTexture);
+    context->isInitialized = ci->Initialize(g_pD3D11Device, context->unityColorSRV, context->unityDepthSRV, context->unityBodySRV, context->outputTexture);
 
-    return isInitialized;
+    return context->isInitialized;
 }
 
-UNITYDLL void StopFrameProvider()
+UNITYDLL bool InitializeFrameProviderOnDevice(int providerId, int outputProviderId)
 {
-    if (ci != NULL)
+    return InitializeFrameProviderOnDeviceForContext(DEFAULT_COMPOSITOR_CONTEXT, providerId, outputProviderId);
+}
+
+UNITYDLL void StopFrameProviderForContext(int handle)
+{
+    CompositorContext* context = GetContext(handle);
+    if (context == nullptr)
     {
-        ci->StopFrameProvider();
+        return;
     }
 
-    FreeVideoBuffers();
+    if (context->ci != NULL)
+    {
+        context->ci->StopFrameProvider();
+    }
+
+    context->FreeVideoBuffers();
 }
 
-UNITYDLL void SetAudioData(BYTE* audioData, int audioSize, double audioTime)
+UNITYDLL void StopFrameProvider()
+{
+    StopFrameProviderForContext(DEFAULT_COMPOSITOR_CONTEXT);
+}
+
+UNITYDLL void SetAudioDataForContext(int handle, BYTE* audioData, int audioSize, double audioTime)
 {
-    if (!isRecording)
+    CompositorContext* context = GetContext(handle);
+    if (context == nullptr || !context->isRecording)
     {
         return;
     }
-    
+
 #if ENCODE_AUDIO
-    if (ci != nullptr)
+    if (context->ci != nullptr)
     {
-		LONGLONG audioTimeHNS = audioTime * QPC_MULTIPLIER;
-        ci->RecordAudioFrameAsync(audioData, audioTimeHNS, audioSize);
+        LONGLONG audioTimeHNS = audioTime * QPC_MULTIPLIER;
+        context->ci->RecordAudioFrameAsync(audioData, audioTimeHNS, audioSize);
+    }
+#endif
+}
+
+UNITYDLL void SetAudioData(BYTE* audioData, int audioSize, double audioTime)
+{
+    SetAudioDataForContext(DEFAULT_COMPOSITOR_CONTEXT, audioData, audioSize, audioTime);
+}
+
+UNITYDLL void TakePictureForContext(int handle)
+{
+    CompositorContext* context = GetContext(handle);
+    if (context != nullptr)
+    {
+        context->takePicture = true;
     }
-#endif    
 }
 
 UNITYDLL void TakePicture()
 {
-    takePicture = true;
+    TakePictureForContext(DEFAULT_COMPOSITOR_CONTEXT);
+}
 
+UNITYDLL void TakeRawPictureForContext(int handle, LPCWSTR lpFilePath)
+{
+    CompositorContext* context = GetContext(handle);
+    if (context != nullptr)
+    {
+        context->takeRawPicture = true;
+        context->rawPicturePath = lpFilePath;
+    }
 }
 
 UNITYDLL void TakeRawPicture(LPCWSTR lpFilePath)
 {
-    takeRawPicture = true;
-    rawPicturePath = lpFilePath;
+    TakeRawPictureForContext(DEFAULT_COMPOSITOR_CONTEXT, lpFilePath);
 }
 
-UNITYDLL bool StartRecording(VideoRecordingFrameLayout frameLayout, LPCWSTR lpcDesiredFileName, const int desiredFileNameLength, const int inputFileNameLength, LPWSTR lpFileName, int* fileNameLength)
+UNITYDLL bool StartRecordingForContext(int handle, VideoRecordingFrameLayout frameLayout, LPCWSTR lpcDesiredFileName, const int desiredFileNameLength, const int inputFileNameLength, LPWSTR lpFileName, int* fileNameLength)
 {
-    if (videoInitialized && ci != nullptr)
+    CompositorContext* context = GetContext(handle);
+    if (context != nullptr && context->videoInitialized && context->ci != nullptr)
     {
-        lastVideoFrame = -1;
-		lastRecordedVideoFrame = -1;
-        AllocateVideoBuffers(frameLayout);
-        VideoTextureBuffer.ReleaseTextures();
-        VideoTextureBuffer.Reset();
-		isRecording = ci->StartRecording(frameLayout, lpcDesiredFileName, desiredFileNameLength, inputFileNameLength, lpFileName, fileNameLength);
-		return isRecording;
+        context->lastVideoFrame = -1;
+        context->lastRecordedVideoFrame = -1;
+        context->AllocateVideoBuffers(frameLayout);
+        context->videoTextureBuffer.ReleaseTextures();
+        context->videoTextureBuffer.Reset();
+        context->isRecording = context->ci->StartRecording(frameLayout, lpcDesiredFileName, desiredFileNameLength, inputFileNameLength, lpFileName, fileNameLength);
+        return context->isRecording;
     }
 
-	return false;
+    return false;
 }
 
-UNITYDLL void StopRecording()
+UNITYDLL bool StartRecording(VideoRecordingFrameLayout frameLayout, LPCWSTR lpcDesiredFileName, const int desiredFileNameLength, const int inputFileNameLength, LPWSTR lpFileName, int* fileNameLength)
 {
-    if (videoInitialized && ci != nullptr)
+    return StartRecordingForContext(DEFAULT_COMPOSITOR_CONTEXT, frameLayout, lpcDesiredFileName, desiredFileNameLength, inputFileNameLength, lpFileName, fileNameLength);
+}
+
+UNITYDLL void StopRecordingForContext(int handle)
+{
+    CompositorContext* context = GetContext(handle);
+    if (context != nullptr && context->videoInitialized && context->ci != nullptr)
     {
-        ci->StopRecording();
-        FreeVideoBuffers();
-        isRecording = false;
+        context->ci->StopRecording();
+        context->FreeVideoBuffers();
+        context->isRecording = false;
     }
 }
 
+UNITYDLL void StopRecording()
+{
+    StopRecordingForContext(DEFAULT_COMPOSITOR_CONTEXT);
+}
+
+UNITYDLL bool IsRecordingForContext(int handle)
+{
+    CompositorContext* context = GetContext(handle);
+    return context != nullptr && context->isRecording;
+}
+
 UNITYDLL bool IsRecording()
 {
-    return isRecording;
+    return IsRecordingForContext(DEFAULT_COMPOSITOR_CONTEXT);
 }
 
-UNITYDLL void SetAlpha(float alpha)
+UNITYDLL void SetAlphaForContext(int handle, float alpha)
 {
+    CompositorInterface* ci = GetCompositor(handle);
     if (ci != NULL)
     {
         ci->SetAlpha(alpha);
     }
 }
 
-UNITYDLL float GetAlpha()
+UNITYDLL void SetAlpha(float alpha)
+{
+    SetAlphaForContext(DEFAULT_COMPOSITOR_CONTEXT, alpha);
+}
+
+UNITYDLL float GetAlphaForContext(int handle)
 {
+    CompositorInterface* ci = GetCompositor(handle);
     if (ci != NULL)
     {
         return ci->GetAlpha();
@@ -525,29 +892,45 @@ UNITYDLL float GetAlpha()
     return 0;
 }
 
-UNITYDLL void Reset()
+UNITYDLL float GetAlpha()
+{
+    return GetAlphaForContext(DEFAULT_COMPOSITOR_CONTEXT);
+}
+
+UNITYDLL void ResetForContext(int handle)
 {
     EnterCriticalSection(&lock);
-    g_colorTexture = nullptr;
-    g_depthCameraTexture = nullptr;
-    g_bodyMaskTexture = nullptr;
-    g_compositeTexture = nullptr;
-    g_videoTexture = nullptr;
-    g_outputTexture = nullptr;
 
-    g_holoRenderTexture = nullptr;
+    CompositorContext* context = GetContext(handle);
+    if (context != nullptr)
+    {
+        context->colorTexture = nullptr;
+        context->depthCameraTexture = nullptr;
+        context->bodyMaskTexture = nullptr;
+        context->compositeTexture = nullptr;
+        context->videoTexture = nullptr;
+        context->outputTexture = nullptr;
+
+        context->holoRenderTexture = nullptr;
 
-    g_UnityColorSRV = nullptr;
-    g_UnityDepthSRV = nullptr;
-    g_UnityBodySRV = nullptr;
+        context->unityColorSRV = nullptr;
+        context->unityDepthSRV = nullptr;
+        context->unityBodySRV = nullptr;
 
-    isInitialized = false;
+        context->isInitialized = false;
+    }
 
     LeaveCriticalSection(&lock);
 }
 
-UNITYDLL bool ProvidesYUV()
+UNITYDLL void Reset()
+{
+    ResetForContext(DEFAULT_COMPOSITOR_CONTEXT);
+}
+
+UNITYDLL bool ProvidesYUVForContext(int handle)
 {
+    CompositorInterface* ci = GetCompositor(handle);
     if (ci == nullptr)
     {
         return false;
@@ -556,8 +939,14 @@ UNITYDLL bool ProvidesYUV()
     return ci->ProvidesYUV();
 }
 
-UNITYDLL bool ExpectsYUV()
+UNITYDLL bool ProvidesYUV()
+{
+    return ProvidesYUVForContext(DEFAULT_COMPOSITOR_CONTEXT);
+}
+
+UNITYDLL bool ExpectsYUVForContext(int handle)
 {
+    CompositorInterface* ci = GetCompositor(handle);
     if (ci == nullptr)
     {
         return false;
@@ -566,6 +955,11 @@ UNITYDLL bool ExpectsYUV()
     return ci->ExpectsYUV();
 }
 
+UNITYDLL bool ExpectsYUV()
+{
+    return ExpectsYUVForContext(DEFAULT_COMPOSITOR_CONTEXT);
+}
+
 UNITYDLL LONGLONG GetCurrentUnityTime()
 {
     LARGE_INTEGER time;
@@ -579,108 +973,170 @@ UNITYDLL bool HardwareEncodeVideo()
 }
 
 #pragma region CreateExternalTextures
-UNITYDLL bool SetHoloTexture(ID3D11Texture2D* holoTexture)
+UNITYDLL bool SetHoloTextureForContext(int handle, ID3D11Texture2D* holoTexture)
 {
+    CompositorContext* context = GetContext(handle);
+    if (context == nullptr)
+    {
+        return false;
+    }
+
     // We have already set a texture ptr.
-    if (g_compositeTexture != nullptr)
+    if (context->compositeTexture == nullptr)
     {
-        return true;
+        context->compositeTexture = holoTexture;
     }
 
-    if (g_compositeTexture == nullptr)
+    return context->compositeTexture != nullptr;
+}
+
+UNITYDLL bool SetHoloTexture(ID3D11Texture2D* holoTexture)
+{
+    return SetHoloTextureForContext(DEFAULT_COMPOSITOR_CONTEXT, holoTexture);
+}
+
+UNITYDLL bool SetVideoRenderTextureForContext(int handle, ID3D11Texture2D* tex)
+{
+    CompositorContext* context = GetContext(handle);
+    if (context == nullptr)
     {
-		g_compositeTexture = holoTexture;
+        return false;
     }
 
-    return g_compositeTexture != nullptr;
+    context->videoTexture = tex;
+
+    return context->videoTexture != nullptr;
 }
 
 UNITYDLL bool SetVideoRenderTexture(ID3D11Texture2D* tex)
 {
-    g_videoTexture = tex;
-
-    return g_videoTexture != nullptr;
+    return SetVideoRenderTextureForContext(DEFAULT_COMPOSITOR_CONTEXT, tex);
 }
 
-UNITYDLL bool SetOutputRenderTexture(ID3D11Texture2D* tex)
+UNITYDLL bool SetOutputRenderTextureForContext(int handle, ID3D11Texture2D* tex)
 {
-    if (g_outputTexture == nullptr)
+    CompositorContext* context = GetContext(handle);
+    if (context == nullptr)
     {
-        g_outputTexture = tex;
+        return false;
     }
 
-    return g_outputTexture != nullptr;
+    if (context->outputTexture == nullptr)
+    {
+        context->outputTexture = tex;
+    }
+
+    return context->outputTexture != nullptr;
 }
 
-UNITYDLL bool CreateUnityColorTexture(ID3D11ShaderResourceView*& srv)
+UNITYDLL bool SetOutputRenderTexture(ID3D11Texture2D* tex)
+{
+    return SetOutputRenderTextureForContext(DEFAULT_COMPOSITOR_CONTEXT, tex);
+}
+
+UNITYDLL bool CreateUnityColorTextureForContext(int handle, ID3D11ShaderResourceView*& srv)
 {
-    if (g_UnityColorSRV == nullptr && g_pD3D11Device != nullptr)
+    CompositorContext* context = GetContext(handle);
+    if (context == nullptr)
     {
-        g_colorTexture = DirectXHelper::CreateTexture(g_pD3D11Device, colorBytes, FRAME_WIDTH, FRAME_HEIGHT, FRAME_BPP_RGBA);
+        return false;
+    }
 
-        if (g_colorTexture == nullptr)
+    if (context->unityColorSRV == nullptr && g_pD3D11Device != nullptr)
+    {
+        context->colorTexture = DirectXHelper::CreateTexture(g_pD3D11Device, colorBytes, FRAME_WIDTH, FRAME_HEIGHT, FRAME_BPP_RGBA);
+
+        if (context->colorTexture == nullptr)
         {
             return false;
         }
 
-        g_UnityColorSRV = DirectXHelper::CreateShaderResourceView(g_pD3D11Device, g_colorTexture);
-        if (g_UnityColorSRV == nullptr)
+        context->unityColorSRV = DirectXHelper::CreateShaderResourceView(g_pD3D11Device, context->colorTexture);
+        if (context->unityColorSRV == nullptr)
         {
             return false;
         }
     }
 
-    srv = g_UnityColorSRV;
+    srv = context->unityColorSRV;
     return true;
 }
 
-UNITYDLL bool CreateUnityDepthCameraTexture(ID3D11ShaderResourceView*& srv)
+UNITYDLL bool CreateUnityColorTexture(ID3D11ShaderResourceView*& srv)
+{
+    return CreateUnityColorTextureForContext(DEFAULT_COMPOSITOR_CONTEXT, srv);
+}
+
+UNITYDLL bool CreateUnityDepthCameraTextureForContext(int handle, ID3D11ShaderResourceView*& srv)
 {
-    if (g_UnityDepthSRV == nullptr && g_pD3D11Device != nullptr)
+    CompositorContext* context = GetContext(handle);
+    if (context == nullptr)
+    {
+        return false;
+    }
+
+    if (context->unityDepthSRV == nullptr && g_pD3D11Device != nullptr)
     {
-        g_depthCameraTexture = DirectXHelper::CreateTexture(g_pD3D11Device, depthBytes, FRAME_WIDTH, FRAME_HEIGHT, FRAME_BPP_DEPTH16, DXGI_FORMAT_R16_UNORM);
+        context->depthCameraTexture = DirectXHelper::CreateTexture(g_pD3D11Device, depthBytes, FRAME_WIDTH, FRAME_HEIGHT, FRAME_BPP_DEPTH16, DXGI_FORMAT_R16_UNORM);
 
-        if (g_depthCameraTexture == nullptr)
+        if (context->depthCameraTexture == nullptr)
         {
             return false;
         }
 
-        g_UnityDepthSRV = DirectXHelper::CreateShaderResourceView(g_pD3D11Device, g_depthCameraTexture, DXGI_FORMAT_R16_UNORM);
-        if (g_UnityDepthSRV == nullptr)
+        context->unityDepthSRV = DirectXHelper::CreateShaderResourceView(g_pD3D11Device, context->depthCameraTexture, DXGI_FORMAT_R16_UNORM);
+        if (context->unityDepthSRV == nullptr)
         {
             return false;
         }
     }
 
-    srv = g_UnityDepthSRV;
+    srv = context->unityDepthSRV;
     return true;
 }
 
-UNITYDLL bool CreateUnityBodyMaskTexture(ID3D11ShaderResourceView*& srv)
+UNITYDLL bool CreateUnityDepthCameraTexture(ID3D11ShaderResourceView*& srv)
 {
-    if (g_UnityBodySRV == nullptr && g_pD3D11Device != nullptr)
+    return CreateUnityDepthCameraTextureForContext(DEFAULT_COMPOSITOR_CONTEXT, srv);
+}
+
+UNITYDLL bool CreateUnityBodyMaskTextureForContext(int handle, ID3D11ShaderResourceView*& srv)
+{
+    CompositorContext* context = GetContext(handle);
+    if (context == nullptr)
+    {
+        return false;
+    }
+
+    if (context->unityBodySRV == nullptr && g_pD3D11Device != nullptr)
     {
-        g_bodyMaskTexture = DirectXHelper::CreateTexture(g_pD3D11Device, bodyMaskBytes, FRAME_WIDTH, FRAME_HEIGHT, FRAME_BPP_DEPTH16, DXGI_FORMAT_R16_UNORM);
+        context->bodyMaskTexture = DirectXHelper::CreateTexture(g_pD3D11Device, bodyMaskBytes, FRAME_WIDTH, FRAME_HEIGHT, FRAME_BPP_DEPTH16, DXGI_FORMAT_R16_UNORM);
 
-        if (g_bodyMaskTexture == nullptr)
+        if (context->bodyMaskTexture == nullptr)
         {
             return false;
         }
 
-        g_UnityBodySRV = DirectXHelper::CreateShaderResourceView(g_pD3D11Device, g_bodyMaskTexture, DXGI_FORMAT_R16_UNORM);
-        if (g_UnityBodySRV == nullptr)
+        context->unityBodySRV = DirectXHelper::CreateShaderResourceView(g_pD3D11Device, context->bodyMaskTexture, DXGI_FORMAT_R16_UNORM);
+        if (context->unityBodySRV == nullptr)
         {
             return false;
         }
     }
 
-    srv = g_UnityBodySRV;
+    srv = context->unityBodySRV;
     return true;
 }
 
+UNITYDLL bool CreateUnityBodyMaskTexture(ID3D11ShaderResourceView*& srv)
+{
+    return CreateUnityBodyMaskTextureForContext(DEFAULT_COMPOSITOR_CONTEXT, srv);
+}
 
-UNITYDLL bool IsArUcoMarkerDetectorSupported()
+
+UNITYDLL bool IsArUcoMarkerDetectorSupportedForContext(int handle)
 {
+    CompositorInterface* ci = GetCompositor(handle);
     if (ci != nullptr)
     {
         return ci->IsArUcoMarkerDetectorSupported();
@@ -691,24 +1147,42 @@ UNITYDLL bool IsArUcoMarkerDetectorSupported()
     }
 }
 
-UNITYDLL void StartArUcoMarkerDetector(cv::aruco::PREDEFINED_DICTIONARY_NAME markerDictionaryName, float markerSize)
+UNITYDLL bool IsArUcoMarkerDetectorSupported()
+{
+    return IsArUcoMarkerDetectorSupportedForContext(DEFAULT_COMPOSITOR_CONTEXT);
+}
+
+UNITYDLL void StartArUcoMarkerDetectorForContext(int handle, cv::aruco::PREDEFINED_DICTIONARY_NAME markerDictionaryName, float markerSize)
 {
+    CompositorInterface* ci = GetCompositor(handle);
     if (ci != nullptr)
     {
         ci->StartArUcoMarkerDetector(markerDictionaryName, markerSize);
     }
 }
 
-UNITYDLL void StopArUcoMarkerDetector()
+UNITYDLL void StartArUcoMarkerDetector(cv::aruco::PREDEFINED_DICTIONARY_NAME markerDictionaryName, float markerSize)
 {
+    StartArUcoMarkerDetectorForContext(DEFAULT_COMPOSITOR_CONTEXT, markerDictionaryName, markerSize);
+}
+
+UNITYDLL void StopArUcoMarkerDetectorForContext(int handle)
+{
+    CompositorInterface* ci = GetCompositor(handle);
     if (ci != nullptr)
     {
         ci->StopArUcoMarkerDetector();
     }
 }
 
-UNITYDLL int GetLatestArUcoMarkerCount()
+UNITYDLL void StopArUcoMarkerDetector()
 {
+    StopArUcoMarkerDetectorForContext(DEFAULT_COMPOSITOR_CONTEXT);
+}
+
+UNITYDLL int GetLatestArUcoMarkerCountForContext(int handle)
+{
+    CompositorInterface* ci = GetCompositor(handle);
     if (ci != nullptr)
     {
         return ci->GetLatestArUcoMarkerCount();
@@ -719,11 +1193,22 @@ UNITYDLL int GetLatestArUcoMarkerCount()
     }
 }
 
-UNITYDLL void GetLatestArUcoMarkers(int size, Marker* markers)
+UNITYDLL int GetLatestArUcoMarkerCount()
 {
+    return GetLatestArUcoMarkerCountForContext(DEFAULT_COMPOSITOR_CONTEXT);
+}
+
+UNITYDLL void GetLatestArUcoMarkersForContext(int handle, int size, Marker* markers)
+{
+    CompositorInterface* ci = GetCompositor(handle);
     if (ci != nullptr)
     {
         ci->GetLatestArUcoMarkers(size, markers);
     }
 }
+
+UNITYDLL void GetLatestArUcoMarkers(int size, Marker* markers)
+{
+    GetLatestArUcoMarkersForContext(DEFAULT_COMPOSITOR_CONTEXT, size, markers);
+}
 #pragma endregion CreateExternalTextures
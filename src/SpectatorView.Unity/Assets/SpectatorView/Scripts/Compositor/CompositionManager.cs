@@ -97,6 +97,11 @@ namespace Microsoft.MixedReality.SpectatorView
         private bool isVideoFrameProviderInitialized = false;
         private SpectatorViewPoseCache poseCache = new SpectatorViewPoseCache();
         private SpectatorViewTimeSynchronizer timeSynchronizer = new SpectatorViewTimeSynchronizer();
+#if UNITY_EDITOR
+        private long captureTimestampOrigin = 0;
+        private int lastTimedFrame = -1;
+        private float lastTimedFrameTime = 0.0f;
+#endif
 
         private Camera spectatorCamera;
         public GameObject VideoCameraPose { get; private set; }
@@ -424,12 +429,37 @@ namespace Microsoft.MixedReality.SpectatorView
 
         /// <summary>
         /// Gets the time for a video frame relative to the start of video capture.
+        /// Frames the compositor still caches are timed by their capture timestamp, which follows the camera
+        /// rather than assuming every frame arrived exactly one frame duration after the last. Older frames
+        /// are stepped back from the last frame that was timed. Frames before the first timestamp are timed by
+        /// their index, and the timestamps are measured from where that index clock puts the first timed frame,
+        /// so both share one origin.
         /// </summary>
         /// <param name="frame">The index of the video frame.</param>
         /// <returns>The time of the video frame relative to the start of the video capture, in seconds.</returns>
         private float GetTimeFromFrame(int frame)
         {
-            return GetVideoFrameDuration() * frame;
+            // Capture timestamps are QueryPerformanceCounter ticks, which Stopwatch also counts in.
+            long timestamp = UnityCompositorInterface.GetCaptureFrameTimestamp(frame);
+            if (timestamp > 0)
+            {
+                if (captureTimestampOrigin == 0)
+                {
+                    double frameTicks = (double)GetVideoFrameDuration() * System.Diagnostics.Stopwatch.Frequency;
+                    captureTimestampOrigin = timestamp - (long)(frameTicks * frame);
+                }
+
+                lastTimedFrame = frame;
+                lastTimedFrameTime = (float)((double)(timestamp - captureTimestampOrigin) / System.Diagnostics.Stopwatch.Frequency);
+                return lastTimedFrameTime;
+            }
+
+            if (lastTimedFrame < 0)
+            {
+                return GetVideoFrameDuration() * frame;
+            }
+
+            return lastTimedFrameTime + GetVideoFrameDuration() * (frame - lastTimedFrame);
         }
 
         /// <summary>
@@ -567,7 +597,7 @@ namespace Microsoft.MixedReality.SpectatorView
                     SpectatorViewPoseCache.PoseData poseData = poseCache.GetLatestPose();
                     if (poseData != null)
                     {
-                        timeSynchronizer.Update(UnityCompositorInterface.GetCaptureFrameIndex(), captureTime, poseData.Index, poseData.TimeStamp);
+                        timeSynchronizer.Update(captureFrameIndex, captureTime, poseData.Index, poseData.TimeStamp);
                     }
                 }
 
@@ -606,6 +636,8 @@ namespace Microsoft.MixedReality.SpectatorView
                     if (isVideoFrameProviderInitialized)
                     {
                         CurrentCompositeFrame = 0;
+                        captureTimestampOrigin = 0;
+                        lastTimedFrame = -1;
                         timeSynchronizer.Reset();
                         poseCache.Reset();
 
@@ -622,8 +654,6 @@ namespace Microsoft.MixedReality.SpectatorView
                     Debug.LogWarning($"The current device selection, Capture: {CaptureDevice}, Output: {OutputDevice}, is not supported by your build of SpectatorView.Compositor.UnityPlugin.dll.");
                 }
             }
-
-            UnityCompositorInterface.UpdateCompositor();
 #endif
         }
 
@@ -190,6 +190,18 @@ namespace Microsoft.MixedReality.SpectatorView
         [DllImport(CompositorPluginDll)]
         public static extern void SetLatencyPreference(float latencyPreference);
 
+        [DllImport(CompositorPluginDll)]
+        public static extern void SetEncoderQueuePolicy(int policy, int capacity);
+
+        [DllImport(CompositorPluginDll)]
+        public static extern bool GetEncoderQueueStats(out int depth, out int peakDepth, out long dropped, out long stalls, out double stallMilliseconds);
+
+        [DllImport(CompositorPluginDll)]
+        public static extern void SetConversionWorkerCount(int workerCount);
+
+        [DllImport(CompositorPluginDll)]
+        public static extern void SetThreadRoleScheduling(int role, int priority, ulong affinityMask, int mmcssTask);
+
         [DllImport(CompositorPluginDll)]
         public static extern IntPtr GetRenderEventFunc();
 
@@ -202,6 +214,15 @@ namespace Microsoft.MixedReality.SpectatorView
         [DllImport(CompositorPluginDll)]
         public static extern int GetCaptureFrameIndex();
 
+        [DllImport(CompositorPluginDll)]
+        public static extern long GetCaptureFrameTimestamp(int frame);
+
+        [DllImport(CompositorPluginDll)]
+        public static extern int GetFrameNearestTimestamp(long timestamp, out int earlierFrame, out int laterFrame);
+
+        [DllImport(CompositorPluginDll)]
+        public static extern bool GetTimestampClockFit(out int samples, out double driftPpm, out double residualMicroseconds);
+
         [DllImport(CompositorPluginDll)]
         public static extern void SetCompositeFrameIndex(int index);
 
@@ -228,6 +249,133 @@ namespace Microsoft.MixedReality.SpectatorView
 
         [DllImport(CompositorPluginDll)]
         public static extern bool TryGetLatestArUcoMarkerPose(int markerId, out CompositorVector3 position, out CompositorVector3 rotation);
+
+        // Compositor contexts capture from one camera each. The functions above use the default context, handle 0.
+        [DllImport(CompositorPluginDll)]
+        public static extern int CreateCompositorContext();
+
+        [DllImport(CompositorPluginDll)]
+        public static extern void DestroyCompositorContext(int context);
+
+        [DllImport(CompositorPluginDll)]
+        public static extern int GetMaxCompositorContexts();
+
+        [DllImport(CompositorPluginDll)]
+        public static extern IntPtr GetContextRenderEventFunc();
+
+        [DllImport(CompositorPluginDll)]
+        public static extern void SetCaptureDeviceIndexForContext(int context, int deviceIndex);
+
+        [DllImport(CompositorPluginDll)]
+        public static extern bool SetHoloTextureForContext(int context, IntPtr holoTexture);
+
+        [DllImport(CompositorPluginDll)]
+        public static extern void SetAlphaForContext(int context, float alpha);
+
+        [DllImport(CompositorPluginDll)]
+        public static extern float GetAlphaForContext(int context);
+
+        [DllImport(CompositorPluginDll)]
+        public static extern bool CreateUnityColorTextureForContext(int context, out IntPtr srv);
+
+        [DllImport(CompositorPluginDll)]
+        public static extern bool CreateUnityDepthCameraTextureForContext(int context, out IntPtr srv);
+
+        [DllImport(CompositorPluginDll)]
+        public static extern bool CreateUnityBodyMaskTextureForContext(int context, out IntPtr srv);
+
+        [DllImport(CompositorPluginDll)]
+        public static extern bool SetVideoRenderTextureForContext(int context, IntPtr texturePtr);
+
+        [DllImport(CompositorPluginDll)]
+        public static extern bool SetOutputRenderTextureForContext(int context, IntPtr texturePtr);
+
+        [DllImport(CompositorPluginDll)]
+        public static extern bool IsRecordingForContext(int context);
+
+        [DllImport(CompositorPluginDll)]
+        public static extern bool ProvidesYUVForContext(int context);
+
+        [DllImport(CompositorPluginDll)]
+        public static extern bool ExpectsYUVForContext(int context);
+
+        [DllImport(CompositorPluginDll)]
+        public static extern void StopFrameProviderForContext(int context);
+
+        [DllImport(CompositorPluginDll)]
+        public static extern void TakePictureForContext(int context);
+
+        [DllImport(CompositorPluginDll, CharSet = CharSet.Unicode)]
+        public static extern void TakeRawPictureForContext(int context, string path);
+
+        [DllImport(CompositorPluginDll, CharSet = CharSet.Unicode)]
+        public static extern bool StartRecordingForContext(int context, int frameLayout, string desiredFileName, int desiredFileNameLength, int inputFileNameLength, StringBuilder fileName, int[] fileNameLength);
+
+        [DllImport(CompositorPluginDll)]
+        public static extern void StopRecordingForContext(int context);
+
+        [DllImport(CompositorPluginDll)]
+        public static extern bool InitializeFrameProviderOnDeviceForContext(int context, [MarshalAs(UnmanagedType.I4)] FrameProviderDeviceType providerId, [MarshalAs(UnmanagedType.I4)] FrameProviderDeviceType outputProviderId);
+
+        [DllImport(CompositorPluginDll)]
+        public static extern void ResetForContext(int context);
+
+        [DllImport(CompositorPluginDll)]
+        public static extern long GetColorDurationForContext(int context);
+
+        [DllImport(CompositorPluginDll)]
+        public static extern int GetNumQueuedOutputFramesForContext(int context);
+
+        [DllImport(CompositorPluginDll)]
+        public static extern void SetLatencyPreferenceForContext(int context, float latencyPreference);
+
+        [DllImport(CompositorPluginDll)]
+        public static extern void SetEncoderQueuePolicyForContext(int context, int policy, int capacity);
+
+        [DllImport(CompositorPluginDll)]
+        public static extern bool GetEncoderQueueStatsForContext(int context, out int depth, out int peakDepth, out long dropped, out long stalls, out double stallMilliseconds);
+
+        [DllImport(CompositorPluginDll)]
+        public static extern void SetAudioDataForContext(int context, byte[] audioData, int dataLength, double audioTime);
+
+        [DllImport(CompositorPluginDll)]
+        public static extern void UpdateCompositorForContext(int context);
+
+        [DllImport(CompositorPluginDll)]
+        public static extern int GetCaptureFrameIndexForContext(int context);
+
+        [DllImport(CompositorPluginDll)]
+        public static extern long GetCaptureFrameTimestampForContext(int context, int frame);
+
+        [DllImport(CompositorPluginDll)]
+        public static extern int GetFrameNearestTimestampForContext(int context, long timestamp, out int earlierFrame, out int laterFrame);
+
+        [DllImport(CompositorPluginDll)]
+        public static extern bool GetTimestampClockFitForContext(int context, out int samples, out double driftPpm, out double residualMicroseconds);
+
+        [DllImport(CompositorPluginDll)]
+        public static extern void SetCompositeFrameIndexForContext(int context, int index);
+
+        [DllImport(CompositorPluginDll)]
+        public static extern bool IsCameraCalibrationInformationAvailableForContext(int context);
+
+        [DllImport(CompositorPluginDll)]
+        public static extern void GetCameraCalibrationInformationForContext(int context, out CompositorCameraIntrinsics cameraIntrinsics);
+
+        [DllImport(CompositorPluginDll)]
+        public static extern bool IsArUcoMarkerDetectorSupportedForContext(int context);
+
+        [DllImport(CompositorPluginDll)]
+        public static extern void StartArUcoMarkerDetectorForContext(int context, int markerDictionaryName, float markerSize);
+
+        [DllImport(CompositorPluginDll)]
+        public static extern void StopArUcoMarkerDetectorForContext(int context);
+
+        [DllImport(CompositorPluginDll)]
+        public static extern int GetLatestArUcoMarkerCountForContext(int context);
+
+        [DllImport(CompositorPluginDll)]
+        public static extern void GetLatestArUcoMarkersForContext(int context, int size, CompositorMarker[] markers);
     }
 #endif
 }